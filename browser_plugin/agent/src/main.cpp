@@ -15,6 +15,7 @@
 #include <httplib.h>
 #include <nlohmann/json.hpp>
 
+#include "markql/json_writer.h"
 #include "markql/markql.h"
 #include "sha256.h"
 
@@ -34,12 +35,18 @@ struct QueryOptions {
   int timeout_ms = kDefaultTimeoutMs;
 };
 
+struct QueryColumn {
+  std::string name;
+  std::string type;
+};
+
+/// A successful /v1/query payload. Rows are serialized into `rows_json` as they are mapped,
+/// so large results never exist as a json tree.
 struct QueryResponse {
-  int elapsed_ms = 0;
-  json columns = json::array();
-  json rows = json::array();
+  std::vector<QueryColumn> columns;
+  std::string rows_json;
+  size_t row_count = 0;
   bool truncated = false;
-  json error = nullptr;
 };
 
 struct ExecutionOutcome {
@@ -292,45 +299,6 @@ std::vector<std::string> resolve_columns(const markql::QueryResult& result) {
   return {"node_id", "tag", "attributes", "parent_id", "max_depth", "doc_order"};
 }
 
-json value_for_field(const std::string& field, const markql::QueryResultRow& row) {
-  if (field == "node_id" || field == "count") return row.node_id;
-  if (field == "tag") return row.tag;
-  if (field == "text") return row.text;
-  if (field == "inner_html") return row.inner_html;
-  if (field == "parent_id") {
-    if (row.parent_id.has_value()) return *row.parent_id;
-    return nullptr;
-  }
-  if (field == "sibling_pos") return row.sibling_pos;
-  if (field == "max_depth") return row.max_depth;
-  if (field == "doc_order") return row.doc_order;
-  if (field == "source_uri") return row.source_uri;
-  if (field == "attributes") {
-    json attrs = json::object();
-    for (const auto& kv : row.attributes) {
-      attrs[kv.first] = kv.second;
-    }
-    return attrs;
-  }
-  if (field == "terms_score") {
-    json scores = json::object();
-    for (const auto& kv : row.term_scores) {
-      scores[kv.first] = kv.second;
-    }
-    return scores;
-  }
-
-  const auto computed = row.computed_fields.find(field);
-  if (computed != row.computed_fields.end()) {
-    return computed->second;
-  }
-  const auto attr = row.attributes.find(field);
-  if (attr != row.attributes.end()) {
-    return attr->second;
-  }
-  return nullptr;
-}
-
 std::string infer_column_type(const std::string& field) {
   if (field == "node_id" || field == "count" || field == "parent_id" || field == "sibling_pos" ||
       field == "max_depth" || field == "doc_order") {
@@ -347,20 +315,24 @@ QueryResponse map_row_result(const markql::QueryResult& result, size_t max_rows)
   const std::vector<std::string> columns = resolve_columns(result);
 
   for (const auto& name : columns) {
-    out.columns.push_back({{"name", name}, {"type", infer_column_type(name)}});
+    out.columns.push_back({name, infer_column_type(name)});
   }
 
+  markql::JsonWriter writer(out.rows_json);
+  writer.begin_array();
   for (const auto& row : result.rows) {
-    if (out.rows.size() >= max_rows) {
+    if (out.row_count >= max_rows) {
       out.truncated = true;
       break;
     }
-    json values = json::array();
+    writer.begin_array();
     for (const auto& field : columns) {
-      values.push_back(value_for_field(field, row));
+      markql::write_json_field(writer, row, field);
     }
-    out.rows.push_back(std::move(values));
+    writer.end_array();
+    ++out.row_count;
   }
+  writer.end_array();
   return out;
 }
 
@@ -371,20 +343,29 @@ QueryResponse map_list_result(const markql::QueryResult& result, size_t max_rows
     field = result.columns.front();
   }
 
-  out.columns.push_back({{"name", field}, {"type", infer_column_type(field)}});
+  out.columns.push_back({field, infer_column_type(field)});
+  markql::JsonWriter writer(out.rows_json);
+  writer.begin_array();
   for (const auto& row : result.rows) {
-    if (out.rows.size() >= max_rows) {
+    if (out.row_count >= max_rows) {
       out.truncated = true;
       break;
     }
-    out.rows.push_back(json::array({value_for_field(field, row)}));
+    writer.begin_array();
+    markql::write_json_field(writer, row, field);
+    writer.end_array();
+    ++out.row_count;
   }
+  writer.end_array();
   return out;
 }
 
 QueryResponse map_table_result(const markql::QueryResult& result, size_t max_rows) {
   QueryResponse out;
+  markql::JsonWriter writer(out.rows_json);
+  writer.begin_array();
   if (result.tables.empty()) {
+    writer.end_array();
     return out;
   }
 
@@ -408,7 +389,7 @@ QueryResponse map_table_result(const markql::QueryResult& result, size_t max_row
   }
 
   if (include_table_id) {
-    out.columns.push_back({{"name", "table_node_id"}, {"type", "number"}});
+    out.columns.push_back({"table_node_id", "number"});
   }
 
   for (size_t i = 0; i < max_cols; ++i) {
@@ -418,32 +399,35 @@ QueryResponse map_table_result(const markql::QueryResult& result, size_t max_row
     } else {
       name = "col_" + std::to_string(i + 1);
     }
-    out.columns.push_back({{"name", name}, {"type", "string"}});
+    out.columns.push_back({name, "string"});
   }
 
   for (const auto& table : result.tables) {
     size_t start = result.table_has_header ? 1 : 0;
     for (size_t i = start; i < table.rows.size(); ++i) {
-      if (out.rows.size() >= max_rows) {
+      if (out.row_count >= max_rows) {
         out.truncated = true;
+        writer.end_array();
         return out;
       }
 
-      json values = json::array();
+      writer.begin_array();
       if (include_table_id) {
-        values.push_back(table.node_id);
+        writer.integer(table.node_id);
       }
       for (size_t c = 0; c < max_cols; ++c) {
         if (c < table.rows[i].size()) {
-          values.push_back(table.rows[i][c]);
+          writer.string(table.rows[i][c]);
         } else {
-          values.push_back(nullptr);
+          writer.null();
         }
       }
-      out.rows.push_back(std::move(values));
+      writer.end_array();
+      ++out.row_count;
     }
   }
 
+  writer.end_array();
   return out;
 }
 
@@ -457,6 +441,35 @@ QueryResponse map_result(const markql::QueryResult& result, size_t max_rows) {
   return map_row_result(result, max_rows);
 }
 
+/// Serializes a success payload with the key order json::dump used before (keys sorted).
+std::string query_response_json(const QueryResponse& payload, int elapsed) {
+  std::string out;
+  out.reserve(payload.rows_json.size() + 256);
+  markql::JsonWriter writer(out);
+  writer.begin_object();
+  writer.key("columns");
+  writer.begin_array();
+  for (const auto& column : payload.columns) {
+    writer.begin_object();
+    writer.key("name");
+    writer.string(column.name);
+    writer.key("type");
+    writer.string(column.type);
+    writer.end_object();
+  }
+  writer.end_array();
+  writer.key("elapsed_ms");
+  writer.integer(elapsed);
+  writer.key("error");
+  writer.null();
+  writer.key("rows");
+  writer.raw(payload.rows_json);
+  writer.key("truncated");
+  writer.boolean(payload.truncated);
+  writer.end_object();
+  return out;
+}
+
 }  // namespace
 
 int main() {
@@ -521,17 +534,10 @@ int main() {
       return;
     }
 
-    QueryResponse payload = map_result(execution.result, options.max_rows);
-    payload.elapsed_ms = elapsed_ms(started_at);
-
-    write_json(res, 200,
-               {
-                   {"elapsed_ms", payload.elapsed_ms},
-                   {"columns", payload.columns},
-                   {"rows", payload.rows},
-                   {"truncated", payload.truncated},
-                   {"error", nullptr},
-               });
+    const QueryResponse payload = map_result(execution.result, options.max_rows);
+    res.status = 200;
+    set_cors_headers(res);
+    res.set_content(query_response_json(payload, elapsed_ms(started_at)), "application/json");
   });
 
   std::cout << "[markql-agent] Listening on http://" << kBindHost << ":" << bind_port << "\n";
@@ -19,7 +19,7 @@ void print_startup_help(std::ostream& os) {
   os << "  markql --lint \"<query>\" [--format text|json]\n";
   os << "  markql --interactive [--input <path>]\n";
   os << "  markql explore <input.html>\n";
-  os << "  markql --mode duckbox|json|plain|csv\n";
+  os << "  markql --mode duckbox|json|plain|csv|arrow\n";
   os << "  markql --display_mode more|less\n";
   os << "  markql --highlight on|off\n";
   os << "  markql --timeout-ms <n>\n";
@@ -58,7 +58,7 @@ void print_help(std::ostream& os) {
   os << "       markql --lint \"<query>\" [--format text|json]\n";
   os << "       markql --interactive [--input <path>]\n";
   os << "       markql explore <input.html>\n";
-  os << "       markql --mode duckbox|json|plain|csv\n";
+  os << "       markql --mode duckbox|json|plain|csv|arrow\n";
   os << "       markql --display_mode more|less\n";
   os << "       markql --highlight on|off\n";
   os << "       markql --timeout-ms <n>\n";
@@ -67,8 +67,8 @@ void print_help(std::ostream& os) {
   os << "Legacy `markql` command name remains available.\n";
   os << "If --input is omitted, HTML is read from stdin.\n";
   os << "Scripts and REPL input support SQL comments: -- ... and /* ... */.\n";
-  os << "Use TO CSV('file.csv'), TO PARQUET('file.parquet'), TO JSON('file.json'), or\n"
-        "TO NDJSON('file.ndjson') in queries to export.\n";
+  os << "Use TO CSV('file.csv'), TO PARQUET('file.parquet'), TO JSON('file.json'),\n"
+        "TO NDJSON('file.ndjson'), or TO ARROW('file.arrow') in queries to export.\n";
   os << "Use --render j2 to render .mql.j2 query files into plain MarkQL before lint/execute.\n";
   os << "--vars loads TOML template variables. Missing variables fail with strict undefined "
         "behavior.\n";
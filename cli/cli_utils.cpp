@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -18,9 +19,6 @@
 #include "runtime/engine/markql_internal.h"
 #include "ui/color.h"
 
-#ifdef MARKQL_USE_NLOHMANN_JSON
-#include <nlohmann/json.hpp>
-#endif
 namespace markql::cli {
 
 std::string read_file(const std::string& path) {
@@ -591,6 +589,7 @@ std::string export_kind_label(markql::QueryResult::ExportSink::Kind kind) {
   if (kind == markql::QueryResult::ExportSink::Kind::Parquet) return "Parquet";
   if (kind == markql::QueryResult::ExportSink::Kind::Json) return "JSON";
   if (kind == markql::QueryResult::ExportSink::Kind::Ndjson) return "NDJSON";
+  if (kind == markql::QueryResult::ExportSink::Kind::Arrow) return "Arrow";
   return "Export";
 }
 
@@ -104,6 +104,15 @@ bool is_valid_utf8(const std::string& text);
 /// Inputs are QueryResult rows; outputs are JSON text with no side effects.
 std::string build_json(const markql::QueryResult& result,
                        markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
+/// Row-at-a-time pieces of build_json for streamed output: the output schema, one array
+/// element with the separator before it, and the closing bracket after an opening "[".
+/// MUST concatenate to exactly build_json's text for the same rows.
+std::vector<markql::ColumnNameMapping> json_output_schema(
+    const markql::QueryResult& result,
+    markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
+void append_json_array_row(std::string& out, const markql::QueryResultRow& row,
+                           const std::vector<markql::ColumnNameMapping>& schema, bool first);
+void append_json_array_end(std::string& out, bool empty);
 /// Serializes a single-column result into a JSON list.
 /// MUST enforce single-column output and MUST represent NULLs explicitly.
 /// Inputs are QueryResult rows; outputs are JSON list text with no side effects.
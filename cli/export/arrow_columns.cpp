@@ -0,0 +1,148 @@
+#include "export/arrow_columns.h"
+
+#ifdef MARKQL_USE_ARROW
+
+#include <arrow/c/bridge.h>
+
+#include <charconv>
+#include <cmath>
+#include <string_view>
+
+#include "markql/arrow_c_data.h"
+
+namespace markql::cli {
+
+namespace {
+
+using ColumnType = markql::ColumnarColumn::Type;
+
+enum class InferredType { Int64, Double, Text };
+
+/// Digits with an optional leading '-' and no leading zeros, so codes such as "007" keep their
+/// text form.
+bool is_integer_text(std::string_view text) {
+  if (!text.empty() && text.front() == '-') text.remove_prefix(1);
+  if (text.empty() || (text.size() > 1 && text.front() == '0')) return false;
+  for (char c : text) {
+    if (c < '0' || c > '9') return false;
+  }
+  return true;
+}
+
+/// An integer part as above, then a fraction and/or an exponent.
+bool is_decimal_text(std::string_view text) {
+  if (!text.empty() && text.front() == '-') text.remove_prefix(1);
+  size_t i = 0;
+  while (i < text.size() && text[i] >= '0' && text[i] <= '9') ++i;
+  if (i == 0 || (i > 1 && text.front() == '0')) return false;
+  bool has_fraction_or_exponent = false;
+  if (i < text.size() && text[i] == '.') {
+    const size_t start = ++i;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') ++i;
+    if (i == start) return false;
+    has_fraction_or_exponent = true;
+  }
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    ++i;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) ++i;
+    const size_t start = i;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') ++i;
+    if (i == start) return false;
+    has_fraction_or_exponent = true;
+  }
+  return i == text.size() && has_fraction_or_exponent;
+}
+
+bool parse_int64(std::string_view text, int64_t& out) {
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+bool parse_double(std::string_view text, double& out) {
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc() && end == text.data() + text.size() && std::isfinite(out);
+}
+
+/// Picks int64 when every non-null value is an integer that fits, double when every value is
+/// numeric, and text otherwise (including columns with no non-null values).
+InferredType infer_type(const markql::ColumnarColumn& column, int64_t num_rows) {
+  bool saw_value = false;
+  bool all_int64 = true;
+  for (int64_t r = 0; r < num_rows; ++r) {
+    if (!column.is_valid(static_cast<size_t>(r))) continue;
+    const std::string_view text = column.strings.at(static_cast<size_t>(r));
+    saw_value = true;
+    int64_t int_value = 0;
+    double double_value = 0;
+    if (all_int64 && is_integer_text(text) && parse_int64(text, int_value)) continue;
+    if ((is_integer_text(text) || is_decimal_text(text)) && parse_double(text, double_value)) {
+      all_int64 = false;
+      continue;
+    }
+    return InferredType::Text;
+  }
+  if (!saw_value) return InferredType::Text;
+  return all_int64 ? InferredType::Int64 : InferredType::Double;
+}
+
+template <typename Builder, typename Parse>
+arrow::Result<std::shared_ptr<arrow::Array>> build_numeric(const markql::ColumnarColumn& column,
+                                                           int64_t num_rows, Parse parse) {
+  Builder builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(num_rows));
+  for (int64_t r = 0; r < num_rows; ++r) {
+    if (!column.is_valid(static_cast<size_t>(r))) {
+      builder.UnsafeAppendNull();
+      continue;
+    }
+    typename Builder::value_type value{};
+    parse(column.strings.at(static_cast<size_t>(r)), value);
+    builder.UnsafeAppend(value);
+  }
+  std::shared_ptr<arrow::Array> out;
+  ARROW_RETURN_NOT_OK(builder.Finish(&out));
+  return out;
+}
+
+}  // namespace
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> to_arrow_record_batch(
+    const std::shared_ptr<const markql::ColumnarResult>& columns,
+    const std::vector<std::string>& output_names, bool infer_types) {
+  ArrowSchema c_schema;
+  ArrowArray c_array;
+  markql::export_columnar_result(columns, &c_schema, &c_array);
+  auto imported = arrow::ImportRecordBatch(&c_array, &c_schema);
+  if (!imported.ok()) {
+    if (c_array.release != nullptr) c_array.release(&c_array);
+    if (c_schema.release != nullptr) c_schema.release(&c_schema);
+    return imported.status();
+  }
+  std::shared_ptr<arrow::RecordBatch> batch = *imported;
+
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> arrays;
+  fields.reserve(columns->columns.size());
+  arrays.reserve(columns->columns.size());
+  for (size_t i = 0; i < columns->columns.size(); ++i) {
+    const markql::ColumnarColumn& column = columns->columns[i];
+    std::shared_ptr<arrow::Array> array = batch->column(static_cast<int>(i));
+    if (column.type == ColumnType::Utf8 && column.computed && infer_types) {
+      const InferredType inferred = infer_type(column, columns->num_rows);
+      if (inferred == InferredType::Int64) {
+        ARROW_ASSIGN_OR_RAISE(array, build_numeric<arrow::Int64Builder>(
+                                         column, columns->num_rows, parse_int64));
+      } else if (inferred == InferredType::Double) {
+        ARROW_ASSIGN_OR_RAISE(array, build_numeric<arrow::DoubleBuilder>(
+                                         column, columns->num_rows, parse_double));
+      }
+    }
+    fields.push_back(arrow::field(output_names[i], array->type(), true));
+    arrays.push_back(std::move(array));
+  }
+  return arrow::RecordBatch::Make(arrow::schema(fields), columns->num_rows, arrays);
+}
+
+}  // namespace markql::cli
+
+#endif
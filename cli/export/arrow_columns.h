@@ -0,0 +1,25 @@
+#pragma once
+
+#ifdef MARKQL_USE_ARROW
+
+#include <arrow/api.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "markql/columnar_result.h"
+
+namespace markql::cli {
+
+/// Adopts `columns` as an Arrow record batch whose column i is named `output_names[i]`. This is
+/// the type mapping shared by the Parquet and Arrow IPC sinks: node fields keep their
+/// ColumnarResult types without copying, and when `infer_types` is set, computed text columns
+/// whose every value is an integer (no leading zeros) or a decimal become int64 or double.
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> to_arrow_record_batch(
+    const std::shared_ptr<const markql::ColumnarResult>& columns,
+    const std::vector<std::string>& output_names, bool infer_types);
+
+}  // namespace markql::cli
+
+#endif
@@ -0,0 +1,189 @@
+#include "export/arrow_ipc_writer.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef MARKQL_USE_ARROW
+#include <arrow/api.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/ipc/writer.h>
+
+#include "export/arrow_columns.h"
+#endif
+
+namespace markql::cli {
+
+#ifdef MARKQL_USE_ARROW
+
+namespace {
+
+/// Lets the IPC writer target a std::ostream, so files and stdout share one path.
+class OstreamOutput : public arrow::io::OutputStream {
+ public:
+  explicit OstreamOutput(std::ostream& out) : out_(out) {}
+
+  arrow::Status Close() override {
+    closed_ = true;
+    return Flush();
+  }
+  bool closed() const override { return closed_; }
+  arrow::Result<int64_t> Tell() const override { return position_; }
+  arrow::Status Write(const void* data, int64_t nbytes) override {
+    out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(nbytes));
+    if (!out_) return arrow::Status::IOError("Failed to write Arrow stream");
+    position_ += nbytes;
+    return arrow::Status::OK();
+  }
+  arrow::Status Flush() override {
+    out_.flush();
+    if (!out_) return arrow::Status::IOError("Failed to write Arrow stream");
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::ostream& out_;
+  int64_t position_ = 0;
+  bool closed_ = false;
+};
+
+void check(const arrow::Status& status) {
+  if (!status.ok()) throw std::runtime_error(status.ToString());
+}
+
+template <typename T>
+T check(arrow::Result<T> result) {
+  check(result.status());
+  return std::move(result).ValueUnsafe();
+}
+
+/// Owns the IPC writer, which is created from the first batch's schema.
+class BatchStream {
+ public:
+  explicit BatchStream(std::ostream& out) : output_(std::make_shared<OstreamOutput>(out)) {}
+
+  /// Writes `columns` in kBatchRows slices; slices share the dictionary, so it is sent once.
+  void write(const std::shared_ptr<const markql::ColumnarResult>& columns,
+             const std::vector<std::string>& output_names, bool infer_types) {
+    auto batch = check(to_arrow_record_batch(columns, output_names, infer_types));
+    if (writer_ == nullptr) {
+      writer_ = check(arrow::ipc::MakeStreamWriter(output_, batch->schema()));
+    }
+    const int64_t rows = batch->num_rows();
+    for (int64_t offset = 0; offset < rows; offset += ArrowIpcStreamWriter::kBatchRows) {
+      check(writer_->WriteRecordBatch(*batch->Slice(offset, ArrowIpcStreamWriter::kBatchRows)));
+    }
+  }
+
+  void close() {
+    if (writer_ != nullptr) check(writer_->Close());
+    check(output_->Flush());
+  }
+
+ private:
+  std::shared_ptr<OstreamOutput> output_;
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer_;
+};
+
+}  // namespace
+
+struct ArrowIpcStreamWriter::Impl {
+  explicit Impl(std::ostream& out) : stream(out) {}
+
+  BatchStream stream;
+  std::vector<std::string> output_names;
+  /// Column names only.
+  markql::QueryResult header;
+  markql::ColumnarResultBuilder builder;
+  int64_t pending_rows = 0;
+  /// Set once a full batch shows no computed text column, so inference cannot change types.
+  bool streaming = false;
+  bool checked_streaming = false;
+
+  void flush(bool infer_types) {
+    auto columns = std::make_shared<const markql::ColumnarResult>(builder.finish(header));
+    builder.begin(header);
+    pending_rows = 0;
+    stream.write(columns, output_names, infer_types);
+  }
+};
+
+ArrowIpcStreamWriter::ArrowIpcStreamWriter(std::ostream& out,
+                                           std::vector<std::string> output_names)
+    : impl_(std::make_unique<Impl>(out)) {
+  impl_->output_names = std::move(output_names);
+}
+
+ArrowIpcStreamWriter::~ArrowIpcStreamWriter() = default;
+
+void ArrowIpcStreamWriter::begin(const markql::QueryResult& header) {
+  if (header.to_table || !header.tables.empty()) {
+    throw std::runtime_error("Arrow output does not support TO TABLE() results");
+  }
+  // Only the columns are needed to rebuild the builder after each batch; rows are not copied.
+  impl_->header.columns = header.columns;
+  impl_->builder.begin(impl_->header);
+}
+
+void ArrowIpcStreamWriter::write_row(const markql::QueryResultRow& row) {
+  impl_->builder.row(row);
+  if (++impl_->pending_rows < kBatchRows) return;
+  if (!impl_->checked_streaming) {
+    impl_->checked_streaming = true;
+    impl_->streaming = true;
+    for (const auto& column : impl_->builder.columns().columns) {
+      if (column.type == markql::ColumnarColumn::Type::Utf8 && column.computed) {
+        impl_->streaming = false;
+      }
+    }
+  }
+  // WHY: later batches skip inference; once streaming, no computed column was seen, so types
+  // follow from column names alone and every batch matches the schema already written.
+  if (impl_->streaming) impl_->flush(false);
+}
+
+void ArrowIpcStreamWriter::finish() {
+  impl_->flush(!impl_->streaming);
+  impl_->stream.close();
+}
+
+void write_arrow_columns(std::ostream& out,
+                         const std::shared_ptr<const markql::ColumnarResult>& columns,
+                         const std::vector<std::string>& output_names) {
+  BatchStream stream(out);
+  stream.write(columns, output_names, true);
+  stream.close();
+}
+
+#else
+
+struct ArrowIpcStreamWriter::Impl {};
+
+ArrowIpcStreamWriter::ArrowIpcStreamWriter(std::ostream& out,
+                                           std::vector<std::string> output_names) {
+  (void)out;
+  (void)output_names;
+}
+
+ArrowIpcStreamWriter::~ArrowIpcStreamWriter() = default;
+
+void ArrowIpcStreamWriter::begin(const markql::QueryResult& header) {
+  (void)header;
+  throw std::runtime_error("Arrow output requires Apache Arrow feature");
+}
+
+void ArrowIpcStreamWriter::write_row(const markql::QueryResultRow& row) { (void)row; }
+
+void ArrowIpcStreamWriter::finish() {}
+
+void write_arrow_columns(std::ostream& out,
+                         const std::shared_ptr<const markql::ColumnarResult>& columns,
+                         const std::vector<std::string>& output_names) {
+  (void)out;
+  (void)columns;
+  (void)output_names;
+  throw std::runtime_error("Arrow output requires Apache Arrow feature");
+}
+
+#endif
+
+}  // namespace markql::cli
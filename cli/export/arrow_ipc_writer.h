@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "markql/columnar_result.h"
+#include "markql/markql.h"
+
+namespace markql::cli {
+
+/// Writes rows as an Arrow IPC stream (schema message, then record batches) into `out`, with
+/// the same column types as TO PARQUET. Rows are gathered into columns and written every
+/// kBatchRows rows. While a computed column may still be inferred as numeric, rows keep
+/// accumulating so that every batch shares one schema. Failures throw std::runtime_error,
+/// including in builds without Arrow.
+class ArrowIpcStreamWriter {
+ public:
+  static constexpr int64_t kBatchRows = int64_t{1} << 16;
+
+  ArrowIpcStreamWriter(std::ostream& out, std::vector<std::string> output_names);
+  ~ArrowIpcStreamWriter();
+
+  void begin(const markql::QueryResult& header);
+  void write_row(const markql::QueryResultRow& row);
+  /// Writes the remaining rows and the end-of-stream marker.
+  void finish();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+/// Writes already built columns as one Arrow IPC stream, in kBatchRows record batches.
+void write_arrow_columns(std::ostream& out,
+                         const std::shared_ptr<const markql::ColumnarResult>& columns,
+                         const std::vector<std::string>& output_names);
+
+}  // namespace markql::cli
@@ -0,0 +1,332 @@
+#include "export/async_file_writer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "runtime/engine/relation_worker_lease.h"
+
+namespace markql::cli {
+
+namespace {
+
+int open_for_write(const std::string& path, bool exclusive) {
+#ifdef _WIN32
+  const int mode = exclusive ? _O_EXCL : _O_TRUNC;
+  return _open(path.c_str(), _O_WRONLY | _O_CREAT | mode | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  const int mode = exclusive ? O_EXCL : O_TRUNC;
+  return ::open(path.c_str(), O_WRONLY | O_CREAT | mode | O_CLOEXEC, 0644);
+#endif
+}
+
+/// Creates a new, uniquely named file next to `path` and stores its name in `temp_path`.
+/// Returns -1 with errno set on failure.
+int open_temp_for_write(const std::string& path, std::string& temp_path) {
+  static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+  const std::string prefix = path + ".tmp-" + std::to_string(_getpid()) + "-";
+#else
+  const std::string prefix = path + ".tmp-" + std::to_string(::getpid()) + "-";
+#endif
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    temp_path = prefix + std::to_string(counter.fetch_add(1));
+    const int fd = open_for_write(temp_path, true);
+    if (fd >= 0 || errno != EEXIST) return fd;
+  }
+  return -1;
+}
+
+/// Writes all of `data`, retrying short writes; returns false with errno set on failure.
+bool write_all(int fd, const std::string& data) {
+  const char* cursor = data.data();
+  size_t remaining = data.size();
+  while (remaining > 0) {
+#ifdef _WIN32
+    const unsigned int chunk = static_cast<unsigned int>(std::min<size_t>(remaining, 1u << 30));
+    const int written = _write(fd, cursor, chunk);
+#else
+    const ssize_t written = ::write(fd, cursor, remaining);
+#endif
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    cursor += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+bool sync_file(int fd) {
+#ifdef _WIN32
+  return _commit(fd) == 0;
+#else
+  return ::fsync(fd) == 0;
+#endif
+}
+
+bool close_file(int fd) {
+#ifdef _WIN32
+  return _close(fd) == 0;
+#else
+  return ::close(fd) == 0;
+#endif
+}
+
+/// Makes a rename into the directory holding `path` durable; a no-op on Windows.
+bool sync_parent_dir(const std::string& path) {
+#ifdef _WIN32
+  (void)path;
+  return true;
+#else
+  std::string dir = std::filesystem::path(path).parent_path().string();
+  if (dir.empty()) dir = ".";
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  const bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+#endif
+}
+
+/// Returns the file a finished export of `path` replaces by rename, or "" when the export must
+/// write `path` in place.
+std::string replace_target(const std::string& path) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::path target = path;
+  // WHY: rename replaces a symlink itself, so follow it and replace the file it names.
+  if (fs::is_symlink(fs::symlink_status(target, ec))) {
+    target = fs::weakly_canonical(target, ec);
+    if (ec || fs::is_symlink(fs::symlink_status(target, ec))) return "";
+  }
+  const fs::file_status status = fs::status(target, ec);
+  if (!fs::exists(status)) return target.string();
+  // WHY: devices and pipes such as /dev/stdout cannot be replaced, and a replaced hard-linked
+  // file would be split from its other names.
+  if (!fs::is_regular_file(status) || fs::hard_link_count(target, ec) != 1) return "";
+  return target.string();
+}
+
+/// Gives the temporary file `fd` at `temp_path` the owner, group and mode of `target`, if it
+/// exists. Returns false when the owner cannot be kept.
+bool adopt_target_metadata(int fd, const std::string& temp_path, const std::string& target) {
+  std::error_code ec;
+  const std::filesystem::file_status status = std::filesystem::status(target, ec);
+  if (!std::filesystem::exists(status)) return true;
+#ifndef _WIN32
+  struct stat want {};
+  struct stat have {};
+  if (::stat(target.c_str(), &want) != 0 || ::fstat(fd, &have) != 0) return false;
+  if ((want.st_uid != have.st_uid || want.st_gid != have.st_gid) &&
+      ::fchown(fd, want.st_uid, want.st_gid) != 0) {
+    return false;
+  }
+#else
+  (void)fd;
+#endif
+  std::filesystem::permissions(temp_path, status.permissions(), ec);
+  return true;
+}
+
+}  // namespace
+
+AsyncFileWriter::AsyncFileWriter(const std::string& path, Sync sync, Compression compression)
+    : path_(path), sync_(sync), compression_(compression), compressor_(compression) {
+  target_path_ = replace_target(path);
+  if (!target_path_.empty()) {
+    fd_ = open_temp_for_write(target_path_, temp_path_);
+    if (fd_ < 0) temp_path_.clear();
+    if (fd_ >= 0 && !adopt_target_metadata(fd_, temp_path_, target_path_)) {
+      // WHY: a replacement owned by someone else would change who owns the user's file.
+      close_file(fd_);
+      discard_temp();
+      target_path_.clear();
+    }
+  }
+  if (target_path_.empty()) fd_ = open_for_write(path, false);
+  if (fd_ < 0) throw std::runtime_error("Failed to open file for writing: " + path);
+  if (compression_ != Compression::None) {
+    // WHY: the lease counts the caller's own thread; that share goes to a compression worker
+    // since the caller is busy formatting rows and the writer thread mostly waits on I/O.
+    lease_ = std::make_unique<RelationWorkerLease>(
+        std::max<size_t>(1, std::thread::hardware_concurrency()));
+    const size_t workers = lease_->threads();
+    // WHY: two blocks per worker keep every worker busy while the writer drains the front.
+    max_queued_ = workers * 2;
+    for (size_t i = 0; i < workers; ++i) {
+      workers_.emplace_back([this] { compress_blocks(); });
+    }
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  if (fd_ < 0) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // WHY: the abandoned file is deleted, so blocks still queued need not be written.
+    if (error_.empty()) error_ = "Export abandoned: " + path_;
+  }
+  shutdown_threads();
+  close_file(fd_);
+  fd_ = -1;
+  discard_temp();
+}
+
+void AsyncFileWriter::submit(std::string& buffer) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return queue_.size() < max_queued_; });
+  if (!error_.empty()) throw std::runtime_error(error_);
+  if (buffer.empty()) return;
+  std::unique_ptr<Block> block;
+  if (spare_.empty()) {
+    block = std::make_unique<Block>();
+  } else {
+    block = std::move(spare_.back());
+    spare_.pop_back();
+  }
+  // WHY: swapping hands the caller a written block's buffer, so steady-state exports never
+  // reallocate.
+  block->data.swap(buffer);
+  block->ready = compression_ == Compression::None;
+  queue_.push_back(std::move(block));
+  cv_.notify_all();
+}
+
+void AsyncFileWriter::shutdown_threads() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) worker.join();
+  workers_.clear();
+  lease_.reset();
+  thread_.join();
+}
+
+void AsyncFileWriter::close() {
+  if (fd_ < 0) return;
+  shutdown_threads();
+  std::string failure = error_;
+  if (failure.empty() && sync_ == Sync::OnClose && !sync_file(fd_)) {
+    failure = "Failed to sync file: " + path_ + ": " + std::strerror(errno);
+  }
+  if (!close_file(fd_) && failure.empty()) {
+    failure = "Failed to write file: " + path_ + ": " + std::strerror(errno);
+  }
+  fd_ = -1;
+  if (failure.empty() && !temp_path_.empty()) {
+    std::error_code ec;
+    std::filesystem::rename(temp_path_, target_path_, ec);
+    if (ec) {
+      failure = "Failed to replace file: " + path_ + ": " + ec.message();
+    } else {
+      temp_path_.clear();
+      if (sync_ == Sync::OnClose && !sync_parent_dir(target_path_)) {
+        failure = "Failed to sync directory of file: " + path_ + ": " + std::strerror(errno);
+      }
+    }
+  }
+  if (!failure.empty()) {
+    discard_temp();
+    throw std::runtime_error(failure);
+  }
+}
+
+void AsyncFileWriter::discard_temp() {
+  if (temp_path_.empty()) return;
+  std::error_code ec;
+  std::filesystem::remove(temp_path_, ec);
+  temp_path_.clear();
+}
+
+void AsyncFileWriter::run() {
+  auto write_bytes = [this](const std::string& bytes) {
+    if (write_all(fd_, bytes)) return std::string();
+    return "Failed to write file: " + path_ + ": " + std::strerror(errno);
+  };
+  std::string failure = write_bytes(compressor_.header());
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (error_.empty()) error_ = failure;
+  while (true) {
+    cv_.wait(lock, [this] {
+      return (!queue_.empty() && queue_.front()->ready) || (stop_ && queue_.empty());
+    });
+    if (queue_.empty()) break;
+    Block& block = *queue_.front();
+    const bool failed = !error_.empty();
+    lock.unlock();
+    failure.clear();
+    if (!failed) {
+      if (compression_ == Compression::None) {
+        failure = write_bytes(block.data);
+      } else {
+        compressor_.add(block.compressed);
+        failure = write_bytes(block.compressed.bytes);
+      }
+    }
+    block.data.clear();
+    block.compressed.bytes.clear();
+    lock.lock();
+    if (!failure.empty() && error_.empty()) error_ = failure;
+    block.claimed = false;
+    block.ready = false;
+    spare_.push_back(std::move(queue_.front()));
+    queue_.pop_front();
+    cv_.notify_all();
+  }
+  const bool failed = !error_.empty();
+  lock.unlock();
+  failure = failed ? std::string() : write_bytes(compressor_.trailer());
+  lock.lock();
+  if (!failure.empty() && error_.empty()) error_ = failure;
+}
+
+void AsyncFileWriter::compress_blocks() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Block* block = nullptr;
+    cv_.wait(lock, [&] {
+      for (auto& queued : queue_) {
+        if (!queued->claimed) {
+          block = queued.get();
+          return true;
+        }
+      }
+      return stop_;
+    });
+    if (block == nullptr) return;
+    block->claimed = true;
+    lock.unlock();
+    std::string failure;
+    try {
+      compressor_.compress(block->data, block->compressed);
+    } catch (const std::exception& ex) {
+      failure = ex.what();
+    }
+    lock.lock();
+    if (!failure.empty() && error_.empty()) error_ = failure;
+    block->ready = true;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace markql::cli
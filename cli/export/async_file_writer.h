@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "export/block_compressor.h"
+
+namespace markql {
+class RelationWorkerLease;
+}  // namespace markql
+
+namespace markql::cli {
+
+/// Writes a file from a background thread: while the thread write(2)s one buffer, the caller
+/// formats the next one. With compression, each submitted buffer is compressed as an
+/// independent block on a pool of worker threads leased from the relation thread budget
+/// (at least one) and the blocks are written in submission order. Open failures and write/fsync errors throw std::runtime_error; an error on a
+/// background thread is reported by the next submit() or close().
+/// Bytes go to a temporary file next to `path` that replaces it only when close() succeeds, so
+/// a failed or abandoned export leaves an existing file untouched. A symlinked `path` replaces
+/// the file the link names, keeping its owner and mode. Devices, pipes, hard-linked files and
+/// files whose owner cannot be kept are written in place.
+class AsyncFileWriter {
+ public:
+  /// OnClose fsyncs the file before close() returns, so a completed export survives a crash.
+  enum class Sync { None, OnClose };
+
+  AsyncFileWriter(const std::string& path, Sync sync = Sync::None,
+                  Compression compression = Compression::None);
+  /// Without a successful close(), stops writing and removes the temporary file.
+  ~AsyncFileWriter();
+
+  AsyncFileWriter(const AsyncFileWriter&) = delete;
+  AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+  /// Queues `buffer` for writing and hands back an empty buffer with the capacity of one
+  /// written earlier. Blocks only while the queue is full: one buffer without compression,
+  /// two per worker with it.
+  void submit(std::string& buffer);
+  /// Writes everything queued, fsyncs when requested, closes the file and moves it to `path`.
+  /// On failure the temporary file is removed and `path` keeps its previous contents.
+  void close();
+
+ private:
+  struct Block {
+    std::string data;
+    CompressedBlock compressed;
+    /// Set when a worker takes the block, so each block is compressed once.
+    bool claimed = false;
+    /// Set when the block's bytes are final and it may be written.
+    bool ready = false;
+  };
+
+  void run();
+  void compress_blocks();
+  void shutdown_threads();
+  void discard_temp();
+
+  std::string path_;
+  /// The file close() replaces: path_, or the file it links to; empty when writing in place.
+  std::string target_path_;
+  /// Where bytes are written until close() renames it to target_path_; empty when in place.
+  std::string temp_path_;
+  Sync sync_;
+  Compression compression_;
+  BlockCompressor compressor_;
+  int fd_ = -1;
+  size_t max_queued_ = 1;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  /// Blocks in submission order; the front one is next to be written.
+  std::deque<std::unique_ptr<Block>> queue_;
+  /// Written blocks kept for their buffers' capacity.
+  std::vector<std::unique_ptr<Block>> spare_;
+  bool stop_ = false;
+  std::string error_;
+  std::thread thread_;
+  /// Held while the compression workers run, so queries streaming into the export and the
+  /// workers share one thread budget.
+  std::unique_ptr<RelationWorkerLease> lease_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace markql::cli
@@ -0,0 +1,180 @@
+#include "export/block_compressor.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#ifdef MARKQL_USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MARKQL_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace markql::cli {
+
+namespace {
+
+bool ends_with(const std::string& value, std::string_view suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void append_le32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+#ifdef MARKQL_USE_ZLIB
+
+/// Raw-deflates `input` and ends with a sync flush, leaving the stream byte aligned and open.
+void deflate_block(std::string_view input, std::string& out) {
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    throw std::runtime_error("Failed to initialize gzip compression");
+  }
+  const char* next = input.data();
+  size_t remaining = input.size();
+  out.clear();
+  size_t used = 0;
+  int status = Z_OK;
+  do {
+    const uInt chunk = static_cast<uInt>(
+        std::min<size_t>(remaining, std::numeric_limits<uInt>::max()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(next));
+    stream.avail_in = chunk;
+    next += chunk;
+    remaining -= chunk;
+    const int flush = remaining == 0 ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    do {
+      if (out.size() - used < 64) {
+        out.resize(used + deflateBound(&stream, stream.avail_in) + 64);
+      }
+      stream.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+      stream.avail_out = static_cast<uInt>(
+          std::min<size_t>(out.size() - used, std::numeric_limits<uInt>::max()));
+      const uInt before = stream.avail_out;
+      status = deflate(&stream, flush);
+      used += before - stream.avail_out;
+    } while (status == Z_OK && stream.avail_out == 0);
+  } while (status == Z_OK && remaining > 0);
+  deflateEnd(&stream);
+  if (status != Z_OK && status != Z_BUF_ERROR) {
+    throw std::runtime_error("gzip compression failed");
+  }
+  out.resize(used);
+}
+
+#endif
+
+}  // namespace
+
+Compression compression_from_path(const std::string& path) {
+  if (ends_with(path, ".gz")) return Compression::Gzip;
+  if (ends_with(path, ".zst")) return Compression::Zstd;
+  return Compression::None;
+}
+
+Compression export_compression(markql::QueryResult::ExportSink::Compression option,
+                               const std::string& path) {
+  using Option = markql::QueryResult::ExportSink::Compression;
+  switch (option) {
+    case Option::None:
+      return Compression::None;
+    case Option::Gzip:
+      return Compression::Gzip;
+    case Option::Zstd:
+      return Compression::Zstd;
+    case Option::Auto:
+      break;
+  }
+  return compression_from_path(path);
+}
+
+BlockCompressor::BlockCompressor(Compression compression) : compression_(compression) {
+#ifndef MARKQL_USE_ZLIB
+  if (compression == Compression::Gzip) {
+    throw std::runtime_error("gzip export requires zlib (build with MARKQL_WITH_ZLIB=ON)");
+  }
+#endif
+#ifndef MARKQL_USE_ZSTD
+  if (compression == Compression::Zstd) {
+    throw std::runtime_error("zstd export requires libzstd (build with MARKQL_WITH_ZSTD=ON)");
+  }
+#endif
+}
+
+void BlockCompressor::compress(std::string_view input, CompressedBlock& out) const {
+  out.input_size = input.size();
+  out.crc = 0;
+  switch (compression_) {
+    case Compression::None:
+      out.bytes.assign(input);
+      return;
+    case Compression::Gzip:
+#ifdef MARKQL_USE_ZLIB
+      deflate_block(input, out.bytes);
+      // WHY: crc32() takes a uInt length, so long blocks are summed in pieces.
+      for (size_t offset = 0; offset < input.size();) {
+        const uInt chunk = static_cast<uInt>(
+            std::min<size_t>(input.size() - offset, std::numeric_limits<uInt>::max()));
+        out.crc = static_cast<uint32_t>(
+            crc32(out.crc, reinterpret_cast<const Bytef*>(input.data() + offset), chunk));
+        offset += chunk;
+      }
+#endif
+      return;
+    case Compression::Zstd:
+#ifdef MARKQL_USE_ZSTD
+    {
+      out.bytes.resize(ZSTD_compressBound(input.size()));
+      const size_t written = ZSTD_compress(out.bytes.data(), out.bytes.size(), input.data(),
+                                           input.size(), ZSTD_CLEVEL_DEFAULT);
+      if (ZSTD_isError(written)) {
+        throw std::runtime_error(std::string("zstd compression failed: ") +
+                                 ZSTD_getErrorName(written));
+      }
+      out.bytes.resize(written);
+    }
+#endif
+      return;
+  }
+}
+
+std::string BlockCompressor::header() const {
+  if (compression_ != Compression::Gzip) return "";
+  // Magic, deflate, no flags, no mtime, no extra flags, unknown OS.
+  return std::string("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+}
+
+void BlockCompressor::add(const CompressedBlock& block) {
+#ifdef MARKQL_USE_ZLIB
+  if (compression_ == Compression::Gzip) {
+    crc_ = static_cast<uint32_t>(
+        crc32_combine(crc_, block.crc, static_cast<z_off_t>(block.input_size)));
+  }
+#endif
+  size_ += block.input_size;
+  ++blocks_;
+}
+
+std::string BlockCompressor::trailer() const {
+  if (compression_ == Compression::Gzip) {
+    // An empty final fixed-Huffman block closes the deflate stream the blocks left open.
+    std::string out("\x03\x00", 2);
+    append_le32(out, crc_);
+    append_le32(out, static_cast<uint32_t>(size_ & 0xFFFFFFFFu));
+    return out;
+  }
+  if (compression_ == Compression::Zstd && blocks_ == 0) {
+    // zstd readers reject an empty file, so an empty export is one empty frame.
+    CompressedBlock empty;
+    compress("", empty);
+    return empty.bytes;
+  }
+  return "";
+}
+
+}  // namespace markql::cli
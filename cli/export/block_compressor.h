@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "markql/markql.h"
+
+namespace markql::cli {
+
+/// Whole-file compression for CSV, JSON and NDJSON exports.
+enum class Compression { None, Gzip, Zstd };
+
+/// ".gz" selects gzip and ".zst" zstd; any other path is written uncompressed.
+Compression compression_from_path(const std::string& path);
+/// The COMPRESSION option when the query gives one, otherwise the suffix of `path`.
+Compression export_compression(markql::QueryResult::ExportSink::Compression option,
+                               const std::string& path);
+
+/// One block compressed on its own, with what the stream trailer needs to know about it.
+struct CompressedBlock {
+  std::string bytes;
+  uint32_t crc = 0;
+  uint64_t input_size = 0;
+};
+
+/// Compresses a stream as independent blocks, so blocks can be compressed on several threads
+/// and written in order (the pigz approach). gzip output is one member: each block is a raw
+/// deflate run ended with a sync flush, and the trailer combines the blocks' CRCs. zstd output
+/// is one frame per block, which zstd readers decode as a single stream.
+/// compress() may run on any thread; header(), add() and trailer() run on the writing thread
+/// in block order.
+class BlockCompressor {
+ public:
+  /// Throws std::runtime_error when this build has no library for `compression`.
+  explicit BlockCompressor(Compression compression);
+
+  void compress(std::string_view input, CompressedBlock& out) const;
+  /// Bytes that start the stream.
+  std::string header() const;
+  /// Records a block as it is written.
+  void add(const CompressedBlock& block);
+  /// Bytes that end the stream.
+  std::string trailer() const;
+
+ private:
+  Compression compression_;
+  uint32_t crc_ = 0;
+  uint64_t size_ = 0;
+  uint64_t blocks_ = 0;
+};
+
+}  // namespace markql::cli
@@ -6,13 +6,20 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-#ifdef MARKQL_USE_ARROW
-#include <arrow/api.h>
-#include <arrow/io/api.h>
-#include <parquet/arrow/writer.h>
+#include "export/arrow_ipc_writer.h"
+#include "export/parquet_writer.h"
+#include "markql/columnar_result.h"
+#include "markql/json_writer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 namespace markql::cli {
@@ -38,9 +45,14 @@ std::string attributes_to_string(const std::unordered_map<std::string, std::stri
   return oss.str();
 }
 
+/// One cell's text. String fields point into the row so large inner_html values are not
+/// copied per cell; numbers and maps are rendered into `owned`.
 struct CellValue {
-  std::string value;
+  const std::string* ref = nullptr;
+  std::string owned;
   bool is_null = false;
+
+  std::string_view value() const { return ref != nullptr ? std::string_view(*ref) : owned; }
 };
 
 /// Serializes TFIDF term scores for CSV export cells.
@@ -62,112 +74,108 @@ std::string term_scores_to_string(const std::unordered_map<std::string, double>&
   return oss.str();
 }
 
-CellValue field_value(const markql::QueryResultRow& row, const std::string& field) {
-  if (field == "node_id") return {std::to_string(row.node_id), false};
-  if (field == "count") return {std::to_string(row.node_id), false};
-  if (field == "tag") return {row.tag, false};
-  if (field == "text") return {row.text, false};
-  if (field == "inner_html") return {row.inner_html, false};
+CellValue field_value(const markql::QueryResultRow& row, const std::string& field,
+                      const markql::ComputedFieldLookup& computed) {
+  if (field == "node_id") return {nullptr, std::to_string(row.node_id), false};
+  if (field == "count") return {nullptr, std::to_string(row.node_id), false};
+  if (field == "tag") return {&row.tag, {}, false};
+  if (field == "text") return {&row.text, {}, false};
+  if (field == "inner_html") return {&row.inner_html, {}, false};
   if (field == "parent_id") {
-    if (!row.parent_id.has_value()) return {"", true};
-    return {std::to_string(*row.parent_id), false};
-  }
-  if (field == "max_depth") return {std::to_string(row.max_depth), false};
-  if (field == "doc_order") return {std::to_string(row.doc_order), false};
-  if (field == "source_uri") return {row.source_uri, false};
-  if (field == "attributes") return {attributes_to_string(row.attributes), false};
-  if (field == "terms_score") return {term_scores_to_string(row.term_scores), false};
-  auto computed = row.computed_fields.find(field);
-  if (computed != row.computed_fields.end()) return {computed->second, false};
+    if (!row.parent_id.has_value()) return {nullptr, {}, true};
+    return {nullptr, std::to_string(*row.parent_id), false};
+  }
+  if (field == "max_depth") return {nullptr, std::to_string(row.max_depth), false};
+  if (field == "doc_order") return {nullptr, std::to_string(row.doc_order), false};
+  if (field == "source_uri") return {&row.source_uri, {}, false};
+  if (field == "attributes") return {nullptr, attributes_to_string(row.attributes), false};
+  if (field == "terms_score") return {nullptr, term_scores_to_string(row.term_scores), false};
+  if (const std::string* value = computed.find(row.computed_fields)) return {value, {}, false};
   auto it = row.attributes.find(field);
-  if (it == row.attributes.end()) return {"", true};
-  return {it->second, false};
+  if (it == row.attributes.end()) return {nullptr, {}, true};
+  return {&it->second, {}, false};
 }
 
-std::string csv_escape(const std::string& value) {
-  bool needs_quotes = false;
-  for (char c : value) {
-    if (c == ',' || c == '"' || c == '\n' || c == '\r') {
-      needs_quotes = true;
-      break;
-    }
-  }
-  if (!needs_quotes) return value;
-  std::string out;
-  out.reserve(value.size() + 2);
-  out.push_back('"');
-  for (char c : value) {
-    if (c == '"') {
-      out.push_back('"');
-      out.push_back('"');
-    } else {
-      out.push_back(c);
-    }
+/// True when `value` contains ',', '"', '\n' or '\r', which force a CSV cell to be quoted.
+/// Scans 16 bytes at a time where SSE2 or NEON is available.
+bool csv_needs_quotes(std::string_view value) {
+  const char* data = value.data();
+  const size_t size = value.size();
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i hits =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+                     _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage_return)));
+    if (_mm_movemask_epi8(hits) != 0) return true;
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t comma = vdupq_n_u8(',');
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t newline = vdupq_n_u8('\n');
+  const uint8x16_t carriage_return = vdupq_n_u8('\r');
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+    const uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(v, comma), vceqq_u8(v, quote)),
+                                     vorrq_u8(vceqq_u8(v, newline), vceqq_u8(v, carriage_return)));
+    if (vmaxvq_u8(hits) != 0) return true;
   }
-  out.push_back('"');
-  return out;
-}
-
-std::string json_escape(const std::string& value) {
-  std::string out;
-  out.reserve(value.size() + 8);
-  for (char c : value) {
-    switch (c) {
-      case '\"':
-        out += "\\\"";
-        break;
-      case '\\':
-        out += "\\\\";
-        break;
-      case '\b':
-        out += "\\b";
-        break;
-      case '\f':
-        out += "\\f";
-        break;
-      case '\n':
-        out += "\\n";
-        break;
-      case '\r':
-        out += "\\r";
-        break;
-      case '\t':
-        out += "\\t";
-        break;
-      default:
-        if (static_cast<unsigned char>(c) < 0x20) {
-          std::ostringstream hex;
-          hex << "\\u" << std::hex << std::setw(4) << std::setfill('0')
-              << static_cast<int>(static_cast<unsigned char>(c));
-          out += hex.str();
-        } else {
-          out.push_back(c);
-        }
-        break;
-    }
+#endif
+  for (; i < size; ++i) {
+    const char c = data[i];
+    if (c == ',' || c == '"' || c == '\n' || c == '\r') return true;
   }
-  return out;
+  return false;
+}
+
+void append_csv_escaped(std::string& out, std::string_view value) {
+  if (!csv_needs_quotes(value)) {
+    out += value;
+    return;
+  }
+  out += '"';
+  // Copy the runs between quotes whole, doubling each quote.
+  size_t start = 0;
+  for (size_t quote = value.find('"'); quote != std::string_view::npos;
+       quote = value.find('"', start)) {
+    out.append(value.data() + start, quote + 1 - start);
+    out += '"';
+    start = quote + 1;
+  }
+  out.append(value.data() + start, value.size() - start);
+  out += '"';
 }
 
-void write_json_row(std::ostream& out, const markql::QueryResultRow& row,
-                    const std::vector<markql::ColumnNameMapping>& schema) {
-  out << "{";
+void append_json_row(std::string& out, const markql::QueryResultRow& row,
+                     const std::vector<markql::ColumnNameMapping>& schema,
+                     const std::vector<markql::ComputedFieldLookup>& computed) {
+  out += '{';
   for (size_t i = 0; i < schema.size(); ++i) {
-    if (i > 0) out << ",";
-    out << "\"" << json_escape(schema[i].output_name) << "\":";
-    CellValue cell = field_value(row, schema[i].raw_name);
+    if (i > 0) out += ',';
+    markql::append_json_string(out, schema[i].output_name);
+    out += ':';
+    CellValue cell = field_value(row, schema[i].raw_name, computed[i]);
     if (cell.is_null) {
-      out << "null";
+      out += "null";
     } else {
-      out << "\"" << json_escape(cell.value) << "\"";
+      markql::append_json_string(out, cell.value());
     }
   }
-  out << "}";
+  out += '}';
 }
 
+// WHY: one stream write per block instead of several per cell keeps large exports I/O bound
+// rather than bound by ostream call overhead.
+constexpr size_t kRowStreamFlushBytes = size_t{1} << 20;
+
 bool validate_rectangular(const markql::QueryResult& result, std::string& error) {
   if (result.to_table || !result.tables.empty()) {
-    error = "TO CSV/PARQUET/JSON/NDJSON does not support TO TABLE() results";
+    error = "TO CSV/PARQUET/JSON/NDJSON/ARROW does not support TO TABLE() results";
     return false;
   }
   if (result.columns.empty()) {
@@ -184,266 +192,329 @@ std::vector<markql::ColumnNameMapping> result_schema(const markql::QueryResult&
 
 }  // namespace
 
-static std::vector<std::string> table_columns(const markql::QueryResult::TableResult& table);
+RowStreamWriter::RowStreamWriter(std::ostream& out, Format format,
+                                 std::vector<markql::ColumnNameMapping> schema)
+    : out_(&out), format_(format), schema_(std::move(schema)) {
+  for (const auto& mapping : schema_) computed_.emplace_back(mapping.raw_name);
+}
 
-bool write_csv(std::ostream& out, const markql::QueryResult& result, std::string& error,
-               markql::ColumnNameMode colname_mode) {
-  if (!validate_rectangular(result, error)) return false;
-  std::vector<markql::ColumnNameMapping> schema = result_schema(result, colname_mode);
-  for (size_t i = 0; i < schema.size(); ++i) {
-    if (i > 0) out << ",";
-    out << csv_escape(schema[i].output_name);
-  }
-  out << "\n";
-  for (const auto& row : result.rows) {
-    for (size_t i = 0; i < schema.size(); ++i) {
-      if (i > 0) out << ",";
-      CellValue cell = field_value(row, schema[i].raw_name);
-      const std::string& value = cell.is_null ? "" : cell.value;
-      out << csv_escape(value);
+RowStreamWriter::RowStreamWriter(std::unique_ptr<AsyncFileWriter> file, Format format,
+                                 std::vector<markql::ColumnNameMapping> schema)
+    : file_(std::move(file)), format_(format), schema_(std::move(schema)) {
+  for (const auto& mapping : schema_) computed_.emplace_back(mapping.raw_name);
+}
+
+void RowStreamWriter::begin() {
+  if (format_ == Format::Csv) {
+    for (size_t i = 0; i < schema_.size(); ++i) {
+      if (i > 0) buffer_ += ',';
+      append_csv_escaped(buffer_, schema_[i].output_name);
     }
-    out << "\n";
+    buffer_ += '\n';
+  } else if (format_ == Format::Json) {
+    buffer_ += '[';
   }
-  return true;
 }
 
-bool write_csv(const markql::QueryResult& result, const std::string& path, std::string& error,
-               markql::ColumnNameMode colname_mode) {
-  std::ofstream file;
-  std::ostream* out = &std::cout;
-  if (!path.empty()) {
-    file.open(path, std::ios::binary);
-    if (!file) {
-      error = "Failed to open file for writing: " + path;
-      return false;
+void RowStreamWriter::write_row(const markql::QueryResultRow& row) {
+  if (format_ == Format::Csv) {
+    for (size_t i = 0; i < schema_.size(); ++i) {
+      if (i > 0) buffer_ += ',';
+      CellValue cell = field_value(row, schema_[i].raw_name, computed_[i]);
+      if (!cell.is_null) append_csv_escaped(buffer_, cell.value());
     }
-    out = &file;
+    buffer_ += '\n';
+  } else {
+    // WHY: write delimiters incrementally so large results do not require buffering.
+    if (format_ == Format::Json && !first_row_) buffer_ += ',';
+    append_json_row(buffer_, row, schema_, computed_);
+    if (format_ == Format::Ndjson) buffer_ += '\n';
+  }
+  first_row_ = false;
+  if (buffer_.size() >= kRowStreamFlushBytes) flush();
+}
+
+void RowStreamWriter::finish() {
+  if (format_ == Format::Json) buffer_ += "]\n";
+  flush();
+  if (file_ != nullptr) {
+    file_->close();
+  } else {
+    out_->flush();
   }
-  return write_csv(*out, result, error, colname_mode);
 }
 
-bool write_json(const markql::QueryResult& result, const std::string& path, std::string& error,
+void RowStreamWriter::flush() {
+  if (file_ != nullptr) {
+    file_->submit(buffer_);
+    return;
+  }
+  out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+}
+
+namespace {
+
+bool write_rows(std::ostream& out, const markql::QueryResult& result,
+                RowStreamWriter::Format format, std::string& error,
                 markql::ColumnNameMode colname_mode) {
   if (!validate_rectangular(result, error)) return false;
-  std::vector<markql::ColumnNameMapping> schema = result_schema(result, colname_mode);
-  std::ofstream file;
-  std::ostream* out = &std::cout;
-  if (!path.empty()) {
-    file.open(path, std::ios::binary);
-    if (!file) {
-      error = "Failed to open file for writing: " + path;
-      return false;
-    }
-    out = &file;
-  }
-  // WHY: write delimiters incrementally so large results do not require buffering.
-  *out << "[";
-  bool first = true;
-  for (const auto& row : result.rows) {
-    if (!first) *out << ",";
-    first = false;
-    write_json_row(*out, row, schema);
+  RowStreamWriter writer(out, format, result_schema(result, colname_mode));
+  writer.begin();
+  for (const auto& row : result.rows) writer.write_row(row);
+  writer.finish();
+  return true;
+}
+
+bool write_rows(const markql::QueryResult& result, const std::string& path,
+                RowStreamWriter::Format format, std::string& error,
+                markql::ColumnNameMode colname_mode) {
+  if (!validate_rectangular(result, error)) return false;
+  if (path.empty()) return write_rows(std::cout, result, format, error, colname_mode);
+  try {
+    const auto sync = result.export_sink.fsync ? AsyncFileWriter::Sync::OnClose
+                                               : AsyncFileWriter::Sync::None;
+    const Compression compression = export_compression(result.export_sink.compression, path);
+    RowStreamWriter writer(std::make_unique<AsyncFileWriter>(path, sync, compression), format,
+                           result_schema(result, colname_mode));
+    writer.begin();
+    for (const auto& row : result.rows) writer.write_row(row);
+    writer.finish();
+  } catch (const std::runtime_error& ex) {
+    error = ex.what();
+    return false;
   }
-  *out << "]\n";
   return true;
 }
 
+}  // namespace
+
+bool write_csv(std::ostream& out, const markql::QueryResult& result, std::string& error,
+               markql::ColumnNameMode colname_mode) {
+  return write_rows(out, result, RowStreamWriter::Format::Csv, error, colname_mode);
+}
+
+bool write_csv(const markql::QueryResult& result, const std::string& path, std::string& error,
+               markql::ColumnNameMode colname_mode) {
+  return write_rows(result, path, RowStreamWriter::Format::Csv, error, colname_mode);
+}
+
+bool write_json(const markql::QueryResult& result, const std::string& path, std::string& error,
+                markql::ColumnNameMode colname_mode) {
+  return write_rows(result, path, RowStreamWriter::Format::Json, error, colname_mode);
+}
+
 bool write_ndjson(const markql::QueryResult& result, const std::string& path, std::string& error,
                   markql::ColumnNameMode colname_mode) {
-  if (!validate_rectangular(result, error)) return false;
-  std::vector<markql::ColumnNameMapping> schema = result_schema(result, colname_mode);
-  std::ofstream file;
-  std::ostream* out = &std::cout;
-  if (!path.empty()) {
-    file.open(path, std::ios::binary);
-    if (!file) {
-      error = "Failed to open file for writing: " + path;
-      return false;
+  return write_rows(result, path, RowStreamWriter::Format::Ndjson, error, colname_mode);
+}
+
+TableCsvWriter::TableCsvWriter(std::unique_ptr<AsyncFileWriter> file) : file_(std::move(file)) {}
+
+void TableCsvWriter::write_row(const std::vector<std::string>& cells) {
+  for (size_t i = 0; i < cells.size(); ++i) {
+    if (i > 0) buffer_ += ',';
+    append_csv_escaped(buffer_, cells[i]);
+  }
+  buffer_ += '\n';
+  if (buffer_.size() >= kRowStreamFlushBytes) file_->submit(buffer_);
+}
+
+void TableCsvWriter::finish() {
+  file_->submit(buffer_);
+  file_->close();
+}
+
+std::vector<std::string> table_csv_header(const markql::QueryResult& result,
+                                          size_t column_count) {
+  if (result.table_options.format == markql::QueryResult::TableOptions::Format::Sparse) {
+    std::vector<std::string> header_row = {"row_index", "col_index"};
+    if (result.table_has_header) {
+      header_row.push_back("header");
     }
-    out = &file;
+    header_row.push_back("value");
+    return header_row;
   }
-  for (const auto& row : result.rows) {
-    write_json_row(*out, row, schema);
-    *out << "\n";
+  if (result.table_has_header) return {};
+  std::vector<std::string> cols;
+  cols.reserve(column_count);
+  for (size_t i = 0; i < column_count; ++i) {
+    cols.push_back("col" + std::to_string(i + 1));
   }
-  return true;
+  return cols;
 }
 
-bool write_table_csv(const markql::QueryResult::TableResult& table, const std::string& path,
-                     std::string& error, bool table_has_header) {
-  std::ofstream out(path, std::ios::binary);
-  if (!out) {
-    error = "Failed to open file for writing: " + path;
-    return false;
+TableColumnsBuilder::TableColumnsBuilder(size_t column_count)
+    : columns_(std::make_shared<markql::ColumnarResult>()) {
+  columns_->columns.resize(column_count);
+  names_.reserve(column_count);
+  for (size_t i = 0; i < column_count; ++i) {
+    names_.push_back("col" + std::to_string(i + 1));
+    columns_->columns[i].name = names_.back();
+    columns_->columns[i].type = markql::ColumnarColumn::Type::Utf8;
   }
-  if (!table_has_header) {
-    std::vector<std::string> cols = table_columns(table);
-    if (!cols.empty()) {
-      for (size_t i = 0; i < cols.size(); ++i) {
-        if (i > 0) out << ",";
-        out << csv_escape(cols[i]);
-      }
-      out << "\n";
+}
+
+void TableColumnsBuilder::add_row(const std::vector<std::string>& cells) {
+  const size_t row = static_cast<size_t>(columns_->num_rows++);
+  for (size_t i = 0; i < columns_->columns.size(); ++i) {
+    markql::ColumnarColumn& column = columns_->columns[i];
+    const bool present = i < cells.size();
+    // The bitmap is only allocated once the column's first null shows up.
+    if (!present && column.validity.empty()) {
+      column.validity.assign(row / 8 + 1, 0xFF);
+    } else if (!column.validity.empty() && column.validity.size() < row / 8 + 1) {
+      column.validity.push_back(0xFF);
     }
-  }
-  for (const auto& row : table.rows) {
-    for (size_t i = 0; i < row.size(); ++i) {
-      if (i > 0) out << ",";
-      out << csv_escape(row[i]);
+    if (!present) {
+      column.validity[row / 8] &= static_cast<uint8_t>(~(1u << (row % 8)));
+      ++column.null_count;
     }
-    out << "\n";
+    column.strings.append(present ? std::string_view(cells[i]) : std::string_view());
+  }
+}
+
+std::shared_ptr<const markql::ColumnarResult> TableColumnsBuilder::finish() {
+  return std::move(columns_);
+}
+
+namespace {
+
+bool write_table_csv_file(const markql::QueryResult::TableResult& table,
+                          const std::vector<std::string>& header_row, const std::string& path,
+                          AsyncFileWriter::Sync sync, Compression compression,
+                          std::string& error) {
+  try {
+    TableCsvWriter writer(std::make_unique<AsyncFileWriter>(path, sync, compression));
+    if (!header_row.empty()) writer.write_row(header_row);
+    for (const auto& row : table.rows) writer.write_row(row);
+    writer.finish();
+  } catch (const std::runtime_error& ex) {
+    error = ex.what();
+    return false;
   }
   return true;
 }
 
-static std::vector<std::string> table_columns(const markql::QueryResult::TableResult& table) {
+size_t table_column_count(const markql::QueryResult::TableResult& table) {
   size_t max_cols = 0;
   for (const auto& row : table.rows) {
     if (row.size() > max_cols) {
       max_cols = row.size();
     }
   }
-  std::vector<std::string> cols;
-  cols.reserve(max_cols);
-  for (size_t i = 0; i < max_cols; ++i) {
-    cols.push_back("col" + std::to_string(i + 1));
+  return max_cols;
+}
+
+/// TO TABLE() cells as text columns col1..colN; cells missing from short rows are null.
+TableColumnsBuilder table_columns(const markql::QueryResult::TableResult& table) {
+  TableColumnsBuilder columns(table_column_count(table));
+  for (const auto& row : table.rows) columns.add_row(row);
+  return columns;
+}
+
+}  // namespace
+
+bool write_table_csv(const markql::QueryResult::TableResult& table, const std::string& path,
+                     std::string& error, bool table_has_header) {
+  std::vector<std::string> header_row;
+  if (!table_has_header) {
+    markql::QueryResult header;
+    header.table_has_header = false;
+    header_row = table_csv_header(header, table_column_count(table));
   }
-  return cols;
+  return write_table_csv_file(table, header_row, path, AsyncFileWriter::Sync::None,
+                              compression_from_path(path), error);
 }
 
 bool write_parquet(const markql::QueryResult& result, const std::string& path, std::string& error,
                    markql::ColumnNameMode colname_mode) {
   if (!validate_rectangular(result, error)) return false;
-  std::vector<markql::ColumnNameMapping> col_schema = result_schema(result, colname_mode);
-#ifdef MARKQL_USE_ARROW
-  std::vector<std::shared_ptr<arrow::ArrayBuilder>> builders;
-  builders.reserve(col_schema.size());
-  for (size_t i = 0; i < col_schema.size(); ++i) {
-    builders.push_back(std::make_shared<arrow::StringBuilder>());
-  }
-  for (const auto& row : result.rows) {
-    for (size_t i = 0; i < col_schema.size(); ++i) {
-      CellValue cell = field_value(row, col_schema[i].raw_name);
-      auto builder = std::static_pointer_cast<arrow::StringBuilder>(builders[i]);
-      if (cell.is_null) {
-        auto st = builder->AppendNull();
-        if (!st.ok()) {
-          error = st.ToString();
-          return false;
-        }
-      } else {
-        auto st = builder->Append(cell.value);
-        if (!st.ok()) {
-          error = st.ToString();
-          return false;
-        }
-      }
-    }
-  }
-  std::vector<std::shared_ptr<arrow::Field>> fields;
-  std::vector<std::shared_ptr<arrow::Array>> arrays;
-  fields.reserve(col_schema.size());
-  arrays.reserve(col_schema.size());
-  for (size_t i = 0; i < col_schema.size(); ++i) {
-    fields.push_back(arrow::field(col_schema[i].output_name, arrow::utf8(), true));
-    auto builder = std::static_pointer_cast<arrow::StringBuilder>(builders[i]);
-    std::shared_ptr<arrow::Array> array;
-    auto st = builder->Finish(&array);
-    if (!st.ok()) {
-      error = st.ToString();
-      return false;
-    }
-    arrays.push_back(array);
-  }
-  auto arrow_schema = arrow::schema(fields);
-  auto table = arrow::Table::Make(arrow_schema, arrays);
-  auto output_res = arrow::io::FileOutputStream::Open(path);
-  if (!output_res.ok()) {
-    error = output_res.status().ToString();
-    return false;
+  std::vector<std::string> names;
+  for (const auto& mapping : result_schema(result, colname_mode)) {
+    names.push_back(mapping.output_name);
   }
-  auto output = *output_res;
-  auto st = parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), output, 1024);
-  if (!st.ok()) {
-    error = st.ToString();
+  auto columns = std::make_shared<const markql::ColumnarResult>(markql::to_columnar_result(result));
+  return write_parquet_columns(columns, names, result.export_sink.parquet, path, error);
+}
+
+bool write_table_parquet(const markql::QueryResult::TableResult& table, const std::string& path,
+                         std::string& error,
+                         const markql::QueryResult::ExportSink::ParquetOptions& options) {
+  markql::QueryResult::ExportSink sink;
+  sink.kind = markql::QueryResult::ExportSink::Kind::Parquet;
+  sink.path = path;
+  sink.parquet = options;
+  TableColumnsBuilder columns = table_columns(table);
+  return write_table_columns(columns, sink, error);
+}
+
+bool write_arrow(std::ostream& out, const markql::QueryResult& result, std::string& error,
+                 markql::ColumnNameMode colname_mode) {
+  if (!validate_rectangular(result, error)) return false;
+  std::vector<std::string> names;
+  for (const auto& mapping : result_schema(result, colname_mode)) {
+    names.push_back(mapping.output_name);
+  }
+  try {
+    ArrowIpcStreamWriter writer(out, std::move(names));
+    writer.begin(result);
+    for (const auto& row : result.rows) writer.write_row(row);
+    writer.finish();
+  } catch (const std::exception& ex) {
+    error = ex.what();
     return false;
   }
   return true;
-#else
-  (void)result;
-  (void)path;
-  (void)colname_mode;
-  error = "TO PARQUET requires Apache Arrow feature";
-  return false;
-#endif
 }
 
-bool write_table_parquet(const markql::QueryResult::TableResult& table, const std::string& path,
-                         std::string& error) {
-#ifdef MARKQL_USE_ARROW
-  std::vector<std::string> cols = table_columns(table);
-  if (cols.empty()) {
+bool write_arrow(const markql::QueryResult& result, const std::string& path, std::string& error,
+                 markql::ColumnNameMode colname_mode) {
+  if (!validate_rectangular(result, error)) return false;
+  std::ofstream file;
+  std::ostream* out = &std::cout;
+  if (!path.empty()) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+      error = "Failed to open file for writing: " + path;
+      return false;
+    }
+    out = &file;
+  }
+  return write_arrow(*out, result, error, colname_mode);
+}
+
+bool write_table_arrow(const markql::QueryResult::TableResult& table, const std::string& path,
+                       std::string& error) {
+  markql::QueryResult::ExportSink sink;
+  sink.kind = markql::QueryResult::ExportSink::Kind::Arrow;
+  sink.path = path;
+  TableColumnsBuilder columns = table_columns(table);
+  return write_table_columns(columns, sink, error);
+}
+
+bool write_table_columns(TableColumnsBuilder& columns,
+                         const markql::QueryResult::ExportSink& sink, std::string& error) {
+  if (columns.names().empty() || columns.num_rows() == 0) {
     error = "Table export has no rows";
     return false;
   }
-  std::vector<std::shared_ptr<arrow::ArrayBuilder>> builders;
-  builders.reserve(cols.size());
-  for (size_t i = 0; i < cols.size(); ++i) {
-    builders.push_back(std::make_shared<arrow::StringBuilder>());
-  }
-  for (const auto& row : table.rows) {
-    for (size_t i = 0; i < cols.size(); ++i) {
-      auto builder = std::static_pointer_cast<arrow::StringBuilder>(builders[i]);
-      if (i < row.size()) {
-        auto st = builder->Append(row[i]);
-        if (!st.ok()) {
-          error = st.ToString();
-          return false;
-        }
-      } else {
-        auto st = builder->AppendNull();
-        if (!st.ok()) {
-          error = st.ToString();
-          return false;
-        }
-      }
-    }
-  }
-  std::vector<std::shared_ptr<arrow::Field>> fields;
-  std::vector<std::shared_ptr<arrow::Array>> arrays;
-  fields.reserve(cols.size());
-  arrays.reserve(cols.size());
-  for (size_t i = 0; i < cols.size(); ++i) {
-    fields.push_back(arrow::field(cols[i], arrow::utf8(), true));
-    auto builder = std::static_pointer_cast<arrow::StringBuilder>(builders[i]);
-    std::shared_ptr<arrow::Array> array;
-    auto st = builder->Finish(&array);
-    if (!st.ok()) {
-      error = st.ToString();
-      return false;
-    }
-    arrays.push_back(array);
+  const std::vector<std::string>& names = columns.names();
+  if (sink.kind == markql::QueryResult::ExportSink::Kind::Parquet) {
+    return write_parquet_columns(columns.finish(), names, sink.parquet, sink.path, error);
   }
-  auto schema = arrow::schema(fields);
-  auto table_out = arrow::Table::Make(schema, arrays);
-  auto output_res = arrow::io::FileOutputStream::Open(path);
-  if (!output_res.ok()) {
-    error = output_res.status().ToString();
+  std::ofstream out(sink.path, std::ios::binary);
+  if (!out) {
+    error = "Failed to open file for writing: " + sink.path;
     return false;
   }
-  auto output = *output_res;
-  auto st = parquet::arrow::WriteTable(*table_out, arrow::default_memory_pool(), output, 1024);
-  if (!st.ok()) {
-    error = st.ToString();
+  try {
+    write_arrow_columns(out, columns.finish(), names);
+  } catch (const std::exception& ex) {
+    error = ex.what();
     return false;
   }
   return true;
-#else
-  (void)table;
-  (void)path;
-  error = "TO PARQUET requires Apache Arrow feature";
-  return false;
-#endif
 }
 
 bool export_result(const markql::QueryResult& result, std::string& error,
@@ -465,21 +536,23 @@ bool export_result(const markql::QueryResult& result, std::string& error,
       return false;
     }
     if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Csv) {
-      if (sparse && sparse_long) {
-        markql::QueryResult::TableResult table = result.tables[0];
-        std::vector<std::string> header_row = {"row_index", "col_index"};
-        if (result.table_has_header) {
-          header_row.push_back("header");
-        }
-        header_row.push_back("value");
-        table.rows.insert(table.rows.begin(), std::move(header_row));
-        return write_table_csv(table, result.export_sink.path, error, true);
-      }
-      return write_table_csv(result.tables[0], result.export_sink.path, error,
-                             result.table_has_header);
+      const auto& sink = result.export_sink;
+      const auto& table = result.tables[0];
+      return write_table_csv_file(
+          table, table_csv_header(result, table_column_count(table)), sink.path,
+          sink.fsync ? AsyncFileWriter::Sync::OnClose : AsyncFileWriter::Sync::None,
+          export_compression(sink.compression, sink.path), error);
     }
     if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Parquet) {
-      return write_table_parquet(result.tables[0], result.export_sink.path, error);
+      return write_table_parquet(result.tables[0], result.export_sink.path, error,
+                                 result.export_sink.parquet);
+    }
+    if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Arrow) {
+      if (result.export_sink.path.empty()) {
+        error = "TO ARROW() on stdout does not support TO TABLE() results";
+        return false;
+      }
+      return write_table_arrow(result.tables[0], result.export_sink.path, error);
     }
     if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Json ||
         result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Ndjson) {
@@ -499,6 +572,9 @@ bool export_result(const markql::QueryResult& result, std::string& error,
   if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Ndjson) {
     return write_ndjson(result, result.export_sink.path, error, colname_mode);
   }
+  if (result.export_sink.kind == markql::QueryResult::ExportSink::Kind::Arrow) {
+    return write_arrow(result, result.export_sink.path, error, colname_mode);
+  }
   error = "Unknown export sink";
   return false;
 }
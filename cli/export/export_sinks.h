@@ -1,13 +1,84 @@
 #pragma once
 
+#include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
+#include "export/async_file_writer.h"
 #include "markql/column_names.h"
+#include "markql/columnar_result.h"
 #include "markql/markql.h"
 
 namespace markql::cli {
 
+/// Serializes rows one at a time as CSV, JSON or NDJSON into `out`, collecting the text in
+/// large blocks so each row is not a separate stream write. write_csv, write_json and
+/// write_ndjson emit their rows through it.
+class RowStreamWriter {
+ public:
+  enum class Format { Csv, Json, Ndjson };
+
+  RowStreamWriter(std::ostream& out, Format format,
+                  std::vector<markql::ColumnNameMapping> schema);
+  /// Writes the blocks to `file`, whose I/O thread writes one block while the next is
+  /// formatted; finish() closes it.
+  RowStreamWriter(std::unique_ptr<AsyncFileWriter> file, Format format,
+                  std::vector<markql::ColumnNameMapping> schema);
+  /// Writes the CSV header or the opening JSON bracket.
+  void begin();
+  void write_row(const markql::QueryResultRow& row);
+  /// Writes the closing JSON bracket and flushes the buffered text to the output.
+  void finish();
+
+ private:
+  void flush();
+
+  std::ostream* out_ = nullptr;
+  std::unique_ptr<AsyncFileWriter> file_;
+  Format format_;
+  std::vector<markql::ColumnNameMapping> schema_;
+  /// One per schema_ column; resolves computed-field slots once per result.
+  std::vector<markql::ComputedFieldLookup> computed_;
+  std::string buffer_;
+  bool first_row_ = true;
+};
+
+/// Writes TO TABLE() rows to a CSV file a row at a time; finish() closes the file. Collected
+/// and streamed table exports both write through it.
+class TableCsvWriter {
+ public:
+  explicit TableCsvWriter(std::unique_ptr<AsyncFileWriter> file);
+  void write_row(const std::vector<std::string>& cells);
+  void finish();
+
+ private:
+  std::unique_ptr<AsyncFileWriter> file_;
+  std::string buffer_;
+};
+
+/// The line a TO TABLE() CSV export starts with: the long sparse column names, or
+/// col1..col<column_count> when the table has no header row. Empty when the table's own first
+/// row is the header.
+std::vector<std::string> table_csv_header(const markql::QueryResult& result,
+                                          size_t column_count);
+
+/// Collects TO TABLE() cells a row at a time into text columns col1..col<column_count>; cells
+/// missing from short rows are null.
+class TableColumnsBuilder {
+ public:
+  explicit TableColumnsBuilder(size_t column_count);
+  void add_row(const std::vector<std::string>& cells);
+  const std::vector<std::string>& names() const { return names_; }
+  int64_t num_rows() const { return columns_->num_rows; }
+  /// Hands over the columns; the builder is spent afterwards.
+  std::shared_ptr<const markql::ColumnarResult> finish();
+
+ private:
+  std::shared_ptr<markql::ColumnarResult> columns_;
+  std::vector<std::string> names_;
+};
+
 bool export_result(const markql::QueryResult& result, std::string& error,
                    markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
 bool write_csv(std::ostream& out, const markql::QueryResult& result, std::string& error,
@@ -20,9 +91,21 @@ bool write_ndjson(const markql::QueryResult& result, const std::string& path, st
                   markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
 bool write_parquet(const markql::QueryResult& result, const std::string& path, std::string& error,
                    markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
+/// Arrow IPC stream with the TO PARQUET column types; an empty `path` writes to stdout.
+bool write_arrow(std::ostream& out, const markql::QueryResult& result, std::string& error,
+                 markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
+bool write_arrow(const markql::QueryResult& result, const std::string& path, std::string& error,
+                 markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize);
 bool write_table_csv(const markql::QueryResult::TableResult& table, const std::string& path,
                      std::string& error, bool table_has_header);
 bool write_table_parquet(const markql::QueryResult::TableResult& table, const std::string& path,
-                         std::string& error);
+                         std::string& error,
+                         const markql::QueryResult::ExportSink::ParquetOptions& options = {});
+/// Writes TO TABLE() cells as text columns col1..colN.
+bool write_table_arrow(const markql::QueryResult::TableResult& table, const std::string& path,
+                       std::string& error);
+/// Writes built TO TABLE() columns to the TO PARQUET or TO ARROW file of `sink`.
+bool write_table_columns(TableColumnsBuilder& columns,
+                         const markql::QueryResult::ExportSink& sink, std::string& error);
 
 }  // namespace markql::cli
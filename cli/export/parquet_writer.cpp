@@ -0,0 +1,115 @@
+#include "export/parquet_writer.h"
+
+#ifdef MARKQL_USE_ARROW
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+#include <string_view>
+#include <unordered_set>
+
+#include "export/arrow_columns.h"
+#endif
+
+namespace markql::cli {
+
+#ifdef MARKQL_USE_ARROW
+
+namespace {
+
+using ColumnType = markql::ColumnarColumn::Type;
+
+// WHY: a dictionary only pays off when values repeat; for mostly distinct columns the writer
+// would fill a dictionary page, then fall back to plain encoding anyway.
+bool worth_dictionary(const markql::ColumnarColumn& column, int64_t num_rows) {
+  const size_t limit = static_cast<size_t>(num_rows / 2);
+  if (column.type == ColumnType::Int64) {
+    std::unordered_set<int64_t> distinct;
+    for (int64_t value : column.int64_values) {
+      if (distinct.insert(value).second && distinct.size() > limit) return false;
+    }
+    return !distinct.empty();
+  }
+  std::unordered_set<std::string_view> distinct;
+  for (size_t r = 0; r < column.strings.size(); ++r) {
+    if (distinct.insert(column.strings.at(r)).second && distinct.size() > limit) return false;
+  }
+  return !distinct.empty();
+}
+
+parquet::Compression::type to_parquet_compression(
+    markql::QueryResult::ExportSink::ParquetOptions::Compression compression) {
+  using Compression = markql::QueryResult::ExportSink::ParquetOptions::Compression;
+  switch (compression) {
+    case Compression::Snappy:
+      return parquet::Compression::SNAPPY;
+    case Compression::Zstd:
+      return parquet::Compression::ZSTD;
+    case Compression::Gzip:
+      return parquet::Compression::GZIP;
+    case Compression::None:
+      return parquet::Compression::UNCOMPRESSED;
+  }
+  return parquet::Compression::SNAPPY;
+}
+
+arrow::Status write_parquet_file(const std::shared_ptr<const markql::ColumnarResult>& columns,
+                                 const std::vector<std::string>& output_names,
+                                 const markql::QueryResult::ExportSink::ParquetOptions& options,
+                                 const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto batch,
+                        to_arrow_record_batch(columns, output_names, options.infer_types));
+
+  parquet::WriterProperties::Builder properties;
+  properties.compression(to_parquet_compression(options.compression));
+  properties.max_row_group_length(options.row_group_size);
+  for (size_t i = 0; i < columns->columns.size(); ++i) {
+    const markql::ColumnarColumn& column = columns->columns[i];
+    if ((column.type == ColumnType::Int64 || column.type == ColumnType::Utf8) &&
+        !worth_dictionary(column, columns->num_rows)) {
+      properties.disable_dictionary(output_names[i]);
+    }
+  }
+
+  ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches({batch}));
+  ARROW_ASSIGN_OR_RAISE(auto output, arrow::io::FileOutputStream::Open(path));
+  auto arrow_properties =
+      parquet::ArrowWriterProperties::Builder().set_use_threads(true)->store_schema()->build();
+  ARROW_RETURN_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), output,
+                                                 options.row_group_size, properties.build(),
+                                                 arrow_properties));
+  return output->Close();
+}
+
+}  // namespace
+
+bool write_parquet_columns(const std::shared_ptr<const markql::ColumnarResult>& columns,
+                           const std::vector<std::string>& output_names,
+                           const markql::QueryResult::ExportSink::ParquetOptions& options,
+                           const std::string& path, std::string& error) {
+  arrow::Status status = write_parquet_file(columns, output_names, options, path);
+  if (!status.ok()) {
+    error = status.ToString();
+    return false;
+  }
+  return true;
+}
+
+#else
+
+bool write_parquet_columns(const std::shared_ptr<const markql::ColumnarResult>& columns,
+                           const std::vector<std::string>& output_names,
+                           const markql::QueryResult::ExportSink::ParquetOptions& options,
+                           const std::string& path, std::string& error) {
+  (void)columns;
+  (void)output_names;
+  (void)options;
+  (void)path;
+  error = "TO PARQUET requires Apache Arrow feature";
+  return false;
+}
+
+#endif
+
+}  // namespace markql::cli
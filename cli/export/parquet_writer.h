@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "markql/columnar_result.h"
+#include "markql/markql.h"
+
+namespace markql::cli {
+
+/// Writes `columns` to a Parquet file at `path`, naming column i `output_names[i]`.
+/// Node fields keep their ColumnarResult types (int64, dictionary tag, attribute and score
+/// maps); computed text columns become int64 or double when `options.infer_types` is set and
+/// every value parses. Row groups hold at most `options.row_group_size` rows, dictionary
+/// encoding is kept only for low-cardinality columns, and columns of a row group are encoded
+/// in parallel. Returns false with `error` set on failure, including builds without Arrow.
+bool write_parquet_columns(const std::shared_ptr<const markql::ColumnarResult>& columns,
+                           const std::vector<std::string>& output_names,
+                           const markql::QueryResult::ExportSink::ParquetOptions& options,
+                           const std::string& path, std::string& error);
+
+}  // namespace markql::cli
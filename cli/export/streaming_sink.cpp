@@ -0,0 +1,201 @@
+#include "export/streaming_sink.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "cli_utils.h"
+#include "export/parquet_writer.h"
+
+namespace markql::cli {
+
+namespace {
+
+constexpr size_t kJsonFlushBytes = size_t{1} << 20;
+
+std::optional<RowStreamWriter::Format> export_format(markql::QueryResult::ExportSink::Kind kind) {
+  using Kind = markql::QueryResult::ExportSink::Kind;
+  if (kind == Kind::Csv) return RowStreamWriter::Format::Csv;
+  if (kind == Kind::Json) return RowStreamWriter::Format::Json;
+  if (kind == Kind::Ndjson) return RowStreamWriter::Format::Ndjson;
+  return std::nullopt;
+}
+
+}  // namespace
+
+StreamingResultSink::StreamingResultSink(Options options) : options_(std::move(options)) {}
+
+bool StreamingResultSink::begin(const markql::QueryResult& header) {
+  if (header.to_table || !header.tables.empty()) return false;
+  // WHY: apply_source_uri_policy adds a source_uri column to implicit columns only after
+  // seeing every row's source, so those results cannot be written before they finish.
+  if (header.columns_implicit && !header.source_uri_excluded) return false;
+  using Kind = markql::QueryResult::ExportSink::Kind;
+#ifdef MARKQL_USE_ARROW
+  if (header.export_sink.kind == Kind::Parquet) {
+    if (header.columns.empty()) return false;
+    parquet_ = std::make_unique<markql::ColumnarResultBuilder>();
+    parquet_->begin(header);
+    parquet_header_ = header;
+    streamed_ = true;
+    return true;
+  }
+  if (header.export_sink.kind == Kind::Arrow ||
+      (header.export_sink.kind == Kind::None && options_.output_mode == "arrow")) {
+    if (header.columns.empty()) return false;
+    std::vector<std::string> names;
+    for (const auto& mapping :
+         markql::build_column_name_map(header.columns, options_.colname_mode)) {
+      names.push_back(mapping.output_name);
+    }
+    arrow_ = std::make_unique<ArrowIpcStreamWriter>(open_export(header), std::move(names));
+    arrow_->begin(header);
+    streamed_ = true;
+    return true;
+  }
+#endif
+  if (header.export_sink.kind != Kind::None) {
+    std::optional<RowStreamWriter::Format> format = export_format(header.export_sink.kind);
+    if (!format.has_value() || header.columns.empty()) return false;
+    std::vector<markql::ColumnNameMapping> schema =
+        markql::build_column_name_map(header.columns, options_.colname_mode);
+    if (header.export_sink.path.empty()) {
+      writer_ = std::make_unique<RowStreamWriter>(std::cout, *format, std::move(schema));
+    } else {
+      const auto& sink = header.export_sink;
+      const auto sync =
+          sink.fsync ? AsyncFileWriter::Sync::OnClose : AsyncFileWriter::Sync::None;
+      writer_ = std::make_unique<RowStreamWriter>(
+          std::make_unique<AsyncFileWriter>(sink.path, sync,
+                                            export_compression(sink.compression, sink.path)),
+          *format, std::move(schema));
+    }
+  } else if (options_.output_mode == "csv") {
+    if (header.columns.empty()) return false;
+    writer_ = std::make_unique<RowStreamWriter>(
+        std::cout, RowStreamWriter::Format::Csv,
+        markql::build_column_name_map(header.columns, options_.colname_mode));
+  } else if (!header.to_list && (options_.output_mode == "plain" ||
+                                 (options_.output_mode == "json" && options_.display_full))) {
+    json_schema_ = json_output_schema(header, options_.colname_mode);
+    json_buffer_ = "[";
+  } else {
+    return false;
+  }
+  if (writer_ != nullptr) writer_->begin();
+  streamed_ = true;
+  return true;
+}
+
+void StreamingResultSink::row(const markql::QueryResultRow& row) {
+  if (parquet_ != nullptr) {
+    parquet_->row(row);
+    return;
+  }
+  if (writer_ != nullptr) {
+    writer_->write_row(row);
+    return;
+  }
+  if (arrow_ != nullptr) {
+    arrow_->write_row(row);
+    return;
+  }
+  append_json_array_row(json_buffer_, row, *json_schema_, json_empty_);
+  json_empty_ = false;
+  if (json_buffer_.size() >= kJsonFlushBytes) flush_json();
+}
+
+bool StreamingResultSink::begin_table(const markql::QueryResult& header,
+                                      const markql::QueryResult::TableResult& /*table*/,
+                                      size_t column_count) {
+  using Kind = markql::QueryResult::ExportSink::Kind;
+  const auto& sink = header.export_sink;
+  // WHY: table exports to stdout are rejected by export_result; declining keeps that error.
+  if (sink.path.empty()) return false;
+  if (sink.kind == Kind::Csv) {
+    const auto sync = sink.fsync ? AsyncFileWriter::Sync::OnClose : AsyncFileWriter::Sync::None;
+    table_csv_ = std::make_unique<TableCsvWriter>(std::make_unique<AsyncFileWriter>(
+        sink.path, sync, export_compression(sink.compression, sink.path)));
+    std::vector<std::string> header_row = table_csv_header(header, column_count);
+    if (!header_row.empty()) table_csv_->write_row(header_row);
+#ifdef MARKQL_USE_ARROW
+  } else if (sink.kind == Kind::Parquet || sink.kind == Kind::Arrow) {
+    table_columns_ = std::make_unique<TableColumnsBuilder>(column_count);
+#endif
+  } else {
+    return false;
+  }
+  table_sink_ = sink;
+  streamed_ = true;
+  return true;
+}
+
+void StreamingResultSink::table_row(const std::vector<std::string>& cells) {
+  if (table_csv_ != nullptr) {
+    table_csv_->write_row(cells);
+    return;
+  }
+  table_columns_->add_row(cells);
+}
+
+void StreamingResultSink::end() {
+  if (table_csv_ != nullptr) {
+    table_csv_->finish();
+    return;
+  }
+  if (table_columns_ != nullptr) {
+    std::string error;
+    const bool written = write_table_columns(*table_columns_, table_sink_, error);
+    table_columns_.reset();
+    if (!written) throw std::runtime_error(error);
+    return;
+  }
+  if (parquet_ != nullptr) {
+    std::vector<std::string> names;
+    for (const auto& mapping :
+         markql::build_column_name_map(parquet_header_.columns, options_.colname_mode)) {
+      names.push_back(mapping.output_name);
+    }
+    auto columns =
+        std::make_shared<const markql::ColumnarResult>(parquet_->finish(parquet_header_));
+    parquet_.reset();
+    std::string error;
+    if (!write_parquet_columns(columns, names, parquet_header_.export_sink.parquet,
+                               parquet_header_.export_sink.path, error)) {
+      throw std::runtime_error(error);
+    }
+    return;
+  }
+  if (writer_ != nullptr) {
+    writer_->finish();
+    return;
+  }
+  if (arrow_ != nullptr) {
+    arrow_->finish();
+    arrow_.reset();
+    if (file_.is_open()) file_.close();
+    return;
+  }
+  append_json_array_end(json_buffer_, json_empty_);
+  json_buffer_ += '\n';
+  flush_json();
+  std::cout.flush();
+}
+
+std::ostream& StreamingResultSink::open_export(const markql::QueryResult& header) {
+  if (header.export_sink.path.empty()) return std::cout;
+  file_.open(header.export_sink.path, std::ios::binary);
+  if (!file_) {
+    throw std::runtime_error("Failed to open file for writing: " + header.export_sink.path);
+  }
+  return file_;
+}
+
+void StreamingResultSink::flush_json() {
+  // Buffers always end on a whole element, so each chunk colorizes like the full document.
+  const bool colorize = options_.output_mode == "json" && options_.color;
+  std::cout << (colorize ? colorize_json(json_buffer_, true) : json_buffer_);
+  json_buffer_.clear();
+}
+
+}  // namespace markql::cli
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "export/arrow_ipc_writer.h"
+#include "export/export_sinks.h"
+#include "markql/column_names.h"
+#include "markql/columnar_result.h"
+#include "markql/markql.h"
+
+namespace markql::cli {
+
+/// Writes a statement's rows while the engine produces them whenever the output needs no
+/// whole-result pass: TO CSV/JSON/NDJSON exports, --mode csv, --mode plain and untruncated
+/// --mode json. TO ARROW and --mode arrow write record batches as they fill. TO PARQUET
+/// collects the rows straight into columns and writes the file at end(). Other outputs
+/// (duckbox, TO LIST, TO TABLE, truncated JSON, implicit columns that may gain source_uri)
+/// decline, so their rows stay in the QueryResult. An exported TO TABLE() result is taken
+/// through begin_table(): CSV rows are written as they are read, and TO PARQUET / TO ARROW
+/// collect them straight into columns.
+class StreamingResultSink : public markql::QueryResultSink {
+ public:
+  struct Options {
+    std::string output_mode = "duckbox";
+    bool display_full = false;
+    bool color = false;
+    markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize;
+  };
+
+  explicit StreamingResultSink(Options options);
+
+  bool begin(const markql::QueryResult& header) override;
+  void row(const markql::QueryResultRow& row) override;
+  bool begin_table(const markql::QueryResult& header,
+                   const markql::QueryResult::TableResult& table, size_t column_count) override;
+  void table_row(const std::vector<std::string>& cells) override;
+  void end() override;
+
+  /// True once begin() accepted the stream; the statement's output is then already written.
+  bool streamed() const { return streamed_; }
+
+ private:
+  void flush_json();
+  std::ostream& open_export(const markql::QueryResult& header);
+
+  Options options_;
+  bool streamed_ = false;
+  std::ofstream file_;
+  std::unique_ptr<RowStreamWriter> writer_;
+  std::unique_ptr<ArrowIpcStreamWriter> arrow_;
+  /// Set for TO PARQUET, along with the header it was started from.
+  std::unique_ptr<markql::ColumnarResultBuilder> parquet_;
+  markql::QueryResult parquet_header_;
+  /// Set for a streamed TO TABLE() export, along with its sink.
+  std::unique_ptr<TableCsvWriter> table_csv_;
+  std::unique_ptr<TableColumnsBuilder> table_columns_;
+  markql::QueryResult::ExportSink table_sink_;
+  /// Set for stdout JSON, which reuses build_json's element formatting.
+  std::optional<std::vector<markql::ColumnNameMapping>> json_schema_;
+  std::string json_buffer_;
+  bool json_empty_ = true;
+};
+
+}  // namespace markql::cli
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <chrono>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -8,6 +9,7 @@
 #include "markql/markql.h"
 #include "dom/html_parser.h"
 #include "export/export_sinks.h"
+#include "export/streaming_sink.h"
 #include "render/duckbox_renderer.h"
 #include "render/query_template_renderer.h"
 #include "cli_args.h"
@@ -79,8 +81,13 @@ int main(int argc, char** argv) {
   const markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize;
 
   // WHY: reject unknown modes to avoid silently changing output contracts.
-  if (!markql::cli::is_supported_output_mode(output_mode)) {
-    std::cerr << "Invalid --mode value (use duckbox|json|plain|csv)\n";
+  // Arrow writes a binary stream to stdout, so it is a --mode value only, not a REPL mode.
+  if (output_mode != "arrow" && !markql::cli::is_supported_output_mode(output_mode)) {
+    std::cerr << "Invalid --mode value (use duckbox|json|plain|csv|arrow)\n";
+    return 2;
+  }
+  if (output_mode == "arrow" && interactive) {
+    std::cerr << "--mode arrow is not supported with --interactive\n";
     return 2;
   }
 
@@ -194,7 +201,16 @@ int main(int argc, char** argv) {
       return 0;
     }
 
-    std::optional<std::string> stdin_cache;
+    // WHY: every statement of a script reads the same input; parse it once and keep its
+    // relation caches (join indexes, document relations) across statements.
+    std::shared_ptr<const markql::ParsedDocumentHandle> prepared_input;
+    auto print_warnings = [&](const markql::QueryResult& result) {
+      for (const auto& warning : result.warnings) {
+        if (stderr_color) std::cerr << kColor.yellow;
+        std::cerr << "Warning: " << warning << std::endl;
+        if (stderr_color) std::cerr << kColor.reset;
+      }
+    };
     auto render_result = [&](markql::QueryResult& result,
                              const std::chrono::steady_clock::time_point& started_at,
                              const std::optional<size_t>& rss_before_bytes) {
@@ -212,11 +228,7 @@ int main(int argc, char** argv) {
 
       auto sources = collect_source_uris(result);
       apply_source_uri_policy(result, sources);
-      for (const auto& warning : result.warnings) {
-        if (stderr_color) std::cerr << kColor.yellow;
-        std::cerr << "Warning: " << warning << std::endl;
-        if (stderr_color) std::cerr << kColor.reset;
-      }
+      print_warnings(result);
 
       if (result.export_sink.kind != markql::QueryResult::ExportSink::Kind::None) {
         std::string export_error;
@@ -276,7 +288,8 @@ int main(int argc, char** argv) {
           options.highlight = highlight;
           options.is_tty = color;
           options.colname_mode = colname_mode;
-          std::cout << markql::render::render_duckbox(result, options) << std::endl;
+          markql::render::render_duckbox(std::cout, result, options);
+          std::cout << std::endl;
           std::cout << "Rows: " << count_result_rows(result) << std::endl;
           emit_runtime_summary();
         } else {
@@ -290,6 +303,16 @@ int main(int argc, char** argv) {
           std::cout << "Rows: " << count_result_rows(result) << std::endl;
           emit_runtime_summary();
         }
+      } else if (output_mode == "arrow") {
+        if (result.to_table) {
+          throw std::runtime_error(
+              "Arrow output mode does not support TO TABLE() results; use TO "
+              "TABLE(EXPORT='file.csv') instead");
+        }
+        std::string error;
+        if (!markql::cli::write_arrow(std::cout, result, error, colname_mode)) {
+          throw std::runtime_error(error);
+        }
       } else if (output_mode == "csv") {
         if (result.to_table) {
           throw std::runtime_error(
@@ -321,6 +344,12 @@ int main(int argc, char** argv) {
       const auto rss_before_bytes = read_process_rss_bytes();
       std::string statement = rewrite_from_path_if_needed(raw_query);
       markql::QueryResult result;
+      StreamingResultSink::Options stream_options;
+      stream_options.output_mode = output_mode;
+      stream_options.display_full = display_full;
+      stream_options.color = color;
+      stream_options.colname_mode = colname_mode;
+      StreamingResultSink sink(stream_options);
       auto source = parse_query_source(statement);
       if (source.has_value() && source->statement_kind != markql::Query::Kind::Select) {
         std::string meta_error;
@@ -337,26 +366,40 @@ int main(int argc, char** argv) {
         }
       } else {
         if (source.has_value() && source->kind == markql::Source::Kind::Url) {
-          result = markql::execute_query_from_url(source->value, statement, timeout_ms);
+          result = markql::execute_query_from_url(source->value, statement, timeout_ms, sink);
         } else if (source.has_value() && source->kind == markql::Source::Kind::Path) {
-          result = markql::execute_query_from_file(source->value, statement);
+          result = markql::execute_query_from_file(source->value, statement, sink);
         } else if (source.has_value() && source->kind == markql::Source::Kind::RawHtml) {
-          result = markql::execute_query_from_document("", statement);
+          result = markql::execute_query_from_document("", statement, sink);
         } else if (source.has_value() && !source->needs_input) {
-          result = markql::execute_query_from_document("", statement);
+          result = markql::execute_query_from_document("", statement, sink);
         } else if (input.empty() || input == "document") {
-          if (!stdin_cache.has_value()) {
-            stdin_cache = read_stdin();
+          if (prepared_input == nullptr) {
+            prepared_input = markql::prepare_document(read_stdin());
           }
-          result = markql::execute_query_from_document(*stdin_cache, statement);
+          result = markql::execute_query_from_prepared_document(prepared_input, statement, sink);
         } else {
           if (is_url(input)) {
-            result = markql::execute_query_from_url(input, statement, timeout_ms);
+            result = markql::execute_query_from_url(input, statement, timeout_ms, sink);
           } else {
-            result = markql::execute_query_from_file(input, statement);
+            if (prepared_input == nullptr) {
+              prepared_input =
+                  markql::prepare_document(markql::markql_internal::read_file(input), input);
+            }
+            result = markql::execute_query_from_prepared_document(prepared_input, statement, sink);
           }
         }
       }
+      if (sink.streamed()) {
+        // Rows are already written; only the messages that follow an export remain.
+        print_warnings(result);
+        if (result.export_sink.kind != markql::QueryResult::ExportSink::Kind::None &&
+            !result.export_sink.path.empty()) {
+          std::cout << "Wrote " << export_kind_label(result.export_sink.kind) << ": "
+                    << result.export_sink.path << std::endl;
+        }
+        return;
+      }
       render_result(result, started_at, rss_before_bytes);
     };
 
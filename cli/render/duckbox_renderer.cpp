@@ -108,13 +108,14 @@ bool is_numeric(const std::string& value) {
   return has_digit;
 }
 
-std::string truncate_with_ellipsis(const std::string& value, size_t width) {
-  if (display_width(value) <= width) return value;
-  if (width == 0) return "";
-  if (width == 1) return "…";
+/// Cuts `value` (whose display width is `width`) to at most `limit` columns, ending with "…".
+std::string truncate_with_ellipsis(const std::string& value, size_t width, size_t limit) {
+  if (width <= limit) return value;
+  if (limit == 0) return "";
+  if (limit == 1) return "…";
   const std::string ellipsis = "…";
   size_t ellipsis_width = display_width(ellipsis);
-  size_t target = (width > ellipsis_width) ? width - ellipsis_width : 0;
+  size_t target = (limit > ellipsis_width) ? limit - ellipsis_width : 0;
   ensure_locale();
   mbstate_t state{};
   std::string out;
@@ -148,6 +149,10 @@ std::string truncate_with_ellipsis(const std::string& value, size_t width) {
   return out;
 }
 
+std::string truncate_with_ellipsis(const std::string& value, size_t limit) {
+  return truncate_with_ellipsis(value, display_width(value), limit);
+}
+
 std::string pad_cell(const std::string& value, size_t width, bool right_align) {
   size_t w = display_width(value);
   if (w >= width) return value;
@@ -239,9 +244,52 @@ std::string build_separator(const std::vector<size_t>& widths, const std::string
   return oss.str();
 }
 
+/// A formatted cell with its display width measured once.
+struct Cell {
+  std::string text;
+  size_t width = 0;
+  bool numeric = false;
+};
+
+using CellRow = std::vector<Cell>;
+
+CellRow make_cells(const markql::QueryResultRow& row,
+                   const std::vector<markql::ColumnNameMapping>& schema) {
+  CellRow cells;
+  cells.reserve(schema.size());
+  for (const auto& column : schema) {
+    Cell cell;
+    cell.text = sanitize_cell(field_value(row, column.raw_name));
+    cell.width = display_width(cell.text);
+    cell.numeric = is_numeric(cell.text);
+    cells.push_back(std::move(cell));
+  }
+  return cells;
+}
+
+void append_row_line(std::string& line, const CellRow& cells, const std::vector<size_t>& widths) {
+  line += "│";
+  for (size_t i = 0; i < cells.size(); ++i) {
+    const Cell& cell = cells[i];
+    line += ' ';
+    if (cell.width > widths[i]) {
+      line += pad_cell(truncate_with_ellipsis(cell.text, cell.width, widths[i]), widths[i],
+                       cell.numeric);
+    } else {
+      const std::string padding(widths[i] - cell.width, ' ');
+      if (cell.numeric) line += padding;
+      line += cell.text;
+      if (!cell.numeric) line += padding;
+    }
+    line += " │";
+  }
+  line += '\n';
+}
+
 }  // namespace
 
-std::string render_duckbox(const markql::QueryResult& result, const DuckboxOptions& options) {
+void render_duckbox(std::ostream& out, const markql::QueryResult& result,
+                    const DuckboxOptions& options) {
   std::vector<std::string> raw_columns =
       result.columns.empty() ? default_columns() : result.columns;
   std::vector<markql::ColumnNameMapping> schema =
@@ -251,30 +299,40 @@ std::string render_duckbox(const markql::QueryResult& result, const DuckboxOptio
   for (const auto& item : schema) {
     columns.push_back(item.output_name);
   }
-  size_t max_rows = options.max_rows == 0 ? result.rows.size() : options.max_rows;
-  size_t rows_to_render = std::min(result.rows.size(), max_rows);
+  const size_t total_rows = result.rows.size();
+  const size_t first_row = std::min(options.offset, total_rows);
+  const size_t page_rows = total_rows - first_row;
+  const size_t rows_to_render =
+      options.max_rows == 0 ? page_rows : std::min(page_rows, options.max_rows);
+  const size_t end_row = first_row + rows_to_render;
   size_t max_width = options.max_width == 0 ? detect_terminal_width() : options.max_width;
   if (max_width < 20) max_width = 20;
 
-  std::vector<std::vector<std::string>> table_rows;
-  table_rows.reserve(rows_to_render);
-  for (size_t i = 0; i < rows_to_render; ++i) {
-    const auto& row = result.rows[i];
-    std::vector<std::string> cells;
-    cells.reserve(columns.size());
-    for (size_t c = 0; c < schema.size(); ++c) {
-      cells.push_back(sanitize_cell(field_value(row, schema[c].raw_name)));
-    }
-    table_rows.push_back(std::move(cells));
+  // WHY: only the head and tail of the page are formatted up front to size the columns, so the
+  // first line appears after a bounded amount of work however many rows the page holds.
+  const size_t head_rows = std::min(rows_to_render, kDuckboxWidthSampleRows);
+  const size_t tail_rows = std::min(rows_to_render - head_rows, kDuckboxWidthSampleRows);
+  const size_t tail_start = end_row - tail_rows;
+  std::vector<CellRow> head;
+  std::vector<CellRow> tail;
+  head.reserve(head_rows);
+  tail.reserve(tail_rows);
+  for (size_t r = first_row; r < first_row + head_rows; ++r) {
+    head.push_back(make_cells(result.rows[r], schema));
+  }
+  for (size_t r = tail_start; r < end_row; ++r) {
+    tail.push_back(make_cells(result.rows[r], schema));
   }
 
   std::vector<size_t> widths(columns.size(), 0);
   for (size_t i = 0; i < columns.size(); ++i) {
     widths[i] = std::max(widths[i], display_width(columns[i]));
   }
-  for (const auto& row : table_rows) {
-    for (size_t i = 0; i < row.size(); ++i) {
-      widths[i] = std::max(widths[i], display_width(row[i]));
+  for (const auto* sample : {&head, &tail}) {
+    for (const auto& row : *sample) {
+      for (size_t i = 0; i < row.size(); ++i) {
+        widths[i] = std::max(widths[i], row[i].width);
+      }
     }
   }
   for (auto& w : widths) {
@@ -302,42 +360,54 @@ std::string render_duckbox(const markql::QueryResult& result, const DuckboxOptio
     widths[idx]--;
   }
 
-  std::ostringstream oss;
-  oss << build_separator(widths, "┌", "┬", "┐") << "\n";
-  oss << "│";
+  std::string line = build_separator(widths, "┌", "┬", "┐") + "\n│";
   for (size_t i = 0; i < columns.size(); ++i) {
     std::string header = truncate_with_ellipsis(columns[i], widths[i]);
     std::string padded = pad_cell(header, widths[i], false);
     if (options.highlight && options.is_tty) {
       padded = "\033[1m" + padded + "\033[0m";
     }
-    oss << " " << padded << " │";
+    line += " " + padded + " │";
   }
-  oss << "\n";
-  oss << build_separator(widths, "├", "┼", "┤") << "\n";
-
-  for (const auto& row : table_rows) {
-    oss << "│";
-    for (size_t i = 0; i < columns.size(); ++i) {
-      std::string cell = truncate_with_ellipsis(row[i], widths[i]);
-      bool right_align = is_numeric(row[i]);
-      oss << " " << pad_cell(cell, widths[i], right_align) << " │";
+  line += "\n" + build_separator(widths, "├", "┼", "┤") + "\n";
+  out << line;
+
+  // Rows are written one at a time; rows between the samples are formatted only when reached.
+  for (size_t r = first_row; r < end_row; ++r) {
+    line.clear();
+    const size_t head_index = r - first_row;
+    if (head_index < head.size()) {
+      append_row_line(line, head[head_index], widths);
+    } else if (r >= tail_start) {
+      append_row_line(line, tail[r - tail_start], widths);
+    } else {
+      append_row_line(line, make_cells(result.rows[r], schema), widths);
     }
-    oss << "\n";
+    out << line;
   }
 
-  if (result.rows.size() > rows_to_render) {
+  if (end_row < total_rows || first_row > 0) {
     size_t content_width = total_width() >= 4 ? total_width() - 4 : 0;
     std::ostringstream msg;
-    msg << "… truncated, showing first " << rows_to_render << " of " << result.rows.size()
-        << " rows …";
+    if (first_row == 0) {
+      msg << "… truncated, showing first " << rows_to_render << " of " << total_rows
+          << " rows …";
+    } else {
+      msg << "… showing rows " << (rows_to_render == 0 ? first_row : first_row + 1) << "-"
+          << end_row << " of " << total_rows << " …";
+    }
     std::string text = msg.str();
     text = truncate_with_ellipsis(text, content_width);
     text = pad_cell(text, content_width, false);
-    oss << "│ " << text << " │\n";
+    out << "│ " << text << " │\n";
   }
 
-  oss << build_separator(widths, "└", "┴", "┘");
+  out << build_separator(widths, "└", "┴", "┘");
+}
+
+std::string render_duckbox(const markql::QueryResult& result, const DuckboxOptions& options) {
+  std::ostringstream oss;
+  render_duckbox(oss, result, options);
   return oss.str();
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <ostream>
 #include <string>
 
 #include "markql/column_names.h"
@@ -8,14 +9,27 @@
 
 namespace markql::render {
 
+/// Rows formatted from each end of a page to size its columns.
+inline constexpr size_t kDuckboxWidthSampleRows = 256;
+
 struct DuckboxOptions {
   size_t max_width = 0;
+  /// Rows shown per page; 0 shows every row from `offset` on.
   size_t max_rows = 40;
+  /// Index of the first row shown, used to page through a result.
+  size_t offset = 0;
   bool highlight = false;
   bool is_tty = true;
   markql::ColumnNameMode colname_mode = markql::ColumnNameMode::Normalize;
 };
 
+/// Writes one page of `result` to `out` as a box table, a row at a time. Column widths come from
+/// the header and the first and last kDuckboxWidthSampleRows rows of the page, so the cost before
+/// the first row is bounded; longer cells between the samples are cut with an ellipsis. No
+/// trailing newline is written.
+void render_duckbox(std::ostream& out, const markql::QueryResult& result,
+                    const DuckboxOptions& options);
+/// Same as above, returned as a string.
 std::string render_duckbox(const markql::QueryResult& result, const DuckboxOptions& options);
 
 }  // namespace markql::render
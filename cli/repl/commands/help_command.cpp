@@ -18,6 +18,7 @@ CommandHandler make_help_command() {
         << "  .lint on|off            Toggle lint warnings before query execution (or :lint)\n";
     std::cout << "  .display_mode more|less   Control truncation\n";
     std::cout << "  .max_rows <n|inf>        Set duckbox max rows (inf = no limit)\n";
+    std::cout << "  .more                    Show the next page of the last duckbox result\n";
     std::cout << "  .reload_config           Reload REPL config\n";
     std::cout << "  .explore [doc|alias|path|url]  Open DOM Explorer on input\n";
 #ifdef MARKQL_ENABLE_KHMER_NUMBER
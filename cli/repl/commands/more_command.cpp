@@ -0,0 +1,38 @@
+#include "more_command.h"
+
+#include <iostream>
+
+#include "../../cli_utils.h"
+#include "../../render/duckbox_renderer.h"
+
+namespace markql::cli {
+
+CommandHandler make_more_command() {
+  return [](const std::string& line, CommandContext& ctx) -> bool {
+    if (trim_semicolon(line) != ".more") {
+      return false;
+    }
+    if (ctx.pager == nullptr || ctx.pager->result == nullptr) {
+      std::cerr << "No more rows" << std::endl;
+      return true;
+    }
+    const markql::QueryResult& result = *ctx.pager->result;
+    markql::render::DuckboxOptions options;
+    options.max_width = 0;
+    options.max_rows = ctx.max_rows;
+    options.offset = ctx.pager->next_row;
+    options.highlight = ctx.config.highlight;
+    options.is_tty = ctx.config.color;
+    options.colname_mode = ctx.config.colname_mode;
+    markql::render::render_duckbox(std::cout, result, options);
+    std::cout << std::endl;
+    if (ctx.max_rows == 0 || result.rows.size() - options.offset <= ctx.max_rows) {
+      *ctx.pager = DuckboxPager{};
+    } else {
+      ctx.pager->next_row += ctx.max_rows;
+    }
+    return true;
+  };
+}
+
+}  // namespace markql::cli
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "registry.h"
+
+namespace markql::cli {
+
+CommandHandler make_more_command();
+
+}  // namespace markql::cli
@@ -8,6 +8,7 @@
 #include "load_command.h"
 #include "max_rows_command.h"
 #include "mode_command.h"
+#include "more_command.h"
 #include "plugin_command.h"
 #include "reload_config_command.h"
 #include "set_command.h"
@@ -40,6 +41,7 @@ void register_default_commands(CommandRegistry& registry) {
   registry.add(make_display_mode_command());
   registry.add(make_mode_command());
   registry.add(make_max_rows_command());
+  registry.add(make_more_command());
   registry.add(make_reload_config_command());
   registry.add(make_plugin_command());
   registry.add(make_explore_command());
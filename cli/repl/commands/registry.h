@@ -24,6 +24,8 @@ struct CommandContext {
   size_t& max_rows;
   std::vector<markql::ColumnNameMapping>& last_schema_map;
   PluginManager& plugin_manager;
+  /// Unset when the session does not keep results for paging.
+  DuckboxPager* pager = nullptr;
 };
 
 using CommandHandler = std::function<bool(const std::string&, CommandContext&)>;
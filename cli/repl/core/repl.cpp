@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
@@ -39,6 +40,7 @@ int run_repl(ReplConfig& config) {
   std::string last_full_output;
   bool display_full = config.display_full;
   size_t max_rows = 40;
+  DuckboxPager pager;
   std::vector<std::string> last_sources;
   std::vector<markql::ColumnNameMapping> last_schema_map;
   std::string line;
@@ -56,7 +58,7 @@ int run_repl(ReplConfig& config) {
   PluginManager plugin_manager(registry);
   CommandContext command_ctx{
       config,       editor,   sources,         active_alias,   last_full_output,
-      display_full, max_rows, last_schema_map, plugin_manager,
+      display_full, max_rows, last_schema_map, plugin_manager, &pager,
   };
 
   if (!config_error.empty()) {
@@ -97,6 +99,7 @@ int run_repl(ReplConfig& config) {
       print_query_runtime_summary(rss_before_bytes, rss_after_bytes, elapsed_ms);
     };
 
+    pager = DuckboxPager{};
     std::string query_text = rewrite_from_path_if_needed(raw_query);
     if (config.lint_warnings) {
       std::vector<markql::Diagnostic> diagnostics = markql::lint_query(query_text);
@@ -247,9 +250,14 @@ int run_repl(ReplConfig& config) {
         options.highlight = config.highlight;
         options.is_tty = config.color;
         options.colname_mode = config.colname_mode;
-        std::cout << markql::render::render_duckbox(result, options) << std::endl;
+        markql::render::render_duckbox(std::cout, result, options);
+        std::cout << std::endl;
         std::cout << "Rows: " << count_result_rows(result) << std::endl;
         emit_runtime_summary();
+        if (max_rows != 0 && result.rows.size() > max_rows) {
+          pager.next_row = max_rows;
+          pager.result = std::make_shared<const markql::QueryResult>(std::move(result));
+        }
       } else {
         std::string json_out = build_json_list(result, config.colname_mode);
         last_full_output = json_out;
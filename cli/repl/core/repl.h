@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <optional>
 #include <string>
 
 #include "markql/column_names.h"
+#include "markql/markql.h"
 
 namespace markql::cli {
 
@@ -14,6 +16,13 @@ struct LoadedSource {
   std::optional<std::string> html;
 };
 
+/// Keeps the last duckbox result while it has rows left to show, so `.more` can page on.
+/// MUST be reset once the last page is shown so large results are not held longer than needed.
+struct DuckboxPager {
+  std::shared_ptr<const markql::QueryResult> result;
+  size_t next_row = 0;
+};
+
 /// Carries runtime REPL settings that can be mutated during a session.
 /// MUST keep fields synchronized with CLI flags and MUST remain valid for run_repl.
 /// Inputs are from CLI parsing; outputs affect interactive behavior.
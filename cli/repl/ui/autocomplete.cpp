@@ -16,6 +16,7 @@ AutoCompleter::AutoCompleter() {
                ".lint",
                ".display_mode",
                ".max_rows",
+               ".more",
                ".reload_config",
                ".explore",
                ".summarize",
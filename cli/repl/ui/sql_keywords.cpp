@@ -44,6 +44,7 @@ const std::vector<std::string>& markql_completion_keywords() {
                                                     "parquet",
                                                     "json",
                                                     "ndjson",
+                                                    "arrow",
                                                     "document",
                                                     "doc",
                                                     "raw",
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "markql/columnar_result.h"
+
+// Arrow C data interface structures, copied verbatim from the Arrow specification
+// (https://arrow.apache.org/docs/format/CDataInterface.html) and guarded so they coexist with
+// Arrow's own definition when both headers are included.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+}  // extern "C"
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace markql {
+
+/// Exports `result` as one Arrow record batch: a struct array with a child per column, and its
+/// schema. Types: int64 ("l"), large_utf8 ("U"), dictionary<int32, large_utf8> and
+/// map<large_utf8, large_utf8 | float64> with sorted keys. The arrays point into `result`'s
+/// buffers without copying and keep it alive until released, so it may be exported any number
+/// of times. The consumer MUST call both release callbacks.
+void export_columnar_result(const std::shared_ptr<const ColumnarResult>& result,
+                            ArrowSchema* out_schema, ArrowArray* out_array);
+
+}  // namespace markql
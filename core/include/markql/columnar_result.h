@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "markql/markql.h"
+
+namespace markql {
+
+/// Variable-length strings in Arrow large_utf8 layout: `offsets` holds size() + 1 int64 byte
+/// offsets into `data`, starting at 0.
+struct ColumnarStrings {
+  std::vector<int64_t> offsets{0};
+  std::string data;
+
+  size_t size() const { return offsets.size() - 1; }
+  std::string_view at(size_t i) const {
+    return std::string_view(data).substr(static_cast<size_t>(offsets[i]),
+                                         static_cast<size_t>(offsets[i + 1] - offsets[i]));
+  }
+  void append(std::string_view value) {
+    data.append(value.data(), value.size());
+    offsets.push_back(static_cast<int64_t>(data.size()));
+  }
+};
+
+/// One result column in Arrow memory layout, so Arrow consumers can adopt its buffers as is.
+/// Which buffers are used depends on `type`:
+/// - Int64: `int64_values` (node_id, count, parent_id, sibling_pos, max_depth, doc_order).
+/// - Utf8: `strings` (text, inner_html, source_uri, attribute and computed columns).
+/// - DictionaryUtf8: int32 `dictionary_indices` into the distinct values in `strings` (tag).
+/// - StringMap / DoubleMap: int32 `map_offsets` (size num_rows + 1) into entries whose keys are
+///   in `strings` and whose items are in `map_items` / `map_double_items`; keys are sorted
+///   within each row (attributes, terms_score).
+struct ColumnarColumn {
+  enum class Type { Int64, Utf8, DictionaryUtf8, StringMap, DoubleMap };
+
+  std::string name;
+  Type type = Type::Utf8;
+  /// Arrow validity bitmap (bit i set when row i is valid, least significant bit first); left
+  /// empty while no row is null.
+  std::vector<uint8_t> validity;
+  int64_t null_count = 0;
+  std::vector<int64_t> int64_values;
+  ColumnarStrings strings;
+  std::vector<int32_t> dictionary_indices;
+  std::vector<int32_t> map_offsets;
+  ColumnarStrings map_items;
+  std::vector<double> map_double_items;
+
+  /// True when some row took this column's value from QueryResultRow::computed_fields (PROJECT
+  /// fields and expression aliases) rather than a node field or attribute.
+  bool computed = false;
+
+  bool is_valid(size_t row) const {
+    return validity.empty() || ((validity[row / 8] >> (row % 8)) & 1) != 0;
+  }
+};
+
+/// A rectangular query result stored column by column. Column names and order follow
+/// QueryResult::columns.
+struct ColumnarResult {
+  int64_t num_rows = 0;
+  std::vector<ColumnarColumn> columns;
+  std::vector<std::string> warnings;
+
+  const ColumnarColumn* find(const std::string& name) const;
+};
+
+/// Builds a ColumnarResult from rows as execution produces them: pass it to a streaming
+/// execute_query_* overload, then call finish(). Rows are appended to the columns and never
+/// held as QueryResultRow. Declines TO TABLE() results, which have no rows to stream.
+class ColumnarResultBuilder : public QueryResultSink {
+ public:
+  bool begin(const QueryResult& header) override;
+  void row(const QueryResultRow& row) override;
+
+  /// Returns the columns built so far plus the warnings of `result` (the value the streaming
+  /// overload returned) and resets the builder.
+  ColumnarResult finish(const QueryResult& result);
+  /// The columns built since begin(), for inspecting them before finish().
+  const ColumnarResult& columns() const { return out_; }
+
+ private:
+  ColumnarResult out_;
+  std::vector<std::unordered_map<std::string, int32_t>> dictionaries_;
+  /// One per column, so PROJECT values are read by slot rather than by name.
+  std::vector<ComputedFieldLookup> computed_;
+};
+
+/// Converts an already materialized result; its columns match what ColumnarResultBuilder
+/// builds for the same query.
+ColumnarResult to_columnar_result(const QueryResult& result);
+
+}  // namespace markql
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "markql/markql.h"
+
+namespace markql {
+
+/// Appends `value` to `out` as the body of a JSON string (no quotes). '"', '\\' and bytes
+/// below 0x20 are escaped (\b \f \n \r \t, otherwise \u00xx); all other bytes, including
+/// UTF-8 sequences, are copied unchanged. Runs of plain bytes are located 16 at a time where
+/// SSE2 or NEON is available and copied with one append.
+void append_json_escaped(std::string& out, std::string_view value);
+/// Appends `value` as a quoted, escaped JSON string.
+void append_json_string(std::string& out, std::string_view value);
+/// Appends the shortest decimal that reads back as `value`, formatted like nlohmann::json
+/// (always a fraction or exponent: 2.0, 0.25, 1e-07); non-finite values become null.
+void append_json_number(std::string& out, double value);
+
+/// Writes JSON text straight into a caller-owned buffer, with no document tree in between.
+/// The caller may drain `out` between values (for example after each row) to bound memory.
+/// With `indent` 0 output is compact. With `indent` > 0 the layout matches
+/// nlohmann::json::dump(indent): one member per line, ": " after keys, and "[]" / "{}" for
+/// empty containers. `depth` is the nesting level the first value starts at, so an element
+/// written on its own still lines up inside an enclosing array.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::string& out, int indent = 0, int depth = 0);
+
+  void begin_object();
+  void end_object();
+  void begin_array();
+  void end_array();
+  /// Writes an object member name; the next call writes its value.
+  void key(std::string_view name);
+
+  void string(std::string_view value);
+  void integer(int64_t value);
+  void number(double value);
+  void boolean(bool value);
+  void null();
+  /// Writes already serialized JSON as one value.
+  void raw(std::string_view json);
+
+ private:
+  void before_value();
+  void newline(int depth);
+
+  std::string& out_;
+  int indent_;
+  int base_depth_;
+  /// One entry per open container: true until its first member is written.
+  std::vector<bool> empty_;
+  bool after_key_ = false;
+};
+
+/// Writes the JSON value of result column `field` for `row`: node_id, count, parent_id,
+/// sibling_pos, max_depth and doc_order as integers, attributes and terms_score as objects
+/// with sorted keys, computed fields and attributes as strings, and anything missing as null.
+void write_json_field(JsonWriter& writer, const QueryResultRow& row, const std::string& field);
+
+}  // namespace markql
@@ -13,6 +13,116 @@ namespace markql {
 
 struct ParsedDocumentHandle;
 
+/// Names of a result's computed columns (PROJECT fields, expression aliases and FLATTEN
+/// aliases). All rows of a result share one schema, so each row stores only its values,
+/// indexed by slot. Slots are assigned in first-use order and never change. Rows bound to
+/// one schema MUST be modified from a single thread, since inserting a new name grows it.
+class ComputedFieldSchema {
+ public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /// Returns the slot of `name`, adding it when new.
+  size_t add(const std::string& name);
+  /// Returns the slot of `name`, or npos.
+  size_t find(const std::string& name) const;
+  const std::string& name(size_t slot) const { return names_[slot]; }
+  size_t size() const { return names_.size(); }
+
+ private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, size_t> slots_;
+};
+
+/// One row's computed columns: a flat vector of nullable cells indexed by the slots of a
+/// shared ComputedFieldSchema. Keeps the lookup interface of the name -> value map it replaced
+/// (operator[], at, find/end, count, iteration as first/second pairs), so callers that look
+/// fields up by name still compile. A row without a schema creates its own on first insert.
+class ComputedFields {
+ public:
+  struct Entry {
+    const std::string& first;
+    const std::string& second;
+  };
+
+  /// Visits the set cells in slot order.
+  class const_iterator {
+   public:
+    struct Arrow {
+      Entry entry;
+      const Entry* operator->() const { return &entry; }
+    };
+
+    const_iterator(const ComputedFields* fields, size_t slot) : fields_(fields), slot_(slot) {
+      skip_unset();
+    }
+    Entry operator*() const {
+      return Entry{fields_->schema_->name(slot_), *fields_->cells_[slot_]};
+    }
+    Arrow operator->() const { return Arrow{**this}; }
+    const_iterator& operator++() {
+      ++slot_;
+      skip_unset();
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const { return slot_ == other.slot_; }
+    bool operator!=(const const_iterator& other) const { return slot_ != other.slot_; }
+
+   private:
+    void skip_unset() {
+      while (slot_ < fields_->cells_.size() && !fields_->cells_[slot_].has_value()) ++slot_;
+    }
+
+    const ComputedFields* fields_;
+    size_t slot_;
+  };
+  using iterator = const_iterator;
+
+  ComputedFields() = default;
+  explicit ComputedFields(std::shared_ptr<ComputedFieldSchema> schema)
+      : schema_(std::move(schema)) {}
+
+  /// Returns the value of `name`, setting it to "" first when unset.
+  std::string& operator[](const std::string& name);
+  /// Returns the value of `name`; throws std::out_of_range when unset.
+  const std::string& at(const std::string& name) const;
+  const_iterator find(const std::string& name) const;
+  size_t count(const std::string& name) const { return find(name) != end() ? 1 : 0; }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, cells_.size()); }
+  bool empty() const { return begin() == end(); }
+  /// Equal when the same names are set to the same values, whatever the schemas' slot order.
+  bool operator==(const ComputedFields& other) const;
+  bool operator!=(const ComputedFields& other) const { return !(*this == other); }
+
+  /// The value in `slot` of schema(), or nullptr when unset.
+  const std::string* get(size_t slot) const {
+    return slot < cells_.size() && cells_[slot].has_value() ? &*cells_[slot] : nullptr;
+  }
+  /// Sets `slot` of schema() to `value`.
+  void set(size_t slot, std::string value);
+  const std::shared_ptr<ComputedFieldSchema>& schema() const { return schema_; }
+
+ private:
+  std::shared_ptr<ComputedFieldSchema> schema_;
+  std::vector<std::optional<std::string>> cells_;
+};
+
+/// Looks one computed column up across many rows. The slot is resolved once per schema, so
+/// rows that share a schema cost an index instead of a name lookup.
+class ComputedFieldLookup {
+ public:
+  explicit ComputedFieldLookup(std::string name) : name_(std::move(name)) {}
+
+  const std::string* find(const ComputedFields& fields) const;
+
+ private:
+  std::string name_;
+  mutable std::shared_ptr<const ComputedFieldSchema> schema_;
+  /// Schema size when `slot_` was resolved, so a name added later is still found.
+  mutable size_t schema_size_ = 0;
+  mutable size_t slot_ = ComputedFieldSchema::npos;
+};
+
 /// Represents a single materialized row so callers can format or export results consistently.
 /// MUST keep fields aligned with the executor/output contract to avoid schema drift.
 /// Inputs/outputs are the row fields; side effects are none but consumers may rely on defaults.
@@ -23,7 +133,7 @@ struct QueryResultRow {
   std::string inner_html;
   std::unordered_map<std::string, double> term_scores;
   std::unordered_map<std::string, std::string> attributes;
-  std::unordered_map<std::string, std::string> computed_fields;
+  ComputedFields computed_fields;
   std::optional<int64_t> parent_id;
   int64_t sibling_pos = 0;
   int64_t max_depth = 0;
@@ -49,11 +159,27 @@ struct QueryResult {
     /// Describes an export target so the CLI can write files without re-parsing the query.
     /// MUST use Kind::None to indicate no export and MUST carry a valid path otherwise.
     /// Inputs are kind/path; side effects occur when the CLI performs the write.
-    enum class Kind { None, Csv, Parquet, Json, Ndjson } kind = Kind::None;
+    enum class Kind { None, Csv, Parquet, Json, Ndjson, Arrow } kind = Kind::None;
     // WHY: defaulting to None prevents accidental file writes when a sink is not specified.
     std::string path;
+    /// TO PARQUET('path', ROW_GROUP=n, COMPRESSION=..., INFER_TYPES=ON|OFF) settings.
+    struct ParquetOptions {
+      enum class Compression { Snappy, Zstd, Gzip, None } compression = Compression::Snappy;
+      /// Maximum rows per row group.
+      int64_t row_group_size = int64_t{1} << 20;
+      /// When set, computed (PROJECT/expression) columns whose every value is an integer or a
+      /// decimal number are written as int64 or double instead of text.
+      bool infer_types = true;
+    } parquet;
+    /// TO CSV/JSON/NDJSON('path', FSYNC=ON): fsync the file before the export reports success.
+    bool fsync = false;
+    /// TO CSV/JSON/NDJSON('path', COMPRESSION=GZIP|ZSTD|NONE); Auto picks gzip for ".gz"
+    /// paths, zstd for ".zst" and none otherwise.
+    enum class Compression { Auto, None, Gzip, Zstd } compression = Compression::Auto;
   };
   std::vector<std::string> columns;
+  /// Names of the rows' computed fields, stored once for the result; rows share it.
+  std::shared_ptr<const ComputedFieldSchema> computed_schema;
   std::vector<QueryResultRow> rows;
   std::vector<std::string> warnings;
   /// True when output columns come from implicit defaults (e.g., SELECT * or tag-only).
@@ -78,6 +204,33 @@ struct QueryResult {
   ExportSink export_sink;
 };
 
+/// Receives a query's rows while execution produces them, so callers can serialize a result
+/// without holding every row. Blocking steps (ORDER BY, TFIDF, SUMMARIZE, FLATTEN) still finish
+/// before the first row arrives; the sink sees the same rows in the same order either way.
+/// MUST NOT keep references to a row after row() returns.
+class QueryResultSink {
+ public:
+  virtual ~QueryResultSink() = default;
+  /// Called once before the first row with the result's columns, flags and export intent;
+  /// `header.rows` is empty and warnings may still grow until execution returns. Returning
+  /// false declines the stream: the rows then stay in the returned QueryResult and neither
+  /// row() nor end() is called.
+  virtual bool begin(const QueryResult& header) = 0;
+  virtual void row(const QueryResultRow& row) = 0;
+  /// Offered instead of begin() when a statement exports exactly one TO TABLE() result, so the
+  /// table can be written while it is read from the document. `table` carries node_id, headers
+  /// and header_keys but no rows; `column_count` is the widest row that follows. Returning true
+  /// sends the rows TableResult::rows would hold to table_row(), then calls end(); the default
+  /// declines and the table is returned in QueryResult::tables.
+  virtual bool begin_table(const QueryResult& /*header*/,
+                           const QueryResult::TableResult& /*table*/, size_t /*column_count*/) {
+    return false;
+  }
+  virtual void table_row(const std::vector<std::string>& /*cells*/) {}
+  /// Called once after the last accepted row; not called when execution throws.
+  virtual void end() {}
+};
+
 /// Executes a query over an in-memory HTML document for zero-IO operation.
 /// MUST receive valid HTML and MUST treat the input as immutable.
 /// Inputs are HTML/query; failures throw exceptions and side effects are none.
@@ -97,6 +250,17 @@ QueryResult execute_query_from_file(const std::string& path, const std::string&
 /// Inputs are url/query/timeout; side effects include network IO and thrown errors.
 QueryResult execute_query_from_url(const std::string& url, const std::string& query,
                                    int timeout_ms);
+/// Streaming variants of the entry points above: rows go to `sink` as they are produced and
+/// the returned result carries everything else (columns, tables, warnings, export intent).
+QueryResult execute_query_from_document(const std::string& html, const std::string& query,
+                                        QueryResultSink& sink);
+QueryResult execute_query_from_prepared_document(
+    const std::shared_ptr<const ParsedDocumentHandle>& prepared, const std::string& query,
+    QueryResultSink& sink);
+QueryResult execute_query_from_file(const std::string& path, const std::string& query,
+                                    QueryResultSink& sink);
+QueryResult execute_query_from_url(const std::string& url, const std::string& query,
+                                   int timeout_ms, QueryResultSink& sink);
 
 }  // namespace markql
 
@@ -12,6 +12,17 @@ namespace markql {
 
 namespace {
 
+/// Initializes libxml2's global state once per process.
+/// WHY: libxml2 2.9 requires this before parsing from several threads, which concurrent CTE
+/// evaluation can do.
+void ensure_libxml2_initialized() {
+  static const bool initialized = []() {
+    xmlInitParser();
+    return true;
+  }();
+  (void)initialized;
+}
+
 /// Attempts to extract the declared charset from the HTML head.
 /// MUST only scan a small prefix to avoid expensive full-document copies.
 /// Inputs are raw HTML; outputs are lowercase charset tokens or empty string.
@@ -141,6 +152,7 @@ void walk_node(HtmlDocument& doc, xmlNode* node, std::vector<int64_t>& stack) {
 /// Inputs are HTML strings; outputs are HtmlDocument with no side effects.
 HtmlDocument parse_html_libxml2(const std::string& html) {
   HtmlDocument doc;
+  ensure_libxml2_initialized();
   std::string charset = extract_charset(html);
   const char* encoding = charset.empty() ? "UTF-8" : charset.c_str();
   // WHY: recovery mode handles malformed HTML commonly found on the web.
@@ -161,6 +173,7 @@ HtmlDocument parse_html_libxml2(const std::string& html) {
 }
 
 int64_t count_html_nodes_libxml2(const std::string& html) {
+  ensure_libxml2_initialized();
   std::string charset = extract_charset(html);
   const char* encoding = charset.empty() ? "UTF-8" : charset.c_str();
   htmlDocPtr html_doc =
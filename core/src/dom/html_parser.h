@@ -6,6 +6,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "node_text_cache.h"
+
 namespace markql {
 
 struct HtmlNode {
@@ -21,6 +23,8 @@ struct HtmlNode {
 
 struct HtmlDocument {
   std::vector<HtmlNode> nodes;
+  /// Per-node derived text memo (see node_text_cache.h); reset on copy.
+  NodeTextCache text_cache;
 };
 
 HtmlDocument parse_html(const std::string& html);
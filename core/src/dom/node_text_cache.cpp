@@ -0,0 +1,67 @@
+#include "node_text_cache.h"
+
+#include "../runtime/engine/markql_internal.h"
+#include "html_parser.h"
+
+namespace markql {
+
+namespace {
+
+constexpr size_t kKindCount = static_cast<size_t>(NodeTextCache::Kind::Count);
+
+}  // namespace
+
+NodeTextCache::State::~State() {
+  const size_t total = capacity * kKindCount;
+  for (size_t i = 0; i < total; ++i) {
+    delete slots[i].load(std::memory_order_relaxed);
+  }
+}
+
+std::atomic<const std::string*>* NodeTextCache::State::slot(Kind kind, size_t node_count,
+                                                            size_t node_id) {
+  // WHY: the cache is sized once, on first use, for the document's node count; nodes added
+  // afterwards are served uncached instead of resizing under concurrent readers.
+  std::call_once(init, [&]() {
+    capacity = node_count;
+    slots = std::make_unique<std::atomic<const std::string*>[]>(capacity * kKindCount);
+  });
+  if (node_id >= capacity || node_count != capacity) return nullptr;
+  return &slots[node_id * kKindCount + static_cast<size_t>(kind)];
+}
+
+namespace markql_internal {
+
+const std::string& cached_node_text(const HtmlDocument& doc, const HtmlNode& node,
+                                    NodeTextCache::Kind kind,
+                                    std::string (*compute)(const HtmlNode&),
+                                    std::string& scratch) {
+  // WHY: identity, not content, decides a hit: a node rewritten under its document id must not
+  // see the memo, and comparing content to prove otherwise would cost O(n) per lookup.
+  if (node.id >= 0 && static_cast<size_t>(node.id) < doc.nodes.size() &&
+      &doc.nodes[static_cast<size_t>(node.id)] == &node) {
+    const std::string* cached = doc.text_cache.get_or_compute(
+        kind, doc.nodes.size(), static_cast<size_t>(node.id), [&]() { return compute(node); });
+    if (cached != nullptr) return *cached;
+  }
+  scratch = compute(node);
+  return scratch;
+}
+
+const std::string& cached_direct_text(const HtmlDocument& doc, const HtmlNode& node,
+                                      std::string& scratch) {
+  return cached_node_text(
+      doc, node, NodeTextCache::Kind::DirectText,
+      [](const HtmlNode& n) { return extract_direct_text(n.inner_html); }, scratch);
+}
+
+const std::string& cached_direct_text_strict(const HtmlDocument& doc, const HtmlNode& node,
+                                             std::string& scratch) {
+  return cached_node_text(
+      doc, node, NodeTextCache::Kind::DirectTextStrict,
+      [](const HtmlNode& n) { return extract_direct_text_strict(n.inner_html); }, scratch);
+}
+
+}  // namespace markql_internal
+
+}  // namespace markql
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace markql {
+
+/// Lazily memoized text derived from a node's inner_html (direct text, normalized text).
+/// MUST be safe for concurrent readers; each slot is computed at most once per winner and
+/// published with a compare-and-swap. Copies of a document start with an empty cache so
+/// derived text never outlives the nodes it was computed from.
+class NodeTextCache {
+ public:
+  enum class Kind : size_t {
+    DirectText = 0,
+    DirectTextStrict,
+    NormalizedDirectText,
+    NormalizedExtractText,
+    Count
+  };
+
+  NodeTextCache() : state_(std::make_shared<State>()) {}
+  NodeTextCache(const NodeTextCache&) : state_(std::make_shared<State>()) {}
+  NodeTextCache(NodeTextCache&&) noexcept = default;
+  NodeTextCache& operator=(const NodeTextCache&) {
+    state_ = std::make_shared<State>();
+    return *this;
+  }
+  NodeTextCache& operator=(NodeTextCache&&) noexcept = default;
+
+  /// Returns the memoized value for (kind, node_id), computing it with `compute()` on a miss.
+  /// Returns nullptr when node_id is outside the document the cache was sized for.
+  /// Inputs are the current node count and a callable returning std::string.
+  template <typename Compute>
+  const std::string* get_or_compute(Kind kind, size_t node_count, size_t node_id,
+                                    Compute&& compute) const {
+    if (!state_) return nullptr;
+    std::atomic<const std::string*>* slot = state_->slot(kind, node_count, node_id);
+    if (slot == nullptr) return nullptr;
+    const std::string* cached = slot->load(std::memory_order_acquire);
+    if (cached != nullptr) return cached;
+    auto fresh = std::make_unique<const std::string>(compute());
+    const std::string* expected = nullptr;
+    if (slot->compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+      return fresh.release();
+    }
+    return expected;
+  }
+
+ private:
+  struct State {
+    State() = default;
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
+    ~State();
+
+    std::atomic<const std::string*>* slot(Kind kind, size_t node_count, size_t node_id);
+
+    std::once_flag init;
+    size_t capacity = 0;
+    std::unique_ptr<std::atomic<const std::string*>[]> slots;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+struct HtmlDocument;
+struct HtmlNode;
+
+namespace markql_internal {
+
+/// Returns derived text for `node`, memoized on doc.text_cache when `node` is doc.nodes[node.id]
+/// itself. MUST compute from `node` into `scratch` for any other node, copies included; the
+/// returned reference points into the cache or into `scratch`.
+const std::string& cached_node_text(const HtmlDocument& doc, const HtmlNode& node,
+                                    NodeTextCache::Kind kind,
+                                    std::string (*compute)(const HtmlNode&),
+                                    std::string& scratch);
+/// extract_direct_text(node.inner_html), memoized per node.
+const std::string& cached_direct_text(const HtmlDocument& doc, const HtmlNode& node,
+                                      std::string& scratch);
+/// extract_direct_text_strict(node.inner_html), memoized per node.
+const std::string& cached_direct_text_strict(const HtmlDocument& doc, const HtmlNode& node,
+                                             std::string& scratch);
+
+}  // namespace markql_internal
+
+}  // namespace markql
@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include "helper_policy.h"
+#include "markql/json_writer.h"
 
 namespace markql::helper {
 
@@ -10,29 +11,7 @@ namespace {
 
 std::string escape_json(const std::string& text) {
   std::string out;
-  out.reserve(text.size() + 8);
-  for (char c : text) {
-    switch (c) {
-      case '\\':
-        out += "\\\\";
-        break;
-      case '"':
-        out += "\\\"";
-        break;
-      case '\n':
-        out += "\\n";
-        break;
-      case '\r':
-        out += "\\r";
-        break;
-      case '\t':
-        out += "\\t";
-        break;
-      default:
-        out += c;
-        break;
-    }
-  }
+  markql::append_json_escaped(out, text);
   return out;
 }
 
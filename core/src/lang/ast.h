@@ -10,6 +10,12 @@
 
 namespace markql {
 
+namespace util {
+class CompiledLikePattern;
+class MultiPatternMatcher;
+class StringSet;
+}  // namespace util
+
 struct Span {
   size_t start = 0;
   size_t end = 0;
@@ -79,6 +85,11 @@ struct ScalarExpr {
 struct ValueList {
   std::vector<std::string> values;
   Span span;
+  /// Parser-compiled lookup structures for literal right-hand sides; null when not compiled.
+  /// `exact_set` serves IN, `token_matcher` serves CONTAINS ANY/ALL, `like_pattern` serves LIKE.
+  std::shared_ptr<const util::StringSet> exact_set;
+  std::shared_ptr<const util::MultiPatternMatcher> token_matcher;
+  std::shared_ptr<const util::CompiledLikePattern> like_pattern;
 };
 
 struct CompareExpr {
@@ -151,9 +162,17 @@ struct Query {
     bool lateral = false;
     Span span;
   };
+  struct ParquetOptions {
+    enum class Compression { Snappy, Zstd, Gzip, None } compression = Compression::Snappy;
+    int64_t row_group_size = int64_t{1} << 20;
+    bool infer_types = true;
+  };
   struct ExportSink {
-    enum class Kind { None, Csv, Parquet, Json, Ndjson } kind = Kind::None;
+    enum class Kind { None, Csv, Parquet, Json, Ndjson, Arrow } kind = Kind::None;
     std::string path;
+    ParquetOptions parquet;
+    bool fsync = false;
+    enum class Compression { Auto, None, Gzip, Zstd } compression = Compression::Auto;
     Span span;
   };
   struct OrderBy {
@@ -199,6 +218,8 @@ struct Query {
       std::vector<Expr> case_when_conditions;
       std::vector<FlattenExtractExpr> case_when_values;
       std::shared_ptr<FlattenExtractExpr> case_else;
+      /// Parser-compiled pattern for __CMP_LIKE with a string literal right-hand side.
+      std::shared_ptr<const util::CompiledLikePattern> like_pattern;
       Span span;
     };
     enum class Aggregate { None, Count, Summarize, Tfidf } aggregate = Aggregate::None;
@@ -92,6 +92,7 @@ DiagnosticSpan best_effort_semantic_span(const std::string& query, const std::st
     if (auto span = find_keyword_span(query, "TO PARQUET"); span.has_value()) return *span;
     if (auto span = find_keyword_span(query, "TO JSON"); span.has_value()) return *span;
     if (auto span = find_keyword_span(query, "TO NDJSON"); span.has_value()) return *span;
+    if (auto span = find_keyword_span(query, "TO ARROW"); span.has_value()) return *span;
   }
   if (contains_icase(message, "Duplicate source alias") ||
       contains_icase(message, "Identifier 'doc' is not bound") ||
@@ -415,11 +415,12 @@ bool apply_family_based_syntax_details(Diagnostic& d, const std::string& query,
       d.message = "TO requires an output target";
       d.why =
           "After TO, MarkQL expects a supported output target such as LIST(), TABLE(), CSV(...), "
-          "JSON(), or NDJSON().";
+          "JSON(), NDJSON(), or ARROW().";
       d.expected = format_expected_choices(expectation.candidates);
       set_choice_help(
           d, encountered.text, expectation.candidates,
-          "Use TO LIST(), TO TABLE(), TO CSV(...), TO PARQUET(...), TO JSON(), or TO NDJSON().",
+          "Use TO LIST(), TO TABLE(), TO CSV(...), TO PARQUET(...), TO JSON(), TO NDJSON(), or "
+          "TO ARROW().",
           "SELECT a.href FROM doc WHERE href IS NOT NULL TO LIST()");
       return true;
     }
@@ -2,6 +2,8 @@
 
 #include <sstream>
 
+#include "markql/json_writer.h"
+
 namespace markql::diagnostics_internal {
 
 constexpr const char* kAnsiReset = "\033[0m";
@@ -94,30 +96,9 @@ std::string lint_coverage_note(const LintSummary& summary) {
 }
 
 std::string json_escape(std::string_view s) {
-  std::ostringstream out;
-  for (char c : s) {
-    switch (c) {
-      case '\\':
-        out << "\\\\";
-        break;
-      case '"':
-        out << "\\\"";
-        break;
-      case '\n':
-        out << "\\n";
-        break;
-      case '\r':
-        out << "\\r";
-        break;
-      case '\t':
-        out << "\\t";
-        break;
-      default:
-        out << c;
-        break;
-    }
-  }
-  return out.str();
+  std::string out;
+  markql::append_json_escaped(out, s);
+  return out;
 }
 
 std::string render_code_frame(const std::string& query, const DiagnosticSpan& span,
@@ -1,5 +1,9 @@
 #include "parser_internal.h"
 
+#include <memory>
+
+#include "../../util/string_search.h"
+
 namespace markql {
 
 /// Parses an expression with OR precedence.
@@ -128,6 +132,8 @@ bool Parser::parse_cmp_expr(Expr& out) {
     ScalarExpr pattern_expr;
     pattern_expr.kind = ScalarExpr::Kind::StringLiteral;
     pattern_expr.string_value = "%" + needle + "%";
+    like_cmp.rhs.like_pattern =
+        std::make_shared<util::CompiledLikePattern>(pattern_expr.string_value);
     like_cmp.rhs_expr = pattern_expr;
 
     auto node = std::make_shared<BinaryExpr>();
@@ -162,6 +168,10 @@ bool Parser::parse_cmp_expr(Expr& out) {
       return set_error("CONTAINS with multiple values requires ALL or ANY");
     }
     cmp.rhs = values;
+    if (cmp.op != CompareExpr::Op::Contains &&
+        cmp.rhs.values.size() >= util::kCompiledValueListMinSize) {
+      cmp.rhs.token_matcher = std::make_shared<util::MultiPatternMatcher>(cmp.rhs.values);
+    }
     cmp.rhs_expr_list.clear();
     for (const auto& value : values.values) {
       ScalarExpr lit;
@@ -227,6 +237,8 @@ bool Parser::parse_cmp_expr(Expr& out) {
     }
     if (!all_literals) {
       cmp.rhs.values.clear();
+    } else if (cmp.rhs.values.size() >= util::kCompiledValueListMinSize) {
+      cmp.rhs.exact_set = std::make_shared<util::StringSet>(cmp.rhs.values);
     }
     out = cmp;
     return true;
@@ -274,6 +286,9 @@ bool Parser::parse_cmp_expr(Expr& out) {
                                  ? rhs.string_value
                                  : std::to_string(rhs.number_value));
   }
+  if (cmp.op == CompareExpr::Op::Like && rhs.kind == ScalarExpr::Kind::StringLiteral) {
+    cmp.rhs.like_pattern = std::make_shared<util::CompiledLikePattern>(rhs.string_value);
+  }
   out = cmp;
   return true;
 }
@@ -27,6 +27,8 @@ class Parser {
   bool parse_source(Source& src);
   bool parse_subquery(std::shared_ptr<Query>& out);
   bool parse_query_body(Query& q);
+  bool parse_parquet_options(Query::ParquetOptions& options);
+  bool parse_text_export_options(Query::ExportSink& sink);
   bool parse_with_clause(Query::WithClause& with_clause);
   bool parse_join_clauses(std::vector<Query::JoinItem>& joins);
   bool parse_show(Query& q);
@@ -340,12 +340,16 @@ bool Parser::parse_query_body(Query& q) {
     } else if (current_.type == TokenType::KeywordCsv ||
                current_.type == TokenType::KeywordParquet ||
                current_.type == TokenType::KeywordJson ||
-               current_.type == TokenType::KeywordNdjson) {
+               current_.type == TokenType::KeywordNdjson ||
+               // WHY: ARROW is matched in place rather than lexed as a keyword so existing
+               // queries that use "arrow" as a name keep parsing.
+               (current_.type == TokenType::Identifier && to_upper(current_.text) == "ARROW")) {
       Query::ExportSink sink;
       sink.kind = (current_.type == TokenType::KeywordCsv)       ? Query::ExportSink::Kind::Csv
                   : (current_.type == TokenType::KeywordParquet) ? Query::ExportSink::Kind::Parquet
                   : (current_.type == TokenType::KeywordJson)    ? Query::ExportSink::Kind::Json
-                                                                 : Query::ExportSink::Kind::Ndjson;
+                  : (current_.type == TokenType::KeywordNdjson)  ? Query::ExportSink::Kind::Ndjson
+                                                                 : Query::ExportSink::Kind::Arrow;
       size_t start = current_.pos;
       advance();
       if (!consume(TokenType::LParen, "Expected ( after export target")) return false;
@@ -361,16 +365,151 @@ bool Parser::parse_query_body(Query& q) {
         sink.path.clear();
         sink.span = Span{start, current_.pos};
       }
+      if (sink.kind == Query::ExportSink::Kind::Parquet && current_.type == TokenType::Comma) {
+        if (!parse_parquet_options(sink.parquet)) return false;
+      } else if (sink.kind != Query::ExportSink::Kind::Arrow && !sink.path.empty() &&
+                 current_.type == TokenType::Comma) {
+        if (!parse_text_export_options(sink)) return false;
+      }
       if (!consume(TokenType::RParen, "Expected ) after export path")) return false;
       q.export_sink = sink;
     } else {
-      set_error("Expected LIST, TABLE, CSV, PARQUET, JSON, or NDJSON after TO");
+      set_error("Expected LIST, TABLE, CSV, PARQUET, JSON, NDJSON, or ARROW after TO");
       return false;
     }
   }
   return true;
 }
 
+bool Parser::parse_parquet_options(Query::ParquetOptions& options) {
+  bool saw_row_group = false;
+  bool saw_compression = false;
+  bool saw_infer_types = false;
+  while (current_.type == TokenType::Comma) {
+    advance();
+    if (current_.type != TokenType::Identifier) {
+      return set_error("Expected ROW_GROUP, COMPRESSION, or INFER_TYPES inside PARQUET()");
+    }
+    const std::string option = to_upper(current_.text);
+    advance();
+    if (current_.type == TokenType::Equal) {
+      advance();
+    }
+    if (option == "ROW_GROUP") {
+      if (saw_row_group) {
+        return set_error("Duplicate ROW_GROUP option inside PARQUET()");
+      }
+      if (current_.type != TokenType::Number) {
+        return set_error("Expected positive integer after ROW_GROUP");
+      }
+      try {
+        options.row_group_size = std::stoll(current_.text);
+      } catch (...) {
+        return set_error("Expected positive integer after ROW_GROUP");
+      }
+      if (options.row_group_size <= 0) {
+        return set_error("Expected positive integer after ROW_GROUP");
+      }
+      saw_row_group = true;
+    } else if (option == "COMPRESSION") {
+      if (saw_compression) {
+        return set_error("Duplicate COMPRESSION option inside PARQUET()");
+      }
+      if (current_.type != TokenType::Identifier && current_.type != TokenType::String) {
+        return set_error("Expected SNAPPY, ZSTD, GZIP, or NONE after COMPRESSION");
+      }
+      const std::string value = to_upper(current_.text);
+      if (value == "SNAPPY") {
+        options.compression = Query::ParquetOptions::Compression::Snappy;
+      } else if (value == "ZSTD") {
+        options.compression = Query::ParquetOptions::Compression::Zstd;
+      } else if (value == "GZIP") {
+        options.compression = Query::ParquetOptions::Compression::Gzip;
+      } else if (value == "NONE" || value == "UNCOMPRESSED") {
+        options.compression = Query::ParquetOptions::Compression::None;
+      } else {
+        return set_error("Expected SNAPPY, ZSTD, GZIP, or NONE after COMPRESSION");
+      }
+      saw_compression = true;
+    } else if (option == "INFER_TYPES") {
+      if (saw_infer_types) {
+        return set_error("Duplicate INFER_TYPES option inside PARQUET()");
+      }
+      if (current_.type != TokenType::Identifier && current_.type != TokenType::KeywordOn) {
+        return set_error("Expected ON or OFF after INFER_TYPES");
+      }
+      const std::string value = to_upper(current_.text);
+      if (value == "ON") {
+        options.infer_types = true;
+      } else if (value == "OFF") {
+        options.infer_types = false;
+      } else {
+        return set_error("Expected ON or OFF after INFER_TYPES");
+      }
+      saw_infer_types = true;
+    } else {
+      return set_error("Expected ROW_GROUP, COMPRESSION, or INFER_TYPES inside PARQUET()");
+    }
+    advance();
+  }
+  return true;
+}
+
+bool Parser::parse_text_export_options(Query::ExportSink& sink) {
+  bool saw_fsync = false;
+  bool saw_compression = false;
+  while (current_.type == TokenType::Comma) {
+    advance();
+    if (current_.type != TokenType::Identifier) {
+      return set_error("Expected FSYNC or COMPRESSION inside CSV(), JSON() or NDJSON()");
+    }
+    const std::string option = to_upper(current_.text);
+    advance();
+    if (current_.type == TokenType::Equal) {
+      advance();
+    }
+    if (option == "FSYNC") {
+      if (saw_fsync) {
+        return set_error("Duplicate FSYNC option inside export target");
+      }
+      if (current_.type != TokenType::Identifier && current_.type != TokenType::KeywordOn) {
+        return set_error("Expected ON or OFF after FSYNC");
+      }
+      const std::string value = to_upper(current_.text);
+      if (value == "ON") {
+        sink.fsync = true;
+      } else if (value == "OFF") {
+        sink.fsync = false;
+      } else {
+        return set_error("Expected ON or OFF after FSYNC");
+      }
+      saw_fsync = true;
+    } else if (option == "COMPRESSION") {
+      if (saw_compression) {
+        return set_error("Duplicate COMPRESSION option inside export target");
+      }
+      if (current_.type != TokenType::Identifier && current_.type != TokenType::String) {
+        return set_error("Expected GZIP, ZSTD, or NONE after COMPRESSION");
+      }
+      const std::string value = to_upper(current_.text);
+      if (value == "GZIP") {
+        sink.compression = Query::ExportSink::Compression::Gzip;
+      } else if (value == "ZSTD") {
+        sink.compression = Query::ExportSink::Compression::Zstd;
+      } else if (value == "NONE") {
+        sink.compression = Query::ExportSink::Compression::None;
+      } else {
+        return set_error("Expected GZIP, ZSTD, or NONE after COMPRESSION");
+      }
+      saw_compression = true;
+    } else {
+      return set_error("Expected FSYNC or COMPRESSION inside CSV(), JSON() or NDJSON()");
+    }
+    advance();
+  }
+  return true;
+}
+
 bool Parser::parse_with_clause(Query::WithClause& with_clause) {
   if (!consume(TokenType::KeywordWith, "Expected WITH")) return false;
   size_t with_start = current_.pos;
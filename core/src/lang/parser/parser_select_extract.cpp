@@ -1,6 +1,9 @@
 #include "parser_internal.h"
 
 #include <limits>
+#include <memory>
+
+#include "../../util/string_search.h"
 
 namespace markql {
 
@@ -276,6 +279,10 @@ bool Parser::parse_flatten_extract_alias_expr_pairs(Query::SelectItem& item) {
       Query::SelectItem::FlattenExtractExpr cmp_expr;
       cmp_expr.kind = Query::SelectItem::FlattenExtractExpr::Kind::FunctionCall;
       cmp_expr.function_name = op;
+      if (op == "__CMP_LIKE" &&
+          rhs.kind == Query::SelectItem::FlattenExtractExpr::Kind::StringLiteral) {
+        cmp_expr.like_pattern = std::make_shared<util::CompiledLikePattern>(rhs.string_value);
+      }
       cmp_expr.args.push_back(std::move(expr));
       cmp_expr.args.push_back(std::move(rhs));
       expr = std::move(cmp_expr);
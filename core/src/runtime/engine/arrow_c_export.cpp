@@ -0,0 +1,198 @@
+#include "markql/arrow_c_data.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace markql {
+
+namespace {
+
+/// Owns one exported ArrowSchema node: its strings and child structs.
+struct SchemaNode {
+  std::string format;
+  std::string name;
+  std::vector<std::unique_ptr<ArrowSchema>> child_storage;
+  std::vector<ArrowSchema*> children;
+  std::unique_ptr<ArrowSchema> dictionary;
+};
+
+/// Owns one exported ArrowArray node: its buffer table and child structs. `owner` keeps the
+/// columns the buffers point into alive.
+struct ArrayNode {
+  std::shared_ptr<const ColumnarResult> owner;
+  std::vector<const void*> buffers;
+  std::vector<std::unique_ptr<ArrowArray>> child_storage;
+  std::vector<ArrowArray*> children;
+  std::unique_ptr<ArrowArray> dictionary;
+};
+
+// WHY: some importers reject null pointers for zero-length buffers; point them here instead.
+alignas(8) const int64_t kEmptyBuffer[1] = {0};
+
+template <typename T>
+const void* buffer_or_empty(const std::vector<T>& values) {
+  return values.empty() ? static_cast<const void*>(kEmptyBuffer) : values.data();
+}
+
+const void* buffer_or_empty(const std::string& bytes) {
+  return bytes.empty() ? static_cast<const void*>(kEmptyBuffer) : bytes.data();
+}
+
+void release_schema(ArrowSchema* schema) {
+  if (schema == nullptr || schema->release == nullptr) return;
+  auto* node = static_cast<SchemaNode*>(schema->private_data);
+  for (ArrowSchema* child : node->children) {
+    if (child->release != nullptr) child->release(child);
+  }
+  if (node->dictionary != nullptr && node->dictionary->release != nullptr) {
+    node->dictionary->release(node->dictionary.get());
+  }
+  delete node;
+  schema->release = nullptr;
+}
+
+void release_array(ArrowArray* array) {
+  if (array == nullptr || array->release == nullptr) return;
+  auto* node = static_cast<ArrayNode*>(array->private_data);
+  for (ArrowArray* child : node->children) {
+    if (child->release != nullptr) child->release(child);
+  }
+  if (node->dictionary != nullptr && node->dictionary->release != nullptr) {
+    node->dictionary->release(node->dictionary.get());
+  }
+  delete node;
+  array->release = nullptr;
+}
+
+/// Fills `out` and returns its node so the caller can add children or a dictionary.
+SchemaNode* init_schema(ArrowSchema* out, std::string format, std::string name, int64_t flags) {
+  auto* node = new SchemaNode();
+  node->format = std::move(format);
+  node->name = std::move(name);
+  out->format = node->format.c_str();
+  out->name = node->name.c_str();
+  out->metadata = nullptr;
+  out->flags = flags;
+  out->n_children = 0;
+  out->children = nullptr;
+  out->dictionary = nullptr;
+  out->release = &release_schema;
+  out->private_data = node;
+  return node;
+}
+
+ArrowSchema* add_child(ArrowSchema* parent, std::string format, std::string name,
+                       int64_t flags) {
+  auto* node = static_cast<SchemaNode*>(parent->private_data);
+  node->child_storage.push_back(std::make_unique<ArrowSchema>());
+  ArrowSchema* child = node->child_storage.back().get();
+  init_schema(child, std::move(format), std::move(name), flags);
+  node->children.push_back(child);
+  parent->n_children = static_cast<int64_t>(node->children.size());
+  parent->children = node->children.data();
+  return child;
+}
+
+ArrayNode* init_array(ArrowArray* out, const std::shared_ptr<const ColumnarResult>& owner,
+                      int64_t length, int64_t null_count, std::vector<const void*> buffers) {
+  auto* node = new ArrayNode();
+  node->owner = owner;
+  node->buffers = std::move(buffers);
+  out->length = length;
+  out->null_count = null_count;
+  out->offset = 0;
+  out->n_buffers = static_cast<int64_t>(node->buffers.size());
+  out->n_children = 0;
+  out->buffers = node->buffers.data();
+  out->children = nullptr;
+  out->dictionary = nullptr;
+  out->release = &release_array;
+  out->private_data = node;
+  return node;
+}
+
+ArrowArray* add_child(ArrowArray* parent, int64_t length, int64_t null_count,
+                      std::vector<const void*> buffers) {
+  auto* node = static_cast<ArrayNode*>(parent->private_data);
+  node->child_storage.push_back(std::make_unique<ArrowArray>());
+  ArrowArray* child = node->child_storage.back().get();
+  init_array(child, node->owner, length, null_count, std::move(buffers));
+  node->children.push_back(child);
+  parent->n_children = static_cast<int64_t>(node->children.size());
+  parent->children = node->children.data();
+  return child;
+}
+
+std::vector<const void*> string_buffers(const ColumnarStrings& strings, const void* validity) {
+  return {validity, buffer_or_empty(strings.offsets), buffer_or_empty(strings.data)};
+}
+
+void export_column(const ColumnarColumn& column, int64_t num_rows, ArrowSchema* parent_schema,
+                   ArrowArray* parent_array) {
+  using Type = ColumnarColumn::Type;
+  const void* validity = column.validity.empty() ? nullptr : column.validity.data();
+  const int64_t nullable = ARROW_FLAG_NULLABLE;
+  switch (column.type) {
+    case Type::Int64:
+      add_child(parent_schema, "l", column.name, nullable);
+      add_child(parent_array, num_rows, column.null_count,
+                {validity, buffer_or_empty(column.int64_values)});
+      return;
+    case Type::Utf8:
+      add_child(parent_schema, "U", column.name, nullable);
+      add_child(parent_array, num_rows, column.null_count, string_buffers(column.strings, validity));
+      return;
+    case Type::DictionaryUtf8: {
+      ArrowSchema* schema = add_child(parent_schema, "i", column.name, nullable);
+      auto* schema_node = static_cast<SchemaNode*>(schema->private_data);
+      schema_node->dictionary = std::make_unique<ArrowSchema>();
+      init_schema(schema_node->dictionary.get(), "U", "", 0);
+      schema->dictionary = schema_node->dictionary.get();
+
+      ArrowArray* array = add_child(parent_array, num_rows, column.null_count,
+                                    {validity, buffer_or_empty(column.dictionary_indices)});
+      auto* array_node = static_cast<ArrayNode*>(array->private_data);
+      array_node->dictionary = std::make_unique<ArrowArray>();
+      init_array(array_node->dictionary.get(), array_node->owner,
+                 static_cast<int64_t>(column.strings.size()), 0,
+                 string_buffers(column.strings, nullptr));
+      array->dictionary = array_node->dictionary.get();
+      return;
+    }
+    case Type::StringMap:
+    case Type::DoubleMap: {
+      const bool doubles = column.type == Type::DoubleMap;
+      ArrowSchema* schema =
+          add_child(parent_schema, "+m", column.name, nullable | ARROW_FLAG_MAP_KEYS_SORTED);
+      ArrowSchema* entries_schema = add_child(schema, "+s", "entries", 0);
+      add_child(entries_schema, "U", "key", 0);
+      add_child(entries_schema, doubles ? "g" : "U", "value", nullable);
+
+      const int64_t entry_count = static_cast<int64_t>(column.strings.size());
+      ArrowArray* array = add_child(parent_array, num_rows, column.null_count,
+                                    {validity, buffer_or_empty(column.map_offsets)});
+      ArrowArray* entries = add_child(array, entry_count, 0, {nullptr});
+      add_child(entries, entry_count, 0, string_buffers(column.strings, nullptr));
+      if (doubles) {
+        add_child(entries, entry_count, 0, {nullptr, buffer_or_empty(column.map_double_items)});
+      } else {
+        add_child(entries, entry_count, 0, string_buffers(column.map_items, nullptr));
+      }
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+void export_columnar_result(const std::shared_ptr<const ColumnarResult>& result,
+                            ArrowSchema* out_schema, ArrowArray* out_array) {
+  init_schema(out_schema, "+s", "", 0);
+  init_array(out_array, result, result->num_rows, 0, {nullptr});
+  for (const auto& column : result->columns) {
+    export_column(column, result->num_rows, out_schema, out_array);
+  }
+}
+
+}  // namespace markql
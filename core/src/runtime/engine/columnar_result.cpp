@@ -0,0 +1,168 @@
+#include "markql/columnar_result.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace markql {
+
+namespace {
+
+using ColumnType = ColumnarColumn::Type;
+
+ColumnType column_type(const std::string& name) {
+  if (name == "node_id" || name == "count" || name == "parent_id" || name == "sibling_pos" ||
+      name == "max_depth" || name == "doc_order") {
+    return ColumnType::Int64;
+  }
+  if (name == "tag") return ColumnType::DictionaryUtf8;
+  if (name == "attributes") return ColumnType::StringMap;
+  if (name == "terms_score") return ColumnType::DoubleMap;
+  return ColumnType::Utf8;
+}
+
+/// Records row `row`'s validity; the bitmap is only allocated once the first null shows up.
+void append_validity(ColumnarColumn& column, size_t row, bool valid) {
+  if (valid && column.validity.empty()) return;
+  if (column.validity.empty()) {
+    column.validity.assign(row / 8 + 1, 0);
+    for (size_t r = 0; r < row; ++r) {
+      column.validity[r / 8] |= static_cast<uint8_t>(1u << (r % 8));
+    }
+  } else if (column.validity.size() < row / 8 + 1) {
+    column.validity.push_back(0);
+  }
+  if (valid) {
+    column.validity[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+  } else {
+    ++column.null_count;
+  }
+}
+
+std::optional<int64_t> int64_field(const QueryResultRow& row, const std::string& name) {
+  if (name == "node_id" || name == "count") return row.node_id;
+  if (name == "parent_id") return row.parent_id;
+  if (name == "sibling_pos") return row.sibling_pos;
+  if (name == "max_depth") return row.max_depth;
+  return row.doc_order;
+}
+
+/// Same lookup order as the CLI exports: node fields first, then PROJECT/expression columns,
+/// then attributes. Returns nullptr for NULL and sets `computed` for PROJECT/expression values.
+const std::string* string_field(const QueryResultRow& row, const std::string& name,
+                                const ComputedFieldLookup& lookup, bool& computed) {
+  if (name == "tag") return &row.tag;
+  if (name == "text") return &row.text;
+  if (name == "inner_html") return &row.inner_html;
+  if (name == "source_uri") return &row.source_uri;
+  if (const std::string* value = lookup.find(row.computed_fields)) {
+    computed = true;
+    return value;
+  }
+  auto attr = row.attributes.find(name);
+  if (attr != row.attributes.end()) return &attr->second;
+  return nullptr;
+}
+
+template <typename Map, typename AppendItem>
+void append_sorted_map(ColumnarColumn& column, const Map& map, AppendItem append_item) {
+  std::vector<const typename Map::value_type*> entries;
+  entries.reserve(map.size());
+  for (const auto& entry : map) entries.push_back(&entry);
+  std::sort(entries.begin(), entries.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  for (const auto* entry : entries) {
+    column.strings.append(entry->first);
+    append_item(entry->second);
+  }
+  column.map_offsets.push_back(static_cast<int32_t>(column.strings.size()));
+}
+
+}  // namespace
+
+const ColumnarColumn* ColumnarResult::find(const std::string& name) const {
+  for (const auto& column : columns) {
+    if (column.name == name) return &column;
+  }
+  return nullptr;
+}
+
+bool ColumnarResultBuilder::begin(const QueryResult& header) {
+  if (header.to_table || !header.tables.empty()) return false;
+  out_ = ColumnarResult{};
+  dictionaries_.assign(header.columns.size(), {});
+  computed_.clear();
+  out_.columns.reserve(header.columns.size());
+  for (const auto& name : header.columns) {
+    computed_.emplace_back(name);
+    ColumnarColumn column;
+    column.name = name;
+    column.type = column_type(name);
+    if (column.type == ColumnType::StringMap || column.type == ColumnType::DoubleMap) {
+      column.map_offsets.push_back(0);
+    }
+    out_.columns.push_back(std::move(column));
+  }
+  return true;
+}
+
+void ColumnarResultBuilder::row(const QueryResultRow& row) {
+  const size_t index = static_cast<size_t>(out_.num_rows);
+  for (size_t c = 0; c < out_.columns.size(); ++c) {
+    ColumnarColumn& column = out_.columns[c];
+    switch (column.type) {
+      case ColumnType::Int64: {
+        std::optional<int64_t> value = int64_field(row, column.name);
+        append_validity(column, index, value.has_value());
+        column.int64_values.push_back(value.value_or(0));
+        break;
+      }
+      case ColumnType::Utf8: {
+        const std::string* value = string_field(row, column.name, computed_[c], column.computed);
+        append_validity(column, index, value != nullptr);
+        column.strings.append(value != nullptr ? std::string_view(*value) : std::string_view());
+        break;
+      }
+      case ColumnType::DictionaryUtf8: {
+        const std::string* value = string_field(row, column.name, computed_[c], column.computed);
+        append_validity(column, index, value != nullptr);
+        static const std::string kEmpty;
+        const std::string& key = value != nullptr ? *value : kEmpty;
+        auto it = dictionaries_[c].find(key);
+        if (it == dictionaries_[c].end()) {
+          it = dictionaries_[c].emplace(key, static_cast<int32_t>(column.strings.size())).first;
+          column.strings.append(key);
+        }
+        column.dictionary_indices.push_back(it->second);
+        break;
+      }
+      case ColumnType::StringMap:
+        append_sorted_map(column, row.attributes,
+                          [&](const std::string& item) { column.map_items.append(item); });
+        break;
+      case ColumnType::DoubleMap:
+        append_sorted_map(column, row.term_scores,
+                          [&](double item) { column.map_double_items.push_back(item); });
+        break;
+    }
+  }
+  ++out_.num_rows;
+}
+
+ColumnarResult ColumnarResultBuilder::finish(const QueryResult& result) {
+  ColumnarResult out = std::move(out_);
+  out.warnings = result.warnings;
+  out_ = ColumnarResult{};
+  dictionaries_.clear();
+  return out;
+}
+
+ColumnarResult to_columnar_result(const QueryResult& result) {
+  ColumnarResultBuilder builder;
+  if (builder.begin(result)) {
+    for (const auto& row : result.rows) builder.row(row);
+  }
+  return builder.finish(result);
+}
+
+}  // namespace markql
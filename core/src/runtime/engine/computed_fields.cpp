@@ -0,0 +1,71 @@
+#include "markql/markql.h"
+
+#include <stdexcept>
+
+namespace markql {
+
+size_t ComputedFieldSchema::add(const std::string& name) {
+  auto [it, inserted] = slots_.emplace(name, names_.size());
+  if (inserted) names_.push_back(name);
+  return it->second;
+}
+
+size_t ComputedFieldSchema::find(const std::string& name) const {
+  auto it = slots_.find(name);
+  return it == slots_.end() ? npos : it->second;
+}
+
+std::string& ComputedFields::operator[](const std::string& name) {
+  if (schema_ == nullptr) schema_ = std::make_shared<ComputedFieldSchema>();
+  const size_t slot = schema_->add(name);
+  // WHY: sizing to the whole schema keeps later lookups of known names from reallocating, so
+  // references returned for earlier fields stay valid.
+  if (cells_.size() <= slot) cells_.resize(schema_->size());
+  if (!cells_[slot].has_value()) cells_[slot].emplace();
+  return *cells_[slot];
+}
+
+const std::string& ComputedFields::at(const std::string& name) const {
+  auto it = find(name);
+  if (it == end()) throw std::out_of_range("Unknown computed field: " + name);
+  return it->second;
+}
+
+ComputedFields::const_iterator ComputedFields::find(const std::string& name) const {
+  if (schema_ == nullptr) return end();
+  const size_t slot = schema_->find(name);
+  if (get(slot) == nullptr) return end();
+  return const_iterator(this, slot);
+}
+
+bool ComputedFields::operator==(const ComputedFields& other) const {
+  size_t matched = 0;
+  for (const auto& entry : *this) {
+    auto it = other.find(entry.first);
+    if (it == other.end() || it->second != entry.second) return false;
+    ++matched;
+  }
+  size_t other_size = 0;
+  for (auto it = other.begin(); it != other.end(); ++it) ++other_size;
+  return matched == other_size;
+}
+
+void ComputedFields::set(size_t slot, std::string value) {
+  if (cells_.size() <= slot) cells_.resize(schema_->size());
+  cells_[slot] = std::move(value);
+}
+
+const std::string* ComputedFieldLookup::find(const ComputedFields& fields) const {
+  const auto& schema = fields.schema();
+  if (schema == nullptr) return nullptr;
+  const bool stale = schema != schema_ ||
+                     (slot_ == ComputedFieldSchema::npos && schema->size() != schema_size_);
+  if (stale) {
+    schema_ = schema;
+    schema_size_ = schema->size();
+    slot_ = schema->find(name_);
+  }
+  return fields.get(slot_);
+}
+
+}  // namespace markql
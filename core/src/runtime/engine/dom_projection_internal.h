@@ -34,6 +34,13 @@ struct ProjectRowEvalCache {
 };
 
 std::string normalize_flatten_text(const std::string& value);
+/// Normalized strict direct text, falling back to normalized lenient direct text; memoized
+/// per node on doc.text_cache (see markql_internal::cached_node_text).
+const std::string& cached_normalized_direct_text(const HtmlDocument& doc, const HtmlNode& node,
+                                                 std::string& scratch);
+/// cached_normalized_direct_text, falling back to normalized node.text; memoized per node.
+const std::string& cached_normalized_extract_text(const HtmlDocument& doc, const HtmlNode& node,
+                                                  std::string& scratch);
 
 struct ScalarProjectionValue {
   enum class Kind { Null, String, Number } kind = Kind::Null;
@@ -50,7 +57,7 @@ ScalarProjectionValue eval_select_scalar_expr(
 std::optional<std::string> eval_flatten_extract_expr(
     const Query::SelectItem::FlattenExtractExpr& expr, const HtmlNode& base_node,
     const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
-    const std::unordered_map<std::string, std::string>& bindings, ProjectRowEvalCache* row_cache);
+    const ComputedFields& bindings, ProjectRowEvalCache* row_cache);
 
 std::optional<std::string> eval_parse_source_expr(const ScalarExpr& expr);
 
@@ -2,8 +2,10 @@
 
 #include "markql/markql.h"
 
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../../dom/html_parser.h"
@@ -11,37 +13,113 @@
 
 namespace markql {
 
+class RelationDocumentCache;
+
+/// Hands a statement's finished rows to the caller's QueryResultSink, or collects them in
+/// QueryResult::rows when there is none or it declines. Streaming paths push() rows as they
+/// build them; blocking paths fill out.rows and finish() replays them.
+class ResultRowStream {
+ public:
+  explicit ResultRowStream(QueryResultSink* sink) : sink_(sink) {}
+
+  /// Emits `row`. `out`'s header fields MUST be final before the first push.
+  void push(QueryResult& out, QueryResultRow&& row) {
+    if (sink_ != nullptr && !begun_) {
+      begun_ = true;
+      if (!sink_->begin(out)) sink_ = nullptr;
+    }
+    if (sink_ == nullptr) {
+      out.rows.push_back(std::move(row));
+      return;
+    }
+    sink_->row(row);
+  }
+
+  /// Offers the statement's only table to the sink before its rows are read; see
+  /// QueryResultSink::begin_table(). When it is taken, rows go to table_row() and finish()
+  /// ends the stream.
+  bool begin_table(QueryResult& out, const QueryResult::TableResult& table, size_t column_count) {
+    if (sink_ == nullptr || begun_) return false;
+    if (!sink_->begin_table(out, table, column_count)) return false;
+    begun_ = true;
+    return true;
+  }
+  void table_row(const std::vector<std::string>& cells) { sink_->table_row(cells); }
+
+  /// Sends rows still held in out.rows, then ends the stream; out.rows is left empty unless
+  /// the sink declined.
+  void finish(QueryResult& out) {
+    if (sink_ == nullptr) return;
+    if (!begun_) {
+      begun_ = true;
+      std::vector<QueryResultRow> rows = std::move(out.rows);
+      out.rows.clear();
+      if (!sink_->begin(out)) {
+        out.rows = std::move(rows);
+        sink_ = nullptr;
+        return;
+      }
+      for (const auto& row : rows) sink_->row(row);
+    }
+    sink_->end();
+  }
+
+ private:
+  QueryResultSink* sink_ = nullptr;
+  bool begun_ = false;
+};
+
 struct FragmentSource {
   std::vector<std::string> fragments;
 };
 
 QueryResult::TableOptions to_result_table_options(const Query::TableOptions& options);
+QueryResult::ExportSink to_result_export_sink(const Query::ExportSink& sink);
 bool table_uses_default_output(const Query& query);
 void materialize_table_result(const std::vector<std::vector<std::string>>& raw_rows,
                               bool has_header, const Query::TableOptions& options,
                               QueryResult::TableResult& table);
+/// Writes the table at table.node_id straight to `stream`'s sink, reading it from `doc` as the
+/// sink consumes it. Returns false, with no row sent, when the table has no streamed form
+/// (SPARSE_SHAPE=WIDE) or the sink declines it; table.headers may then already be set.
+bool stream_table_result(const Query& query, const HtmlDocument& doc,
+                         const std::vector<std::vector<int64_t>>& children,
+                         QueryResult::TableResult& table, QueryResult& out,
+                         ResultRowStream& stream);
 
 QueryResult execute_meta_query(const Query& query, const std::string& source_uri);
 void validate_query_for_execution(const Query& query);
 std::optional<std::string> eval_parse_source_expr(const ScalarExpr& expr);
 QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
-                              const std::string& source_uri);
+                              const std::string& source_uri, ResultRowStream* stream = nullptr);
+/// `stream`, when given, receives the statement's rows instead of the returned rows.
 QueryResult execute_query_with_source_legacy(const Query& query, const std::string* default_html,
                                              const HtmlDocument* default_document,
-                                             const std::string& default_source_uri);
+                                             const std::string& default_source_uri,
+                                             ResultRowStream* stream = nullptr);
 QueryResult execute_query_with_source(const Query& query, const std::string* default_html,
                                       const HtmlDocument* default_document,
-                                      const std::string& default_source_uri);
+                                      const std::string& default_source_uri,
+                                      ResultRowStream* stream = nullptr);
 QueryResult execute_query_with_source_relation_entry(const Query& query,
                                                      const std::string* default_html,
                                                      const HtmlDocument* default_document,
-                                                     const std::string& default_source_uri);
+                                                     const std::string& default_source_uri,
+                                                     ResultRowStream* stream = nullptr);
+/// Relation caches of one prepared document; they outlive single statements (see
+/// RelationDocumentCache). `doc` MUST outlive the returned cache.
+std::shared_ptr<RelationDocumentCache> make_relation_document_cache(const HtmlDocument& doc);
+/// Runs a parsed SELECT against a prepared document, reusing the relation caches attached to
+/// it. `query_text` is the text `query` was parsed from; it keys CTE relations across runs.
+QueryResult execute_prepared_query(const Query& query, std::string_view query_text,
+                                   const std::string& html, const HtmlDocument& doc,
+                                   const std::string& source_uri,
+                                   const std::shared_ptr<RelationDocumentCache>& cache,
+                                   ResultRowStream* stream = nullptr);
 
-std::optional<int64_t> parse_int64_value(const std::string& value);
-bool contains_ci(const std::string& haystack, const std::string& needle);
-bool like_match_ci(const std::string& text, const std::string& pattern);
-bool contains_all_ci(const std::string& haystack, const std::vector<std::string>& tokens);
-bool contains_any_ci(const std::string& haystack, const std::vector<std::string>& tokens);
+/// Parses a whole base-10 int64 the way std::stoll accepted it (leading whitespace and a sign),
+/// without throwing. Returns nullopt for other text and out-of-range values.
+std::optional<int64_t> parse_int64_value(std::string_view value);
 std::vector<std::string> split_ws(const std::string& s);
 
 std::optional<std::string> field_value_string(const QueryResultRow& row, const std::string& field);
@@ -12,13 +12,17 @@ struct ParsedDocumentHandle {
   HtmlDocument doc;
   std::string html;
   std::string source_uri;
+  /// Join indexes and document relations reused by every query on this handle; declared
+  /// after `doc`, which it borrows.
+  std::shared_ptr<RelationDocumentCache> relation_cache;
 };
 
 QueryResult execute_query_with_source(const Query& query, const std::string* default_html,
                                       const HtmlDocument* default_document,
-                                      const std::string& default_source_uri) {
+                                      const std::string& default_source_uri,
+                                      ResultRowStream* stream) {
   return execute_query_with_source_relation_entry(query, default_html, default_document,
-                                                  default_source_uri);
+                                                  default_source_uri, stream);
 }
 
 std::shared_ptr<const ParsedDocumentHandle> prepare_document(const std::string& html,
@@ -27,11 +31,14 @@ std::shared_ptr<const ParsedDocumentHandle> prepare_document(const std::string&
   prepared->doc = parse_html(html);
   prepared->html = html;
   prepared->source_uri = source_uri.empty() ? "document" : source_uri;
+  prepared->relation_cache = make_relation_document_cache(prepared->doc);
   return prepared;
 }
 
-QueryResult execute_query_from_prepared_document(
-    const std::shared_ptr<const ParsedDocumentHandle>& prepared, const std::string& query) {
+namespace {
+
+QueryResult execute_prepared_statement(const std::shared_ptr<const ParsedDocumentHandle>& prepared,
+                                       const std::string& query, QueryResultSink* sink) {
   if (prepared == nullptr) {
     throw std::runtime_error("Prepared document handle is null");
   }
@@ -40,14 +47,28 @@ QueryResult execute_query_from_prepared_document(
     throw std::runtime_error("Query parse error: " + parsed.error->message);
   }
   validate_query_for_execution(*parsed.query);
-  if (parsed.query->kind != Query::Kind::Select) {
-    return execute_meta_query(*parsed.query, prepared->source_uri);
-  }
-  if (parsed.query->source.kind == Source::Kind::Document) {
-    return execute_query_ast(*parsed.query, prepared->doc, prepared->source_uri);
-  }
-  return execute_query_with_source(*parsed.query, &prepared->html, &prepared->doc,
-                                   prepared->source_uri);
+  ResultRowStream stream(sink);
+  QueryResult out =
+      parsed.query->kind != Query::Kind::Select
+          ? execute_meta_query(*parsed.query, prepared->source_uri)
+          : execute_prepared_query(*parsed.query, query, prepared->html, prepared->doc,
+                                   prepared->source_uri, prepared->relation_cache,
+                                   sink != nullptr ? &stream : nullptr);
+  stream.finish(out);
+  return out;
+}
+
+}  // namespace
+
+QueryResult execute_query_from_prepared_document(
+    const std::shared_ptr<const ParsedDocumentHandle>& prepared, const std::string& query) {
+  return execute_prepared_statement(prepared, query, nullptr);
+}
+
+QueryResult execute_query_from_prepared_document(
+    const std::shared_ptr<const ParsedDocumentHandle>& prepared, const std::string& query,
+    QueryResultSink& sink) {
+  return execute_prepared_statement(prepared, query, &sink);
 }
 
 }  // namespace markql
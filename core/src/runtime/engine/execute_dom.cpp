@@ -4,6 +4,7 @@
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
@@ -32,7 +33,7 @@ struct ScopedProjectBenchStats {
 }  // namespace
 
 QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
-                              const std::string& source_uri) {
+                              const std::string& source_uri, ResultRowStream* stream) {
   ExecuteResult exec = execute_query(query, doc, source_uri);
   ScopedProjectBenchStats scoped_project_bench_stats;
   ProjectBenchStats* project_bench_stats =
@@ -47,18 +48,11 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
   out.table_has_header = query.table_has_header;
   out.table_options = to_result_table_options(query.table_options);
   if (query.export_sink.has_value()) {
-    const auto& sink = *query.export_sink;
-    if (sink.kind == Query::ExportSink::Kind::Csv) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Csv;
-    } else if (sink.kind == Query::ExportSink::Kind::Parquet) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Parquet;
-    } else if (sink.kind == Query::ExportSink::Kind::Json) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Json;
-    } else if (sink.kind == Query::ExportSink::Kind::Ndjson) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Ndjson;
-    }
-    out.export_sink.path = sink.path;
+    out.export_sink = to_result_export_sink(*query.export_sink);
   }
+  // Computed field names are stored once here; rows keep only their values, by slot.
+  auto computed_schema = std::make_shared<ComputedFieldSchema>();
+  out.computed_schema = computed_schema;
   if (query.export_sink.has_value() &&
       (query.to_table || markql_internal::is_table_select(query)) && exec.nodes.size() != 1) {
     throw std::runtime_error(
@@ -72,8 +66,8 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
   if (!query.select_items.empty() &&
       query.select_items[0].aggregate == Query::SelectItem::Aggregate::Summarize) {
     std::unordered_map<std::string, size_t> counts;
-    for (const auto& node : exec.nodes) {
-      ++counts[node.tag];
+    for (const HtmlNode* node : exec.nodes) {
+      ++counts[node->tag];
     }
     std::vector<std::pair<std::string, size_t>> summary;
     summary.reserve(counts.size());
@@ -125,10 +119,19 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
   if (query.to_table ||
       (query.export_sink.has_value() && markql_internal::is_table_select(query))) {
     auto children = markql_internal::build_children(doc);
-    for (const auto& node : exec.nodes) {
+    // WHY: an exported table is written while it is read, so its rows are never all held.
+    if (stream != nullptr && query.export_sink.has_value() && exec.nodes.size() == 1) {
       QueryResult::TableResult table;
-      table.node_id = node.id;
-      markql_internal::collect_rows(doc, children, node.id, table.rows);
+      table.node_id = exec.nodes[0]->id;
+      if (stream_table_result(query, doc, children, table, out, *stream)) {
+        out.tables.push_back(std::move(table));
+        return out;
+      }
+    }
+    for (const HtmlNode* node : exec.nodes) {
+      QueryResult::TableResult table;
+      table.node_id = node->id;
+      markql_internal::collect_rows(doc, children, node->id, table.rows);
       if (!table_uses_default_output(query)) {
         materialize_table_result(table.rows, query.table_has_header, query.table_options, table);
       }
@@ -159,6 +162,10 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
     bool tag_is_alias =
         query.source.alias.has_value() && util::to_lower(*query.source.alias) == base_tag;
     bool match_all_tags = tag_is_alias || base_tag == "document";
+    std::vector<size_t> alias_slots;
+    for (const auto& alias : flatten_extract_item->flatten_extract_aliases) {
+      alias_slots.push_back(computed_schema->add(alias));
+    }
     struct FlattenExtractRow {
       const HtmlNode* node = nullptr;
       QueryResultRow row;
@@ -175,6 +182,7 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
         }
       }
       QueryResultRow row;
+      row.computed_fields = ComputedFields(computed_schema);
       row.node_id = node.id;
       row.tag = node.tag;
       row.text = node.text;
@@ -190,12 +198,11 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
       row_eval_cache.stats = project_bench_stats;
       row_eval_cache.reset_for_row(children, node.id);
       for (size_t i = 0; i < flatten_extract_item->flatten_extract_aliases.size(); ++i) {
-        const auto& alias = flatten_extract_item->flatten_extract_aliases[i];
         const auto& expr = flatten_extract_item->flatten_extract_exprs[i];
         std::optional<std::string> value = eval_flatten_extract_expr(
             expr, node, doc, children, row.computed_fields, &row_eval_cache);
         if (!value.has_value()) continue;
-        row.computed_fields[alias] = *value;
+        row.computed_fields.set(alias_slots[i], std::move(*value));
       }
       rows.push_back(FlattenExtractRow{&node, std::move(row)});
     }
@@ -215,6 +222,10 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
     if (query.limit.has_value() && rows.size() > *query.limit) {
       rows.resize(*query.limit);
     }
+    if (stream != nullptr) {
+      for (auto& entry : rows) stream->push(out, std::move(entry.row));
+      return out;
+    }
     out.rows.reserve(rows.size());
     for (auto& entry : rows) {
       out.rows.push_back(std::move(entry.row));
@@ -238,6 +249,10 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
     bool tag_is_alias =
         query.source.alias.has_value() && util::to_lower(*query.source.alias) == base_tag;
     bool match_all_tags = tag_is_alias || base_tag == "document";
+    std::vector<size_t> alias_slots;
+    for (const auto& alias : flatten_item->flatten_aliases) {
+      alias_slots.push_back(computed_schema->add(alias));
+    }
     struct FlattenRow {
       const HtmlNode* node = nullptr;
       QueryResultRow row;
@@ -254,6 +269,7 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
         }
       }
       QueryResultRow row;
+      row.computed_fields = ComputedFields(computed_schema);
       row.node_id = node.id;
       row.tag = node.tag;
       row.text = node.text;
@@ -283,20 +299,16 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
           }
         }
         if (!matched) continue;
-        std::string direct = markql_internal::extract_direct_text_strict(child.inner_html);
-        std::string normalized = normalize_flatten_text(direct);
-        if (normalized.empty()) {
-          direct = markql_internal::extract_direct_text(child.inner_html);
-          normalized = normalize_flatten_text(direct);
-        }
+        std::string scratch;
+        const std::string& normalized = cached_normalized_direct_text(doc, child, scratch);
         if (depth_is_default && normalized.empty()) {
           continue;
         }
-        values.push_back(std::move(normalized));
+        values.push_back(normalized);
       }
       for (size_t i = 0; i < flatten_item->flatten_aliases.size(); ++i) {
         if (i < values.size()) {
-          row.computed_fields[flatten_item->flatten_aliases[i]] = values[i];
+          row.computed_fields.set(alias_slots[i], std::move(values[i]));
         }
       }
       rows.push_back(FlattenRow{&node, std::move(row)});
@@ -368,8 +380,17 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
       sibling_positions.at(static_cast<size_t>(kids[idx])) = static_cast<int64_t>(idx + 1);
     }
   }
-  for (const auto& node : exec.nodes) {
+  std::vector<size_t> item_slots(query.select_items.size(), ComputedFieldSchema::npos);
+  for (size_t i = 0; i < query.select_items.size(); ++i) {
+    const auto& item = query.select_items[i];
+    if (item.expr_projection && item.field.has_value()) {
+      item_slots[i] = computed_schema->add(*item.field);
+    }
+  }
+  for (const HtmlNode* node_ptr : exec.nodes) {
+    const HtmlNode& node = *node_ptr;
     QueryResultRow row;
+    row.computed_fields = ComputedFields(computed_schema);
     row.node_id = node.id;
     row.tag = node.tag;
     std::optional<size_t> effective_inner_html_depth = inner_html_depth;
@@ -378,8 +399,10 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
       effective_inner_html_depth =
           inner_html_auto_depth ? static_cast<size_t>(std::max<int64_t>(0, node.max_depth)) : 1;
     }
-    row.text =
-        use_text_function ? markql_internal::extract_direct_text(node.inner_html) : node.text;
+    std::string direct_scratch;
+    row.text = use_text_function
+                   ? markql_internal::cached_direct_text(doc, node, direct_scratch)
+                   : node.text;
     row.inner_html =
         effective_inner_html_depth.has_value()
             ? markql_internal::limit_inner_html(node.inner_html, *effective_inner_html_depth)
@@ -399,19 +422,20 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
       row_eval_cache.reset_for_row(children, node.id);
       row_eval_cache_ptr = &row_eval_cache;
     }
-    for (const auto& item : query.select_items) {
-      if (!item.expr_projection || !item.field.has_value()) continue;
+    for (size_t i = 0; i < query.select_items.size(); ++i) {
+      const auto& item = query.select_items[i];
+      if (item_slots[i] == ComputedFieldSchema::npos) continue;
       if (item.project_expr.has_value()) {
         std::optional<std::string> value = eval_flatten_extract_expr(
             *item.project_expr, node, doc, children, row.computed_fields, row_eval_cache_ptr);
         if (!value.has_value()) continue;
-        row.computed_fields[*item.field] = *value;
+        row.computed_fields.set(item_slots[i], std::move(*value));
         continue;
       }
       if (!item.expr.has_value()) continue;
       ScalarProjectionValue value = eval_select_scalar_expr(*item.expr, node, &doc, &children);
       if (projection_is_null(value)) continue;
-      row.computed_fields[*item.field] = projection_to_string(value);
+      row.computed_fields.set(item_slots[i], projection_to_string(value));
     }
     for (const auto& field : trim_fields) {
       if (field == "text") {
@@ -430,7 +454,11 @@ QueryResult execute_query_ast(const Query& query, const HtmlDocument& doc,
       }
     }
     row.parent_id = node.parent_id;
-    out.rows.push_back(row);
+    if (stream != nullptr) {
+      stream->push(out, std::move(row));
+    } else {
+      out.rows.push_back(std::move(row));
+    }
   }
   return out;
 }
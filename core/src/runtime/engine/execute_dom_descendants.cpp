@@ -5,6 +5,7 @@
 
 #include "../executor/executor_internal.h"
 #include "../../lang/markql_parser.h"
+#include "../../util/string_search.h"
 #include "../../util/string_util.h"
 #include "dom_descendants_internal.h"
 #include "engine_execution_internal.h"
@@ -76,13 +77,13 @@ bool match_descendant_predicate(const HtmlNode& node, const DescendantTagFilter:
   if (it == node.attributes.end()) return false;
   const std::string& attr_value = it->second;
   if (pred.op == CompareExpr::Op::Contains) {
-    return contains_ci(attr_value, pred.values.front());
+    return util::contains_ci(attr_value, pred.values.front());
   }
   if (pred.op == CompareExpr::Op::ContainsAll) {
-    return contains_all_ci(attr_value, pred.values);
+    return util::contains_all_ci(attr_value, pred.values);
   }
   if (pred.op == CompareExpr::Op::ContainsAny) {
-    return contains_any_ci(attr_value, pred.values);
+    return util::contains_any_ci(attr_value, pred.values);
   }
   if (pred.op == CompareExpr::Op::In || pred.op == CompareExpr::Op::Eq) {
     if (pred.attribute == "class") {
@@ -12,6 +12,7 @@
 #include "../executor/executor_internal.h"
 #include "../../dom/html_parser.h"
 #include "../../lang/markql_parser.h"
+#include "../../util/string_search.h"
 #include "../../util/string_util.h"
 #include "dom_descendants_internal.h"
 #include "dom_projection_internal.h"
@@ -28,12 +29,15 @@ void collect_row_scope_nodes(const std::vector<std::vector<int64_t>>& children,
   collect_descendants_any_depth(children, node_id, out);
 }
 
-std::string normalized_extract_text(const HtmlNode& node) {
-  std::string direct = markql_internal::extract_direct_text_strict(node.inner_html);
-  std::string normalized = normalize_flatten_text(direct);
+std::string compute_normalized_direct_text(const HtmlNode& node) {
+  std::string normalized =
+      normalize_flatten_text(markql_internal::extract_direct_text_strict(node.inner_html));
   if (!normalized.empty()) return normalized;
-  direct = markql_internal::extract_direct_text(node.inner_html);
-  normalized = normalize_flatten_text(direct);
+  return normalize_flatten_text(markql_internal::extract_direct_text(node.inner_html));
+}
+
+std::string compute_normalized_extract_text(const HtmlNode& node) {
+  std::string normalized = compute_normalized_direct_text(node);
   if (!normalized.empty()) return normalized;
   return normalize_flatten_text(node.text);
 }
@@ -103,14 +107,16 @@ std::optional<std::string> selector_value(
       if (it == node.attributes.end() || it->second.empty()) continue;
       value = it->second;
     } else if (direct_text) {
+      std::string scratch;
       std::string direct =
-          util::trim_ws(markql_internal::extract_direct_text_strict(node.inner_html));
+          util::trim_ws(markql_internal::cached_direct_text_strict(doc, node, scratch));
       if (direct.empty()) continue;
       value = std::move(direct);
     } else {
-      std::string text = normalized_extract_text(node);
+      std::string scratch;
+      const std::string& text = cached_normalized_extract_text(doc, node, scratch);
       if (text.empty()) continue;
-      value = std::move(text);
+      value = text;
     }
     if (!value.has_value()) continue;
     if (selector_last) {
@@ -291,6 +297,20 @@ std::string normalize_flatten_text(const std::string& value) {
   return out;
 }
 
+const std::string& cached_normalized_direct_text(const HtmlDocument& doc, const HtmlNode& node,
+                                                 std::string& scratch) {
+  return markql_internal::cached_node_text(doc, node,
+                                           NodeTextCache::Kind::NormalizedDirectText,
+                                           compute_normalized_direct_text, scratch);
+}
+
+const std::string& cached_normalized_extract_text(const HtmlDocument& doc, const HtmlNode& node,
+                                                  std::string& scratch) {
+  return markql_internal::cached_node_text(doc, node,
+                                           NodeTextCache::Kind::NormalizedExtractText,
+                                           compute_normalized_extract_text, scratch);
+}
+
 bool projection_is_null(const ScalarProjectionValue& value) {
   return value.kind == ScalarProjectionValue::Kind::Null;
 }
@@ -383,8 +403,13 @@ ScalarProjectionValue eval_select_scalar_expr(const ScalarExpr& expr, const Html
 
     if (fn == "TEXT") return make_string_projection(target->text);
     if (fn == "DIRECT_TEXT") {
+      if (doc == nullptr) {
+        return make_string_projection(
+            markql_internal::extract_direct_text_strict(target->inner_html));
+      }
+      std::string scratch;
       return make_string_projection(
-          markql_internal::extract_direct_text_strict(target->inner_html));
+          markql_internal::cached_direct_text_strict(*doc, *target, scratch));
     }
     if (fn == "ATTR") {
       ScalarProjectionValue attr_value = eval_select_scalar_expr(expr.args[1], node, doc, children);
@@ -516,7 +541,7 @@ ScalarProjectionValue eval_select_scalar_expr(const ScalarExpr& expr, const Html
 std::optional<std::string> eval_flatten_extract_expr(
     const Query::SelectItem::FlattenExtractExpr& expr, const HtmlNode& base_node,
     const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
-    const std::unordered_map<std::string, std::string>& bindings, ProjectRowEvalCache* row_cache) {
+    const ComputedFields& bindings, ProjectRowEvalCache* row_cache) {
   using ExtractKind = Query::SelectItem::FlattenExtractExpr::Kind;
 
   if (expr.kind == ExtractKind::StringLiteral) {
@@ -685,7 +710,8 @@ std::optional<std::string> eval_flatten_extract_expr(
       if (args.size() != 2 || !args[0].has_value() || !args[1].has_value()) return std::nullopt;
       bool result = false;
       if (fn == "__CMP_LIKE") {
-        result = like_match_ci(*args[0], *args[1]);
+        result = expr.like_pattern != nullptr ? expr.like_pattern->matches(*args[0])
+                                              : util::like_match_ci(*args[0], *args[1]);
       } else {
         auto lnum = parse_int64_value(*args[0]);
         auto rnum = parse_int64_value(*args[1]);
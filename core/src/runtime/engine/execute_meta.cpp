@@ -143,11 +143,20 @@ QueryResult execute_meta_query(const Query& query, const std::string& source_uri
                "SPARSE_SHAPE=LONG|WIDE]"
                "[, HEADER_NORMALIZE=ON][, EXPORT='file.csv'])",
                "Select table tags only"},
-              {"output", "TO CSV", "TO CSV('file.csv')", "Export result"},
-              {"output", "TO PARQUET", "TO PARQUET('file.parquet')", "Export result"},
-              {"output", "TO JSON", "TO JSON(['file.json'])", "Export rows as a JSON array"},
-              {"output", "TO NDJSON", "TO NDJSON(['file.ndjson'])",
+              {"output", "TO CSV", "TO CSV('file.csv'[, FSYNC=ON][, COMPRESSION=GZIP|ZSTD|NONE])",
+               "Export result; .gz/.zst paths are compressed"},
+              {"output", "TO PARQUET",
+               "TO PARQUET('file.parquet'[, ROW_GROUP=n][, COMPRESSION=SNAPPY|ZSTD|GZIP|NONE]"
+               "[, INFER_TYPES=OFF])",
+               "Export result with typed columns"},
+              {"output", "TO JSON",
+               "TO JSON(['file.json'[, FSYNC=ON][, COMPRESSION=GZIP|ZSTD|NONE]])",
+               "Export rows as a JSON array"},
+              {"output", "TO NDJSON",
+               "TO NDJSON(['file.ndjson'[, FSYNC=ON][, COMPRESSION=GZIP|ZSTD|NONE]])",
                "Export rows as newline-delimited JSON"},
+              {"output", "TO ARROW", "TO ARROW(['file.arrow'])",
+               "Export rows as an Arrow IPC stream"},
               {"source", "document", "FROM document", "Active input in REPL"},
               {"source", "alias", "FROM doc", "Alias for document"},
               {"source", "path", "FROM 'file.html'", "Local file"},
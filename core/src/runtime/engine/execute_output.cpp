@@ -9,6 +9,7 @@
 #include "../../lang/markql_parser.h"
 #include "../../util/string_util.h"
 #include "engine_execution_internal.h"
+#include "markql_internal.h"
 
 namespace markql {
 
@@ -95,40 +96,6 @@ bool table_row_all_empty(const std::vector<std::string>& row, size_t max_cols,
   return true;
 }
 
-std::vector<size_t> select_table_columns(const std::vector<std::vector<std::string>>& rows,
-                                         size_t max_cols, const Query::TableOptions& options) {
-  std::vector<size_t> selected;
-  if (max_cols == 0) return selected;
-  if (options.trim_empty_cols == Query::TableOptions::TrimEmptyCols::Off) {
-    selected.reserve(max_cols);
-    for (size_t col = 0; col < max_cols; ++col) selected.push_back(col);
-    return selected;
-  }
-  std::vector<bool> empty_cols(max_cols, true);
-  for (size_t col = 0; col < max_cols; ++col) {
-    for (const auto& row : rows) {
-      if (!table_cell_empty(row, col, options.empty_is)) {
-        empty_cols[col] = false;
-        break;
-      }
-    }
-  }
-  if (options.trim_empty_cols == Query::TableOptions::TrimEmptyCols::Trailing) {
-    size_t keep_until = max_cols;
-    while (keep_until > 0 && empty_cols[keep_until - 1]) {
-      --keep_until;
-    }
-    selected.reserve(keep_until);
-    for (size_t col = 0; col < keep_until; ++col) selected.push_back(col);
-    return selected;
-  }
-  selected.reserve(max_cols);
-  for (size_t col = 0; col < max_cols; ++col) {
-    if (!empty_cols[col]) selected.push_back(col);
-  }
-  return selected;
-}
-
 std::vector<std::string> unique_header_keys(const std::vector<std::string>& headers) {
   std::vector<std::string> keys;
   keys.reserve(headers.size());
@@ -146,76 +113,180 @@ std::vector<std::string> unique_header_keys(const std::vector<std::string>& head
   return keys;
 }
 
-struct MaterializedTable {
-  std::vector<std::string> headers;
-  std::vector<std::string> header_keys;
-  std::vector<std::vector<std::string>> rect_rows;
-  std::vector<std::vector<std::string>> sparse_long_rows;
-  std::vector<std::vector<std::pair<std::string, std::string>>> sparse_wide_rows;
+/// A table's raw rows, read in order and again from the start after rewind(), so the layout
+/// and output passes below serve both collected and streamed tables.
+class RawTableRows {
+ public:
+  virtual ~RawTableRows() = default;
+  virtual void rewind() = 0;
+  /// The next row, valid until the following call; nullptr after the last row.
+  virtual const std::vector<std::string>* next() = 0;
+  /// The next row's cell count; false after the last row.
+  virtual bool next_width(size_t& width) = 0;
 };
 
-MaterializedTable materialize_table(const std::vector<std::vector<std::string>>& raw_rows,
-                                    bool has_header, const Query::TableOptions& options) {
-  MaterializedTable out;
-  if (raw_rows.empty()) return out;
+class CollectedTableRows : public RawTableRows {
+ public:
+  explicit CollectedTableRows(const std::vector<std::vector<std::string>>& rows) : rows_(rows) {}
 
-  size_t max_cols = 0;
-  for (const auto& row : raw_rows) {
-    if (row.size() > max_cols) max_cols = row.size();
+  void rewind() override { pos_ = 0; }
+  const std::vector<std::string>* next() override {
+    return pos_ < rows_.size() ? &rows_[pos_++] : nullptr;
+  }
+  bool next_width(size_t& width) override {
+    const std::vector<std::string>* row = next();
+    if (row == nullptr) return false;
+    width = row->size();
+    return true;
   }
 
-  std::vector<std::vector<std::string>> kept_rows;
-  kept_rows.reserve(raw_rows.size());
-  size_t consecutive_empty_rows = 0;
-  for (const auto& row : raw_rows) {
-    const bool all_empty = table_row_all_empty(row, max_cols, options.empty_is);
-    if (all_empty) {
-      ++consecutive_empty_rows;
-    } else {
-      consecutive_empty_rows = 0;
-    }
-    if (!(options.trim_empty_rows && all_empty)) {
-      kept_rows.push_back(row);
-    }
-    if (options.stop_after_empty_rows > 0 &&
-        consecutive_empty_rows >= options.stop_after_empty_rows) {
-      break;
+ private:
+  const std::vector<std::vector<std::string>>& rows_;
+  size_t pos_ = 0;
+};
+
+class DocumentTableRows : public RawTableRows {
+ public:
+  DocumentTableRows(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
+                    int64_t table_id)
+      : reader_(doc, children, table_id) {}
+
+  void rewind() override { reader_.rewind(); }
+  const std::vector<std::string>* next() override { return reader_.next(row_) ? &row_ : nullptr; }
+  bool next_width(size_t& width) override { return reader_.next_width(width); }
+
+ private:
+  markql_internal::TableRowReader reader_;
+  std::vector<std::string> row_;
+};
+
+/// Applies TRIM_EMPTY_ROWS and STOP_AFTER_EMPTY_ROWS one row at a time.
+class TableRowFilter {
+ public:
+  TableRowFilter(size_t max_cols, const Query::TableOptions& options)
+      : max_cols_(max_cols), options_(options) {}
+
+  /// Whether `row` is output. A row that reaches STOP_AFTER_EMPTY_ROWS is still judged on
+  /// its own, and done() is true afterwards.
+  bool keep(const std::vector<std::string>& row) {
+    if (!options_.trim_empty_rows && options_.stop_after_empty_rows == 0) return true;
+    const bool all_empty = table_row_all_empty(row, max_cols_, options_.empty_is);
+    consecutive_empty_rows_ = all_empty ? consecutive_empty_rows_ + 1 : 0;
+    if (options_.stop_after_empty_rows > 0 &&
+        consecutive_empty_rows_ >= options_.stop_after_empty_rows) {
+      done_ = true;
     }
+    return !(options_.trim_empty_rows && all_empty);
   }
+  bool done() const { return done_; }
 
-  max_cols = 0;
-  for (const auto& row : kept_rows) {
-    if (row.size() > max_cols) max_cols = row.size();
+ private:
+  size_t max_cols_;
+  const Query::TableOptions& options_;
+  size_t consecutive_empty_rows_ = 0;
+  bool done_ = false;
+};
+
+/// What a table's output needs to know about the whole table before its first row.
+struct TableLayout {
+  /// Widest raw row; decides which rows count as empty.
+  size_t raw_max_cols = 0;
+  /// Source columns written, in output order.
+  std::vector<size_t> keep_cols;
+  std::vector<std::string> headers;
+  std::vector<std::string> header_keys;
+  /// True when some row is kept, so the first kept row is the header row.
+  bool has_rows = false;
+  /// True when the header row is written as the normalized headers.
+  bool replace_header_row = false;
+};
+
+/// Calls `fn(row, index)` for each row kept by the table options, in order.
+template <typename Fn>
+void for_each_kept_row(RawTableRows& rows, size_t raw_max_cols,
+                       const Query::TableOptions& options, Fn&& fn) {
+  TableRowFilter filter(raw_max_cols, options);
+  size_t index = 0;
+  rows.rewind();
+  while (!filter.done()) {
+    const std::vector<std::string>* row = rows.next();
+    if (row == nullptr) break;
+    if (filter.keep(*row)) fn(*row, index++);
   }
-  std::vector<size_t> keep_cols = select_table_columns(kept_rows, max_cols, options);
-  const size_t out_cols = keep_cols.size();
-
-  out.rect_rows.reserve(kept_rows.size());
-  for (const auto& row : kept_rows) {
-    std::vector<std::string> projected;
-    projected.reserve(out_cols);
-    for (size_t keep_index : keep_cols) {
-      if (keep_index < row.size()) {
-        projected.push_back(row[keep_index]);
-      } else {
-        projected.emplace_back();
-      }
+}
+
+TableLayout plan_table_layout(RawTableRows& rows, bool has_header,
+                              const Query::TableOptions& options) {
+  TableLayout layout;
+  size_t width = 0;
+  rows.rewind();
+  while (rows.next_width(width)) {
+    if (width > layout.raw_max_cols) layout.raw_max_cols = width;
+  }
+
+  const bool trim_cols = options.trim_empty_cols != Query::TableOptions::TrimEmptyCols::Off;
+  size_t max_cols = layout.raw_max_cols;
+  std::vector<std::string> first_row;
+  std::vector<bool> non_empty_cols;
+  if (trim_cols || options.trim_empty_rows || options.stop_after_empty_rows > 0) {
+    // WHY: dropped rows can narrow the table and trimmed columns depend on every kept cell, so
+    // these options read the table once here and again when writing it, holding no rows.
+    max_cols = 0;
+    size_t min_cols = layout.raw_max_cols;
+    for_each_kept_row(rows, layout.raw_max_cols, options,
+                      [&](const std::vector<std::string>& row, size_t index) {
+                        if (index == 0) first_row = row;
+                        layout.has_rows = true;
+                        if (row.size() > max_cols) max_cols = row.size();
+                        if (row.size() < min_cols) min_cols = row.size();
+                        if (!trim_cols) return;
+                        if (non_empty_cols.size() < row.size()) {
+                          non_empty_cols.resize(row.size(), false);
+                        }
+                        for (size_t col = 0; col < row.size(); ++col) {
+                          if (!non_empty_cols[col] &&
+                              !table_cell_empty(row, col, options.empty_is)) {
+                            non_empty_cols[col] = true;
+                          }
+                        }
+                      });
+    non_empty_cols.resize(max_cols, false);
+    // EMPTY_IS=BLANK_ONLY does not count a missing cell as empty.
+    if (options.empty_is == Query::TableOptions::EmptyIs::BlankOnly) {
+      for (size_t col = min_cols; col < max_cols; ++col) non_empty_cols[col] = true;
+    }
+  } else {
+    rows.rewind();
+    if (const std::vector<std::string>* row = rows.next()) {
+      first_row = *row;
+      layout.has_rows = true;
     }
-    out.rect_rows.push_back(std::move(projected));
   }
 
-  if (out_cols == 0) {
-    return out;
+  if (!trim_cols) {
+    layout.keep_cols.reserve(max_cols);
+    for (size_t col = 0; col < max_cols; ++col) layout.keep_cols.push_back(col);
+  } else if (options.trim_empty_cols == Query::TableOptions::TrimEmptyCols::Trailing) {
+    size_t keep_until = max_cols;
+    while (keep_until > 0 && !non_empty_cols[keep_until - 1]) {
+      --keep_until;
+    }
+    for (size_t col = 0; col < keep_until; ++col) layout.keep_cols.push_back(col);
+  } else {
+    for (size_t col = 0; col < max_cols; ++col) {
+      if (non_empty_cols[col]) layout.keep_cols.push_back(col);
+    }
   }
+  const size_t out_cols = layout.keep_cols.size();
+  if (out_cols == 0) return layout;
 
   const bool apply_header_normalize =
       has_header && options.header_normalize && options.header_normalize_explicit;
-
-  out.headers.resize(out_cols);
+  layout.headers.resize(out_cols);
   for (size_t col = 0; col < out_cols; ++col) {
     std::string header;
-    if (has_header && !out.rect_rows.empty() && col < out.rect_rows[0].size()) {
-      header = out.rect_rows[0][col];
+    if (has_header && layout.keep_cols[col] < first_row.size()) {
+      header = first_row[layout.keep_cols[col]];
     }
     if (apply_header_normalize) {
       header = normalize_header_text(header);
@@ -223,58 +294,132 @@ MaterializedTable materialize_table(const std::vector<std::vector<std::string>>&
     if (header.empty()) {
       header = "col_" + std::to_string(col + 1);
     }
-    out.headers[col] = std::move(header);
-  }
-  out.header_keys = unique_header_keys(out.headers);
-
-  if (has_header && !out.rect_rows.empty() && apply_header_normalize) {
-    out.rect_rows[0] = out.headers;
+    layout.headers[col] = std::move(header);
   }
+  layout.header_keys = unique_header_keys(layout.headers);
+  layout.replace_header_row = apply_header_normalize && layout.has_rows;
+  return layout;
+}
 
-  if (options.format != Query::TableOptions::Format::Sparse) {
-    return out;
-  }
+/// Calls `emit` with each output row of a rectangular or long sparse table, the rows
+/// TableResult::rows holds for it. `emit` may take the row's contents.
+template <typename Emit>
+void emit_table_rows(RawTableRows& rows, const TableLayout& layout, bool has_header,
+                     const Query::TableOptions& options, Emit&& emit) {
+  const bool sparse = options.format == Query::TableOptions::Format::Sparse;
+  if (sparse && layout.keep_cols.empty()) return;
+  const size_t data_start = (has_header && layout.has_rows) ? 1 : 0;
+  std::vector<std::string> out_row;
+  for_each_kept_row(rows, layout.raw_max_cols, options,
+                    [&](const std::vector<std::string>& row, size_t index) {
+                      if (!sparse) {
+                        out_row.clear();
+                        if (index == 0 && layout.replace_header_row) {
+                          out_row = layout.headers;
+                        } else {
+                          for (size_t source_col : layout.keep_cols) {
+                            out_row.push_back(source_col < row.size() ? row[source_col]
+                                                                      : std::string{});
+                          }
+                        }
+                        emit(out_row);
+                        return;
+                      }
+                      if (index < data_start) return;
+                      for (size_t col_pos = 0; col_pos < layout.keep_cols.size(); ++col_pos) {
+                        const size_t source_col = layout.keep_cols[col_pos];
+                        if (table_cell_empty(row, source_col, options.empty_is)) continue;
+                        out_row.clear();
+                        out_row.push_back(std::to_string((index - data_start) + 1));
+                        out_row.push_back(std::to_string(col_pos + 1));
+                        if (has_header) {
+                          out_row.push_back(layout.headers[col_pos]);
+                        }
+                        out_row.push_back(source_col < row.size() ? row[source_col]
+                                                                  : std::string{});
+                        emit(out_row);
+                      }
+                    });
+}
 
-  const size_t data_start = (has_header && !out.rect_rows.empty()) ? 1 : 0;
-  for (size_t row_idx = data_start; row_idx < kept_rows.size(); ++row_idx) {
-    const auto& original = kept_rows[row_idx];
-    if (options.sparse_shape == Query::TableOptions::SparseShape::Long) {
-      for (size_t col_pos = 0; col_pos < keep_cols.size(); ++col_pos) {
-        const size_t source_col = keep_cols[col_pos];
-        if (table_cell_empty(original, source_col, options.empty_is)) continue;
-        std::vector<std::string> out_row;
-        out_row.reserve(has_header ? 4 : 3);
-        out_row.push_back(std::to_string((row_idx - data_start) + 1));
-        out_row.push_back(std::to_string(col_pos + 1));
-        if (has_header) {
-          out_row.push_back(out.headers[col_pos]);
-        }
-        if (source_col < original.size()) {
-          out_row.push_back(original[source_col]);
-        } else {
-          out_row.emplace_back();
-        }
-        out.sparse_long_rows.push_back(std::move(out_row));
-      }
-      continue;
-    }
-    std::vector<std::pair<std::string, std::string>> sparse_row;
-    sparse_row.reserve(keep_cols.size());
-    for (size_t col_pos = 0; col_pos < keep_cols.size(); ++col_pos) {
-      const size_t source_col = keep_cols[col_pos];
-      if (table_cell_empty(original, source_col, options.empty_is)) continue;
-      std::string key =
-          has_header ? out.header_keys[col_pos] : ("col_" + std::to_string(col_pos + 1));
-      std::string value = (source_col < original.size()) ? original[source_col] : std::string{};
-      sparse_row.emplace_back(std::move(key), std::move(value));
-    }
-    out.sparse_wide_rows.push_back(std::move(sparse_row));
-  }
+/// Builds the SPARSE_SHAPE=WIDE rows, one key/value list per kept data row.
+std::vector<std::vector<std::pair<std::string, std::string>>> sparse_wide_table_rows(
+    RawTableRows& rows, const TableLayout& layout, bool has_header,
+    const Query::TableOptions& options) {
+  std::vector<std::vector<std::pair<std::string, std::string>>> out;
+  if (layout.keep_cols.empty()) return out;
+  const size_t data_start = (has_header && layout.has_rows) ? 1 : 0;
+  for_each_kept_row(rows, layout.raw_max_cols, options,
+                    [&](const std::vector<std::string>& row, size_t index) {
+                      if (index < data_start) return;
+                      std::vector<std::pair<std::string, std::string>> sparse_row;
+                      sparse_row.reserve(layout.keep_cols.size());
+                      for (size_t col_pos = 0; col_pos < layout.keep_cols.size(); ++col_pos) {
+                        const size_t source_col = layout.keep_cols[col_pos];
+                        if (table_cell_empty(row, source_col, options.empty_is)) continue;
+                        std::string key = has_header ? layout.header_keys[col_pos]
+                                                     : ("col_" + std::to_string(col_pos + 1));
+                        std::string value =
+                            (source_col < row.size()) ? row[source_col] : std::string{};
+                        sparse_row.emplace_back(std::move(key), std::move(value));
+                      }
+                      out.push_back(std::move(sparse_row));
+                    });
   return out;
 }
 
 }  // namespace
 
+QueryResult::ExportSink to_result_export_sink(const Query::ExportSink& sink) {
+  QueryResult::ExportSink out;
+  if (sink.kind == Query::ExportSink::Kind::Csv) {
+    out.kind = QueryResult::ExportSink::Kind::Csv;
+  } else if (sink.kind == Query::ExportSink::Kind::Parquet) {
+    out.kind = QueryResult::ExportSink::Kind::Parquet;
+  } else if (sink.kind == Query::ExportSink::Kind::Json) {
+    out.kind = QueryResult::ExportSink::Kind::Json;
+  } else if (sink.kind == Query::ExportSink::Kind::Ndjson) {
+    out.kind = QueryResult::ExportSink::Kind::Ndjson;
+  } else if (sink.kind == Query::ExportSink::Kind::Arrow) {
+    out.kind = QueryResult::ExportSink::Kind::Arrow;
+  }
+  out.path = sink.path;
+  using Compression = QueryResult::ExportSink::ParquetOptions::Compression;
+  switch (sink.parquet.compression) {
+    case Query::ParquetOptions::Compression::Snappy:
+      out.parquet.compression = Compression::Snappy;
+      break;
+    case Query::ParquetOptions::Compression::Zstd:
+      out.parquet.compression = Compression::Zstd;
+      break;
+    case Query::ParquetOptions::Compression::Gzip:
+      out.parquet.compression = Compression::Gzip;
+      break;
+    case Query::ParquetOptions::Compression::None:
+      out.parquet.compression = Compression::None;
+      break;
+  }
+  out.parquet.row_group_size = sink.parquet.row_group_size;
+  out.parquet.infer_types = sink.parquet.infer_types;
+  out.fsync = sink.fsync;
+  using TextCompression = QueryResult::ExportSink::Compression;
+  switch (sink.compression) {
+    case Query::ExportSink::Compression::Auto:
+      out.compression = TextCompression::Auto;
+      break;
+    case Query::ExportSink::Compression::None:
+      out.compression = TextCompression::None;
+      break;
+    case Query::ExportSink::Compression::Gzip:
+      out.compression = TextCompression::Gzip;
+      break;
+    case Query::ExportSink::Compression::Zstd:
+      out.compression = TextCompression::Zstd;
+      break;
+  }
+  return out;
+}
+
 QueryResult::TableOptions to_result_table_options(const Query::TableOptions& options) {
   QueryResult::TableOptions out;
   out.trim_empty_rows = options.trim_empty_rows;
@@ -320,19 +465,56 @@ bool table_uses_default_output(const Query& query) {
 void materialize_table_result(const std::vector<std::vector<std::string>>& raw_rows,
                               bool has_header, const Query::TableOptions& options,
                               QueryResult::TableResult& table) {
-  MaterializedTable materialized = materialize_table(raw_rows, has_header, options);
-  table.headers = std::move(materialized.headers);
-  table.header_keys = std::move(materialized.header_keys);
-  if (options.format == Query::TableOptions::Format::Sparse) {
-    if (options.sparse_shape == Query::TableOptions::SparseShape::Long) {
-      table.rows = std::move(materialized.sparse_long_rows);
-    } else {
-      table.rows.clear();
-      table.sparse_wide_rows = std::move(materialized.sparse_wide_rows);
-    }
+  CollectedTableRows rows(raw_rows);
+  TableLayout layout = plan_table_layout(rows, has_header, options);
+  std::vector<std::vector<std::string>> out_rows;
+  std::vector<std::vector<std::pair<std::string, std::string>>> sparse_wide_rows;
+  if (options.format == Query::TableOptions::Format::Sparse &&
+      options.sparse_shape == Query::TableOptions::SparseShape::Wide) {
+    sparse_wide_rows = sparse_wide_table_rows(rows, layout, has_header, options);
   } else {
-    table.rows = std::move(materialized.rect_rows);
+    emit_table_rows(rows, layout, has_header, options,
+                    [&](std::vector<std::string>& row) { out_rows.push_back(std::move(row)); });
+  }
+  table.headers = std::move(layout.headers);
+  table.header_keys = std::move(layout.header_keys);
+  table.rows = std::move(out_rows);
+  table.sparse_wide_rows = std::move(sparse_wide_rows);
+}
+
+bool stream_table_result(const Query& query, const HtmlDocument& doc,
+                         const std::vector<std::vector<int64_t>>& children,
+                         QueryResult::TableResult& table, QueryResult& out,
+                         ResultRowStream& stream) {
+  const Query::TableOptions& options = query.table_options;
+  if (options.format == Query::TableOptions::Format::Sparse &&
+      options.sparse_shape == Query::TableOptions::SparseShape::Wide) {
+    return false;
   }
+  DocumentTableRows rows(doc, children, table.node_id);
+  if (table_uses_default_output(query)) {
+    size_t column_count = 0;
+    size_t width = 0;
+    while (rows.next_width(width)) {
+      if (width > column_count) column_count = width;
+    }
+    if (!stream.begin_table(out, table, column_count)) return false;
+    rows.rewind();
+    while (const std::vector<std::string>* row = rows.next()) {
+      stream.table_row(*row);
+    }
+    return true;
+  }
+  TableLayout layout = plan_table_layout(rows, query.table_has_header, options);
+  table.headers = layout.headers;
+  table.header_keys = layout.header_keys;
+  const size_t column_count = options.format == Query::TableOptions::Format::Sparse
+                                  ? (query.table_has_header ? 4 : 3)
+                                  : layout.keep_cols.size();
+  if (!stream.begin_table(out, table, column_count)) return false;
+  emit_table_rows(rows, layout, query.table_has_header, options,
+                  [&](const std::vector<std::string>& row) { stream.table_row(row); });
+  return true;
 }
 
 }  // namespace markql
@@ -1,10 +1,12 @@
 #include "markql/markql.h"
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,8 +26,8 @@ namespace markql {
 namespace {
 
 bool query_uses_relation_runtime(const Query& query,
-                                 const std::unordered_map<std::string, Relation>* ctes,
-                                 const RelationRow* outer_row) {
+                                 const RelationCteMap* ctes,
+                                 const RelationRowRef* outer_row) {
   if (outer_row != nullptr) return true;
   if (ctes != nullptr && !ctes->empty()) return true;
   if (query.with.has_value() && !query.with->ctes.empty()) return true;
@@ -69,7 +71,8 @@ std::string join_label_for_index(const Query::JoinItem& join, size_t index) {
   return label;
 }
 
-void maybe_emit_relation_runtime_profile(const RelationRuntimeCache::Profile& profile) {
+void maybe_emit_relation_runtime_profile(const RelationRuntimeCache& cache) {
+  const RelationRuntimeCache::Profile& profile = cache.profile;
   if (!profile.enabled) return;
   std::fprintf(stderr,
                "[markql rel_profile] timings_ms join=%.3f projection=%.3f scalar_expr=%.3f\n",
@@ -78,15 +81,35 @@ void maybe_emit_relation_runtime_profile(const RelationRuntimeCache::Profile& pr
   std::fprintf(stderr, "[markql rel_profile] relation_indexes builds=%llu hits=%llu\n",
                static_cast<unsigned long long>(profile.relation_index_builds),
                static_cast<unsigned long long>(profile.relation_index_hits));
+  if (cache.document_cache != nullptr) {
+    const RelationDocumentCache::Stats stats = cache.document_cache->stats();
+    std::fprintf(stderr,
+                 "[markql rel_profile] document_cache hits=%llu misses=%llu entries=%zu "
+                 "bytes=%zu evictions=%llu\n",
+                 static_cast<unsigned long long>(profile.document_cache_hits),
+                 static_cast<unsigned long long>(profile.document_cache_misses), stats.entries,
+                 stats.bytes, static_cast<unsigned long long>(stats.evictions));
+  }
   for (const auto& cte : profile.cte_sizes) {
-    std::fprintf(stderr, "[markql rel_profile] cte=%s rows=%zu\n", cte.name.c_str(), cte.rows);
+    std::fprintf(stderr, "[markql rel_profile] cte=%s rows=%zu wall_ms=%.3f\n", cte.name.c_str(),
+                 cte.rows, ns_to_ms(cte.wall_ns));
+  }
+  for (const auto& path : profile.cte_paths) {
+    std::string chain;
+    for (const auto& name : path.ctes) {
+      if (!chain.empty()) chain.push_back('>');
+      chain += name;
+    }
+    std::fprintf(stderr, "[markql rel_profile] cte_critical_path wall_ms=%.3f path=%s\n",
+                 ns_to_ms(path.wall_ns), chain.c_str());
   }
   for (const auto& join : profile.joins) {
     std::fprintf(stderr,
                  "[markql rel_profile] %s strategy=%s left_rows=%zu right_rows=%zu output_rows=%zu "
-                 "pairs=%llu\n",
+                 "pairs=%llu%s%s\n",
                  join.label.c_str(), join.strategy.c_str(), join.left_rows, join.right_rows,
-                 join.output_rows, static_cast<unsigned long long>(join.pairs_evaluated));
+                 join.output_rows, static_cast<unsigned long long>(join.pairs_evaluated),
+                 join.detail.empty() ? "" : " ", join.detail.c_str());
   }
 }
 
@@ -98,13 +121,122 @@ bool operand_targets_source_row(const Operand& operand,
   return lower_alias_name(*operand.qualifier) == *active_alias;
 }
 
+/// Collects every name a subquery could use to reach an outer alias: lowered qualifiers, tag and
+/// alias references, string literals, and "" for unqualified operands. Over-collecting only costs
+/// LATERAL memo hits, never correctness.
+void collect_query_mentions(const Query& query, std::unordered_set<std::string>& out);
+
+void collect_operand_mentions(const Operand& operand, std::unordered_set<std::string>& out) {
+  out.insert(operand.qualifier.has_value() ? lower_alias_name(*operand.qualifier)
+                                           : std::string());
+}
+
+void collect_scalar_mentions(const ScalarExpr& expr, std::unordered_set<std::string>& out) {
+  if (expr.kind == ScalarExpr::Kind::Operand) collect_operand_mentions(expr.operand, out);
+  if (expr.kind == ScalarExpr::Kind::StringLiteral) out.insert(lower_alias_name(expr.string_value));
+  for (const auto& arg : expr.args) collect_scalar_mentions(arg, out);
+}
+
+void collect_expr_mentions(const Expr& expr, std::unordered_set<std::string>& out) {
+  if (std::holds_alternative<CompareExpr>(expr)) {
+    const auto& cmp = std::get<CompareExpr>(expr);
+    if (cmp.lhs_expr.has_value()) {
+      collect_scalar_mentions(*cmp.lhs_expr, out);
+    } else {
+      collect_operand_mentions(cmp.lhs, out);
+    }
+    if (cmp.rhs_expr.has_value()) collect_scalar_mentions(*cmp.rhs_expr, out);
+    for (const auto& rhs_expr : cmp.rhs_expr_list) collect_scalar_mentions(rhs_expr, out);
+    for (const auto& value : cmp.rhs.values) out.insert(lower_alias_name(value));
+    return;
+  }
+  if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(expr)) {
+    const auto& exists = *std::get<std::shared_ptr<ExistsExpr>>(expr);
+    out.insert(std::string());
+    if (exists.where.has_value()) collect_expr_mentions(*exists.where, out);
+    return;
+  }
+  const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+  collect_expr_mentions(bin.left, out);
+  collect_expr_mentions(bin.right, out);
+}
+
+void collect_extract_mentions(const Query::SelectItem::FlattenExtractExpr& expr,
+                              std::unordered_set<std::string>& out) {
+  out.insert(lower_alias_name(expr.tag));
+  out.insert(lower_alias_name(expr.alias_ref));
+  out.insert(lower_alias_name(expr.string_value));
+  if (expr.kind == Query::SelectItem::FlattenExtractExpr::Kind::OperandRef) {
+    collect_operand_mentions(expr.operand, out);
+  }
+  if (expr.where.has_value()) collect_expr_mentions(*expr.where, out);
+  for (const auto& arg : expr.args) collect_extract_mentions(arg, out);
+  for (const auto& when_expr : expr.case_when_conditions) collect_expr_mentions(when_expr, out);
+  for (const auto& then_expr : expr.case_when_values) collect_extract_mentions(then_expr, out);
+  if (expr.case_else != nullptr) collect_extract_mentions(*expr.case_else, out);
+}
+
+void collect_source_mentions(const Source& source, std::unordered_set<std::string>& out) {
+  out.insert(lower_alias_name(source.value));
+  if (source.parse_expr != nullptr) collect_scalar_mentions(*source.parse_expr, out);
+  if (source.parse_query != nullptr) collect_query_mentions(*source.parse_query, out);
+  if (source.derived_query != nullptr) collect_query_mentions(*source.derived_query, out);
+}
+
+void collect_query_mentions(const Query& query, std::unordered_set<std::string>& out) {
+  if (query.with.has_value()) {
+    for (const auto& cte : query.with->ctes) {
+      if (cte.query != nullptr) collect_query_mentions(*cte.query, out);
+    }
+  }
+  collect_source_mentions(query.source, out);
+  for (const auto& join : query.joins) {
+    collect_source_mentions(join.right_source, out);
+    if (join.on.has_value()) collect_expr_mentions(*join.on, out);
+  }
+  if (query.where.has_value()) collect_expr_mentions(*query.where, out);
+  for (const auto& item : query.select_items) {
+    out.insert(lower_alias_name(item.tag));
+    if (item.field.has_value()) out.insert(lower_alias_name(*item.field));
+    if (item.expr.has_value()) collect_scalar_mentions(*item.expr, out);
+    if (item.project_expr.has_value()) collect_extract_mentions(*item.project_expr, out);
+    for (const auto& expr : item.flatten_extract_exprs) collect_extract_mentions(expr, out);
+  }
+  for (const auto& order : query.order_by) {
+    const size_t dot = order.field.find('.');
+    out.insert(dot == std::string::npos ? std::string()
+                                        : lower_alias_name(order.field.substr(0, dot)));
+  }
+}
+
+/// Aliases of `left` whose rows a LATERAL right source can observe. Only derived subqueries see
+/// the outer row; other sources evaluate identically for every left row.
+std::vector<size_t> lateral_key_aliases(const Source& right_source, const Relation& left) {
+  std::vector<size_t> out;
+  if (right_source.kind != Source::Kind::DerivedSubquery || right_source.derived_query == nullptr) {
+    return out;
+  }
+  std::unordered_set<std::string> mentions;
+  collect_query_mentions(*right_source.derived_query, mentions);
+  for (size_t i = 0; i < left.aliases.size(); ++i) {
+    // WHY: an unqualified operand can resolve to the outer row when it has a single alias.
+    const bool unqualified = left.aliases.size() == 1 && mentions.count(std::string()) != 0;
+    if (unqualified || mentions.count(left.aliases[i].name) != 0) out.push_back(i);
+  }
+  return out;
+}
+
 std::optional<std::string> compare_rhs_single_value(
-    const CompareExpr& cmp, const RelationRow* outer_row,
+    const CompareExpr& cmp, const RelationRowRef* outer_row,
     const std::optional<std::string>& active_alias) {
   if (cmp.rhs_expr.has_value()) {
-    static const RelationRow kEmptyRow;
-    const RelationRow& row = outer_row != nullptr ? *outer_row : kEmptyRow;
-    return eval_relation_scalar_expr(*cmp.rhs_expr, row, active_alias);
+    static const Relation kEmptyRelation;
+    const Relation& rel = outer_row != nullptr ? *outer_row->relation : kEmptyRelation;
+    RelationScope scope(rel, active_alias);
+    std::vector<uint32_t> cursor(rel.aliases.size(), 0);
+    if (outer_row != nullptr) load_relation_row(rel, outer_row->row, cursor);
+    return eval_relation_scalar_expr(*cmp.rhs_expr, RelationRowView{&scope, cursor.data()})
+        .to_text();
   }
   if (cmp.rhs.values.size() == 1) {
     return cmp.rhs.values.front();
@@ -114,7 +246,8 @@ std::optional<std::string> compare_rhs_single_value(
 
 void collect_source_prefilter_constraints(const Expr& expr,
                                           const std::optional<std::string>& active_alias,
-                                          const RelationRow* outer_row, SourceRowPrefilter& out) {
+                                          const RelationRowRef* outer_row,
+                                          SourceRowPrefilter& out) {
   if (std::holds_alternative<CompareExpr>(expr)) {
     const auto& cmp = std::get<CompareExpr>(expr);
     if (cmp.op != CompareExpr::Op::Eq) return;
@@ -157,164 +290,200 @@ void collect_source_prefilter_constraints(const Expr& expr,
   }
 }
 
+/// Scan prefilter for a document source from conjuncts already pinned to its alias.
+std::optional<SourceRowPrefilter> pushed_source_prefilter(
+    const Source& source, const std::vector<const Expr*>& conjuncts) {
+  if (source.kind != Source::Kind::Document || conjuncts.empty()) return std::nullopt;
+  SourceRowPrefilter prefilter;
+  const std::optional<std::string> alias = source_alias_name(source);
+  for (const Expr* conjunct : conjuncts) {
+    // Only constant right-hand sides can narrow the scan; the rest filter the scanned rows.
+    const auto* cmp = std::get_if<CompareExpr>(conjunct);
+    if (cmp != nullptr && cmp->rhs_expr.has_value() &&
+        cmp->rhs_expr->kind != ScalarExpr::Kind::StringLiteral &&
+        cmp->rhs_expr->kind != ScalarExpr::Kind::NumberLiteral) {
+      continue;
+    }
+    collect_source_prefilter_constraints(*conjunct, alias, nullptr, prefilter);
+  }
+  if (!prefilter.impossible && !prefilter.parent_id_eq.has_value() &&
+      !prefilter.tag_eq.has_value()) {
+    return std::nullopt;
+  }
+  return prefilter;
+}
+
 QueryResult execute_query_with_source_context(const Query& query, const std::string* default_html,
                                               const HtmlDocument* default_document,
                                               const std::string& default_source_uri,
-                                              const std::unordered_map<std::string, Relation>* ctes,
-                                              const RelationRow* outer_row,
-                                              RelationRuntimeCache* cache);
+                                              const RelationCteMap* ctes,
+                                              const RelationRowRef* outer_row,
+                                              RelationRuntimeCache* cache,
+                                              bool node_fields = true,
+                                              ResultRowStream* stream = nullptr);
+
+/// ORDER BY key: NULL sorts first, two integers compare numerically, anything else as text.
+struct RelationSortKey {
+  RelationValue value;
+  std::optional<int64_t> number;
+};
 
-Relation relation_from_query_result(QueryResult result, const std::string& alias_name) {
+int compare_relation_sort_keys(const RelationSortKey& left, const RelationSortKey& right) {
+  if (left.value.is_null() && right.value.is_null()) return 0;
+  if (left.value.is_null()) return -1;
+  if (right.value.is_null()) return 1;
+  if (left.number.has_value() && right.number.has_value()) {
+    if (*left.number < *right.number) return -1;
+    if (*left.number > *right.number) return 1;
+    return 0;
+  }
+  std::array<char, 24> left_scratch;
+  std::array<char, 24> right_scratch;
+  const int cmp = left.value.text(left_scratch).compare(right.value.text(right_scratch));
+  return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+}
+
+/// Dense column ids of the core node fields in a builder created with add_core_columns().
+struct CoreColumnIds {
+  explicit CoreColumnIds(RelationTableBuilder& builder)
+      : node_id(builder.column("node_id")),
+        tag(builder.column("tag")),
+        text(builder.column("text")),
+        inner_html(builder.column("inner_html")),
+        parent_id(builder.column("parent_id")),
+        sibling_pos(builder.column("sibling_pos")),
+        max_depth(builder.column("max_depth")),
+        doc_order(builder.column("doc_order")),
+        source_uri(builder.column("source_uri")) {}
+
+  size_t node_id;
+  size_t tag;
+  size_t text;
+  size_t inner_html;
+  size_t parent_id;
+  size_t sibling_pos;
+  size_t max_depth;
+  size_t doc_order;
+  size_t source_uri;
+};
+
+Relation single_alias_relation(const std::string& alias,
+                               std::shared_ptr<const RelationTable> table) {
   Relation out;
-  const std::string alias = lower_alias_name(alias_name);
-  out.cache_key = "relation_result";
-  out.warnings = std::move(result.warnings);
+  RelationAlias entry;
+  entry.name = alias;
+  std::vector<uint32_t>& rows = entry.rows.mutate();
+  rows.resize(table->row_count());
+  for (size_t i = 0; i < rows.size(); ++i) rows[i] = static_cast<uint32_t>(i);
+  entry.table = std::move(table);
+  out.row_count = entry.rows.size();
+  out.aliases.push_back(std::move(entry));
+  return out;
+}
+
+/// Without `node_fields` the table holds only the result columns; consumers were checked not to
+/// read the node fields a row inherits from its FROM row.
+Relation relation_from_query_result(QueryResult result, const std::string& alias_name,
+                                    bool node_fields = true) {
+  RelationTableBuilder builder;
+  std::optional<CoreColumnIds> core;
+  if (node_fields) {
+    builder.add_core_columns(false);
+    core.emplace(builder);
+  }
+  std::vector<size_t> result_columns;
+  result_columns.reserve(result.columns.size());
+  for (const auto& col : result.columns) {
+    result_columns.push_back(builder.add_dense_column(col, RelationTable::ColumnKind::String));
+  }
   for (auto& row : result.rows) {
-    RelationRow rel_row;
-    RelationRecord record;
-    record.values["node_id"] = std::to_string(row.node_id);
-    record.values["tag"] = row.tag;
-    record.values["text"] = row.text;
-    record.values["inner_html"] = row.inner_html;
-    if (row.parent_id.has_value()) {
-      record.values["parent_id"] = std::to_string(*row.parent_id);
-    } else {
-      record.values["parent_id"] = std::nullopt;
+    builder.begin_row();
+    if (core.has_value()) {
+      builder.set_int(core->node_id, row.node_id);
+      builder.set_string(core->tag, row.tag);
+      builder.set_string(core->text, row.text);
+      builder.set_string(core->inner_html, row.inner_html);
+      if (row.parent_id.has_value()) {
+        builder.set_int(core->parent_id, *row.parent_id);
+      } else {
+        builder.set_null(core->parent_id);
+      }
+      builder.set_int(core->sibling_pos, row.sibling_pos);
+      builder.set_int(core->max_depth, row.max_depth);
+      builder.set_int(core->doc_order, row.doc_order);
+      builder.set_string(core->source_uri, row.source_uri);
     }
-    record.values["sibling_pos"] = std::to_string(row.sibling_pos);
-    record.values["max_depth"] = std::to_string(row.max_depth);
-    record.values["doc_order"] = std::to_string(row.doc_order);
-    record.values["source_uri"] = row.source_uri;
-    for (const auto& col : result.columns) {
-      record.values[col] = field_value_string(row, col);
+    for (size_t i = 0; i < result.columns.size(); ++i) {
+      builder.set_value(result_columns[i], field_value_string(row, result.columns[i]));
     }
+    if (!core.has_value()) continue;
     for (auto& attr : row.attributes) {
-      record.attributes[attr.first] = attr.second;
-      record.values[attr.first] = attr.second;
+      const size_t column = builder.column(attr.first);
+      builder.set_string(column, attr.second);
+      builder.add_attribute(column, std::move(attr.second));
     }
-    rel_row.aliases[alias] = std::move(record);
-    merge_alias_columns(out, alias, rel_row.aliases[alias]);
-    out.rows.push_back(std::move(rel_row));
   }
+  Relation out = single_alias_relation(lower_alias_name(alias_name), builder.finish());
+  // WHY: no cache_key; a constant one made distinct derived tables share relation indexes.
+  out.warnings = std::move(result.warnings);
   return out;
 }
 
-std::vector<int64_t> build_sibling_positions(const HtmlDocument& doc) {
-  std::vector<int64_t> sibling_pos(doc.nodes.size(), 1);
-  std::vector<std::vector<int64_t>> children(doc.nodes.size());
-  for (const auto& node : doc.nodes) {
-    if (node.parent_id.has_value()) {
-      children.at(static_cast<size_t>(*node.parent_id)).push_back(node.id);
-    }
-  }
-  for (const auto& kids : children) {
-    for (size_t i = 0; i < kids.size(); ++i) {
-      sibling_pos.at(static_cast<size_t>(kids[i])) = static_cast<int64_t>(i + 1);
-    }
-  }
-  return sibling_pos;
-}
-
-Relation relation_from_document(const HtmlDocument& doc, const std::string& alias_name,
-                                const std::string& source_uri,
-                                const std::vector<int64_t>* sibling_pos_override,
+Relation relation_from_document(std::shared_ptr<const RelationDocument> document,
+                                const std::string& alias_name, const std::string& source_uri,
                                 const SourceRowPrefilter* prefilter) {
-  Relation out;
-  const std::string alias = lower_alias_name(alias_name);
-  std::vector<int64_t> local_sibling_pos;
-  if (sibling_pos_override == nullptr) {
-    local_sibling_pos = build_sibling_positions(doc);
-    sibling_pos_override = &local_sibling_pos;
-  }
-  std::unordered_map<int64_t, const HtmlNode*> node_by_id;
-  node_by_id.reserve(doc.nodes.size());
-  for (const auto& n : doc.nodes) {
-    node_by_id[n.id] = &n;
-  }
-  for (const auto& node : doc.nodes) {
-    if (prefilter != nullptr) {
-      if (prefilter->impossible) continue;
-      if (prefilter->parent_id_eq.has_value()) {
-        if (!node.parent_id.has_value() || *node.parent_id != *prefilter->parent_id_eq) continue;
+  // WHY: document relations keep node indices only; cells are read from the shared DOM on
+  // first touch, so columns the query never references are never copied.
+  std::vector<uint32_t> nodes;
+  const auto& doc_nodes = document->doc->nodes;
+  if (prefilter != nullptr && !prefilter->impossible && prefilter->parent_id_eq.has_value()) {
+    // WHY: correlated LATERAL subqueries filter on parent_id = outer.node_id once per outer
+    // row; walk the shared child index instead of rescanning the whole document.
+    const int64_t parent = *prefilter->parent_id_eq;
+    if (parent >= 0 && static_cast<size_t>(parent) < doc_nodes.size() &&
+        doc_nodes[static_cast<size_t>(parent)].id == parent) {
+      const size_t begin = document->child_offsets[static_cast<size_t>(parent)];
+      const size_t end = document->child_offsets[static_cast<size_t>(parent) + 1];
+      for (size_t i = begin; i < end; ++i) {
+        const uint32_t child = document->child_nodes[i];
+        if (prefilter->tag_eq.has_value() && doc_nodes[child].tag != *prefilter->tag_eq) continue;
+        nodes.push_back(child);
       }
-      if (prefilter->tag_eq.has_value() && node.tag != *prefilter->tag_eq) continue;
-    }
-    RelationRow rel_row;
-    RelationRecord record;
-    record.values["node_id"] = std::to_string(node.id);
-    record.values["tag"] = node.tag;
-    record.values["text"] = node.text;
-    record.values["inner_html"] = node.inner_html;
-    if (node.parent_id.has_value()) {
-      record.values["parent_id"] = std::to_string(*node.parent_id);
-    } else {
-      record.values["parent_id"] = std::nullopt;
-    }
-    record.values["sibling_pos"] =
-        std::to_string(sibling_pos_override->at(static_cast<size_t>(node.id)));
-    record.values["max_depth"] = std::to_string(node.max_depth);
-    record.values["doc_order"] = std::to_string(node.doc_order);
-    record.values["source_uri"] = source_uri;
-    for (const auto& attr : node.attributes) {
-      record.attributes[attr.first] = attr.second;
-      record.values[attr.first] = attr.second;
-    }
-    if (node.parent_id.has_value()) {
-      auto parent_it = node_by_id.find(*node.parent_id);
-      if (parent_it != node_by_id.end() && parent_it->second != nullptr) {
-        const HtmlNode& parent = *parent_it->second;
-        record.values["parent.node_id"] = std::to_string(parent.id);
-        record.values["parent.tag"] = parent.tag;
-        record.values["parent.text"] = parent.text;
-        record.values["parent.inner_html"] = parent.inner_html;
-        if (parent.parent_id.has_value()) {
-          record.values["parent.parent_id"] = std::to_string(*parent.parent_id);
-        } else {
-          record.values["parent.parent_id"] = std::nullopt;
-        }
-        record.values["parent.sibling_pos"] =
-            std::to_string(sibling_pos_override->at(static_cast<size_t>(parent.id)));
-        record.values["parent.max_depth"] = std::to_string(parent.max_depth);
-        record.values["parent.doc_order"] = std::to_string(parent.doc_order);
-        for (const auto& attr : parent.attributes) {
-          record.values["parent." + attr.first] = attr.second;
-        }
+    }
+  } else if (prefilter == nullptr || !prefilter->impossible) {
+    nodes.reserve(doc_nodes.size());
+    for (size_t i = 0; i < doc_nodes.size(); ++i) {
+      if (prefilter != nullptr && prefilter->tag_eq.has_value() &&
+          doc_nodes[i].tag != *prefilter->tag_eq) {
+        continue;
       }
+      nodes.push_back(static_cast<uint32_t>(i));
     }
-    rel_row.aliases[alias] = std::move(record);
-    merge_alias_columns(out, alias, rel_row.aliases[alias]);
-    out.rows.push_back(std::move(rel_row));
   }
-  return out;
+  return single_alias_relation(
+      lower_alias_name(alias_name),
+      RelationTable::from_document(std::move(document), std::move(nodes), source_uri));
 }
 
 Relation evaluate_source_relation(const Source& source, const std::string* default_html,
                                   const HtmlDocument* default_document,
                                   const std::string& default_source_uri,
-                                  const std::unordered_map<std::string, Relation>* ctes,
-                                  const RelationRow* outer_row, RelationRuntimeCache* cache,
-                                  const SourceRowPrefilter* prefilter) {
+                                  const RelationCteMap* ctes,
+                                  const RelationRowRef* outer_row, RelationRuntimeCache* cache,
+                                  const SourceRowPrefilter* prefilter, bool node_fields = true) {
   if (source.kind == Source::Kind::CteRef) {
     const std::string lookup = lower_alias_name(source.value);
     if (ctes == nullptr || ctes->find(lookup) == ctes->end()) {
       throw std::runtime_error("Unknown CTE source '" + source.value + "'");
     }
-    Relation rel = ctes->at(lookup);
+    // WHY: CTE results are shared; the reference copies alias handles and selection vectors by
+    // reference only, and renaming the alias touches just this view.
+    Relation rel = *ctes->at(lookup);
     const std::string target_alias =
         source.alias.has_value() ? lower_alias_name(*source.alias) : lookup;
     if (target_alias != lookup) {
-      for (auto& row : rel.rows) {
-        auto it = row.aliases.find(lookup);
-        if (it == row.aliases.end()) continue;
-        RelationRecord record = std::move(it->second);
-        row.aliases.erase(it);
-        row.aliases[target_alias] = std::move(record);
-      }
-      auto schema_it = rel.alias_columns.find(lookup);
-      if (schema_it != rel.alias_columns.end()) {
-        rel.alias_columns[target_alias] = std::move(schema_it->second);
-        rel.alias_columns.erase(schema_it);
-      }
+      const int32_t alias = rel.find_alias(lookup);
+      if (alias >= 0) rel.aliases[static_cast<size_t>(alias)].name = target_alias;
     }
     return rel;
   }
@@ -325,46 +494,52 @@ Relation evaluate_source_relation(const Source& source, const std::string* defau
     if (!source.alias.has_value()) {
       throw std::runtime_error("Derived table requires an alias");
     }
-    QueryResult sub =
-        execute_query_with_source_context(*source.derived_query, default_html, default_document,
-                                          default_source_uri, ctes, outer_row, cache);
-    return relation_from_query_result(std::move(sub), *source.alias);
+    QueryResult sub = execute_query_with_source_context(*source.derived_query, default_html,
+                                                        default_document, default_source_uri,
+                                                        ctes, outer_row, cache, node_fields);
+    return relation_from_query_result(std::move(sub), *source.alias, node_fields);
   }
 
-  HtmlDocument doc;
-  const std::vector<int64_t>* sibling_pos = nullptr;
+  std::shared_ptr<const RelationDocument> document;
+  std::shared_ptr<const HtmlDocument> doc;
   std::string source_uri = default_source_uri;
   std::vector<std::string> warnings;
   if (source.kind == Source::Kind::Document) {
-    // WHY: WITH/JOIN/LATERAL can revisit FROM doc many times; parse once per statement.
-    if (cache != nullptr && cache->default_document.has_value()) {
-      doc = *cache->default_document;
-    } else if (default_document != nullptr) {
-      doc = *default_document;
-      if (cache != nullptr) cache->default_document = doc;
-    } else {
-      doc = parse_html(*default_html);
-      if (cache != nullptr) {
-        cache->default_document = doc;
-      }
-    }
-    if (cache != nullptr) {
-      if (!cache->default_sibling_pos.has_value()) {
-        cache->default_sibling_pos = build_sibling_positions(doc);
+    // WHY: WITH/JOIN/LATERAL can revisit FROM doc many times; parse once per statement and
+    // share the DOM instead of copying it into every relation.
+    auto load_document = [&]() {
+      if (default_document != nullptr) {
+        // The caller owns the document for the whole statement; borrow it without copying.
+        doc = std::shared_ptr<const HtmlDocument>(std::shared_ptr<const HtmlDocument>(),
+                                                  default_document);
+      } else {
+        doc = std::make_shared<const HtmlDocument>(parse_html(*default_html));
       }
-      sibling_pos = &*cache->default_sibling_pos;
+      return make_relation_document(std::move(doc));
+    };
+    if (cache != nullptr && cache->document_cache != nullptr) {
+      document = cache->document_cache->document();
+    } else if (cache != nullptr) {
+      // Concurrent CTE tasks share this slot; the first to arrive parses, the rest wait.
+      RelationRuntimeCache::DefaultDocument& slot = *cache->default_document;
+      std::call_once(slot.parsed, [&]() { slot.document = load_document(); });
+      document = slot.document;
+    } else {
+      document = load_document();
     }
   } else if (source.kind == Source::Kind::Path) {
-    doc = parse_html(markql_internal::read_file(source.value));
+    doc = std::make_shared<const HtmlDocument>(
+        parse_html(markql_internal::read_file(source.value)));
     source_uri = source.value;
   } else if (source.kind == Source::Kind::Url) {
-    doc = parse_html(markql_internal::fetch_url(source.value, 5000));
+    doc = std::make_shared<const HtmlDocument>(
+        parse_html(markql_internal::fetch_url(source.value, 5000)));
     source_uri = source.value;
   } else if (source.kind == Source::Kind::RawHtml) {
     if (source.value.size() > markql_internal::kMaxRawHtmlBytes) {
       throw std::runtime_error("RAW() HTML exceeds maximum size");
     }
-    doc = parse_html(source.value);
+    doc = std::make_shared<const HtmlDocument>(parse_html(source.value));
     source_uri = "raw";
   } else if (source.kind == Source::Kind::Parse) {
     FragmentSource fragments;
@@ -386,13 +561,45 @@ Relation evaluate_source_relation(const Source& source, const std::string* defau
     } else {
       throw std::runtime_error("PARSE() requires an expression or subquery input");
     }
-    doc = build_fragments_document(fragments);
+    doc = std::make_shared<const HtmlDocument>(build_fragments_document(fragments));
     source_uri = "parse";
   } else {
     throw std::runtime_error("Unsupported source kind in relation runtime");
   }
   const std::string alias = source.alias.has_value() ? *source.alias : std::string("__self");
-  Relation rel = relation_from_document(doc, alias, source_uri, sibling_pos, prefilter);
+  if (document == nullptr) document = make_relation_document(std::move(doc));
+  if (source.kind == Source::Kind::Document &&
+      (prefilter == nullptr || !prefilter->parent_id_eq.has_value())) {
+    // WHY: default-document relations with the same tag prefilter hold the same rows, so they
+    // share one key for join indexes. Per-row parent_id prefilters (LATERAL) stay unkeyed, or
+    // every outer row would pin an index of its own.
+    std::string key = "doc:*";
+    if (prefilter != nullptr && prefilter->impossible) {
+      key = "doc:!";
+    } else if (prefilter != nullptr && prefilter->tag_eq.has_value()) {
+      key = "doc:=" + *prefilter->tag_eq;
+    }
+    Relation rel;
+    if (cache != nullptr && cache->document_cache != nullptr) {
+      RelationDocumentCache& shared = *cache->document_cache;
+      const std::string table_key = "table:" + key;
+      std::shared_ptr<const RelationTable> table = shared.find_table(table_key);
+      ++(table != nullptr ? cache->profile.document_cache_hits
+                          : cache->profile.document_cache_misses);
+      if (table == nullptr) {
+        table = shared.insert_table(
+            table_key, relation_from_document(std::move(document), alias, source_uri, prefilter)
+                           .aliases.front()
+                           .table);
+      }
+      rel = single_alias_relation(lower_alias_name(alias), std::move(table));
+    } else {
+      rel = relation_from_document(std::move(document), alias, source_uri, prefilter);
+    }
+    rel.cache_key = std::move(key);
+    return rel;
+  }
+  Relation rel = relation_from_document(std::move(document), alias, source_uri, prefilter);
   for (const auto& warning : warnings) {
     rel.warnings.push_back(warning);
   }
@@ -402,15 +609,29 @@ Relation evaluate_source_relation(const Source& source, const std::string* defau
 Relation evaluate_query_relation(const Query& query, const std::string* default_html,
                                  const HtmlDocument* default_document,
                                  const std::string& default_source_uri,
-                                 const std::unordered_map<std::string, Relation>* parent_ctes,
-                                 const RelationRow* outer_row, RelationRuntimeCache* cache) {
+                                 const RelationCteMap* parent_ctes,
+                                 const RelationRowRef* outer_row, RelationRuntimeCache* cache,
+                                 bool node_fields) {
   RelationRuntimeCache::Profile* profile = cache != nullptr ? &cache->profile : nullptr;
+  // WHY: CTE and derived rows drop the node fields of their FROM row when every consumer reads
+  // only projected columns, so wide cells like inner_html are never materialized for them.
+  auto derived_fields = [&](const Source& source) {
+    if (source.kind != Source::Kind::DerivedSubquery) return true;
+    if (cache == nullptr) return derived_node_fields_needed(query, source, node_fields);
+    auto it = cache->derived_node_fields.find(&source);
+    if (it == cache->derived_node_fields.end()) {
+      it = cache->derived_node_fields
+               .emplace(&source, derived_node_fields_needed(query, source, node_fields))
+               .first;
+    }
+    return it->second;
+  };
   const std::optional<std::string> active_alias =
       query.source.alias.has_value()
           ? std::optional<std::string>(lower_alias_name(*query.source.alias))
           : std::nullopt;
 
-  std::unordered_map<std::string, Relation> local_ctes;
+  RelationCteMap local_ctes;
   size_t expected_cte_count = query.with.has_value() ? query.with->ctes.size() : 0;
   if (parent_ctes != nullptr) {
     local_ctes.reserve(parent_ctes->size() + expected_cte_count);
@@ -420,27 +641,139 @@ Relation evaluate_query_relation(const Query& query, const std::string* default_
   }
   std::vector<std::string> warnings;
   if (query.with.has_value()) {
-    for (const auto& cte : query.with->ctes) {
+    std::vector<bool> computed_fields;
+    const std::vector<bool>* cte_fields = &computed_fields;
+    if (cache != nullptr) {
+      auto it = cache->cte_node_fields.find(&query);
+      if (it == cache->cte_node_fields.end()) {
+        it = cache->cte_node_fields.emplace(&query, cte_node_fields_needed(query, node_fields))
+                 .first;
+      }
+      cte_fields = &it->second;
+    } else {
+      computed_fields = cte_node_fields_needed(query, node_fields);
+    }
+    const auto& ctes = query.with->ctes;
+    const std::vector<std::vector<size_t>> deps = cte_dependencies(*query.with);
+    std::vector<std::shared_ptr<const Relation>> cte_relations(ctes.size());
+    std::vector<uint64_t> cte_wall_ns(ctes.size(), 0);
+    // WHY: only the statement's own WITH clause is keyed by its text. A nested clause can read
+    // outer CTEs or an outer row, which the text alone does not pin down; so can a CTE after
+    // one that reads a file or URL.
+    std::vector<std::string> shared_cte_keys(ctes.size());
+    if (cache != nullptr && cache->document_cache != nullptr && &query == cache->statement) {
+      const size_t begin = query.with->span.start;
+      for (size_t i = 0; i < ctes.size(); ++i) {
+        const size_t end = ctes[i].span.end;
+        if (ctes[i].query == nullptr || !relation_query_reads_document_only(*ctes[i].query) ||
+            begin > end || end > cache->statement_text.size()) {
+          break;
+        }
+        shared_cte_keys[i] = std::string((*cte_fields)[i] ? "cte@fields:" : "cte@:") +
+                             std::string(cache->statement_text.substr(begin, end - begin));
+      }
+    }
+    RelationWorkerLease lease(ctes.size());
+    std::vector<std::unique_ptr<RelationRuntimeCache>> workers(ctes.size());
+    if (lease.threads() > 1 && cache != nullptr) {
+      for (auto& worker : workers) worker = cache->make_worker();
+    }
+    auto evaluate_cte = [&](size_t cte_index) {
+      const auto& cte = ctes[cte_index];
       if (cte.query == nullptr) {
         throw std::runtime_error("CTE '" + cte.name + "' is missing a subquery");
       }
-      QueryResult cte_result =
-          execute_query_with_source_context(*cte.query, default_html, default_document,
-                                            default_source_uri, &local_ctes, nullptr, cache);
-      Relation cte_relation = relation_from_query_result(std::move(cte_result), cte.name);
-      if (cache != nullptr) {
+      RelationRuntimeCache* task_cache =
+          workers[cte_index] != nullptr ? workers[cte_index].get() : cache;
+      const bool profiling = task_cache != nullptr && task_cache->profile.enabled;
+      const auto started_at = profiling ? std::chrono::steady_clock::now()
+                                        : std::chrono::steady_clock::time_point{};
+      // WHY: a task sees the parent scope plus the siblings it references. Siblings it does not
+      // reference stay as null placeholders, so scope checks match sequential evaluation
+      // without reading relations other tasks may still be building.
+      RelationCteMap visible;
+      visible.reserve(local_ctes.size() + cte_index);
+      visible.insert(local_ctes.begin(), local_ctes.end());
+      for (size_t earlier = 0; earlier < cte_index; ++earlier) {
+        visible[lower_alias_name(ctes[earlier].name)] = nullptr;
+      }
+      for (size_t dep : deps[cte_index]) {
+        visible[lower_alias_name(ctes[dep].name)] = cte_relations[dep];
+      }
+      const bool cte_node_fields = (*cte_fields)[cte_index];
+      QueryResult cte_result = execute_query_with_source_context(
+          *cte.query, default_html, default_document, default_source_uri, &visible, nullptr,
+          task_cache, cte_node_fields);
+      Relation cte_relation =
+          relation_from_query_result(std::move(cte_result), cte.name, cte_node_fields);
+      if (!shared_cte_keys[cte_index].empty()) {
+        cte_relation.cache_key = shared_cte_keys[cte_index];
+      } else if (task_cache != nullptr) {
         cte_relation.cache_key = "cte:" + lower_alias_name(cte.name) + "#" +
-                                 std::to_string(cache->next_relation_cache_id++);
+                                 std::to_string((*task_cache->next_relation_cache_id)++);
       }
+      if (profiling) {
+        cte_wall_ns[cte_index] =
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - started_at)
+                                      .count());
+        task_cache->profile.cte_sizes.push_back(RelationRuntimeCache::CteSizeSample{
+            cte.name, cte_relation.row_count, cte_wall_ns[cte_index]});
+      }
+      cte_relations[cte_index] = std::make_shared<const Relation>(std::move(cte_relation));
+    };
+    const std::vector<std::exception_ptr> errors =
+        run_relation_task_graph(deps, lease.threads(), evaluate_cte);
+    for (const auto& error : errors) {
+      if (error != nullptr) std::rethrow_exception(error);
+    }
+    for (size_t cte_index = 0; cte_index < ctes.size(); ++cte_index) {
+      if (workers[cte_index] != nullptr) cache->merge_worker(*workers[cte_index]);
+      const Relation& cte_relation = *cte_relations[cte_index];
       warnings.insert(warnings.end(), cte_relation.warnings.begin(), cte_relation.warnings.end());
-      if (profile != nullptr && profile->enabled) {
-        profile->cte_sizes.push_back(
-            RelationRuntimeCache::CteSizeSample{cte.name, cte_relation.rows.size()});
+      local_ctes[lower_alias_name(ctes[cte_index].name)] = cte_relations[cte_index];
+    }
+    if (profile != nullptr && profile->enabled) {
+      // Critical path: the dependency chain with the largest summed wall time.
+      std::vector<uint64_t> path_ns(ctes.size(), 0);
+      std::vector<size_t> path_prev(ctes.size(), ctes.size());
+      size_t path_end = 0;
+      for (size_t i = 0; i < ctes.size(); ++i) {
+        for (size_t dep : deps[i]) {
+          if (path_prev[i] == ctes.size() || path_ns[dep] > path_ns[path_prev[i]]) {
+            path_prev[i] = dep;
+          }
+        }
+        path_ns[i] = cte_wall_ns[i] + (path_prev[i] < ctes.size() ? path_ns[path_prev[i]] : 0);
+        if (path_ns[i] > path_ns[path_end]) path_end = i;
+      }
+      RelationRuntimeCache::CtePathSample path;
+      path.wall_ns = path_ns[path_end];
+      for (size_t i = path_end; i < ctes.size(); i = path_prev[i]) {
+        path.ctes.insert(path.ctes.begin(), ctes[i].name);
       }
-      local_ctes[lower_alias_name(cte.name)] = std::move(cte_relation);
+      profile->cte_paths.push_back(std::move(path));
     }
   }
 
+  // WHY: a conjunct that reads a single input filters that input before any join multiplies
+  // its rows. The FROM side is safe under every join type; a right side only under INNER or
+  // CROSS, since filtering a LEFT JOIN's right side would pad rows the WHERE should drop.
+  std::vector<std::string> input_names{source_alias_name(query.source)};
+  std::vector<bool> input_pushable{true};
+  for (const auto& join : query.joins) {
+    input_names.push_back(source_alias_name(join.right_source));
+    input_pushable.push_back(!join.lateral && join.type != Query::JoinItem::Type::Left);
+  }
+  std::vector<std::string> outer_names;
+  if (outer_row != nullptr) {
+    for (const auto& alias : outer_row->relation->aliases) outer_names.push_back(alias.name);
+  }
+  RelationPushdownPlan where_plan;
+  if (query.where.has_value() && !query.joins.empty()) {
+    where_plan = plan_conjunct_pushdown(*query.where, input_names, input_pushable, outer_names);
+  }
+
   std::optional<SourceRowPrefilter> source_prefilter;
   if (query.source.kind == Source::Kind::Document && query.where.has_value()) {
     SourceRowPrefilter candidate;
@@ -451,31 +784,155 @@ Relation evaluate_query_relation(const Query& query, const std::string* default_
     }
   }
 
-  Relation from_rel = evaluate_source_relation(
-      query.source, default_html, default_document, default_source_uri, &local_ctes, outer_row,
-      cache, source_prefilter.has_value() ? &*source_prefilter : nullptr);
+  // Input 0 is FROM; input j + 1 is the right side of join j.
+  struct JoinInputPlan {
+    std::vector<const Expr*> filters;
+    std::optional<Query::JoinItem> narrowed_join;
+  };
+  auto plan_join_input = [&](size_t join_index, const std::vector<std::string>& left_names) {
+    const auto& join = query.joins[join_index];
+    JoinInputPlan plan;
+    if (where_plan.any_pushed) plan.filters = where_plan.pushed[join_index + 1];
+    const bool scanned_source = join.right_source.kind != Source::Kind::CteRef &&
+                                join.right_source.kind != Source::Kind::DerivedSubquery;
+    if (join.on.has_value() && scanned_source && join.type != Query::JoinItem::Type::Cross) {
+      // WHY: ON conjuncts that read only the right input pick which right rows can match under
+      // INNER and LEFT joins alike, so a scanned source can drop the rest before the join. CTE
+      // and derived sides keep their rows to reuse cached join indexes.
+      RelationPushdownPlan on_plan = plan_conjunct_pushdown(
+          *join.on, {source_alias_name(join.right_source)}, {true}, left_names);
+      if (on_plan.any_pushed && !on_plan.residual.empty()) {
+        plan.filters.insert(plan.filters.end(), on_plan.pushed[0].begin(),
+                            on_plan.pushed[0].end());
+        plan.narrowed_join = join;
+        plan.narrowed_join->on = conjoin_exprs(on_plan.residual);
+      }
+    }
+    return plan;
+  };
+  auto load_input = [&](size_t input, const std::vector<const Expr*>& filters, bool fields,
+                        RelationRuntimeCache* task_cache) {
+    Relation rel;
+    if (input == 0) {
+      rel = evaluate_source_relation(
+          query.source, default_html, default_document, default_source_uri, &local_ctes,
+          outer_row, task_cache, source_prefilter.has_value() ? &*source_prefilter : nullptr,
+          fields);
+    } else {
+      const Source& source = query.joins[input - 1].right_source;
+      const std::optional<SourceRowPrefilter> prefilter =
+          pushed_source_prefilter(source, filters);
+      rel = evaluate_source_relation(source, default_html, default_document, default_source_uri,
+                                     &local_ctes, nullptr, task_cache,
+                                     prefilter.has_value() ? &*prefilter : nullptr, fields);
+    }
+    filter_relation_rows(rel, filters, task_cache != nullptr ? &task_cache->profile : nullptr);
+    return rel;
+  };
+
+  // WHY: FROM and non-lateral join sources never read one another, so with spare threads they
+  // load concurrently. Each is still consumed in query order with its warnings and profile.
+  struct PrefetchedInput {
+    std::vector<const Expr*> filters;
+    std::optional<Relation> relation;
+    std::exception_ptr error;
+    std::unique_ptr<RelationRuntimeCache> worker;
+  };
+  std::vector<PrefetchedInput> prefetched(query.joins.size() + 1);
+  std::vector<size_t> prefetch_inputs;
+  if (cache != nullptr) {
+    // CTE views are cheap copies; only sources that scan, parse or run a subquery qualify.
+    if (query.source.kind != Source::Kind::CteRef) prefetch_inputs.push_back(0);
+    for (size_t j = 0; j < query.joins.size(); ++j) {
+      if (!query.joins[j].lateral && query.joins[j].right_source.kind != Source::Kind::CteRef) {
+        prefetch_inputs.push_back(j + 1);
+      }
+    }
+  }
+  std::optional<RelationWorkerLease> input_lease;
+  if (prefetch_inputs.size() >= 2) input_lease.emplace(prefetch_inputs.size());
+  if (input_lease.has_value() && input_lease->threads() > 1) {
+    // Left aliases are predicted from the query; the join loop replans and reloads any input
+    // whose prediction turns out different.
+    std::vector<std::string> left_names = outer_names;
+    auto predicted_alias = [](const Source& source) {
+      const std::string name = source_alias_name(source);
+      return name.empty() ? std::string("__self") : name;
+    };
+    left_names.push_back(predicted_alias(query.source));
+    std::vector<bool> input_fields(prefetch_inputs.size());
+    for (size_t t = 0; t < prefetch_inputs.size(); ++t) {
+      const size_t input = prefetch_inputs[t];
+      PrefetchedInput& slot = prefetched[input];
+      if (input == 0) {
+        if (where_plan.any_pushed) slot.filters = where_plan.pushed[0];
+        input_fields[t] = derived_fields(query.source);
+      } else {
+        for (size_t j = left_names.size() - outer_names.size(); j < input; ++j) {
+          left_names.push_back(predicted_alias(query.joins[j - 1].right_source));
+        }
+        slot.filters = plan_join_input(input - 1, left_names).filters;
+        input_fields[t] = derived_fields(query.joins[input - 1].right_source);
+      }
+      slot.worker = cache->make_worker();
+    }
+    run_relation_task_graph(
+        std::vector<std::vector<size_t>>(prefetch_inputs.size()), input_lease->threads(),
+        [&](size_t t) {
+          PrefetchedInput& slot = prefetched[prefetch_inputs[t]];
+          try {
+            slot.relation =
+                load_input(prefetch_inputs[t], slot.filters, input_fields[t], slot.worker.get());
+          } catch (...) {
+            slot.error = std::current_exception();
+          }
+        });
+  }
+  input_lease.reset();
+  // Returns input's prefetched relation when it was loaded with `filters`.
+  auto take_prefetched = [&](size_t input,
+                             const std::vector<const Expr*>& filters) -> std::optional<Relation> {
+    PrefetchedInput& slot = prefetched[input];
+    if (slot.worker == nullptr || slot.filters != filters) return std::nullopt;
+    cache->merge_worker(*slot.worker);
+    slot.worker.reset();
+    if (slot.error != nullptr) std::rethrow_exception(slot.error);
+    return std::move(slot.relation);
+  };
+
+  const std::vector<const Expr*> from_filters =
+      where_plan.any_pushed ? where_plan.pushed[0] : std::vector<const Expr*>{};
+  std::optional<Relation> from_loaded = take_prefetched(0, from_filters);
+  Relation from_rel = from_loaded.has_value()
+                          ? std::move(*from_loaded)
+                          : load_input(0, from_filters, derived_fields(query.source), cache);
   warnings.insert(warnings.end(), from_rel.warnings.begin(), from_rel.warnings.end());
 
   Relation current;
   if (outer_row == nullptr) {
     current = std::move(from_rel);
   } else {
-    current.alias_columns = from_rel.alias_columns;
+    // WHY: correlated sources see the outer row as extra aliases; broadcast its table rows
+    // instead of copying cells into every source row.
+    const Relation& outer = *outer_row->relation;
     current.cache_key = from_rel.cache_key;
-    current.rows.reserve(from_rel.rows.size());
-    for (const auto& base_row : from_rel.rows) {
-      RelationRow merged;
-      std::string duplicate;
-      if (!merge_row_aliases(merged, *outer_row, &duplicate)) {
-        throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
-      }
-      if (!merge_row_aliases(merged, base_row, &duplicate)) {
-        throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
+    current.row_count = from_rel.row_count;
+    if (from_rel.row_count > 0) {
+      for (const auto& alias : from_rel.aliases) {
+        if (outer.find_alias(alias.name) >= 0) {
+          throw std::runtime_error("Duplicate source alias '" + alias.name + "' in FROM");
+        }
       }
-      current.rows.push_back(std::move(merged));
     }
-    for (const auto& alias_entry : outer_row->aliases) {
-      merge_alias_columns(current, alias_entry.first, alias_entry.second);
+    for (const auto& alias : outer.aliases) {
+      RelationAlias entry;
+      entry.name = alias.name;
+      entry.table = alias.table;
+      entry.rows.mutate().assign(from_rel.row_count, alias.rows[outer_row->row]);
+      current.aliases.push_back(std::move(entry));
+    }
+    for (auto& alias : from_rel.aliases) {
+      current.aliases.push_back(std::move(alias));
     }
   }
 
@@ -487,77 +944,179 @@ Relation evaluate_query_relation(const Query& query, const std::string* default_
       const auto started_at = profiling_enabled ? std::chrono::steady_clock::now()
                                                 : std::chrono::steady_clock::time_point{};
       uint64_t pairs_evaluated = 0;
-      Relation next;
-      next.alias_columns = current.alias_columns;
-      next.cache_key = current.cache_key;
-      for (const auto& left_row : current.rows) {
-        Relation right_rel =
-            evaluate_source_relation(join.right_source, default_html, default_document,
-                                     default_source_uri, &local_ctes, &left_row, cache, nullptr);
+      // WHY: the right side only depends on the outer rows it can mention, so evaluate it once
+      // per distinct (table row of each mentioned alias) and replay the output rows on repeats.
+      struct LateralMemoEntry {
+        size_t first_output = 0;
+        size_t output_count = 0;
+        std::vector<std::string> warnings;
+      };
+      const std::vector<size_t> key_aliases = lateral_key_aliases(join.right_source, current);
+      std::unordered_map<std::string, LateralMemoEntry> memo;
+      size_t memo_hits = 0;
+      std::vector<uint32_t> left_selection;
+      std::vector<std::string> right_names;
+      std::vector<RelationTableBuilder> right_builders;
+      std::vector<uint32_t> right_built;
+      std::vector<std::vector<uint32_t>> right_rows;
+      std::string key;
+      for (size_t li = 0; li < current.row_count; ++li) {
+        key.clear();
+        for (size_t alias : key_aliases) {
+          const uint32_t table_row = current.aliases[alias].rows[li];
+          key.append(reinterpret_cast<const char*>(&table_row), sizeof(table_row));
+        }
+        auto memo_it = memo.find(key);
+        if (memo_it != memo.end()) {
+          ++memo_hits;
+          const LateralMemoEntry& entry = memo_it->second;
+          warnings.insert(warnings.end(), entry.warnings.begin(), entry.warnings.end());
+          for (size_t k = 0; k < entry.output_count; ++k) {
+            ++pairs_evaluated;
+            left_selection.push_back(static_cast<uint32_t>(li));
+            for (auto& rows : right_rows) {
+              const uint32_t row = rows[entry.first_output + k];
+              rows.push_back(row);
+            }
+          }
+          continue;
+        }
+        const RelationRowRef left_ref{&current, li};
+        Relation right_rel = evaluate_source_relation(
+            join.right_source, default_html, default_document, default_source_uri, &local_ctes,
+            &left_ref, cache, nullptr, derived_fields(join.right_source));
         warnings.insert(warnings.end(), right_rel.warnings.begin(), right_rel.warnings.end());
-        for (const auto& alias_cols : right_rel.alias_columns) {
-          next.alias_columns[alias_cols.first].insert(alias_cols.second.begin(),
-                                                      alias_cols.second.end());
+        std::vector<int32_t> builder_index(right_names.size(), -1);
+        for (size_t a = 0; a < right_rel.aliases.size(); ++a) {
+          const auto& alias = right_rel.aliases[a];
+          if (right_rel.row_count > 0 && current.find_alias(alias.name) >= 0) {
+            throw std::runtime_error("Duplicate source alias '" + alias.name + "' in FROM");
+          }
+          auto it = std::find(right_names.begin(), right_names.end(), alias.name);
+          if (it == right_names.end()) {
+            right_names.push_back(alias.name);
+            right_builders.emplace_back();
+            right_built.push_back(0);
+            right_rows.emplace_back(left_selection.size(), kRelationNullRow);
+            builder_index.push_back(-1);
+            it = right_names.end() - 1;
+          }
+          builder_index[static_cast<size_t>(it - right_names.begin())] = static_cast<int32_t>(a);
         }
-        for (const auto& right_row : right_rel.rows) {
+        LateralMemoEntry entry;
+        entry.first_output = left_selection.size();
+        entry.output_count = right_rel.row_count;
+        entry.warnings = right_rel.warnings;
+        for (size_t ri = 0; ri < right_rel.row_count; ++ri) {
           ++pairs_evaluated;
-          RelationRow merged = left_row;
-          std::string duplicate;
-          if (!merge_row_aliases(merged, right_row, &duplicate)) {
-            throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
+          left_selection.push_back(static_cast<uint32_t>(li));
+          for (size_t b = 0; b < right_names.size(); ++b) {
+            if (builder_index[b] < 0) {
+              right_rows[b].push_back(kRelationNullRow);
+              continue;
+            }
+            const auto& alias = right_rel.aliases[static_cast<size_t>(builder_index[b])];
+            right_builders[b].append_row(alias.table, alias.rows[ri]);
+            right_rows[b].push_back(right_built[b]++);
           }
-          next.rows.push_back(std::move(merged));
         }
+        memo.emplace(key, std::move(entry));
+      }
+      const size_t left_rows = current.row_count;
+      current.select_rows(left_selection);
+      for (size_t b = 0; b < right_names.size(); ++b) {
+        RelationAlias entry;
+        entry.name = right_names[b];
+        entry.table = right_builders[b].finish();
+        entry.rows = std::move(right_rows[b]);
+        current.aliases.push_back(std::move(entry));
       }
       if (profiling_enabled) {
         const auto finished_at = std::chrono::steady_clock::now();
         const uint64_t elapsed_ns = static_cast<uint64_t>(
             std::chrono::duration_cast<std::chrono::nanoseconds>(finished_at - started_at).count());
         profile->join_time_ns += elapsed_ns;
-        profile->joins.push_back(
-            RelationRuntimeCache::JoinSample{join_label, "lateral_nested_loop", current.rows.size(),
-                                             0, next.rows.size(), pairs_evaluated});
+        profile->joins.push_back(RelationRuntimeCache::JoinSample{
+            join_label, memo_hits > 0 ? "lateral_memoized" : "lateral_nested_loop", left_rows, 0,
+            current.row_count, pairs_evaluated, std::string()});
       }
-      current = std::move(next);
       continue;
     }
 
-    Relation right_rel =
-        evaluate_source_relation(join.right_source, default_html, default_document,
-                                 default_source_uri, &local_ctes, nullptr, cache, nullptr);
+    std::vector<std::string> left_names;
+    for (const auto& alias : current.aliases) left_names.push_back(alias.name);
+    const JoinInputPlan plan = plan_join_input(join_index, left_names);
+    std::optional<Relation> right_loaded = take_prefetched(join_index + 1, plan.filters);
+    Relation right_rel = right_loaded.has_value()
+                             ? std::move(*right_loaded)
+                             : load_input(join_index + 1, plan.filters,
+                                          derived_fields(join.right_source), cache);
     warnings.insert(warnings.end(), right_rel.warnings.begin(), right_rel.warnings.end());
-    current = execute_relation_join_non_lateral(join, current, right_rel, active_alias, join_label,
-                                                cache);
-  }
-
-  if (query.where.has_value()) {
-    Relation filtered;
-    filtered.alias_columns = current.alias_columns;
-    filtered.cache_key = current.cache_key;
-    filtered.rows.reserve(current.rows.size());
-    for (auto& row : current.rows) {
-      if (eval_relation_expr(*query.where, row, active_alias, profile)) {
-        filtered.rows.push_back(std::move(row));
+    current = execute_relation_join_non_lateral(
+        plan.narrowed_join.has_value() ? *plan.narrowed_join : join, current, right_rel,
+        active_alias, join_label, cache);
+  }
+
+  if (query.where.has_value() && (!where_plan.any_pushed || !where_plan.residual.empty())) {
+    RelationScope scope(current, active_alias);
+    std::vector<uint32_t> cursor(current.aliases.size(), 0);
+    std::vector<uint32_t> selection;
+    selection.reserve(current.row_count);
+    for (size_t i = 0; i < current.row_count; ++i) {
+      load_relation_row(current, i, cursor);
+      const RelationRowView view{&scope, cursor.data()};
+      bool keep = true;
+      if (!where_plan.any_pushed) {
+        keep = eval_relation_expr(*query.where, view, profile);
+      } else {
+        for (const Expr* conjunct : where_plan.residual) {
+          keep = eval_relation_expr(*conjunct, view, profile) && keep;
+        }
       }
+      if (keep) selection.push_back(static_cast<uint32_t>(i));
     }
-    current = std::move(filtered);
+    current.select_rows(selection);
   }
 
   if (!query.order_by.empty()) {
-    std::stable_sort(current.rows.begin(), current.rows.end(),
-                     [&](const RelationRow& left, const RelationRow& right) {
-                       for (const auto& order : query.order_by) {
-                         int cmp = compare_optional_relation_values(
-                             relation_field_by_name(left, order.field, active_alias),
-                             relation_field_by_name(right, order.field, active_alias));
-                         if (cmp == 0) continue;
-                         return order.descending ? (cmp > 0) : (cmp < 0);
-                       }
-                       return false;
-                     });
-  }
-  if (query.limit.has_value() && current.rows.size() > *query.limit) {
-    current.rows.resize(*query.limit);
+    RelationScope scope(current, active_alias);
+    std::vector<RelationFieldRef> fields;
+    fields.reserve(query.order_by.size());
+    for (const auto& order : query.order_by) {
+      fields.push_back(scope.bind_field(order.field));
+    }
+    // WHY: read every sort key once, typed, instead of per comparison; text keys stay views
+    // into their table cells.
+    const size_t key_count = fields.size();
+    std::vector<RelationSortKey> keys(current.row_count * key_count);
+    std::vector<uint32_t> cursor(current.aliases.size(), 0);
+    for (size_t i = 0; i < current.row_count; ++i) {
+      load_relation_row(current, i, cursor);
+      const RelationRowView view{&scope, cursor.data()};
+      for (size_t k = 0; k < key_count; ++k) {
+        RelationSortKey& key = keys[i * key_count + k];
+        key.value = relation_field_scalar(view, fields[k]);
+        key.number = key.value.as_int64();
+      }
+    }
+    std::vector<uint32_t> order(current.row_count);
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right) {
+      for (size_t k = 0; k < key_count; ++k) {
+        const int cmp =
+            compare_relation_sort_keys(keys[left * key_count + k], keys[right * key_count + k]);
+        if (cmp == 0) continue;
+        return query.order_by[k].descending ? (cmp > 0) : (cmp < 0);
+      }
+      return false;
+    });
+    current.select_rows(order);
+  }
+  if (query.limit.has_value() && current.row_count > *query.limit) {
+    for (auto& alias : current.aliases) {
+      alias.rows.mutate().resize(*query.limit);
+    }
+    current.row_count = *query.limit;
   }
   current.warnings = std::move(warnings);
   return current;
@@ -566,12 +1125,13 @@ Relation evaluate_query_relation(const Query& query, const std::string* default_
 QueryResult execute_query_with_source_context(const Query& query, const std::string* default_html,
                                               const HtmlDocument* default_document,
                                               const std::string& default_source_uri,
-                                              const std::unordered_map<std::string, Relation>* ctes,
-                                              const RelationRow* outer_row,
-                                              RelationRuntimeCache* cache) {
+                                              const RelationCteMap* ctes,
+                                              const RelationRowRef* outer_row,
+                                              RelationRuntimeCache* cache, bool node_fields,
+                                              ResultRowStream* stream) {
   if (!query_uses_relation_runtime(query, ctes, outer_row)) {
     return execute_query_with_source_legacy(query, default_html, default_document,
-                                            default_source_uri);
+                                            default_source_uri, stream);
   }
   const bool is_top_level_relation_query = (cache == nullptr);
   RelationRuntimeCache local_cache;
@@ -580,23 +1140,48 @@ QueryResult execute_query_with_source_context(const Query& query, const std::str
     active_cache->profile = RelationRuntimeCache::Profile{};
     active_cache->profile.enabled = relation_runtime_profile_enabled();
   }
-  Relation relation = evaluate_query_relation(query, default_html, default_document,
-                                              default_source_uri, ctes, outer_row, active_cache);
-  QueryResult out = query_result_from_relation(query, relation, &active_cache->profile);
+  Relation relation =
+      evaluate_query_relation(query, default_html, default_document, default_source_uri, ctes,
+                              outer_row, active_cache, node_fields);
+  QueryResult out =
+      query_result_from_relation(query, relation, &active_cache->profile, node_fields, stream);
   if (is_top_level_relation_query) {
-    maybe_emit_relation_runtime_profile(active_cache->profile);
+    maybe_emit_relation_runtime_profile(*active_cache);
   }
   return out;
 }
 
 }  // namespace
 
+QueryResult execute_prepared_query(const Query& query, std::string_view query_text,
+                                   const std::string& html, const HtmlDocument& doc,
+                                   const std::string& source_uri,
+                                   const std::shared_ptr<RelationDocumentCache>& cache,
+                                   ResultRowStream* stream) {
+  if (!query_uses_relation_runtime(query, nullptr, nullptr)) {
+    return execute_query_with_source_legacy(query, &html, &doc, source_uri, stream);
+  }
+  RelationRuntimeCache statement_cache;
+  statement_cache.profile.enabled = relation_runtime_profile_enabled();
+  statement_cache.document_cache = cache;
+  statement_cache.statement = &query;
+  statement_cache.statement_text = query_text;
+  Relation relation = evaluate_query_relation(query, &html, &doc, source_uri, nullptr, nullptr,
+                                              &statement_cache, true);
+  QueryResult out =
+      query_result_from_relation(query, relation, &statement_cache.profile, true, stream);
+  maybe_emit_relation_runtime_profile(statement_cache);
+  return out;
+}
+
 QueryResult execute_query_with_source_relation_entry(const Query& query,
                                                      const std::string* default_html,
                                                      const HtmlDocument* default_document,
-                                                     const std::string& default_source_uri) {
+                                                     const std::string& default_source_uri,
+                                                     ResultRowStream* stream) {
   return execute_query_with_source_context(query, default_html, default_document,
-                                           default_source_uri, nullptr, nullptr, nullptr);
+                                           default_source_uri, nullptr, nullptr, nullptr, true,
+                                           stream);
 }
 
 }  // namespace markql
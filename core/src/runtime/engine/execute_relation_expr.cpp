@@ -1,16 +1,19 @@
 #include "markql/markql.h"
 
+#include <array>
 #include <chrono>
 #include <cctype>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "../executor/executor_internal.h"
 #include "../../lang/markql_parser.h"
+#include "../../util/string_search.h"
 #include "../../util/string_util.h"
 #include "relation_runtime_internal.h"
 #include "engine_execution_internal.h"
@@ -47,399 +50,242 @@ class ScopedScalarEvalTimer {
   std::chrono::steady_clock::time_point started_at_{};
 };
 
-}  // namespace
-
-std::string lower_alias_name(const std::string& alias) {
-  return util::to_lower(alias);
-}
-
-void merge_alias_columns(Relation& rel, const std::string& alias, const RelationRecord& record) {
-  auto& cols = rel.alias_columns[alias];
-  for (const auto& kv : record.values) {
-    cols.insert(kv.first);
-  }
-}
-
-std::optional<int64_t> parse_optional_i64(const std::optional<std::string>& value) {
-  if (!value.has_value()) return std::nullopt;
-  return parse_int64_value(*value);
-}
-
-void fill_result_core_from_record(QueryResultRow& out, const RelationRecord& record) {
-  auto get = [&](const std::string& key) -> std::optional<std::string> {
-    auto it = record.values.find(key);
-    if (it == record.values.end()) return std::nullopt;
-    return it->second;
-  };
-  if (auto v = get("node_id"); v.has_value()) {
-    if (auto parsed = parse_int64_value(*v); parsed.has_value()) out.node_id = *parsed;
-  }
-  if (auto v = get("tag"); v.has_value()) out.tag = *v;
-  if (auto v = get("text"); v.has_value()) out.text = *v;
-  if (auto v = get("inner_html"); v.has_value()) out.inner_html = *v;
-  if (auto v = get("parent_id"); v.has_value()) {
-    if (auto parsed = parse_int64_value(*v); parsed.has_value()) out.parent_id = *parsed;
-  }
-  if (auto v = get("sibling_pos"); v.has_value()) {
-    if (auto parsed = parse_int64_value(*v); parsed.has_value()) out.sibling_pos = *parsed;
-  }
-  if (auto v = get("max_depth"); v.has_value()) {
-    if (auto parsed = parse_int64_value(*v); parsed.has_value()) out.max_depth = *parsed;
-  }
-  if (auto v = get("doc_order"); v.has_value()) {
-    if (auto parsed = parse_int64_value(*v); parsed.has_value()) out.doc_order = *parsed;
-  }
-  if (auto v = get("source_uri"); v.has_value()) out.source_uri = *v;
-  out.attributes = record.attributes;
-}
-
-const RelationRecord* resolve_record(const RelationRow& row,
-                                     const std::optional<std::string>& qualifier,
-                                     const std::optional<std::string>& active_alias) {
-  if (qualifier.has_value()) {
-    const std::string lowered = lower_alias_name(*qualifier);
-    auto it = row.aliases.find(lowered);
-    if (it != row.aliases.end()) return &it->second;
-    if (lowered == "doc" && row.aliases.size() == 1) {
-      const std::string suggestion = row.aliases.begin()->first;
-      if (suggestion != "doc") {
-        throw std::runtime_error("Identifier 'doc' is not bound; did you mean '" + suggestion +
-                                 "'?");
-      }
-    }
-    throw std::runtime_error("Unknown identifier '" + *qualifier +
-                             "' (expected a FROM alias or legacy tag binding)");
-  }
-  if (active_alias.has_value()) {
-    auto it = row.aliases.find(*active_alias);
-    if (it != row.aliases.end()) return &it->second;
-  }
-  if (row.aliases.size() == 1) {
-    return &row.aliases.begin()->second;
-  }
-  return nullptr;
+RelationValue alias_column_value(const RelationRowView& row, int32_t alias, int32_t column) {
+  return relation_slot_scalar(row, RelationSlot{alias, column});
 }
 
-std::optional<std::string> relation_operand_value(const Operand& operand, const RelationRow& row,
-                                                  const std::optional<std::string>& active_alias) {
-  const RelationRecord* record = resolve_record(row, operand.qualifier, active_alias);
-  if (record == nullptr) return std::nullopt;
-  auto get_field = [&](const std::string& key) -> std::optional<std::string> {
-    auto it = record->values.find(key);
-    if (it == record->values.end()) return std::nullopt;
-    return it->second;
-  };
-  auto prefixed_key = [&](const std::string& key) {
-    if (operand.axis == Operand::Axis::Parent) {
-      return std::string("parent.") + key;
-    }
-    return key;
-  };
-  if (operand.axis != Operand::Axis::Self && operand.axis != Operand::Axis::Parent) {
-    return std::nullopt;
-  }
-  switch (operand.field_kind) {
-    case Operand::FieldKind::Attribute: {
-      auto it = record->values.find(prefixed_key(operand.attribute));
-      if (it != record->values.end()) return it->second;
-      if (operand.axis == Operand::Axis::Self) {
-        auto attr = record->attributes.find(operand.attribute);
-        if (attr != record->attributes.end()) return attr->second;
-      }
-      return std::nullopt;
-    }
-    case Operand::FieldKind::Tag:
-      return get_field(prefixed_key("tag"));
-    case Operand::FieldKind::Text:
-      return get_field(prefixed_key("text"));
-    case Operand::FieldKind::NodeId:
-      return get_field(prefixed_key("node_id"));
-    case Operand::FieldKind::ParentId:
-      return get_field(prefixed_key("parent_id"));
-    case Operand::FieldKind::SiblingPos:
-      return get_field(prefixed_key("sibling_pos"));
-    case Operand::FieldKind::MaxDepth:
-      return get_field(prefixed_key("max_depth"));
-    case Operand::FieldKind::DocOrder:
-      return get_field(prefixed_key("doc_order"));
-    case Operand::FieldKind::AttributesMap:
-      return std::nullopt;
+bool is_blank(std::string_view text) {
+  for (char c : text) {
+    if (!std::isspace(static_cast<unsigned char>(c))) return false;
   }
-  return std::nullopt;
+  return true;
 }
 
-std::optional<std::string> eval_relation_scalar_expr(const ScalarExpr& expr, const RelationRow& row,
-                                                     const std::optional<std::string>& active_alias,
-                                                     RelationRuntimeCache::Profile* profile) {
-  ScopedScalarEvalTimer timer(profile);
-  if (expr.kind == ScalarExpr::Kind::NullLiteral) return std::nullopt;
-  if (expr.kind == ScalarExpr::Kind::StringLiteral) return expr.string_value;
-  if (expr.kind == ScalarExpr::Kind::NumberLiteral) return std::to_string(expr.number_value);
-  if (expr.kind == ScalarExpr::Kind::Operand) {
-    return relation_operand_value(expr.operand, row, active_alias);
-  }
-  if (expr.kind == ScalarExpr::Kind::SelfRef) {
-    return std::nullopt;
-  }
-  const std::string fn = util::to_upper(expr.function_name);
+/// Applies scalar function `fn` to arguments produced on demand by arg(i), so COALESCE stops
+/// evaluating at its first usable argument. Unknown functions yield NULL.
+template <typename ArgFn>
+RelationValue apply_relation_function(const std::string& fn, size_t arg_count, ArgFn&& arg,
+                                      const RelationRowView& row) {
+  std::array<char, 24> scratch;
   if ((fn == "TEXT" || fn == "DIRECT_TEXT" || fn == "INNER_HTML" || fn == "RAW_INNER_HTML") &&
-      !expr.args.empty()) {
-    std::optional<std::string> target =
-        eval_relation_scalar_expr(expr.args[0], row, active_alias, profile);
-    if (!target.has_value()) return std::nullopt;
-    const std::string lowered_target = util::to_lower(*target);
-    auto alias_it = row.aliases.find(lowered_target);
-    if (alias_it != row.aliases.end()) {
-      const std::string key =
-          (fn == "INNER_HTML" || fn == "RAW_INNER_HTML") ? "inner_html" : "text";
-      auto it = alias_it->second.values.find(key);
-      if (it == alias_it->second.values.end()) return std::nullopt;
-      return it->second;
+      arg_count > 0) {
+    const RelationValue target = arg(0);
+    if (target.is_null()) return RelationValue();
+    const std::string lowered_target = util::to_lower(std::string(target.text(scratch)));
+    const RelationCoreColumn key = (fn == "INNER_HTML" || fn == "RAW_INNER_HTML")
+                                       ? RelationCoreColumn::InnerHtml
+                                       : RelationCoreColumn::Text;
+    int32_t alias = row.scope->find_alias(lowered_target);
+    if (alias >= 0) {
+      return alias_column_value(row, alias, row.scope->table(alias).core_column(key));
     }
-    const RelationRecord* active = resolve_record(row, std::nullopt, active_alias);
-    if (active == nullptr) return std::nullopt;
-    auto tag_it = active->values.find("tag");
-    if (tag_it == active->values.end() || !tag_it->second.has_value()) return std::nullopt;
-    if (util::to_lower(*tag_it->second) != lowered_target) return std::nullopt;
-    const std::string key = (fn == "INNER_HTML" || fn == "RAW_INNER_HTML") ? "inner_html" : "text";
-    auto value_it = active->values.find(key);
-    if (value_it == active->values.end()) return std::nullopt;
-    return value_it->second;
-  }
-  if (fn == "ATTR" && expr.args.size() == 2) {
-    std::optional<std::string> target =
-        eval_relation_scalar_expr(expr.args[0], row, active_alias, profile);
-    std::optional<std::string> attr =
-        eval_relation_scalar_expr(expr.args[1], row, active_alias, profile);
-    if (!target.has_value() || !attr.has_value()) return std::nullopt;
-    const std::string lowered_target = util::to_lower(*target);
-    auto alias_it = row.aliases.find(lowered_target);
-    if (alias_it != row.aliases.end()) {
-      auto value_it = alias_it->second.values.find(util::to_lower(*attr));
-      if (value_it != alias_it->second.values.end()) return value_it->second;
-      auto attr_it = alias_it->second.attributes.find(util::to_lower(*attr));
-      if (attr_it != alias_it->second.attributes.end()) return attr_it->second;
-      return std::nullopt;
+    alias = row.scope->default_alias();
+    if (alias < 0) return RelationValue();
+    const RelationTable& table = row.scope->table(alias);
+    const RelationValue tag =
+        alias_column_value(row, alias, table.core_column(RelationCoreColumn::Tag));
+    if (tag.is_null()) return RelationValue();
+    if (util::to_lower(std::string(tag.text(scratch))) != lowered_target) return RelationValue();
+    return alias_column_value(row, alias, table.core_column(key));
+  }
+  if (fn == "ATTR" && arg_count == 2) {
+    const RelationValue target = arg(0);
+    const RelationValue attr = arg(1);
+    if (target.is_null() || attr.is_null()) return RelationValue();
+    const int32_t alias = row.scope->find_alias(util::to_lower(std::string(target.text(scratch))));
+    if (alias >= 0) {
+      return alias_column_value(
+          row, alias,
+          row.scope->table(alias).find_column(util::to_lower(std::string(attr.text(scratch)))));
     }
   }
   if (fn == "COALESCE") {
-    for (const auto& arg : expr.args) {
-      std::optional<std::string> value = eval_relation_scalar_expr(arg, row, active_alias, profile);
-      if (!value.has_value()) continue;
-      if (util::trim_ws(*value).empty()) continue;
+    for (size_t i = 0; i < arg_count; ++i) {
+      RelationValue value = arg(i);
+      if (value.is_null()) continue;
+      if (value.kind() == RelationValue::Kind::String && is_blank(value.string_value())) continue;
       return value;
     }
-    return std::nullopt;
+    return RelationValue();
   }
   if (fn == "LOWER" || fn == "UPPER" || fn == "TRIM" || fn == "LTRIM" || fn == "RTRIM") {
-    if (expr.args.size() != 1) return std::nullopt;
-    std::optional<std::string> value =
-        eval_relation_scalar_expr(expr.args[0], row, active_alias, profile);
-    if (!value.has_value()) return std::nullopt;
-    if (fn == "LOWER") return util::to_lower(*value);
-    if (fn == "UPPER") return util::to_upper(*value);
-    if (fn == "TRIM") return util::trim_ws(*value);
+    if (arg_count != 1) return RelationValue();
+    const RelationValue value = arg(0);
+    if (value.is_null()) return RelationValue();
+    const std::string_view text = value.text(scratch);
+    if (fn == "LOWER") return RelationValue::owned(util::to_lower(std::string(text)));
+    if (fn == "UPPER") return RelationValue::owned(util::to_upper(std::string(text)));
+    if (fn == "TRIM") return RelationValue::owned(util::trim_ws(std::string(text)));
     if (fn == "LTRIM") {
       size_t i = 0;
-      while (i < value->size() && std::isspace(static_cast<unsigned char>((*value)[i]))) ++i;
-      return value->substr(i);
+      while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+      return RelationValue::owned(std::string(text.substr(i)));
     }
-    size_t end = value->size();
-    while (end > 0 && std::isspace(static_cast<unsigned char>((*value)[end - 1]))) --end;
-    return value->substr(0, end);
-  }
-  if (fn == "REPLACE") {
-    if (expr.args.size() != 3) return std::nullopt;
-    std::optional<std::string> text =
-        eval_relation_scalar_expr(expr.args[0], row, active_alias, profile);
-    std::optional<std::string> from =
-        eval_relation_scalar_expr(expr.args[1], row, active_alias, profile);
-    std::optional<std::string> to =
-        eval_relation_scalar_expr(expr.args[2], row, active_alias, profile);
-    if (!text.has_value() || !from.has_value() || !to.has_value()) return std::nullopt;
-    std::string out = *text;
-    if (from->empty()) return out;
-    size_t pos = 0;
-    while ((pos = out.find(*from, pos)) != std::string::npos) {
-      out.replace(pos, from->size(), *to);
-      pos += to->size();
+    size_t end = text.size();
+    while (end > 0 && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+    return RelationValue::owned(std::string(text.substr(0, end)));
+  }
+  if (fn == "REPLACE" || fn == "REGEX_REPLACE") {
+    if (arg_count != 3) return RelationValue();
+    const RelationValue text = arg(0);
+    const RelationValue from = arg(1);
+    const RelationValue to = arg(2);
+    if (text.is_null() || from.is_null() || to.is_null()) return RelationValue();
+    std::array<char, 24> from_scratch;
+    std::array<char, 24> to_scratch;
+    std::string out(text.text(scratch));
+    const std::string pattern(from.text(from_scratch));
+    const std::string replacement(to.text(to_scratch));
+    if (fn == "REGEX_REPLACE") {
+      return RelationValue::from_optional(util::regex_replace_all(out, pattern, replacement));
     }
-    return out;
-  }
-  if (fn == "REGEX_REPLACE") {
-    if (expr.args.size() != 3) return std::nullopt;
-    std::optional<std::string> text =
-        eval_relation_scalar_expr(expr.args[0], row, active_alias, profile);
-    std::optional<std::string> pattern =
-        eval_relation_scalar_expr(expr.args[1], row, active_alias, profile);
-    std::optional<std::string> replacement =
-        eval_relation_scalar_expr(expr.args[2], row, active_alias, profile);
-    if (!text.has_value() || !pattern.has_value() || !replacement.has_value()) {
-      return std::nullopt;
+    if (pattern.empty()) return RelationValue::owned(std::move(out));
+    size_t pos = 0;
+    while ((pos = out.find(pattern, pos)) != std::string::npos) {
+      out.replace(pos, pattern.size(), replacement);
+      pos += replacement.size();
     }
-    return util::regex_replace_all(*text, *pattern, *replacement);
+    return RelationValue::owned(std::move(out));
   }
-  return std::nullopt;
+  return RelationValue();
 }
 
-bool eval_relation_expr(const Expr& expr, const RelationRow& row,
-                        const std::optional<std::string>& active_alias,
-                        RelationRuntimeCache::Profile* profile);
-
-std::optional<std::string> eval_relation_project_expr(
-    const Query::SelectItem::FlattenExtractExpr& expr, const RelationRow& row,
-    const std::optional<std::string>& active_alias,
-    const std::unordered_map<std::string, std::string>& bindings,
+RelationValue eval_relation_project_value(
+    const Query::SelectItem::FlattenExtractExpr& expr, const RelationRowView& row,
+    const ComputedFields& bindings,
     RelationRuntimeCache::Profile* profile) {
   using Kind = Query::SelectItem::FlattenExtractExpr::Kind;
-  if (expr.kind == Kind::StringLiteral) return expr.string_value;
-  if (expr.kind == Kind::NumberLiteral) return std::to_string(expr.number_value);
-  if (expr.kind == Kind::NullLiteral) return std::nullopt;
+  if (expr.kind == Kind::StringLiteral) return RelationValue::view(expr.string_value);
+  if (expr.kind == Kind::NumberLiteral) return RelationValue::number(expr.number_value);
+  if (expr.kind == Kind::NullLiteral) return RelationValue();
   if (expr.kind == Kind::AliasRef) {
     auto it = bindings.find(expr.alias_ref);
-    if (it == bindings.end()) return std::nullopt;
-    return it->second;
+    if (it == bindings.end()) return RelationValue();
+    return RelationValue::view(it->second);
   }
   if (expr.kind == Kind::OperandRef) {
-    return relation_operand_value(expr.operand, row, active_alias);
+    return relation_operand_value(expr.operand, row);
   }
   if (expr.kind == Kind::Coalesce) {
-    for (const auto& arg : expr.args) {
-      std::optional<std::string> value =
-          eval_relation_project_expr(arg, row, active_alias, bindings, profile);
-      if (!value.has_value()) continue;
-      if (util::trim_ws(*value).empty()) continue;
-      return value;
-    }
-    return std::nullopt;
+    return apply_relation_function(
+        "COALESCE", expr.args.size(),
+        [&](size_t i) { return eval_relation_project_value(expr.args[i], row, bindings, profile); },
+        row);
   }
   if (expr.kind == Kind::FunctionCall) {
-    ScalarExpr scalar_expr;
-    scalar_expr.kind = ScalarExpr::Kind::FunctionCall;
-    scalar_expr.function_name = expr.function_name;
-    for (const auto& arg : expr.args) {
-      if (arg.kind == Kind::StringLiteral) {
-        ScalarExpr scalar_arg;
-        scalar_arg.kind = ScalarExpr::Kind::StringLiteral;
-        scalar_arg.string_value = arg.string_value;
-        scalar_expr.args.push_back(std::move(scalar_arg));
-        continue;
-      }
-      if (arg.kind == Kind::NumberLiteral) {
-        ScalarExpr scalar_arg;
-        scalar_arg.kind = ScalarExpr::Kind::NumberLiteral;
-        scalar_arg.number_value = arg.number_value;
-        scalar_expr.args.push_back(std::move(scalar_arg));
-        continue;
-      }
-      if (arg.kind == Kind::NullLiteral) {
-        ScalarExpr scalar_arg;
-        scalar_arg.kind = ScalarExpr::Kind::NullLiteral;
-        scalar_expr.args.push_back(std::move(scalar_arg));
-        continue;
-      }
-      if (arg.kind == Kind::OperandRef) {
-        ScalarExpr scalar_arg;
-        scalar_arg.kind = ScalarExpr::Kind::Operand;
-        scalar_arg.operand = arg.operand;
-        scalar_expr.args.push_back(std::move(scalar_arg));
-        continue;
-      }
-      if (arg.kind == Kind::AliasRef) {
-        auto it = bindings.find(arg.alias_ref);
-        ScalarExpr scalar_arg;
-        if (it == bindings.end()) {
-          scalar_arg.kind = ScalarExpr::Kind::NullLiteral;
-        } else {
-          scalar_arg.kind = ScalarExpr::Kind::StringLiteral;
-          scalar_arg.string_value = it->second;
-        }
-        scalar_expr.args.push_back(std::move(scalar_arg));
-        continue;
-      }
-      std::optional<std::string> nested =
-          eval_relation_project_expr(arg, row, active_alias, bindings, profile);
-      ScalarExpr scalar_arg;
-      if (!nested.has_value()) {
-        scalar_arg.kind = ScalarExpr::Kind::NullLiteral;
-      } else {
-        scalar_arg.kind = ScalarExpr::Kind::StringLiteral;
-        scalar_arg.string_value = *nested;
-      }
-      scalar_expr.args.push_back(std::move(scalar_arg));
-    }
-    return eval_relation_scalar_expr(scalar_expr, row, active_alias, profile);
+    ScopedScalarEvalTimer timer(profile);
+    return apply_relation_function(
+        util::to_upper(expr.function_name), expr.args.size(),
+        [&](size_t i) { return eval_relation_project_value(expr.args[i], row, bindings, profile); },
+        row);
   }
   if (expr.kind == Kind::CaseWhen) {
     for (size_t i = 0; i < expr.case_when_conditions.size() && i < expr.case_when_values.size();
          ++i) {
-      if (!eval_relation_expr(expr.case_when_conditions[i], row, active_alias, profile)) continue;
-      return eval_relation_project_expr(expr.case_when_values[i], row, active_alias, bindings,
-                                        profile);
+      if (!eval_relation_expr(expr.case_when_conditions[i], row, profile)) continue;
+      return eval_relation_project_value(expr.case_when_values[i], row, bindings, profile);
     }
     if (expr.case_else != nullptr) {
-      return eval_relation_project_expr(*expr.case_else, row, active_alias, bindings, profile);
+      return eval_relation_project_value(*expr.case_else, row, bindings, profile);
     }
-    return std::nullopt;
+    return RelationValue();
+  }
+  return RelationValue();
+}
+
+}  // namespace
+
+std::string lower_alias_name(const std::string& alias) {
+  return util::to_lower(alias);
+}
+
+RelationValue relation_operand_value(const Operand& operand, const RelationRowView& row) {
+  return relation_slot_scalar(row, row.scope->operand_slot(operand));
+}
+
+RelationValue eval_relation_scalar_expr(const ScalarExpr& expr, const RelationRowView& row,
+                                        RelationRuntimeCache::Profile* profile) {
+  ScopedScalarEvalTimer timer(profile);
+  if (expr.kind == ScalarExpr::Kind::NullLiteral) return RelationValue();
+  if (expr.kind == ScalarExpr::Kind::StringLiteral) return RelationValue::view(expr.string_value);
+  if (expr.kind == ScalarExpr::Kind::NumberLiteral) {
+    return RelationValue::number(expr.number_value);
   }
-  return std::nullopt;
+  if (expr.kind == ScalarExpr::Kind::Operand) {
+    return relation_operand_value(expr.operand, row);
+  }
+  if (expr.kind == ScalarExpr::Kind::SelfRef) {
+    return RelationValue();
+  }
+  return apply_relation_function(
+      util::to_upper(expr.function_name), expr.args.size(),
+      [&](size_t i) { return eval_relation_scalar_expr(expr.args[i], row, profile); }, row);
+}
+
+std::optional<std::string> eval_relation_project_expr(
+    const Query::SelectItem::FlattenExtractExpr& expr, const RelationRowView& row,
+    const ComputedFields& bindings,
+    RelationRuntimeCache::Profile* profile) {
+  return eval_relation_project_value(expr, row, bindings, profile).to_text();
 }
 
-bool eval_relation_expr(const Expr& expr, const RelationRow& row,
-                        const std::optional<std::string>& active_alias,
+bool eval_relation_expr(const Expr& expr, const RelationRowView& row,
                         RelationRuntimeCache::Profile* profile) {
   if (std::holds_alternative<CompareExpr>(expr)) {
     const auto& cmp = std::get<CompareExpr>(expr);
-    std::optional<std::string> lhs;
-    if (cmp.lhs_expr.has_value()) {
-      lhs = eval_relation_scalar_expr(*cmp.lhs_expr, row, active_alias, profile);
-    } else {
-      lhs = relation_operand_value(cmp.lhs, row, active_alias);
-    }
+    const RelationValue lhs = cmp.lhs_expr.has_value()
+                                  ? eval_relation_scalar_expr(*cmp.lhs_expr, row, profile)
+                                  : relation_operand_value(cmp.lhs, row);
     if (cmp.op == CompareExpr::Op::IsNull) {
-      return !lhs.has_value();
+      return lhs.is_null();
     }
     if (cmp.op == CompareExpr::Op::IsNotNull) {
-      return lhs.has_value();
+      return !lhs.is_null();
     }
+    std::array<char, 24> lhs_scratch;
+    std::array<char, 24> rhs_scratch;
     if (cmp.op == CompareExpr::Op::In) {
-      if (!lhs.has_value()) return false;
-      std::vector<std::string> candidates;
-      if (!cmp.rhs_expr_list.empty()) {
-        for (const auto& rhs_expr : cmp.rhs_expr_list) {
-          std::optional<std::string> rhs =
-              eval_relation_scalar_expr(rhs_expr, row, active_alias, profile);
-          if (rhs.has_value()) candidates.push_back(*rhs);
-        }
-      } else {
-        candidates = cmp.rhs.values;
+      if (lhs.is_null()) return false;
+      const std::string_view lhs_text = lhs.text(lhs_scratch);
+      if (!cmp.rhs.values.empty()) {
+        return executor_internal::value_list_contains(cmp.rhs, lhs_text);
+      }
+      for (const auto& rhs_expr : cmp.rhs_expr_list) {
+        const RelationValue rhs = eval_relation_scalar_expr(rhs_expr, row, profile);
+        if (!rhs.is_null() && rhs.text(rhs_scratch) == lhs_text) return true;
       }
-      return executor_internal::string_in_list(*lhs, candidates);
+      return false;
     }
     if (cmp.op == CompareExpr::Op::Contains || cmp.op == CompareExpr::Op::ContainsAll ||
         cmp.op == CompareExpr::Op::ContainsAny) {
-      if (!lhs.has_value()) return false;
+      if (lhs.is_null()) return false;
+      const std::string_view lhs_text = lhs.text(lhs_scratch);
       if (cmp.op == CompareExpr::Op::Contains) {
         if (cmp.rhs.values.empty()) return false;
-        return contains_ci(*lhs, cmp.rhs.values.front());
+        return util::contains_ci(lhs_text, cmp.rhs.values.front());
       }
       if (cmp.op == CompareExpr::Op::ContainsAll) {
-        return contains_all_ci(*lhs, cmp.rhs.values);
+        return executor_internal::value_list_contains_all_ci(cmp.rhs, lhs_text);
       }
-      return contains_any_ci(*lhs, cmp.rhs.values);
+      return executor_internal::value_list_contains_any_ci(cmp.rhs, lhs_text);
     }
-    std::optional<std::string> rhs;
+    RelationValue rhs;
     if (cmp.rhs_expr.has_value()) {
-      rhs = eval_relation_scalar_expr(*cmp.rhs_expr, row, active_alias, profile);
+      rhs = eval_relation_scalar_expr(*cmp.rhs_expr, row, profile);
     } else if (!cmp.rhs.values.empty()) {
-      rhs = cmp.rhs.values.front();
+      rhs = RelationValue::view(cmp.rhs.values.front());
     }
-    if (!lhs.has_value() || !rhs.has_value()) return false;
+    if (lhs.is_null() || rhs.is_null()) return false;
     if (cmp.op == CompareExpr::Op::Like) {
-      return like_match_ci(*lhs, *rhs);
+      if (cmp.rhs.like_pattern != nullptr) {
+        return cmp.rhs.like_pattern->matches(lhs.text(lhs_scratch));
+      }
+      return util::like_match_ci(lhs.text(lhs_scratch), rhs.text(rhs_scratch));
     }
-    auto lhs_num = parse_int64_value(*lhs);
-    auto rhs_num = parse_int64_value(*rhs);
+    // WHY: Int64 cells and numeric literals compare without a text round trip; text operands
+    // compare numerically only when both sides parse as int64, as before.
+    const std::optional<int64_t> lhs_num = lhs.as_int64();
+    const std::optional<int64_t> rhs_num = lhs_num.has_value() ? rhs.as_int64() : std::nullopt;
     if (lhs_num.has_value() && rhs_num.has_value()) {
       if (cmp.op == CompareExpr::Op::Eq) return *lhs_num == *rhs_num;
       if (cmp.op == CompareExpr::Op::NotEq) return *lhs_num != *rhs_num;
@@ -448,67 +294,23 @@ bool eval_relation_expr(const Expr& expr, const RelationRow& row,
       if (cmp.op == CompareExpr::Op::Gt) return *lhs_num > *rhs_num;
       if (cmp.op == CompareExpr::Op::Gte) return *lhs_num >= *rhs_num;
     }
-    if (cmp.op == CompareExpr::Op::Eq) return *lhs == *rhs;
-    if (cmp.op == CompareExpr::Op::NotEq) return *lhs != *rhs;
-    if (cmp.op == CompareExpr::Op::Lt) return *lhs < *rhs;
-    if (cmp.op == CompareExpr::Op::Lte) return *lhs <= *rhs;
-    if (cmp.op == CompareExpr::Op::Gt) return *lhs > *rhs;
-    if (cmp.op == CompareExpr::Op::Gte) return *lhs >= *rhs;
+    const std::string_view lhs_text = lhs.text(lhs_scratch);
+    const std::string_view rhs_text = rhs.text(rhs_scratch);
+    if (cmp.op == CompareExpr::Op::Eq) return lhs_text == rhs_text;
+    if (cmp.op == CompareExpr::Op::NotEq) return lhs_text != rhs_text;
+    if (cmp.op == CompareExpr::Op::Lt) return lhs_text < rhs_text;
+    if (cmp.op == CompareExpr::Op::Lte) return lhs_text <= rhs_text;
+    if (cmp.op == CompareExpr::Op::Gt) return lhs_text > rhs_text;
+    if (cmp.op == CompareExpr::Op::Gte) return lhs_text >= rhs_text;
     return false;
   }
   if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(expr)) {
     return false;
   }
   const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
-  bool left = eval_relation_expr(bin.left, row, active_alias, profile);
-  bool right = eval_relation_expr(bin.right, row, active_alias, profile);
+  bool left = eval_relation_expr(bin.left, row, profile);
+  bool right = eval_relation_expr(bin.right, row, profile);
   return (bin.op == BinaryExpr::Op::And) ? (left && right) : (left || right);
 }
 
-int compare_optional_relation_values(const std::optional<std::string>& left,
-                                     const std::optional<std::string>& right) {
-  if (!left.has_value() && !right.has_value()) return 0;
-  if (!left.has_value()) return -1;
-  if (!right.has_value()) return 1;
-  auto left_num = parse_int64_value(*left);
-  auto right_num = parse_int64_value(*right);
-  if (left_num.has_value() && right_num.has_value()) {
-    if (*left_num < *right_num) return -1;
-    if (*left_num > *right_num) return 1;
-    return 0;
-  }
-  if (*left < *right) return -1;
-  if (*left > *right) return 1;
-  return 0;
-}
-
-std::optional<std::string> relation_field_by_name(const RelationRow& row, const std::string& field,
-                                                  const std::optional<std::string>& active_alias) {
-  size_t dot = field.find('.');
-  if (dot != std::string::npos) {
-    const std::string alias = lower_alias_name(field.substr(0, dot));
-    const std::string col = field.substr(dot + 1);
-    auto it = row.aliases.find(alias);
-    if (it == row.aliases.end()) return std::nullopt;
-    auto value_it = it->second.values.find(col);
-    if (value_it == it->second.values.end()) return std::nullopt;
-    return value_it->second;
-  }
-  if (active_alias.has_value()) {
-    auto it = row.aliases.find(*active_alias);
-    if (it != row.aliases.end()) {
-      auto value_it = it->second.values.find(field);
-      if (value_it != it->second.values.end()) return value_it->second;
-    }
-  }
-  std::optional<std::string> found;
-  for (const auto& alias_entry : row.aliases) {
-    auto value_it = alias_entry.second.values.find(field);
-    if (value_it == alias_entry.second.values.end()) continue;
-    if (found.has_value()) return std::nullopt;
-    found = value_it->second;
-  }
-  return found;
-}
-
 }  // namespace markql
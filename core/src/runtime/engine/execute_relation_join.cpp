@@ -28,15 +28,32 @@ struct RelationHashJoinPlan {
   RelationJoinKeySpec right_key;
 };
 
+/// Containment join between a document-backed alias and node ids on the other side.
+/// `doc_key` names the alias whose table carries the shared DOM; `value_key` reads node_id
+/// values from the opposite relation. With `parent_child` only direct parents match.
+/// `term` is the ON conjunct the merge answers; the remaining conjuncts run per candidate pair.
+struct RelationStructuralJoinPlan {
+  RelationJoinKeySpec doc_key;
+  RelationJoinKeySpec value_key;
+  bool doc_in_left = false;
+  bool doc_is_descendant = true;
+  bool parent_child = false;
+  const CompareExpr* term = nullptr;
+  bool full_on_covered = false;
+};
+
 enum class RelationJoinStrategy {
   NestedLoop,
   HashEqui,
   IndexedLookupNested,
+  StructuralContainment,
+  StructuralParentChild,
 };
 
 struct RelationJoinExecutionPlan {
   RelationJoinStrategy strategy = RelationJoinStrategy::NestedLoop;
   std::optional<RelationHashJoinPlan> hash_plan;
+  std::optional<RelationStructuralJoinPlan> structural_plan;
 };
 
 struct RelationIndexLookupTerm {
@@ -91,7 +108,12 @@ std::optional<RelationJoinKeySpec> join_key_spec_from_scalar(const ScalarExpr& e
 }
 
 bool relation_has_alias(const Relation& rel, const std::string& alias) {
-  return rel.alias_columns.find(alias) != rel.alias_columns.end();
+  return rel.find_alias(alias) >= 0;
+}
+
+bool alias_is_only_in_relation(const std::string& alias, const Relation& yes_rel,
+                               const Relation& no_rel) {
+  return relation_has_alias(yes_rel, alias) && !relation_has_alias(no_rel, alias);
 }
 
 std::optional<RelationHashJoinPlan> plan_simple_hash_join(const Query::JoinItem& join,
@@ -125,10 +147,112 @@ std::optional<RelationHashJoinPlan> plan_simple_hash_join(const Query::JoinItem&
   return std::nullopt;
 }
 
+bool append_compare_conjuncts(const Expr& expr, std::vector<const CompareExpr*>& out);
+
+/// Returns the shared DOM of `alias` when it is document-backed with real subtree intervals.
+const RelationDocument* alias_document(const Relation& rel, const std::string& alias) {
+  const int32_t index = rel.find_alias(alias);
+  if (index < 0) return nullptr;
+  const RelationTable& table = *rel.aliases[static_cast<size_t>(index)].table;
+  const RelationDocument* document = table.document();
+  if (document == nullptr || !document->preorder) return nullptr;
+  return document;
+}
+
+bool doc_column_is_plain(const Relation& rel, const std::string& alias,
+                         const std::string& column) {
+  const int32_t index = rel.find_alias(alias);
+  if (index < 0) return false;
+  const RelationTable& table = *rel.aliases[static_cast<size_t>(index)].table;
+  const int32_t col = table.find_column(column);
+  return col >= 0 && !table.column_shadowed(static_cast<size_t>(col));
+}
+
+/// Recognizes one ON conjunct as a containment term:
+/// - `x.ancestor.node_id = y.k` (y is an ancestor of x) or `x.descendant.node_id = y.k`
+///   where x is document-backed;
+/// - `p.k = c.parent_id` where c is document-backed (parent-child).
+std::optional<RelationStructuralJoinPlan> structural_term_from_compare(const CompareExpr& cmp,
+                                                                      const Relation& left_rel,
+                                                                      const Relation& right_rel) {
+  if (cmp.op != CompareExpr::Op::Eq || !cmp.rhs_expr.has_value()) return std::nullopt;
+  ScalarExpr lhs_scalar;
+  if (cmp.lhs_expr.has_value()) {
+    lhs_scalar = *cmp.lhs_expr;
+  } else {
+    lhs_scalar.kind = ScalarExpr::Kind::Operand;
+    lhs_scalar.operand = cmp.lhs;
+  }
+  const ScalarExpr* sides[2] = {&lhs_scalar, &*cmp.rhs_expr};
+  for (int axis_side = 0; axis_side < 2; ++axis_side) {
+    const ScalarExpr& axis_expr = *sides[axis_side];
+    const ScalarExpr& value_expr = *sides[1 - axis_side];
+    if (axis_expr.kind != ScalarExpr::Kind::Operand) continue;
+    const Operand& operand = axis_expr.operand;
+    if (!operand.qualifier.has_value()) continue;
+    std::optional<RelationJoinKeySpec> value_key = join_key_spec_from_scalar(value_expr);
+    if (!value_key.has_value()) continue;
+    RelationStructuralJoinPlan plan;
+    plan.doc_key.alias = lower_alias_name(*operand.qualifier);
+    if ((operand.axis == Operand::Axis::Ancestor || operand.axis == Operand::Axis::Descendant) &&
+        operand.field_kind == Operand::FieldKind::NodeId) {
+      plan.doc_key.column = "node_id";
+      plan.doc_is_descendant = operand.axis == Operand::Axis::Ancestor;
+    } else if (operand.axis == Operand::Axis::Self &&
+               operand.field_kind == Operand::FieldKind::ParentId) {
+      plan.doc_key.column = "parent_id";
+      plan.parent_child = true;
+    } else {
+      continue;
+    }
+    plan.value_key = std::move(*value_key);
+    if (alias_is_only_in_relation(plan.doc_key.alias, left_rel, right_rel) &&
+        alias_is_only_in_relation(plan.value_key.alias, right_rel, left_rel)) {
+      plan.doc_in_left = true;
+    } else if (!alias_is_only_in_relation(plan.doc_key.alias, right_rel, left_rel) ||
+               !alias_is_only_in_relation(plan.value_key.alias, left_rel, right_rel)) {
+      continue;
+    }
+    const Relation& doc_rel = plan.doc_in_left ? left_rel : right_rel;
+    if (alias_document(doc_rel, plan.doc_key.alias) == nullptr) continue;
+    if (plan.parent_child &&
+        !doc_column_is_plain(doc_rel, plan.doc_key.alias, plan.doc_key.column)) {
+      continue;
+    }
+    return plan;
+  }
+  return std::nullopt;
+}
+
+std::optional<RelationStructuralJoinPlan> plan_structural_join(const Query::JoinItem& join,
+                                                               const Relation& left_rel,
+                                                               const Relation& right_rel) {
+  if (join.type != Query::JoinItem::Type::Inner && join.type != Query::JoinItem::Type::Left) {
+    return std::nullopt;
+  }
+  if (!join.on.has_value()) return std::nullopt;
+  std::vector<const CompareExpr*> conjuncts;
+  if (!append_compare_conjuncts(*join.on, conjuncts)) return std::nullopt;
+  for (const CompareExpr* cmp : conjuncts) {
+    if (auto plan = structural_term_from_compare(*cmp, left_rel, right_rel); plan.has_value()) {
+      plan->term = cmp;
+      plan->full_on_covered = conjuncts.size() == 1;
+      return plan;
+    }
+  }
+  return std::nullopt;
+}
+
 RelationJoinExecutionPlan select_join_strategy(const Query::JoinItem& join,
                                                const Relation& left_rel,
                                                const Relation& right_rel) {
   RelationJoinExecutionPlan plan;
+  if (auto structural = plan_structural_join(join, left_rel, right_rel); structural.has_value()) {
+    plan.strategy = structural->parent_child ? RelationJoinStrategy::StructuralParentChild
+                                             : RelationJoinStrategy::StructuralContainment;
+    plan.structural_plan = std::move(structural);
+    return plan;
+  }
   if (auto hash = plan_simple_hash_join(join, left_rel, right_rel); hash.has_value()) {
     plan.strategy = RelationJoinStrategy::HashEqui;
     plan.hash_plan = std::move(hash);
@@ -147,6 +271,23 @@ bool append_compare_conjuncts(const Expr& expr, std::vector<const CompareExpr*>&
   return append_compare_conjuncts(bin.left, out) && append_compare_conjuncts(bin.right, out);
 }
 
+/// Evaluates an AND-of-comparisons ON clause with `skip` treated as already satisfied.
+bool eval_on_conjuncts_except(const Expr& expr, const CompareExpr* skip,
+                              const RelationRowView& row,
+                              RelationRuntimeCache::Profile* profile) {
+  if (std::holds_alternative<CompareExpr>(expr) && &std::get<CompareExpr>(expr) == skip) {
+    return true;
+  }
+  if (std::holds_alternative<std::shared_ptr<BinaryExpr>>(expr)) {
+    const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+    if (bin.op == BinaryExpr::Op::And) {
+      return eval_on_conjuncts_except(bin.left, skip, row, profile) &&
+             eval_on_conjuncts_except(bin.right, skip, row, profile);
+    }
+  }
+  return eval_relation_expr(expr, row, profile);
+}
+
 std::optional<ScalarExpr> compare_lhs_scalar(const CompareExpr& cmp) {
   if (cmp.lhs_expr.has_value()) return cmp.lhs_expr;
   ScalarExpr expr;
@@ -180,11 +321,6 @@ bool scalar_literal_value(const ScalarExpr& expr, std::optional<std::string>* ou
   return false;
 }
 
-bool alias_is_only_in_relation(const std::string& alias, const Relation& yes_rel,
-                               const Relation& no_rel) {
-  return relation_has_alias(yes_rel, alias) && !relation_has_alias(no_rel, alias);
-}
-
 std::optional<RelationIndexLookupTerm> lookup_term_from_compare(const CompareExpr& cmp,
                                                                 const Relation& left_rel,
                                                                 const Relation& right_rel) {
@@ -244,7 +380,7 @@ std::optional<RelationIndexLookupPlan> plan_index_lookup_join(const Query::JoinI
   if (join.type != Query::JoinItem::Type::Inner && join.type != Query::JoinItem::Type::Left) {
     return std::nullopt;
   }
-  if (right_rel.alias_columns.size() != 1) return std::nullopt;
+  if (right_rel.aliases.size() != 1) return std::nullopt;
 
   std::vector<const CompareExpr*> conjuncts;
   if (!append_compare_conjuncts(*join.on, conjuncts)) return std::nullopt;
@@ -279,22 +415,66 @@ std::optional<RelationIndexLookupPlan> plan_index_lookup_join(const Query::JoinI
   return plan;
 }
 
-std::optional<std::string> relation_row_key_value(const RelationRow& row,
-                                                  const RelationJoinKeySpec& key) {
-  auto alias_it = row.aliases.find(key.alias);
-  if (alias_it == row.aliases.end()) return std::nullopt;
-  auto value_it = alias_it->second.values.find(key.column);
-  if (value_it == alias_it->second.values.end()) return std::nullopt;
-  return value_it->second;
+/// Resolved join key column: alias index in its relation plus the table column.
+struct RelationKeySlot {
+  int32_t alias = -1;
+  int32_t column = -1;
+};
+
+RelationKeySlot bind_key_slot(const Relation& rel, const std::string& alias,
+                              const std::string& column) {
+  RelationKeySlot slot;
+  slot.alias = rel.find_alias(alias);
+  if (slot.alias >= 0) {
+    slot.column = rel.aliases[static_cast<size_t>(slot.alias)].table->find_column(column);
+  }
+  return slot;
 }
 
-std::optional<std::string> single_alias_relation_row_value(const RelationRow& row,
-                                                           const std::string& column) {
-  if (row.aliases.size() != 1) return std::nullopt;
-  const auto& record = row.aliases.begin()->second;
-  auto value_it = record.values.find(column);
-  if (value_it == record.values.end()) return std::nullopt;
-  return value_it->second;
+/// Reads a join key as its normalized form without materializing integer columns as text.
+std::optional<std::string> relation_key_at(const Relation& rel, const RelationKeySlot& slot,
+                                           size_t row) {
+  if (slot.alias < 0 || slot.column < 0) return std::nullopt;
+  const RelationAlias& alias = rel.aliases[static_cast<size_t>(slot.alias)];
+  const uint32_t table_row = alias.rows[row];
+  if (table_row == kRelationNullRow) return std::nullopt;
+  const size_t column = static_cast<size_t>(slot.column);
+  if (auto value = alias.table->int_value(column, table_row); value.has_value()) {
+    return std::string("N:") + std::to_string(*value);
+  }
+  const std::string* text = alias.table->string_value(column, table_row);
+  if (text == nullptr) return std::nullopt;
+  return normalize_join_key(*text);
+}
+
+/// Extracts one join key column with integer keys kept as int64 (see RelationJoinKeys).
+RelationJoinKeys relation_join_keys(const Relation& rel, const RelationKeySlot& slot) {
+  RelationJoinKeys keys;
+  keys.kinds.assign(rel.row_count, RelationJoinKeys::Kind::Null);
+  keys.ints.assign(rel.row_count, 0);
+  keys.texts.assign(rel.row_count, nullptr);
+  if (slot.alias < 0 || slot.column < 0) return keys;
+  const RelationAlias& alias = rel.aliases[static_cast<size_t>(slot.alias)];
+  const size_t column = static_cast<size_t>(slot.column);
+  for (size_t row = 0; row < rel.row_count; ++row) {
+    const uint32_t table_row = alias.rows[row];
+    if (table_row == kRelationNullRow) continue;
+    std::optional<int64_t> number = alias.table->int_value(column, table_row);
+    const std::string* text = nullptr;
+    if (!number.has_value()) {
+      text = alias.table->string_value(column, table_row);
+      if (text == nullptr) continue;
+      number = parse_int64_value(*text);
+    }
+    if (number.has_value()) {
+      keys.kinds[row] = RelationJoinKeys::Kind::Int;
+      keys.ints[row] = *number;
+    } else {
+      keys.kinds[row] = RelationJoinKeys::Kind::Text;
+      keys.texts[row] = text;
+    }
+  }
+  return keys;
 }
 
 std::optional<std::string> normalize_join_key(const std::optional<std::string>& raw) {
@@ -329,44 +509,119 @@ std::optional<std::string> relation_index_signature(const Relation& right_rel,
   return signature;
 }
 
-RelationRow build_left_join_padded_row(const RelationRow& left_row, const Relation& right_rel) {
-  RelationRow padded = left_row;
-  for (const auto& alias_cols : right_rel.alias_columns) {
-    RelationRecord null_record;
-    for (const auto& col : alias_cols.second) {
-      null_record.values[col] = std::nullopt;
-    }
-    padded.aliases[alias_cols.first] = std::move(null_record);
-  }
-  return padded;
-}
-
-void merge_alias_columns_from_right(Relation& target, const Relation& right_rel) {
-  for (const auto& alias_cols : right_rel.alias_columns) {
-    target.alias_columns[alias_cols.first].insert(alias_cols.second.begin(),
-                                                  alias_cols.second.end());
-  }
+/// True for relation keys that name the same rows in every statement run against a prepared
+/// document: default-document scans and text-keyed CTEs of the statement's WITH clause.
+bool relation_key_outlives_statement(const std::string& key) {
+  return key.rfind("doc:", 0) == 0 || key.rfind("cte@", 0) == 0;
 }
 
 const char* join_strategy_name(RelationJoinStrategy strategy) {
   if (strategy == RelationJoinStrategy::HashEqui) return "hash_equi";
+  if (strategy == RelationJoinStrategy::StructuralContainment) return "structural_containment";
+  if (strategy == RelationJoinStrategy::StructuralParentChild) return "structural_parent_child";
   if (strategy == RelationJoinStrategy::IndexedLookupNested) return "indexed_lookup_nested";
   return "nested_loop";
 }
 
-}  // namespace
+/// Reads a node_id-valued key cell as an integer, the way join keys normalize numbers.
+std::optional<int64_t> relation_node_id_at(const Relation& rel, const RelationKeySlot& slot,
+                                           size_t row) {
+  if (slot.alias < 0 || slot.column < 0) return std::nullopt;
+  const RelationAlias& alias = rel.aliases[static_cast<size_t>(slot.alias)];
+  const uint32_t table_row = alias.rows[row];
+  if (table_row == kRelationNullRow) return std::nullopt;
+  const size_t column = static_cast<size_t>(slot.column);
+  if (auto value = alias.table->int_value(column, table_row); value.has_value()) return value;
+  const std::string* text = alias.table->string_value(column, table_row);
+  if (text == nullptr) return std::nullopt;
+  return parse_int64_value(*text);
+}
 
-bool merge_row_aliases(RelationRow& target, const RelationRow& add, std::string* duplicate_alias) {
-  for (const auto& alias_entry : add.aliases) {
-    if (target.aliases.find(alias_entry.first) != target.aliases.end()) {
-      if (duplicate_alias != nullptr) *duplicate_alias = alias_entry.first;
-      return false;
+/// Stack-tree containment join over preorder node indices.
+/// Returns (ancestor_row, descendant_row) candidate pairs in O(|A| + |D| + output) after sorting
+/// both inputs by node index; with `parent_child` only direct parents are paired.
+std::vector<std::pair<uint32_t, uint32_t>> stack_tree_join(
+    const RelationDocument& document, std::vector<std::pair<uint32_t, uint32_t>> ancestors,
+    std::vector<std::pair<uint32_t, uint32_t>> descendants, bool parent_child) {
+  std::sort(ancestors.begin(), ancestors.end());
+  std::sort(descendants.begin(), descendants.end());
+  std::vector<std::pair<uint32_t, uint32_t>> out;
+  std::vector<std::pair<uint32_t, uint32_t>> stack;
+  auto encloses = [&](uint32_t outer, uint32_t inner) {
+    return outer == inner || document.contains(outer, inner);
+  };
+  size_t next_ancestor = 0;
+  for (const auto& descendant : descendants) {
+    const uint32_t node = descendant.first;
+    while (next_ancestor < ancestors.size() && ancestors[next_ancestor].first < node) {
+      const auto& candidate = ancestors[next_ancestor++];
+      while (!stack.empty() && !encloses(stack.back().first, candidate.first)) stack.pop_back();
+      stack.push_back(candidate);
     }
-    target.aliases.insert(alias_entry);
+    while (!stack.empty() && !document.contains(stack.back().first, node)) stack.pop_back();
+    if (parent_child) {
+      const int32_t parent = document.parent_index[node];
+      for (size_t i = stack.size(); i-- > 0;) {
+        if (static_cast<int32_t>(stack[i].first) < parent) break;
+        if (static_cast<int32_t>(stack[i].first) == parent) {
+          out.emplace_back(stack[i].second, descendant.second);
+        }
+      }
+      continue;
+    }
+    for (const auto& entry : stack) out.emplace_back(entry.second, descendant.second);
   }
-  return true;
+  return out;
 }
 
+/// Accumulates join output as selection vectors over the input relations' tables.
+class JoinOutput {
+ public:
+  JoinOutput(const Relation& left, const Relation& right) : left_(left), right_(right) {
+    for (const auto& alias : left.aliases) {
+      out_.aliases.push_back(RelationAlias{alias.name, alias.table, {}});
+    }
+    for (const auto& alias : right.aliases) {
+      if (duplicate_.empty() && left.find_alias(alias.name) >= 0) duplicate_ = alias.name;
+      out_.aliases.push_back(RelationAlias{alias.name, alias.table, {}});
+    }
+    rows_.resize(out_.aliases.size());
+  }
+
+  /// Throws like the row model did once a left and right row are actually combined.
+  void check_pair() const {
+    if (!duplicate_.empty()) {
+      throw std::runtime_error("Duplicate source alias '" + duplicate_ + "' in FROM");
+    }
+  }
+
+  void emit(size_t left_row, std::optional<size_t> right_row) {
+    const size_t left_count = left_.aliases.size();
+    for (size_t i = 0; i < left_count; ++i) {
+      rows_[i].push_back(left_.aliases[i].rows[left_row]);
+    }
+    for (size_t i = 0; i < right_.aliases.size(); ++i) {
+      rows_[left_count + i].push_back(
+          right_row.has_value() ? right_.aliases[i].rows[*right_row] : kRelationNullRow);
+    }
+    ++out_.row_count;
+  }
+
+  Relation take() {
+    for (size_t i = 0; i < rows_.size(); ++i) out_.aliases[i].rows = std::move(rows_[i]);
+    return std::move(out_);
+  }
+
+ private:
+  const Relation& left_;
+  const Relation& right_;
+  Relation out_;
+  std::vector<std::vector<uint32_t>> rows_;
+  std::string duplicate_;
+};
+
+}  // namespace
+
 Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Relation& left_rel,
                                            const Relation& right_rel,
                                            const std::optional<std::string>& active_alias,
@@ -377,45 +632,124 @@ Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Re
   const auto started_at = profiling_enabled ? std::chrono::steady_clock::now()
                                             : std::chrono::steady_clock::time_point{};
 
-  Relation next;
-  next.alias_columns = left_rel.alias_columns;
-  merge_alias_columns_from_right(next, right_rel);
-  next.cache_key = left_rel.cache_key;
+  JoinOutput output(left_rel, right_rel);
+  const size_t left_alias_count = left_rel.aliases.size();
+  RelationScope on_scope(left_rel, right_rel, active_alias);
+  std::vector<uint32_t> cursor(left_alias_count + right_rel.aliases.size(), 0);
+  const RelationRowView on_row{&on_scope, cursor.data()};
+  auto on_matches = [&](size_t left_row, size_t right_row, bool needs_eval) {
+    output.check_pair();
+    if (!needs_eval || join.type == Query::JoinItem::Type::Cross || !join.on.has_value()) {
+      return true;
+    }
+    load_relation_row(left_rel, left_row, cursor);
+    load_relation_row(right_rel, right_row, cursor, left_alias_count);
+    return eval_relation_expr(*join.on, on_row, profile);
+  };
 
   uint64_t pairs_evaluated = 0;
+  std::string join_detail;
   RelationJoinExecutionPlan plan = select_join_strategy(join, left_rel, right_rel);
-  if (plan.strategy == RelationJoinStrategy::HashEqui && plan.hash_plan.has_value()) {
-    std::unordered_map<std::string, std::vector<size_t>> right_index;
-    right_index.reserve(right_rel.rows.size());
-    for (size_t i = 0; i < right_rel.rows.size(); ++i) {
-      std::optional<std::string> key =
-          normalize_join_key(relation_row_key_value(right_rel.rows[i], plan.hash_plan->right_key));
-      if (!key.has_value()) continue;
-      right_index[*key].push_back(i);
+  if (plan.structural_plan.has_value()) {
+    const RelationStructuralJoinPlan& structural = *plan.structural_plan;
+    const Relation& doc_rel = structural.doc_in_left ? left_rel : right_rel;
+    const Relation& value_rel = structural.doc_in_left ? right_rel : left_rel;
+    const RelationDocument& document = *alias_document(doc_rel, structural.doc_key.alias);
+    const RelationAlias& doc_alias =
+        doc_rel.aliases[static_cast<size_t>(doc_rel.find_alias(structural.doc_key.alias))];
+    const RelationKeySlot value_slot =
+        bind_key_slot(value_rel, structural.value_key.alias, structural.value_key.column);
+
+    // WHY: the document-backed side maps rows to preorder node indices directly; the value
+    // side holds node ids that name nodes of the same document.
+    std::vector<std::pair<uint32_t, uint32_t>> doc_nodes;
+    doc_nodes.reserve(doc_rel.row_count);
+    for (size_t row = 0; row < doc_rel.row_count; ++row) {
+      const uint32_t table_row = doc_alias.rows[row];
+      if (table_row == kRelationNullRow) continue;
+      doc_nodes.emplace_back(doc_alias.table->node_index(table_row), static_cast<uint32_t>(row));
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> value_nodes;
+    value_nodes.reserve(value_rel.row_count);
+    for (size_t row = 0; row < value_rel.row_count; ++row) {
+      std::optional<int64_t> id = relation_node_id_at(value_rel, value_slot, row);
+      if (!id.has_value()) continue;
+      const int64_t node = document.node_index(*id);
+      if (node < 0) continue;
+      value_nodes.emplace_back(static_cast<uint32_t>(node), static_cast<uint32_t>(row));
     }
-    for (const auto& left_row : left_rel.rows) {
+    const bool doc_is_descendant = structural.parent_child || structural.doc_is_descendant;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs =
+        doc_is_descendant
+            ? stack_tree_join(document, std::move(value_nodes), std::move(doc_nodes),
+                              structural.parent_child)
+            : stack_tree_join(document, std::move(doc_nodes), std::move(value_nodes), false);
+
+    // Re-emit in left-row order (right rows ascending) so output matches the nested loop.
+    const bool doc_rows_are_first = !doc_is_descendant;
+    std::vector<uint32_t> offsets(left_rel.row_count + 1, 0);
+    auto split = [&](const std::pair<uint32_t, uint32_t>& pair) {
+      const uint32_t doc_row = doc_rows_are_first ? pair.first : pair.second;
+      const uint32_t value_row = doc_rows_are_first ? pair.second : pair.first;
+      return structural.doc_in_left ? std::make_pair(doc_row, value_row)
+                                    : std::make_pair(value_row, doc_row);
+    };
+    for (const auto& pair : pairs) ++offsets[split(pair).first + 1];
+    for (size_t i = 0; i < left_rel.row_count; ++i) offsets[i + 1] += offsets[i];
+    std::vector<uint32_t> right_rows(pairs.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& pair : pairs) {
+      const auto [left_row, right_row] = split(pair);
+      right_rows[fill[left_row]++] = right_row;
+    }
+    // WHY: the merge alone decides the containment term; axis operands are not row values, so
+    // re-evaluating that term per pair would reject every candidate.
+    auto residual_matches = [&](size_t left_row, size_t right_row) {
+      output.check_pair();
+      if (structural.full_on_covered) return true;
+      load_relation_row(left_rel, left_row, cursor);
+      load_relation_row(right_rel, right_row, cursor, left_alias_count);
+      return eval_on_conjuncts_except(*join.on, structural.term, on_row, profile);
+    };
+    for (size_t left_row = 0; left_row < left_rel.row_count; ++left_row) {
       bool matched = false;
-      std::optional<std::string> left_key =
-          normalize_join_key(relation_row_key_value(left_row, plan.hash_plan->left_key));
-      if (left_key.has_value()) {
-        auto it = right_index.find(*left_key);
-        if (it != right_index.end()) {
-          for (size_t right_idx : it->second) {
-            ++pairs_evaluated;
-            RelationRow merged = left_row;
-            std::string duplicate;
-            if (!merge_row_aliases(merged, right_rel.rows[right_idx], &duplicate)) {
-              throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
-            }
-            matched = true;
-            next.rows.push_back(std::move(merged));
-          }
-        }
+      auto begin = right_rows.begin() + offsets[left_row];
+      auto end = right_rows.begin() + offsets[left_row + 1];
+      std::sort(begin, end);
+      for (auto it = begin; it != end; ++it) {
+        ++pairs_evaluated;
+        if (!residual_matches(left_row, *it)) continue;
+        matched = true;
+        output.emit(left_row, *it);
+      }
+      if (join.type == Query::JoinItem::Type::Left && !matched) {
+        output.emit(left_row, std::nullopt);
+      }
+    }
+  } else if (plan.strategy == RelationJoinStrategy::HashEqui && plan.hash_plan.has_value()) {
+    const RelationKeySlot left_key =
+        bind_key_slot(left_rel, plan.hash_plan->left_key.alias, plan.hash_plan->left_key.column);
+    const RelationKeySlot right_key = bind_key_slot(right_rel, plan.hash_plan->right_key.alias,
+                                                    plan.hash_plan->right_key.column);
+    const RelationJoinMatches matches =
+        relation_hash_join(relation_join_keys(left_rel, left_key),
+                           relation_join_keys(right_rel, right_key));
+    for (size_t left_row = 0; left_row < left_rel.row_count; ++left_row) {
+      bool matched = false;
+      for (uint32_t i = matches.offsets[left_row]; i < matches.offsets[left_row + 1]; ++i) {
+        ++pairs_evaluated;
+        output.check_pair();
+        matched = true;
+        output.emit(left_row, matches.right_rows[i]);
       }
       if (join.type == Query::JoinItem::Type::Left && !matched) {
-        next.rows.push_back(build_left_join_padded_row(left_row, right_rel));
+        output.emit(left_row, std::nullopt);
       }
     }
+    if (profiling_enabled) {
+      join_detail = std::string("build=") + (matches.built_on_left ? "left" : "right") +
+                    " partitions=" + std::to_string(matches.partitions);
+    }
   } else {
     std::optional<RelationIndexLookupPlan> index_lookup =
         plan_index_lookup_join(join, left_rel, right_rel);
@@ -423,37 +757,49 @@ Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Re
       plan.strategy = RelationJoinStrategy::IndexedLookupNested;
       const bool needs_full_on_eval = !index_lookup->full_on_covered;
 
-      std::unordered_map<std::string, std::vector<size_t>> local_index;
-      std::unordered_map<std::string, std::vector<size_t>>* right_index = nullptr;
-
-      bool cache_hit = false;
+      std::optional<std::string> signature;
+      std::shared_ptr<const RelationLookupIndex> right_index;
+      RelationDocumentCache* shared = nullptr;
       if (cache != nullptr) {
-        std::optional<std::string> signature = relation_index_signature(right_rel, *index_lookup);
+        signature = relation_index_signature(right_rel, *index_lookup);
+        if (signature.has_value() && relation_key_outlives_statement(right_rel.cache_key)) {
+          shared = cache->document_cache.get();
+        }
         if (signature.has_value()) {
           auto found = cache->relation_index_cache.find(*signature);
           if (found != cache->relation_index_cache.end()) {
-            cache_hit = true;
-            right_index = &found->second;
-          } else {
-            auto [it, _] = cache->relation_index_cache.emplace(
-                *signature, std::unordered_map<std::string, std::vector<size_t>>{});
-            right_index = &it->second;
+            right_index = found->second;
+          } else if (shared != nullptr) {
+            right_index = shared->find_index(*signature);
+            ++(right_index != nullptr ? profile->document_cache_hits
+                                      : profile->document_cache_misses);
+            if (right_index != nullptr) {
+              cache->relation_index_cache.emplace(*signature, right_index);
+            }
           }
         }
       }
-      if (right_index == nullptr) {
-        right_index = &local_index;
+      const bool cache_hit = right_index != nullptr;
+      std::vector<RelationKeySlot> right_slots;
+      std::vector<RelationKeySlot> left_slots;
+      for (const auto& term : index_lookup->terms) {
+        right_slots.push_back(bind_key_slot(right_rel, right_rel.aliases.front().name,
+                                            term.right_column));
+        left_slots.push_back(term.kind == RelationIndexLookupTerm::Kind::LeftColumn
+                                 ? bind_key_slot(left_rel, term.left_key.alias,
+                                                 term.left_key.column)
+                                 : RelationKeySlot{});
       }
+      std::vector<std::string> parts;
+      parts.reserve(index_lookup->terms.size());
       if (!cache_hit) {
-        right_index->reserve(right_rel.rows.size());
-        for (size_t right_idx = 0; right_idx < right_rel.rows.size(); ++right_idx) {
-          const RelationRow& right_row = right_rel.rows[right_idx];
-          std::vector<std::string> parts;
-          parts.reserve(index_lookup->terms.size());
+        auto built = std::make_shared<RelationLookupIndex>();
+        built->reserve(right_rel.row_count);
+        for (size_t right_idx = 0; right_idx < right_rel.row_count; ++right_idx) {
+          parts.clear();
           bool has_full_key = true;
-          for (const auto& term : index_lookup->terms) {
-            std::optional<std::string> normalized =
-                normalize_join_key(single_alias_relation_row_value(right_row, term.right_column));
+          for (const auto& slot : right_slots) {
+            std::optional<std::string> normalized = relation_key_at(right_rel, slot, right_idx);
             if (!normalized.has_value()) {
               has_full_key = false;
               break;
@@ -461,7 +807,12 @@ Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Re
             parts.push_back(std::move(*normalized));
           }
           if (!has_full_key) continue;
-          (*right_index)[composite_lookup_key(parts)].push_back(right_idx);
+          (*built)[composite_lookup_key(parts)].push_back(right_idx);
+        }
+        right_index = std::move(built);
+        if (signature.has_value()) {
+          if (shared != nullptr) right_index = shared->insert_index(*signature, right_index);
+          cache->relation_index_cache.emplace(*signature, right_index);
         }
       }
       if (profiling_enabled) {
@@ -472,82 +823,63 @@ Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Re
         }
       }
 
-      for (const auto& left_row : left_rel.rows) {
+      for (size_t left_row = 0; left_row < left_rel.row_count; ++left_row) {
         bool matched = false;
-        std::vector<std::string> lookup_parts;
-        lookup_parts.reserve(index_lookup->terms.size());
+        parts.clear();
         bool has_lookup_key = true;
-        for (const auto& term : index_lookup->terms) {
-          std::optional<std::string> normalized;
-          if (term.kind == RelationIndexLookupTerm::Kind::LeftColumn) {
-            normalized = normalize_join_key(relation_row_key_value(left_row, term.left_key));
-          } else {
-            normalized = term.normalized_literal_key;
-          }
+        for (size_t t = 0; t < index_lookup->terms.size(); ++t) {
+          const auto& term = index_lookup->terms[t];
+          std::optional<std::string> normalized =
+              term.kind == RelationIndexLookupTerm::Kind::LeftColumn
+                  ? relation_key_at(left_rel, left_slots[t], left_row)
+                  : term.normalized_literal_key;
           if (!normalized.has_value()) {
             has_lookup_key = false;
             break;
           }
-          lookup_parts.push_back(std::move(*normalized));
+          parts.push_back(std::move(*normalized));
         }
         if (has_lookup_key) {
-          auto it = right_index->find(composite_lookup_key(lookup_parts));
+          auto it = right_index->find(composite_lookup_key(parts));
           if (it != right_index->end()) {
             for (size_t right_idx : it->second) {
               ++pairs_evaluated;
-              RelationRow merged = left_row;
-              std::string duplicate;
-              if (!merge_row_aliases(merged, right_rel.rows[right_idx], &duplicate)) {
-                throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
-              }
-              bool keep = true;
-              if (needs_full_on_eval && join.type != Query::JoinItem::Type::Cross &&
-                  join.on.has_value()) {
-                keep = eval_relation_expr(*join.on, merged, active_alias, profile);
-              }
-              if (!keep) continue;
+              if (!on_matches(left_row, right_idx, needs_full_on_eval)) continue;
               matched = true;
-              next.rows.push_back(std::move(merged));
+              output.emit(left_row, right_idx);
             }
           }
         }
         if (join.type == Query::JoinItem::Type::Left && !matched) {
-          next.rows.push_back(build_left_join_padded_row(left_row, right_rel));
+          output.emit(left_row, std::nullopt);
         }
       }
     } else {
-      for (const auto& left_row : left_rel.rows) {
+      for (size_t left_row = 0; left_row < left_rel.row_count; ++left_row) {
         bool matched = false;
-        for (const auto& right_row : right_rel.rows) {
+        for (size_t right_row = 0; right_row < right_rel.row_count; ++right_row) {
           ++pairs_evaluated;
-          RelationRow merged = left_row;
-          std::string duplicate;
-          if (!merge_row_aliases(merged, right_row, &duplicate)) {
-            throw std::runtime_error("Duplicate source alias '" + duplicate + "' in FROM");
-          }
-          bool keep = true;
-          if (join.type != Query::JoinItem::Type::Cross && join.on.has_value()) {
-            keep = eval_relation_expr(*join.on, merged, active_alias, profile);
-          }
-          if (!keep) continue;
+          if (!on_matches(left_row, right_row, true)) continue;
           matched = true;
-          next.rows.push_back(std::move(merged));
+          output.emit(left_row, right_row);
         }
         if (join.type == Query::JoinItem::Type::Left && !matched) {
-          next.rows.push_back(build_left_join_padded_row(left_row, right_rel));
+          output.emit(left_row, std::nullopt);
         }
       }
     }
   }
 
+  Relation next = output.take();
+  next.cache_key = left_rel.cache_key;
   if (profiling_enabled) {
     const auto finished_at = std::chrono::steady_clock::now();
     const uint64_t elapsed_ns = static_cast<uint64_t>(
         std::chrono::duration_cast<std::chrono::nanoseconds>(finished_at - started_at).count());
     profile->join_time_ns += elapsed_ns;
     profile->joins.push_back(RelationRuntimeCache::JoinSample{
-        join_label, join_strategy_name(plan.strategy), left_rel.rows.size(), right_rel.rows.size(),
-        next.rows.size(), pairs_evaluated});
+        join_label, join_strategy_name(plan.strategy), left_rel.row_count, right_rel.row_count,
+        next.row_count, pairs_evaluated, std::move(join_detail)});
   }
 
   return next;
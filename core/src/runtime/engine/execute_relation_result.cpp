@@ -1,8 +1,11 @@
 #include "markql/markql.h"
 
 #include <chrono>
+#include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "../../util/string_util.h"
 #include "engine_execution_internal.h"
@@ -39,8 +42,15 @@ class ScopedProfileTimer {
   std::chrono::steady_clock::time_point started_at_{};
 };
 
+bool is_core_result_column(const std::string& column) {
+  return column == "node_id" || column == "tag" || column == "text" || column == "inner_html" ||
+         column == "parent_id" || column == "sibling_pos" || column == "max_depth" ||
+         column == "doc_order" || column == "source_uri";
+}
+
+/// Stores `value` in the node field named `column`, or else in computed field `computed_slot`.
 void assign_result_column_value(QueryResultRow& row, const std::string& column,
-                                const std::optional<std::string>& value) {
+                                size_t computed_slot, std::optional<std::string>&& value) {
   if (!value.has_value()) return;
   if (column == "node_id") {
     if (auto parsed = parse_int64_value(*value); parsed.has_value()) row.node_id = *parsed;
@@ -78,13 +88,14 @@ void assign_result_column_value(QueryResultRow& row, const std::string& column,
     row.source_uri = *value;
     return;
   }
-  row.computed_fields[column] = *value;
+  row.computed_fields.set(computed_slot, std::move(*value));
 }
 
 }  // namespace
 
 QueryResult query_result_from_relation(const Query& query, const Relation& relation,
-                                       RelationRuntimeCache::Profile* profile) {
+                                       RelationRuntimeCache::Profile* profile,
+                                       bool node_fields, ResultRowStream* stream) {
   ScopedProfileTimer projection_timer(profile,
                                       profile != nullptr ? &profile->projection_time_ns : nullptr);
   QueryResult out;
@@ -95,26 +106,25 @@ QueryResult query_result_from_relation(const Query& query, const Relation& relat
   out.table_has_header = query.table_has_header;
   out.table_options = to_result_table_options(query.table_options);
   if (query.export_sink.has_value()) {
-    const auto& sink = *query.export_sink;
-    if (sink.kind == Query::ExportSink::Kind::Csv) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Csv;
-    } else if (sink.kind == Query::ExportSink::Kind::Parquet) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Parquet;
-    } else if (sink.kind == Query::ExportSink::Kind::Json) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Json;
-    } else if (sink.kind == Query::ExportSink::Kind::Ndjson) {
-      out.export_sink.kind = QueryResult::ExportSink::Kind::Ndjson;
-    }
-    out.export_sink.path = sink.path;
+    out.export_sink = to_result_export_sink(*query.export_sink);
   }
   out.warnings = relation.warnings;
-  out.rows.reserve(relation.rows.size());
+  auto computed_schema = std::make_shared<ComputedFieldSchema>();
+  out.computed_schema = computed_schema;
+  if (stream == nullptr) out.rows.reserve(relation.row_count);
+  auto emit = [&](QueryResultRow&& row) {
+    if (stream != nullptr) {
+      stream->push(out, std::move(row));
+    } else {
+      out.rows.push_back(std::move(row));
+    }
+  };
 
   for (const auto& item : query.select_items) {
     if (item.aggregate == Query::SelectItem::Aggregate::Count) {
       QueryResultRow row;
-      row.node_id = static_cast<int64_t>(relation.rows.size());
-      out.rows.push_back(std::move(row));
+      row.node_id = static_cast<int64_t>(relation.row_count);
+      emit(std::move(row));
       return out;
     }
   }
@@ -123,86 +133,112 @@ QueryResult query_result_from_relation(const Query& query, const Relation& relat
       query.source.alias.has_value()
           ? std::optional<std::string>(lower_alias_name(*query.source.alias))
           : std::nullopt;
+  RelationScope scope(relation, active_alias);
+  std::vector<uint32_t> cursor(relation.aliases.size(), 0);
+  const RelationRowView row_view{&scope, cursor.data()};
 
   if (!markql_internal::is_projection_query(query)) {
-    for (const auto& rel_row : relation.rows) {
-      const RelationRecord* selected = nullptr;
-      for (const auto& item : query.select_items) {
-        if (item.self_node_projection) {
-          if (active_alias.has_value()) {
-            auto it = rel_row.aliases.find(*active_alias);
-            if (it != rel_row.aliases.end()) {
-              selected = &it->second;
-            }
-          }
-          if (selected == nullptr && !rel_row.aliases.empty()) {
-            selected = &rel_row.aliases.begin()->second;
-          }
-          break;
-        }
-        const std::string tag_or_alias = lower_alias_name(item.tag);
-        if (item.tag == "*") {
-          if (active_alias.has_value()) {
-            auto it = rel_row.aliases.find(*active_alias);
-            if (it != rel_row.aliases.end()) selected = &it->second;
-          }
-          if (selected == nullptr && !rel_row.aliases.empty()) {
-            selected = &rel_row.aliases.begin()->second;
-          }
-          break;
-        }
-        auto alias_it = rel_row.aliases.find(tag_or_alias);
-        if (alias_it != rel_row.aliases.end()) {
-          selected = &alias_it->second;
+    // WHY: the selected alias depends only on the schema unless an item names a tag, which
+    // is matched per row against each alias' tag column.
+    struct ItemChoice {
+      int32_t alias = -1;
+      std::string tag;
+    };
+    std::vector<ItemChoice> choices;
+    for (const auto& item : query.select_items) {
+      ItemChoice choice;
+      if (item.self_node_projection || item.tag == "*") {
+        choice.alias = active_alias.has_value() ? scope.find_alias(*active_alias) : -1;
+        if (choice.alias < 0 && !relation.aliases.empty()) choice.alias = 0;
+        if (choice.alias >= 0) choices.push_back(std::move(choice));
+        break;
+      }
+      choice.tag = lower_alias_name(item.tag);
+      choice.alias = scope.find_alias(choice.tag);
+      const bool fixed = choice.alias >= 0;
+      choices.push_back(std::move(choice));
+      if (fixed) break;
+    }
+    for (size_t r = 0; r < relation.row_count; ++r) {
+      load_relation_row(relation, r, cursor);
+      int32_t selected = -1;
+      for (const auto& choice : choices) {
+        if (choice.alias >= 0) {
+          selected = choice.alias;
           break;
         }
-        for (const auto& alias_entry : rel_row.aliases) {
-          auto tag_it = alias_entry.second.values.find("tag");
-          if (tag_it == alias_entry.second.values.end() || !tag_it->second.has_value()) continue;
-          if (util::to_lower(*tag_it->second) == tag_or_alias) {
-            selected = &alias_entry.second;
-            break;
+        for (size_t a = 0; a < scope.alias_count() && selected < 0; ++a) {
+          const int32_t tag_column = scope.table(a).core_column(RelationCoreColumn::Tag);
+          std::optional<std::string> tag = relation_slot_value(
+              row_view, RelationSlot{static_cast<int32_t>(a), tag_column});
+          if (tag.has_value() && util::to_lower(*tag) == choice.tag) {
+            selected = static_cast<int32_t>(a);
           }
         }
-        if (selected != nullptr) break;
+        if (selected >= 0) break;
       }
-      if (selected == nullptr) continue;
+      if (selected < 0) continue;
       QueryResultRow row;
-      fill_result_core_from_record(row, *selected);
-      out.rows.push_back(std::move(row));
+      fill_result_core_from_row(row, scope.table(selected), cursor[selected]);
+      emit(std::move(row));
     }
     return out;
   }
 
-  for (const auto& rel_row : relation.rows) {
+  struct BoundItem {
+    const Query::SelectItem* item = nullptr;
+    bool by_alias = false;
+    RelationSlot slot;
+    RelationFieldRef field;
+    size_t computed_slot = ComputedFieldSchema::npos;
+  };
+  std::vector<BoundItem> bound_items;
+  bound_items.reserve(query.select_items.size());
+  for (const auto& item : query.select_items) {
+    if (!item.field.has_value()) continue;
+    BoundItem bound;
+    bound.item = &item;
+    if (!is_core_result_column(*item.field)) {
+      bound.computed_slot = computed_schema->add(*item.field);
+    }
+    const bool evaluates_expr =
+        item.expr_projection && (item.expr.has_value() || item.project_expr.has_value());
+    if (!evaluates_expr) {
+      const int32_t alias = scope.find_alias(lower_alias_name(item.tag));
+      if (alias >= 0) {
+        bound.by_alias = true;
+        bound.slot = RelationSlot{alias, scope.table(alias).find_column(*item.field)};
+      } else {
+        bound.field = scope.bind_field(*item.field);
+      }
+    }
+    bound_items.push_back(std::move(bound));
+  }
+
+  const int32_t seed_alias = node_fields ? scope.default_alias() : -1;
+  for (size_t r = 0; r < relation.row_count; ++r) {
+    load_relation_row(relation, r, cursor);
     QueryResultRow row;
-    const RelationRecord* seed = resolve_record(rel_row, std::nullopt, active_alias);
-    if (seed != nullptr) {
-      fill_result_core_from_record(row, *seed);
+    row.computed_fields = ComputedFields(computed_schema);
+    if (seed_alias >= 0) {
+      fill_result_core_from_row(row, scope.table(seed_alias), cursor[seed_alias]);
     }
-    for (const auto& item : query.select_items) {
-      if (!item.field.has_value()) continue;
+    for (const auto& bound : bound_items) {
+      const Query::SelectItem& item = *bound.item;
       std::optional<std::string> value;
       if (item.expr_projection && item.expr.has_value()) {
-        value = eval_relation_scalar_expr(*item.expr, rel_row, active_alias, profile);
+        value = eval_relation_scalar_expr(*item.expr, row_view, profile).to_text();
       } else if (item.expr_projection && item.project_expr.has_value()) {
-        value = eval_relation_project_expr(*item.project_expr, rel_row, active_alias,
-                                           row.computed_fields, profile);
+        value =
+            eval_relation_project_expr(*item.project_expr, row_view, row.computed_fields, profile);
+      } else if (bound.by_alias) {
+        value = relation_slot_value(row_view, bound.slot);
       } else {
-        const std::string lowered_tag = lower_alias_name(item.tag);
-        auto it = rel_row.aliases.find(lowered_tag);
-        if (it != rel_row.aliases.end()) {
-          auto value_it = it->second.values.find(*item.field);
-          if (value_it != it->second.values.end()) {
-            value = value_it->second;
-          }
-        } else {
-          value = relation_field_by_name(rel_row, *item.field, active_alias);
-        }
+        value = relation_field_value(row_view, bound.field);
       }
-      assign_result_column_value(row, *item.field, value);
+      assign_result_column_value(row, *item.field, bound.computed_slot, std::move(value));
     }
-    out.rows.push_back(std::move(row));
+    emit(std::move(row));
   }
   return out;
 }
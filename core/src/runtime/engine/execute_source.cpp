@@ -49,7 +49,8 @@ QueryResult build_count_star_result(const Query& query, int64_t count,
 
 QueryResult execute_query_with_source_legacy(const Query& query, const std::string* default_html,
                                              const HtmlDocument* default_document,
-                                             const std::string& default_source_uri) {
+                                             const std::string& default_source_uri,
+                                             ResultRowStream* stream) {
   std::string effective_source_uri = default_source_uri;
   if (is_plain_count_star_document_query(query)) {
     // WHY: COUNT(*) FROM doc does not need per-node inner_html/text materialization.
@@ -64,7 +65,7 @@ QueryResult execute_query_with_source_legacy(const Query& query, const std::stri
     }
     HtmlDocument doc = parse_html(query.source.value);
     effective_source_uri = "raw";
-    return execute_query_ast(query, doc, effective_source_uri);
+    return execute_query_ast(query, doc, effective_source_uri, stream);
   }
   if (query.source.kind == Source::Kind::Parse) {
     FragmentSource fragments;
@@ -98,26 +99,32 @@ QueryResult execute_query_with_source_legacy(const Query& query, const std::stri
     }
     HtmlDocument doc = build_fragments_document(fragments);
     effective_source_uri = "parse";
-    return execute_query_ast(query, doc, effective_source_uri);
+    return execute_query_ast(query, doc, effective_source_uri, stream);
   }
-  HtmlDocument doc = default_document != nullptr ? *default_document : parse_html(*default_html);
-  return execute_query_ast(query, doc, effective_source_uri);
+  if (default_document != nullptr) {
+    // The caller owns the parsed document for the whole statement; read it in place.
+    return execute_query_ast(query, *default_document, effective_source_uri, stream);
+  }
+  return execute_query_ast(query, parse_html(*default_html), effective_source_uri, stream);
 }
 
 /// Executes a parsed query over provided HTML and assembles QueryResult.
 /// MUST apply validation before execution and MUST propagate errors as exceptions.
-/// Inputs are HTML/source/query; outputs are QueryResult with no side effects.
+/// Inputs are HTML/source/query; rows go to `sink` when given, else into the result.
 QueryResult execute_query_from_html(const std::string& html, const std::string& source_uri,
-                                    const std::string& query) {
+                                    const std::string& query, QueryResultSink* sink = nullptr) {
   auto parsed = parse_query(query);
   if (!parsed.query.has_value()) {
     throw std::runtime_error("Query parse error: " + parsed.error->message);
   }
   validate_query_for_execution(*parsed.query);
-  if (parsed.query->kind != Query::Kind::Select) {
-    return execute_meta_query(*parsed.query, source_uri);
-  }
-  return execute_query_with_source(*parsed.query, &html, nullptr, source_uri);
+  ResultRowStream stream(sink);
+  QueryResult out = parsed.query->kind != Query::Kind::Select
+                        ? execute_meta_query(*parsed.query, source_uri)
+                        : execute_query_with_source(*parsed.query, &html, nullptr, source_uri,
+                                                    sink != nullptr ? &stream : nullptr);
+  stream.finish(out);
+  return out;
 }
 
 /// Executes a query over in-memory HTML with document as the source label.
@@ -127,6 +134,11 @@ QueryResult execute_query_from_document(const std::string& html, const std::stri
   return execute_query_from_html(html, "document", query);
 }
 
+QueryResult execute_query_from_document(const std::string& html, const std::string& query,
+                                        QueryResultSink& sink) {
+  return execute_query_from_html(html, "document", query, &sink);
+}
+
 /// Executes a query over a file and uses the path as source label.
 /// MUST read from disk and MUST propagate IO failures as exceptions.
 /// Inputs are path/query; outputs are QueryResult with file IO side effects.
@@ -135,6 +147,12 @@ QueryResult execute_query_from_file(const std::string& path, const std::string&
   return execute_query_from_html(html, path, query);
 }
 
+QueryResult execute_query_from_file(const std::string& path, const std::string& query,
+                                    QueryResultSink& sink) {
+  std::string html = markql_internal::read_file(path);
+  return execute_query_from_html(html, path, query, &sink);
+}
+
 /// Executes a query over a URL and uses the URL as source label.
 /// MUST honor timeout_ms and MUST propagate network failures as exceptions.
 /// Inputs are url/query/timeout; outputs are QueryResult with network side effects.
@@ -144,4 +162,10 @@ QueryResult execute_query_from_url(const std::string& url, const std::string& qu
   return execute_query_from_html(html, url, query);
 }
 
+QueryResult execute_query_from_url(const std::string& url, const std::string& query,
+                                   int timeout_ms, QueryResultSink& sink) {
+  std::string html = markql_internal::fetch_url(url, timeout_ms);
+  return execute_query_from_html(html, url, query, &sink);
+}
+
 }  // namespace markql
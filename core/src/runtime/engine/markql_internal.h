@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "../../dom/html_parser.h"
@@ -80,7 +81,7 @@ bool has_inner_html_auto_depth(const Query& query);
 /// Computes TFIDF term scores per node for TFIDF() queries.
 /// MUST return rows with term score dictionaries for each matched node.
 std::vector<QueryResultRow> build_tfidf_rows(const Query& query,
-                                             const std::vector<HtmlNode>& nodes);
+                                             const std::vector<const HtmlNode*>& nodes);
 
 /// Builds a child adjacency list for efficient tree traversal.
 /// MUST preserve node order and MUST size the vector to doc.nodes.
@@ -91,6 +92,34 @@ std::vector<std::vector<int64_t>> build_children(const HtmlDocument& doc);
 /// Inputs are doc/children/table_id; outputs are row vectors.
 void collect_rows(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
                   int64_t table_id, std::vector<std::vector<std::string>>& out_rows);
+/// Reads a table's rows one at a time with collect_rows' cells and skipping rules.
+/// MUST yield the same rows in the same order as collect_rows.
+/// Holds only the walk's ancestor path, so a table can be read again without keeping its rows.
+class TableRowReader {
+ public:
+  TableRowReader(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
+                 int64_t table_id);
+
+  /// Starts again from the table's first row.
+  void rewind();
+  /// Replaces `row` with the next row's cells; false after the last row.
+  bool next(std::vector<std::string>& row);
+  /// Like next(), but only counts the cells, without copying their text.
+  bool next_width(size_t& width);
+
+ private:
+  bool next_tr(int64_t& tr_id);
+  /// Calls `fn` with each td/th of `tr_id` in document order.
+  template <typename Fn>
+  void for_each_cell(int64_t tr_id, Fn&& fn);
+
+  const HtmlDocument& doc_;
+  const std::vector<std::vector<int64_t>>& children_;
+  int64_t table_id_;
+  /// Nodes on the way from the table down, each with the index of its next child to visit.
+  std::vector<std::pair<int64_t, size_t>> path_;
+  std::vector<std::pair<int64_t, size_t>> cell_path_;
+};
 /// Limits inner_html content to a maximum nesting depth.
 /// MUST preserve tag balance up to max_depth and MUST be deterministic.
 /// Inputs are HTML and depth; outputs are truncated HTML strings.
@@ -0,0 +1,147 @@
+#include "relation_runtime_internal.h"
+
+#include "engine_execution_internal.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace markql {
+
+namespace {
+
+constexpr size_t kDefaultRelationCacheBytes = size_t{64} << 20;
+
+size_t relation_cache_capacity_bytes() {
+  static const size_t capacity = []() -> size_t {
+    if (const char* env = std::getenv("MARKQL_REL_CACHE_MB"); env != nullptr && *env != '\0') {
+      return static_cast<size_t>(std::strtoull(env, nullptr, 10)) << 20;
+    }
+    return kDefaultRelationCacheBytes;
+  }();
+  return capacity;
+}
+
+size_t lookup_index_bytes(const RelationLookupIndex& index) {
+  size_t bytes = sizeof(RelationLookupIndex) + index.bucket_count() * sizeof(void*);
+  for (const auto& [key, rows] : index) {
+    // Node, hash and next pointer per entry, plus heap storage beyond the small-string buffer.
+    bytes += sizeof(RelationLookupIndex::value_type) + 2 * sizeof(void*);
+    if (key.capacity() > sizeof(std::string)) bytes += key.capacity();
+    bytes += rows.capacity() * sizeof(size_t);
+  }
+  return bytes;
+}
+
+size_t table_bytes(const RelationTable& table) {
+  // WHY: only document-backed tables are cached here; they hold one node index per row and
+  // read every cell from the shared DOM, which the prepared document already owns.
+  return sizeof(RelationTable) + table.row_count() * sizeof(uint32_t) +
+         table.column_count() * 64;
+}
+
+bool source_reads_document_only(const Source& source) {
+  if (source.kind == Source::Kind::Path || source.kind == Source::Kind::Url) return false;
+  if (source.parse_query != nullptr && !relation_query_reads_document_only(*source.parse_query)) {
+    return false;
+  }
+  return source.derived_query == nullptr ||
+         relation_query_reads_document_only(*source.derived_query);
+}
+
+}  // namespace
+
+RelationDocumentCache::RelationDocumentCache(const HtmlDocument& doc, size_t capacity_bytes)
+    : doc_(doc), capacity_bytes_(capacity_bytes) {}
+
+std::shared_ptr<const RelationDocument> RelationDocumentCache::document() {
+  std::call_once(document_once_, [&]() {
+    // The prepared handle owns the DOM and this cache; borrow it without copying.
+    document_ = make_relation_document(
+        std::shared_ptr<const HtmlDocument>(std::shared_ptr<const HtmlDocument>(), &doc_));
+  });
+  return document_;
+}
+
+RelationDocumentCache::Entry* RelationDocumentCache::find_locked(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return &*it->second;
+}
+
+RelationDocumentCache::Entry& RelationDocumentCache::insert_locked(Entry entry) {
+  if (auto it = entries_.find(entry.key); it != entries_.end()) return *it->second;
+  lru_.push_front(std::move(entry));
+  Entry& inserted = lru_.front();
+  entries_.emplace(inserted.key, lru_.begin());
+  stats_.bytes += inserted.bytes;
+  while (stats_.bytes > capacity_bytes_ && lru_.size() > 1) {
+    Entry& victim = lru_.back();
+    stats_.bytes -= victim.bytes;
+    entries_.erase(victim.key);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+  return inserted;
+}
+
+std::shared_ptr<const RelationLookupIndex> RelationDocumentCache::find_index(
+    const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = find_locked(key);
+  return entry != nullptr ? entry->index : nullptr;
+}
+
+std::shared_ptr<const RelationTable> RelationDocumentCache::find_table(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = find_locked(key);
+  return entry != nullptr ? entry->table : nullptr;
+}
+
+std::shared_ptr<const RelationLookupIndex> RelationDocumentCache::insert_index(
+    const std::string& key, std::shared_ptr<const RelationLookupIndex> index) {
+  const size_t bytes = key.size() + lookup_index_bytes(*index);
+  if (bytes > capacity_bytes_) return index;
+  std::lock_guard<std::mutex> lock(mutex_);
+  return insert_locked(Entry{key, std::move(index), nullptr, bytes}).index;
+}
+
+std::shared_ptr<const RelationTable> RelationDocumentCache::insert_table(
+    const std::string& key, std::shared_ptr<const RelationTable> table) {
+  const size_t bytes = key.size() + table_bytes(*table);
+  if (bytes > capacity_bytes_) return table;
+  std::lock_guard<std::mutex> lock(mutex_);
+  return insert_locked(Entry{key, nullptr, std::move(table), bytes}).table;
+}
+
+RelationDocumentCache::Stats RelationDocumentCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats out = stats_;
+  out.entries = lru_.size();
+  return out;
+}
+
+bool relation_query_reads_document_only(const Query& query) {
+  if (query.with.has_value()) {
+    for (const auto& cte : query.with->ctes) {
+      if (cte.query != nullptr && !relation_query_reads_document_only(*cte.query)) return false;
+    }
+  }
+  if (!source_reads_document_only(query.source)) return false;
+  for (const auto& join : query.joins) {
+    if (!source_reads_document_only(join.right_source)) return false;
+  }
+  return true;
+}
+
+std::shared_ptr<RelationDocumentCache> make_relation_document_cache(const HtmlDocument& doc) {
+  return std::make_shared<RelationDocumentCache>(doc, relation_cache_capacity_bytes());
+}
+
+}  // namespace markql
@@ -0,0 +1,212 @@
+#include "relation_runtime_internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace markql {
+
+namespace {
+
+constexpr uint32_t kNoGroup = UINT32_MAX;
+constexpr size_t kRadixBits = 6;
+constexpr size_t kRadixPartitions = size_t{1} << kRadixBits;
+
+uint64_t hash_join_key(int64_t key) {
+  // WHY: node ids are dense and sequential; a multiplicative mix spreads them over both the
+  // partition bits (top) and the slot bits (bottom) instead of clustering runs of slots.
+  uint64_t x = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+  return x ^ (x >> 29);
+}
+
+/// Open-addressing (linear probing) table from int64 key to a dense group id.
+/// Groups list their build rows in CSR order, ascending by row.
+class FlatInt64Index {
+ public:
+  /// Indexes `rows` (build-side row ids, ascending) whose keys are keys[row].
+  FlatInt64Index(const std::vector<int64_t>& keys, const std::vector<uint32_t>& rows) {
+    size_t capacity = 16;
+    while (capacity < rows.size() * 2) capacity <<= 1;
+    mask_ = capacity - 1;
+    slot_keys_.resize(capacity);
+    slot_groups_.assign(capacity, kNoGroup);
+    std::vector<uint32_t> row_groups(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const int64_t key = keys[rows[i]];
+      size_t slot = hash_join_key(key) & mask_;
+      while (slot_groups_[slot] != kNoGroup && slot_keys_[slot] != key) {
+        slot = (slot + 1) & mask_;
+      }
+      if (slot_groups_[slot] == kNoGroup) {
+        slot_keys_[slot] = key;
+        slot_groups_[slot] = static_cast<uint32_t>(group_offsets_.size());
+        group_offsets_.push_back(0);
+      }
+      row_groups[i] = slot_groups_[slot];
+      ++group_offsets_[row_groups[i]];
+    }
+    uint32_t running = 0;
+    for (uint32_t& offset : group_offsets_) {
+      const uint32_t count = offset;
+      offset = running;
+      running += count;
+    }
+    group_offsets_.push_back(running);
+    group_rows_.resize(rows.size());
+    std::vector<uint32_t> fill(group_offsets_.begin(), group_offsets_.end() - 1);
+    for (size_t i = 0; i < rows.size(); ++i) group_rows_[fill[row_groups[i]]++] = rows[i];
+  }
+
+  /// Calls fn(build_row) for every build row whose key equals `key`.
+  template <typename Fn>
+  void for_each_match(int64_t key, Fn&& fn) const {
+    size_t slot = hash_join_key(key) & mask_;
+    while (slot_groups_[slot] != kNoGroup) {
+      if (slot_keys_[slot] == key) {
+        const uint32_t group = slot_groups_[slot];
+        for (uint32_t i = group_offsets_[group]; i < group_offsets_[group + 1]; ++i) {
+          fn(group_rows_[i]);
+        }
+        return;
+      }
+      slot = (slot + 1) & mask_;
+    }
+  }
+
+ private:
+  size_t mask_ = 0;
+  std::vector<int64_t> slot_keys_;
+  std::vector<uint32_t> slot_groups_;
+  std::vector<uint32_t> group_offsets_;
+  std::vector<uint32_t> group_rows_;
+};
+
+struct SidedKeys {
+  const RelationJoinKeys* keys = nullptr;
+  std::vector<uint32_t> int_rows;
+  std::vector<uint32_t> text_rows;
+};
+
+SidedKeys split_keys(const RelationJoinKeys& keys) {
+  SidedKeys out;
+  out.keys = &keys;
+  for (size_t row = 0; row < keys.kinds.size(); ++row) {
+    if (keys.kinds[row] == RelationJoinKeys::Kind::Int) {
+      out.int_rows.push_back(static_cast<uint32_t>(row));
+    } else if (keys.kinds[row] == RelationJoinKeys::Kind::Text) {
+      out.text_rows.push_back(static_cast<uint32_t>(row));
+    }
+  }
+  return out;
+}
+
+using MatchPairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+/// Builds on `build_rows` and probes with `probe_rows`, appending (probe_row, build_row) pairs.
+void join_int_rows(const RelationJoinKeys& build, const std::vector<uint32_t>& build_rows,
+                   const RelationJoinKeys& probe, const std::vector<uint32_t>& probe_rows,
+                   MatchPairs& out) {
+  if (build_rows.empty() || probe_rows.empty()) return;
+  FlatInt64Index index(build.ints, build_rows);
+  for (uint32_t probe_row : probe_rows) {
+    index.for_each_match(probe.ints[probe_row],
+                         [&](uint32_t build_row) { out.emplace_back(probe_row, build_row); });
+  }
+}
+
+/// Radix-partitions both integer key sets by hash and joins partitions on worker threads.
+std::vector<MatchPairs> join_int_rows_partitioned(const SidedKeys& build, const SidedKeys& probe,
+                                                  size_t threads) {
+  auto partition = [](const SidedKeys& side) {
+    std::vector<std::vector<uint32_t>> parts(kRadixPartitions);
+    for (uint32_t row : side.int_rows) {
+      parts[hash_join_key(side.keys->ints[row]) >> (64 - kRadixBits)].push_back(row);
+    }
+    return parts;
+  };
+  const std::vector<std::vector<uint32_t>> build_parts = partition(build);
+  const std::vector<std::vector<uint32_t>> probe_parts = partition(probe);
+  std::vector<MatchPairs> results(kRadixPartitions);
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t part = next++; part < kRadixPartitions; part = next++) {
+      join_int_rows(*build.keys, build_parts[part], *probe.keys, probe_parts[part],
+                    results[part]);
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+  worker();
+  for (auto& thread : pool) thread.join();
+  return results;
+}
+
+void join_text_rows(const SidedKeys& build, const SidedKeys& probe, MatchPairs& out) {
+  if (build.text_rows.empty() || probe.text_rows.empty()) return;
+  std::unordered_map<std::string_view, std::vector<uint32_t>> index;
+  index.reserve(build.text_rows.size());
+  for (uint32_t row : build.text_rows) index[*build.keys->texts[row]].push_back(row);
+  for (uint32_t probe_row : probe.text_rows) {
+    auto it = index.find(*probe.keys->texts[probe_row]);
+    if (it == index.end()) continue;
+    for (uint32_t build_row : it->second) out.emplace_back(probe_row, build_row);
+  }
+}
+
+}  // namespace
+
+RelationJoinMatches relation_hash_join(const RelationJoinKeys& left,
+                                       const RelationJoinKeys& right) {
+  SidedKeys left_keys = split_keys(left);
+  SidedKeys right_keys = split_keys(right);
+  RelationJoinMatches matches;
+  const size_t left_count = left_keys.int_rows.size() + left_keys.text_rows.size();
+  const size_t right_count = right_keys.int_rows.size() + right_keys.text_rows.size();
+  matches.built_on_left = left_count < right_count;
+  const SidedKeys& build = matches.built_on_left ? left_keys : right_keys;
+  const SidedKeys& probe = matches.built_on_left ? right_keys : left_keys;
+
+  std::vector<MatchPairs> batches;
+  const size_t int_rows = build.int_rows.size() + probe.int_rows.size();
+  if (int_rows >= kRelationRadixJoinRows) {
+    // WHY: each partition's table stays cache-sized even on one core; threads leased from the
+    // relation budget join partitions concurrently, so joins inside concurrent CTEs share it.
+    RelationWorkerLease lease(kRadixPartitions);
+    batches = join_int_rows_partitioned(build, probe, lease.threads());
+    matches.partitions = kRadixPartitions;
+  } else {
+    batches.emplace_back();
+    join_int_rows(*build.keys, build.int_rows, *probe.keys, probe.int_rows, batches.back());
+  }
+  batches.emplace_back();
+  join_text_rows(build, probe, batches.back());
+
+  // WHY: callers emit in left-row order with right rows ascending, like the nested loop. All
+  // matches of one key come from one batch in probe-row order with build rows ascending, so a
+  // stable counting sort by left row yields that order for either build side.
+  const size_t left_rows = left.kinds.size();
+  matches.offsets.assign(left_rows + 1, 0);
+  size_t total = 0;
+  for (const MatchPairs& batch : batches) {
+    total += batch.size();
+    for (const auto& [probe_row, build_row] : batch) {
+      ++matches.offsets[(matches.built_on_left ? build_row : probe_row) + 1];
+    }
+  }
+  for (size_t i = 0; i < left_rows; ++i) matches.offsets[i + 1] += matches.offsets[i];
+  matches.right_rows.resize(total);
+  std::vector<uint32_t> fill(matches.offsets.begin(), matches.offsets.end() - 1);
+  for (const MatchPairs& batch : batches) {
+    for (const auto& [probe_row, build_row] : batch) {
+      const uint32_t left_row = matches.built_on_left ? build_row : probe_row;
+      const uint32_t right_row = matches.built_on_left ? probe_row : build_row;
+      matches.right_rows[fill[left_row]++] = right_row;
+    }
+  }
+  return matches;
+}
+
+}  // namespace markql
@@ -0,0 +1,460 @@
+#include "relation_runtime_internal.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../util/string_util.h"
+#include "markql_internal.h"
+
+namespace markql {
+
+namespace {
+
+void split_conjuncts(const Expr& expr, std::vector<const Expr*>& out) {
+  if (std::holds_alternative<std::shared_ptr<BinaryExpr>>(expr)) {
+    const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+    if (bin.op == BinaryExpr::Op::And) {
+      split_conjuncts(bin.left, out);
+      split_conjuncts(bin.right, out);
+      return;
+    }
+  }
+  out.push_back(&expr);
+}
+
+/// Aliases one conjunct reads. A conjunct that is not `pinned` can also read the default alias
+/// (unqualified operands, SELF, alias-less TEXT() targets) or a subquery, so it stays in place.
+struct ConjunctAliases {
+  std::unordered_set<std::string> names;
+  std::unordered_set<std::string> qualifiers;
+  bool pinned = true;
+};
+
+void collect_conjunct_operand(const Operand& operand, ConjunctAliases& out) {
+  if (!operand.qualifier.has_value()) {
+    out.pinned = false;
+    return;
+  }
+  const std::string name = lower_alias_name(*operand.qualifier);
+  out.names.insert(name);
+  out.qualifiers.insert(name);
+}
+
+void collect_conjunct_scalar(const ScalarExpr& expr, ConjunctAliases& out) {
+  if (expr.kind == ScalarExpr::Kind::Operand) {
+    collect_conjunct_operand(expr.operand, out);
+    return;
+  }
+  if (expr.kind == ScalarExpr::Kind::SelfRef) {
+    out.pinned = false;
+    return;
+  }
+  if (expr.kind != ScalarExpr::Kind::FunctionCall) return;
+  const std::string fn = util::to_upper(expr.function_name);
+  const bool alias_target = fn == "TEXT" || fn == "DIRECT_TEXT" || fn == "INNER_HTML" ||
+                            fn == "RAW_INNER_HTML" || fn == "ATTR";
+  for (size_t i = 0; i < expr.args.size(); ++i) {
+    if (alias_target && i == 0) {
+      // WHY: the target names an alias, or falls back to the default alias's tag otherwise;
+      // only a literal target pins the call to one alias.
+      if (expr.args[0].kind != ScalarExpr::Kind::StringLiteral) {
+        out.pinned = false;
+        continue;
+      }
+      out.names.insert(lower_alias_name(expr.args[0].string_value));
+      continue;
+    }
+    collect_conjunct_scalar(expr.args[i], out);
+  }
+}
+
+ConjunctAliases conjunct_aliases(const Expr& expr) {
+  ConjunctAliases out;
+  std::vector<const Expr*> stack{&expr};
+  while (!stack.empty()) {
+    const Expr& current = *stack.back();
+    stack.pop_back();
+    if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(current)) {
+      out.pinned = false;
+      continue;
+    }
+    if (std::holds_alternative<std::shared_ptr<BinaryExpr>>(current)) {
+      const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(current);
+      stack.push_back(&bin.left);
+      stack.push_back(&bin.right);
+      continue;
+    }
+    const auto& cmp = std::get<CompareExpr>(current);
+    if (cmp.lhs_expr.has_value()) {
+      collect_conjunct_scalar(*cmp.lhs_expr, out);
+    } else {
+      collect_conjunct_operand(cmp.lhs, out);
+    }
+    if (cmp.rhs_expr.has_value()) collect_conjunct_scalar(*cmp.rhs_expr, out);
+    for (const auto& rhs_expr : cmp.rhs_expr_list) collect_conjunct_scalar(rhs_expr, out);
+  }
+  return out;
+}
+
+/// Tracks how consumers read one CTE or derived table: which aliases bind it and whether any
+/// reference can observe more than its projected columns.
+struct NodeFieldUse {
+  std::string cte_name;
+  const Source* derived = nullptr;
+  std::unordered_set<std::string> outputs;
+  std::unordered_set<std::string> aliases;
+  bool observed = false;
+
+  bool binds(const Source& source) const {
+    if (derived != nullptr) return &source == derived;
+    return source.kind == Source::Kind::CteRef && lower_alias_name(source.value) == cte_name;
+  }
+};
+
+bool is_node_field_name(const std::string& name) {
+  return name == "node_id" || name == "tag" || name == "text" || name == "inner_html" ||
+         name == "parent_id" || name == "sibling_pos" || name == "max_depth" ||
+         name == "doc_order" || name == "source_uri";
+}
+
+std::string operand_column_name(const Operand& operand) {
+  switch (operand.field_kind) {
+    case Operand::FieldKind::Attribute:
+      return operand.attribute;
+    case Operand::FieldKind::Tag:
+      return "tag";
+    case Operand::FieldKind::Text:
+      return "text";
+    case Operand::FieldKind::NodeId:
+      return "node_id";
+    case Operand::FieldKind::ParentId:
+      return "parent_id";
+    case Operand::FieldKind::SiblingPos:
+      return "sibling_pos";
+    case Operand::FieldKind::MaxDepth:
+      return "max_depth";
+    case Operand::FieldKind::DocOrder:
+      return "doc_order";
+    case Operand::FieldKind::AttributesMap:
+      break;
+  }
+  return std::string();
+}
+
+/// Calls fn(query) for every subquery nested directly in `query`.
+template <typename Fn>
+void for_each_subquery(const Query& query, bool include_with, Fn&& fn) {
+  if (include_with && query.with.has_value()) {
+    for (const auto& cte : query.with->ctes) {
+      if (cte.query != nullptr) fn(*cte.query);
+    }
+  }
+  auto visit_source = [&](const Source& source) {
+    if (source.parse_query != nullptr) fn(*source.parse_query);
+    if (source.derived_query != nullptr) fn(*source.derived_query);
+  };
+  visit_source(query.source);
+  for (const auto& join : query.joins) visit_source(join.right_source);
+}
+
+void collect_node_field_aliases(const Query& query, bool include_with, NodeFieldUse& use) {
+  if (include_with && query.with.has_value() && use.derived == nullptr) {
+    for (const auto& cte : query.with->ctes) {
+      // WHY: a nested WITH may shadow the name; give up rather than track scopes.
+      if (lower_alias_name(cte.name) == use.cte_name) use.observed = true;
+    }
+  }
+  if (use.binds(query.source)) use.aliases.insert(source_alias_name(query.source));
+  for (const auto& join : query.joins) {
+    if (use.binds(join.right_source)) use.aliases.insert(source_alias_name(join.right_source));
+  }
+  for_each_subquery(query, include_with, [&](const Query& sub) {
+    collect_node_field_aliases(sub, true, use);
+  });
+}
+
+void check_node_field_column(const std::string& column, NodeFieldUse& use) {
+  if (use.outputs.count(column) == 0) use.observed = true;
+}
+
+/// `default_binds` holds when unqualified operands resolve to the tracked relation.
+void check_node_field_operand(const Operand& operand, bool default_binds, NodeFieldUse& use) {
+  if (operand.qualifier.has_value()) {
+    if (use.aliases.count(lower_alias_name(*operand.qualifier)) == 0) return;
+  } else if (!default_binds) {
+    return;
+  }
+  if (operand.axis != Operand::Axis::Self ||
+      operand.field_kind == Operand::FieldKind::AttributesMap) {
+    use.observed = true;
+    return;
+  }
+  check_node_field_column(operand_column_name(operand), use);
+}
+
+void check_node_field_scalar(const ScalarExpr& expr, bool default_binds, NodeFieldUse& use) {
+  if (expr.kind == ScalarExpr::Kind::Operand) {
+    check_node_field_operand(expr.operand, default_binds, use);
+    return;
+  }
+  if (expr.kind != ScalarExpr::Kind::FunctionCall) return;
+  const std::string fn = util::to_upper(expr.function_name);
+  const bool alias_target = fn == "TEXT" || fn == "DIRECT_TEXT" || fn == "INNER_HTML" ||
+                            fn == "RAW_INNER_HTML" || fn == "ATTR";
+  for (size_t i = 0; i < expr.args.size(); ++i) {
+    if (alias_target && i == 0) {
+      // WHY: these read node fields of the alias they name, or of the default alias when the
+      // target names a tag instead.
+      const ScalarExpr& target = expr.args[0];
+      if (target.kind == ScalarExpr::Kind::StringLiteral) {
+        if (default_binds || use.aliases.count(lower_alias_name(target.string_value)) != 0) {
+          use.observed = true;
+        }
+      } else if (default_binds || !use.aliases.empty()) {
+        use.observed = true;
+      }
+      continue;
+    }
+    check_node_field_scalar(expr.args[i], default_binds, use);
+  }
+}
+
+void check_node_field_expr(const Expr& expr, bool default_binds, NodeFieldUse& use) {
+  if (std::holds_alternative<CompareExpr>(expr)) {
+    const auto& cmp = std::get<CompareExpr>(expr);
+    if (cmp.lhs_expr.has_value()) {
+      check_node_field_scalar(*cmp.lhs_expr, default_binds, use);
+    } else {
+      check_node_field_operand(cmp.lhs, default_binds, use);
+    }
+    if (cmp.rhs_expr.has_value()) check_node_field_scalar(*cmp.rhs_expr, default_binds, use);
+    for (const auto& rhs : cmp.rhs_expr_list) check_node_field_scalar(rhs, default_binds, use);
+    return;
+  }
+  if (std::holds_alternative<std::shared_ptr<BinaryExpr>>(expr)) {
+    const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+    check_node_field_expr(bin.left, default_binds, use);
+    check_node_field_expr(bin.right, default_binds, use);
+  }
+}
+
+/// `seed_needed` holds when the query's own result rows must keep the node fields they seed
+/// from their FROM row; `in_scope` when an enclosing query already binds the tracked relation.
+void check_node_field_query(const Query& query, bool include_with, bool seed_needed,
+                            bool in_scope, NodeFieldUse& use) {
+  const bool from_binds = use.binds(query.source);
+  bool binds = from_binds;
+  for (const auto& join : query.joins) binds = binds || use.binds(join.right_source);
+  in_scope = in_scope || binds;
+  if (from_binds && seed_needed) use.observed = true;
+  if (binds) {
+    // WHY: node-shaped results and column names that alias a node field read the seeded row
+    // rather than a projected column.
+    if (!markql_internal::is_projection_query(query)) use.observed = true;
+    if (from_binds) {
+      for (const auto& column : markql_internal::build_columns(query)) {
+        if (is_node_field_name(column)) use.observed = true;
+      }
+    }
+  }
+  if (in_scope) {
+    std::unordered_set<std::string> query_aliases{source_alias_name(query.source)};
+    for (const auto& join : query.joins) {
+      query_aliases.insert(source_alias_name(join.right_source));
+    }
+    for (const auto& item : query.select_items) {
+      if (item.aggregate != Query::SelectItem::Aggregate::None || item.flatten_text ||
+          item.flatten_extract || item.self_node_projection || item.text_function ||
+          item.inner_html_function || item.raw_inner_html_function || item.tag == "*" ||
+          item.project_expr.has_value()) {
+        use.observed = true;
+        continue;
+      }
+      if (item.expr_projection && item.expr.has_value()) continue;
+      if (!item.field.has_value()) continue;
+      const std::string tag = lower_alias_name(item.tag);
+      // WHY: a field not qualified by another alias binds to whichever alias carries it.
+      if (use.aliases.count(tag) != 0 || query_aliases.count(tag) == 0) {
+        check_node_field_column(*item.field, use);
+      }
+    }
+    for (const auto& order : query.order_by) {
+      const size_t dot = order.field.find('.');
+      if (dot == std::string::npos) {
+        check_node_field_column(order.field, use);
+      } else if (use.aliases.count(lower_alias_name(order.field.substr(0, dot))) != 0) {
+        check_node_field_column(order.field.substr(dot + 1), use);
+      }
+    }
+  }
+  for (const auto& item : query.select_items) {
+    if (item.expr.has_value()) check_node_field_scalar(*item.expr, from_binds, use);
+  }
+  for (const auto& join : query.joins) {
+    if (join.on.has_value()) check_node_field_expr(*join.on, from_binds, use);
+  }
+  if (query.where.has_value()) check_node_field_expr(*query.where, from_binds, use);
+  if (query.source.parse_expr != nullptr) {
+    check_node_field_scalar(*query.source.parse_expr, from_binds, use);
+  }
+  for (const auto& join : query.joins) {
+    if (join.right_source.parse_expr != nullptr) {
+      check_node_field_scalar(*join.right_source.parse_expr, from_binds, use);
+    }
+  }
+  for_each_subquery(query, include_with, [&](const Query& sub) {
+    // The producer's own body reads its sources, not its output.
+    if (use.derived != nullptr && &sub == use.derived->derived_query.get()) return;
+    check_node_field_query(sub, true, true, in_scope, use);
+  });
+}
+
+/// Projected output columns of `producer`, or nullopt when its rows are node-shaped.
+std::optional<std::unordered_set<std::string>> projected_columns(const Query& producer) {
+  if (!markql_internal::is_projection_query(producer)) return std::nullopt;
+  for (const auto& item : producer.select_items) {
+    if (item.aggregate != Query::SelectItem::Aggregate::None || item.flatten_text ||
+        item.flatten_extract) {
+      return std::nullopt;
+    }
+  }
+  const std::vector<std::string> columns = markql_internal::build_columns(producer);
+  return std::unordered_set<std::string>(columns.begin(), columns.end());
+}
+
+}  // namespace
+
+std::string source_alias_name(const Source& source) {
+  if (source.alias.has_value()) return lower_alias_name(*source.alias);
+  if (source.kind == Source::Kind::CteRef) return lower_alias_name(source.value);
+  return std::string();
+}
+
+Expr conjoin_exprs(const std::vector<const Expr*>& conjuncts) {
+  Expr out = *conjuncts.front();
+  for (size_t i = 1; i < conjuncts.size(); ++i) {
+    auto bin = std::make_shared<BinaryExpr>();
+    bin->op = BinaryExpr::Op::And;
+    bin->left = std::move(out);
+    bin->right = *conjuncts[i];
+    out = std::move(bin);
+  }
+  return out;
+}
+
+RelationPushdownPlan plan_conjunct_pushdown(const Expr& expr,
+                                            const std::vector<std::string>& names,
+                                            const std::vector<bool>& pushable,
+                                            const std::vector<std::string>& outer) {
+  RelationPushdownPlan plan;
+  plan.pushed.resize(names.size());
+  split_conjuncts(expr, plan.residual);
+  std::unordered_map<std::string, size_t> bound;
+  for (const auto& name : names) {
+    if (!name.empty()) ++bound[name];
+  }
+  for (const auto& name : outer) ++bound[name];
+  std::vector<ConjunctAliases> aliases;
+  aliases.reserve(plan.residual.size());
+  for (const Expr* conjunct : plan.residual) {
+    aliases.push_back(conjunct_aliases(*conjunct));
+    // WHY: an unknown qualifier must still raise its binding error, which filtering the rows
+    // that would reach it first could hide.
+    for (const auto& qualifier : aliases.back().qualifiers) {
+      if (bound.find(qualifier) == bound.end()) return plan;
+    }
+  }
+  std::vector<const Expr*> residual;
+  for (size_t c = 0; c < plan.residual.size(); ++c) {
+    const ConjunctAliases& read = aliases[c];
+    size_t target = names.size();
+    if (read.pinned && read.names.size() == 1) {
+      const std::string& name = *read.names.begin();
+      if (bound[name] == 1) {
+        const auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end()) target = static_cast<size_t>(it - names.begin());
+      }
+    }
+    if (target < names.size() && pushable[target]) {
+      plan.pushed[target].push_back(plan.residual[c]);
+      plan.any_pushed = true;
+    } else {
+      residual.push_back(plan.residual[c]);
+    }
+  }
+  plan.residual = std::move(residual);
+  return plan;
+}
+
+void filter_relation_rows(Relation& rel, const std::vector<const Expr*>& conjuncts,
+                          RelationRuntimeCache::Profile* profile) {
+  if (conjuncts.empty()) return;
+  RelationScope scope(rel, std::nullopt);
+  std::vector<uint32_t> cursor(rel.aliases.size(), 0);
+  std::vector<uint32_t> selection;
+  selection.reserve(rel.row_count);
+  for (size_t i = 0; i < rel.row_count; ++i) {
+    load_relation_row(rel, i, cursor);
+    const RelationRowView view{&scope, cursor.data()};
+    bool keep = true;
+    for (const Expr* conjunct : conjuncts) {
+      if (!eval_relation_expr(*conjunct, view, profile)) {
+        keep = false;
+        break;
+      }
+    }
+    if (keep) selection.push_back(static_cast<uint32_t>(i));
+  }
+  rel.select_rows(selection);
+  rel.cache_key.clear();
+}
+
+std::vector<bool> cte_node_fields_needed(const Query& query, bool query_node_fields) {
+  std::vector<bool> needed;
+  if (!query.with.has_value()) return needed;
+  const auto& ctes = query.with->ctes;
+  needed.assign(ctes.size(), true);
+  // WHY: later CTEs decide first, since a CTE seeded from this one passes its node fields on.
+  for (size_t i = ctes.size(); i-- > 0;) {
+    if (ctes[i].query == nullptr) continue;
+    std::optional<std::unordered_set<std::string>> outputs = projected_columns(*ctes[i].query);
+    if (!outputs.has_value()) continue;
+    NodeFieldUse use;
+    use.cte_name = lower_alias_name(ctes[i].name);
+    use.outputs = std::move(*outputs);
+    for (size_t j = i + 1; j < ctes.size(); ++j) {
+      if (lower_alias_name(ctes[j].name) == use.cte_name) use.observed = true;
+      if (ctes[j].query != nullptr) collect_node_field_aliases(*ctes[j].query, true, use);
+    }
+    collect_node_field_aliases(query, false, use);
+    for (size_t j = i + 1; j < ctes.size(); ++j) {
+      if (ctes[j].query != nullptr) {
+        check_node_field_query(*ctes[j].query, true, needed[j], false, use);
+      }
+    }
+    check_node_field_query(query, false, query_node_fields, false, use);
+    needed[i] = use.observed;
+  }
+  return needed;
+}
+
+bool derived_node_fields_needed(const Query& query, const Source& derived,
+                                bool query_node_fields) {
+  if (derived.derived_query == nullptr) return true;
+  std::optional<std::unordered_set<std::string>> outputs =
+      projected_columns(*derived.derived_query);
+  if (!outputs.has_value()) return true;
+  NodeFieldUse use;
+  use.derived = &derived;
+  use.outputs = std::move(*outputs);
+  collect_node_field_aliases(query, false, use);
+  check_node_field_query(query, false, query_node_fields, false, use);
+  return use.observed;
+}
+
+}  // namespace markql
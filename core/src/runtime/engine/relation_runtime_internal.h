@@ -3,43 +3,480 @@
 #include "markql/markql.h"
 
 #include <optional>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "../../dom/html_parser.h"
 #include "../../lang/markql_parser.h"
+#include "relation_worker_lease.h"
 
 namespace markql {
 
-struct RelationRecord {
-  std::unordered_map<std::string, std::optional<std::string>> values;
-  std::unordered_map<std::string, std::string> attributes;
+class ResultRowStream;
+
+/// Presence of one relation cell: Absent cells were never set for the row (a node without the
+/// attribute), Null cells exist but hold SQL NULL (LEFT JOIN padding, NULL projections).
+enum class RelationCellState : uint8_t { Absent = 0, Null, Value };
+
+/// Core node columns every relation table resolves once so row materialization skips lookups.
+enum class RelationCoreColumn : uint8_t {
+  NodeId = 0,
+  Tag,
+  Text,
+  InnerHtml,
+  ParentId,
+  SiblingPos,
+  MaxDepth,
+  DocOrder,
+  SourceUri,
+  Count
 };
 
-struct RelationRow {
-  std::unordered_map<std::string, RelationRecord> aliases;
+/// A parsed document shared by every document-backed relation table of one statement.
+/// Sibling positions, parent indices, a child index, subtree intervals and the distinct
+/// attribute names are derived once. MUST outlive every table built from it (tables hold a
+/// shared_ptr).
+struct RelationDocument {
+  std::shared_ptr<const HtmlDocument> doc;
+  std::vector<int64_t> sibling_pos;
+  std::vector<int32_t> parent_index;
+  /// Children of node i are child_nodes[child_offsets[i] .. child_offsets[i + 1]), in doc order.
+  std::vector<uint32_t> child_offsets;
+  std::vector<uint32_t> child_nodes;
+  /// Descendants of node i are the indices (i, subtree_end[i]); valid only when `preorder`.
+  std::vector<uint32_t> subtree_end;
+  /// True when every parent precedes its children, so subtree_end describes real subtrees.
+  bool preorder = true;
+  std::vector<std::string> attribute_names;
+
+  /// Maps a node_id value to its node index, or -1 when it names no node of this document.
+  int64_t node_index(int64_t node_id) const {
+    if (node_id < 0 || static_cast<size_t>(node_id) >= doc->nodes.size()) return -1;
+    return doc->nodes[static_cast<size_t>(node_id)].id == node_id ? node_id : -1;
+  }
+  /// True when `descendant` lies strictly inside the subtree of `ancestor`.
+  bool contains(size_t ancestor, size_t descendant) const {
+    return ancestor < descendant && descendant < subtree_end[ancestor];
+  }
+};
+
+/// Derives sibling positions, parent indices and attribute names for `doc`.
+std::shared_ptr<const RelationDocument> make_relation_document(
+    std::shared_ptr<const HtmlDocument> doc);
+
+/// Immutable columnar storage for the rows of one relation alias.
+/// Core and projected columns are dense typed vectors (int64 or string) with a state byte per
+/// row; attribute-like columns that only some rows carry are stored as per-row sparse cells.
+/// Document-backed tables store only node indices and read every cell (core fields, attributes,
+/// parent.*) from the shared DOM when it is touched.
+/// MUST be treated as read-only once built so tables can be shared across relations.
+class RelationTable {
+ public:
+  enum class ColumnKind : uint8_t { Int64, String, Sparse };
+
+  /// Builds a late-materialized table over `nodes` (indices into document->doc->nodes).
+  static std::shared_ptr<const RelationTable> from_document(
+      std::shared_ptr<const RelationDocument> document, std::vector<uint32_t> nodes,
+      std::string source_uri);
+
+  size_t row_count() const { return row_count_; }
+  size_t column_count() const { return columns_.size(); }
+  const std::string& column_name(size_t column) const { return columns_[column].name; }
+  ColumnKind column_kind(size_t column) const { return columns_[column].kind; }
+  /// Returns the column index for `name`, or -1 when no row of the table carries it.
+  int32_t find_column(std::string_view name) const;
+  int32_t core_column(RelationCoreColumn column) const {
+    return core_columns_[static_cast<size_t>(column)];
+  }
+  /// Shared DOM of a document-backed table, or nullptr for materialized tables.
+  const RelationDocument* document() const { return document_.get(); }
+  /// Node index a document-backed row points at.
+  uint32_t node_index(size_t row) const { return document_nodes_[row]; }
+  /// True when an attribute can override core column `column` of a document-backed table.
+  bool column_shadowed(size_t column) const { return columns_[column].doc_shadowed; }
+
+  RelationCellState state(size_t column, size_t row) const;
+  std::optional<std::string> value(size_t column, size_t row) const;
+  /// Returns the stored integer for Int64 columns; string cells are not parsed here.
+  std::optional<int64_t> int_value(size_t column, size_t row) const;
+  /// Returns a pointer to the stored string for String/Sparse cells holding a value.
+  const std::string* string_value(size_t column, size_t row) const;
+
+  /// Visits the row's HTML attributes in their original insertion order.
+  template <typename Fn>
+  void for_each_attribute(size_t row, Fn&& fn) const {
+    if (document_ != nullptr) {
+      for (const auto& attr : document_node(row).attributes) fn(attr.first, attr.second);
+      return;
+    }
+    for (uint32_t i = attribute_offsets_[row]; i < attribute_offsets_[row + 1]; ++i) {
+      fn(columns_[attribute_cells_[i].column].name, attribute_cells_[i].value);
+    }
+  }
+
+ private:
+  friend class RelationTableBuilder;
+
+  struct Column {
+    std::string name;
+    ColumnKind kind = ColumnKind::Sparse;
+    std::vector<RelationCellState> states;
+    std::vector<int64_t> ints;
+    std::vector<std::string> strings;
+    // Document-backed tables only: the node field read (Count means the attribute named
+    // `doc_attribute`), whether it is read from the parent node, and whether an attribute of
+    // the same name overrides the field like it did when rows were materialized.
+    RelationCoreColumn doc_field = RelationCoreColumn::Count;
+    bool doc_parent = false;
+    bool doc_shadowed = false;
+    std::string doc_attribute;
+  };
+
+  struct SparseCell {
+    uint32_t column = 0;
+    RelationCellState state = RelationCellState::Null;
+    std::string value;
+  };
+
+  struct AttributeCell {
+    uint32_t column = 0;
+    std::string value;
+  };
+
+  const SparseCell* find_sparse(size_t column, size_t row) const;
+  const HtmlNode& document_node(size_t row) const {
+    return document_->doc->nodes[document_nodes_[row]];
+  }
+  /// Node a document cell reads from, or nullptr when the row has no parent for parent.*.
+  const HtmlNode* document_target(const Column& col, size_t row) const;
+  /// Attribute value overriding a document cell, if any.
+  const std::string* document_attribute(const Column& col, const HtmlNode& node) const;
+
+  size_t row_count_ = 0;
+  std::vector<Column> columns_;
+  std::unordered_map<std::string, uint32_t> column_index_;
+  std::vector<int32_t> core_columns_ =
+      std::vector<int32_t>(static_cast<size_t>(RelationCoreColumn::Count), -1);
+  std::vector<uint32_t> sparse_offsets_{0};
+  std::vector<SparseCell> sparse_cells_;
+  std::vector<uint32_t> attribute_offsets_{0};
+  std::vector<AttributeCell> attribute_cells_;
+  std::shared_ptr<const RelationDocument> document_;
+  std::vector<uint32_t> document_nodes_;
+  std::string source_uri_;
+};
+
+/// Appends rows to a RelationTable one at a time.
+/// Dense columns are declared up front; unknown names become sparse columns on first use.
+/// Int64 columns fall back to strings when a value does not round-trip through int64.
+class RelationTableBuilder {
+ public:
+  RelationTableBuilder();
+
+  size_t add_dense_column(const std::string& name, RelationTable::ColumnKind kind);
+  /// Declares the dense core node columns (node_id, tag, text, ...) plus their parent.* mirrors
+  /// when `with_parent` is set.
+  void add_core_columns(bool with_parent);
+  size_t column(const std::string& name);
+
+  void begin_row();
+  void set_null(size_t column);
+  void set_int(size_t column, int64_t value);
+  void set_string(size_t column, std::string value);
+  void set_value(size_t column, const std::optional<std::string>& value);
+  /// Records an HTML attribute and its value column for the current row.
+  void add_attribute(size_t column, std::string value);
+  /// Copies one row of `source` into a new row, mapping columns by name.
+  void append_row(const std::shared_ptr<const RelationTable>& source, size_t row);
+
+  std::shared_ptr<const RelationTable> finish();
+
+ private:
+  void demote_to_string(size_t column);
+  RelationTable::SparseCell* current_sparse(size_t column);
+
+  std::shared_ptr<RelationTable> table_;
+  size_t row_start_sparse_ = 0;
+  // WHY: LATERAL appends many rows from the same source table; keep its column map (and the
+  // table alive, so the pointer cannot be recycled) until a different source shows up.
+  std::shared_ptr<const RelationTable> append_source_;
+  std::vector<uint32_t> append_map_;
+};
+
+/// Table row index that pads an alias with NULLs (unmatched LEFT JOIN rows).
+constexpr uint32_t kRelationNullRow = 0xFFFFFFFFu;
+
+/// Selection vector of one alias, shared copy-on-write between relations.
+/// Copying a relation (a CTE reference, an alias rename) shares the rows; the first writer
+/// through mutate() takes a private copy.
+class RelationRows {
+ public:
+  RelationRows() = default;
+  RelationRows(std::vector<uint32_t> rows)  // NOLINT(google-explicit-constructor)
+      : rows_(std::make_shared<std::vector<uint32_t>>(std::move(rows))) {}
+
+  uint32_t operator[](size_t row) const { return (*rows_)[row]; }
+  size_t size() const { return rows_ != nullptr ? rows_->size() : 0; }
+  bool empty() const { return size() == 0; }
+  const uint32_t* begin() const { return rows_ != nullptr ? rows_->data() : nullptr; }
+  const uint32_t* end() const { return begin() + size(); }
+
+  /// Returns the rows for writing, copying them first when another relation shares them.
+  std::vector<uint32_t>& mutate() {
+    if (rows_ == nullptr) {
+      rows_ = std::make_shared<std::vector<uint32_t>>();
+    } else if (rows_.use_count() > 1) {
+      rows_ = std::make_shared<std::vector<uint32_t>>(*rows_);
+    }
+    return *rows_;
+  }
+
+ private:
+  std::shared_ptr<std::vector<uint32_t>> rows_;
+};
+
+/// One alias of a relation: a shared table plus the table row each relation row points at.
+/// Joins, filters and sorts rewrite `rows` (a selection vector) and never copy cell data.
+struct RelationAlias {
+  std::string name;
+  std::shared_ptr<const RelationTable> table;
+  RelationRows rows;
 };
 
 struct Relation {
-  std::vector<RelationRow> rows;
-  std::unordered_map<std::string, std::unordered_set<std::string>> alias_columns;
+  std::vector<RelationAlias> aliases;
+  size_t row_count = 0;
   std::vector<std::string> warnings;
   std::string cache_key;
+
+  /// Returns the alias index for a lowered alias name, or -1.
+  int32_t find_alias(const std::string& name) const;
+  /// Keeps only `selection` rows (in that order) across every alias.
+  void select_rows(const std::vector<uint32_t>& selection);
+};
+
+/// CTE results by lowered name. Relations are immutable once published, so nested scopes and
+/// every reference share them instead of copying.
+using RelationCteMap = std::unordered_map<std::string, std::shared_ptr<const Relation>>;
+
+/// One row of a relation outside its evaluation loop (LATERAL and correlated sources).
+struct RelationRowRef {
+  const Relation* relation = nullptr;
+  size_t row = 0;
+};
+
+/// A resolved (alias, column) position; alias or column is -1 when unresolved.
+struct RelationSlot {
+  int32_t alias = -1;
+  int32_t column = -1;
+};
+
+/// A resolved ORDER BY / projection field reference.
+/// Qualified fields read one slot; bare fields prefer the active alias, then a column unique
+/// to one alias for that row.
+struct RelationFieldRef {
+  bool qualified = false;
+  RelationSlot slot;
+  std::vector<RelationSlot> candidates;
+};
+
+/// Column bindings for a fixed alias schema (one relation, or both sides of a join).
+/// Operand slots are resolved once, on first use, and reused for every row evaluated against
+/// the same schema. MUST outlive the row views that reference it.
+class RelationScope {
+ public:
+  RelationScope(const Relation& relation, const std::optional<std::string>& active_alias);
+  RelationScope(const Relation& left, const Relation& right,
+                const std::optional<std::string>& active_alias);
+
+  size_t alias_count() const { return aliases_.size(); }
+  const std::string& alias_name(size_t alias) const { return aliases_[alias].name; }
+  const RelationTable& table(size_t alias) const { return *aliases_[alias].table; }
+  int32_t find_alias(const std::string& lowered) const;
+  /// Alias used by unqualified operands: the active alias, else the only alias, else -1.
+  int32_t default_alias() const { return default_alias_; }
+
+  /// Resolves an AST operand to a slot; throws for unknown qualifiers like the row model did.
+  const RelationSlot& operand_slot(const Operand& operand) const;
+  RelationFieldRef bind_field(const std::string& field) const;
+
+ private:
+  struct Entry {
+    std::string name;
+    const RelationTable* table = nullptr;
+  };
+
+  void init_default_alias(const std::optional<std::string>& active_alias);
+  RelationSlot resolve_operand(const Operand& operand) const;
+
+  std::vector<Entry> aliases_;
+  int32_t active_alias_ = -1;
+  int32_t default_alias_ = -1;
+  mutable std::unordered_map<const Operand*, RelationSlot> operand_slots_;
+};
+
+/// A row as seen by expression evaluation: one table row per scope alias.
+struct RelationRowView {
+  const RelationScope* scope = nullptr;
+  const uint32_t* table_rows = nullptr;
 };
 
+/// Gathers the table rows of `relation` row `row` into `out` starting at `offset`.
+void load_relation_row(const Relation& relation, size_t row, std::vector<uint32_t>& out,
+                       size_t offset = 0);
+
+/// A scalar flowing through relation expressions: NULL, an int64, or text.
+/// Text read from a table cell or the query text is a view, valid while the row's tables and
+/// the query live; only text an expression computes is owned. Numbers stay int64 until the
+/// output boundary renders them (to_text()).
+class RelationValue {
+ public:
+  enum class Kind : uint8_t { Null, Number, String };
+
+  RelationValue() = default;
+  static RelationValue number(int64_t value) {
+    RelationValue out;
+    out.kind_ = Kind::Number;
+    out.number_ = value;
+    return out;
+  }
+  static RelationValue view(std::string_view text) {
+    RelationValue out;
+    out.kind_ = Kind::String;
+    out.view_ = text;
+    return out;
+  }
+  static RelationValue owned(std::string text) {
+    RelationValue out;
+    out.kind_ = Kind::String;
+    out.owns_ = true;
+    out.owned_ = std::move(text);
+    return out;
+  }
+  static RelationValue from_optional(std::optional<std::string> text) {
+    return text.has_value() ? owned(std::move(*text)) : RelationValue();
+  }
+
+  Kind kind() const { return kind_; }
+  bool is_null() const { return kind_ == Kind::Null; }
+  int64_t number_value() const { return number_; }
+  /// Text of a String value; empty for other kinds.
+  std::string_view string_value() const { return owns_ ? std::string_view(owned_) : view_; }
+  /// Integer reading for comparisons: the number itself, or String text that parses as int64.
+  std::optional<int64_t> as_int64() const;
+  /// Text form of a non-NULL value, rendering numbers into `scratch` like std::to_string.
+  std::string_view text(std::array<char, 24>& scratch) const;
+  /// Owned text at the output boundary; nullopt for NULL.
+  std::optional<std::string> to_text() const;
+
+ private:
+  Kind kind_ = Kind::Null;
+  int64_t number_ = 0;
+  bool owns_ = false;
+  std::string_view view_;
+  std::string owned_;
+};
+
+RelationCellState relation_slot_state(const RelationRowView& row, const RelationSlot& slot);
+std::optional<std::string> relation_slot_value(const RelationRowView& row,
+                                               const RelationSlot& slot);
+std::optional<std::string> relation_field_value(const RelationRowView& row,
+                                                const RelationFieldRef& field);
+/// Typed reads of the same cells: Int64 cells and node numbers stay numbers, text is a view.
+RelationValue relation_slot_scalar(const RelationRowView& row, const RelationSlot& slot);
+RelationValue relation_field_scalar(const RelationRowView& row, const RelationFieldRef& field);
+
 struct SourceRowPrefilter {
   std::optional<int64_t> parent_id_eq;
   std::optional<std::string> tag_eq;
   bool impossible = false;
 };
 
+/// Length-prefixed composite join key to the right-side rows holding it, ascending.
+using RelationLookupIndex = std::unordered_map<std::string, std::vector<size_t>>;
+
+/// Relation state derived from one prepared document that stays valid for every statement run
+/// against it: the document's sibling positions and child index, document relations by row
+/// prefilter, and join indexes keyed by relation signature.
+/// Tables and indexes share one LRU list bounded by an estimated byte budget (64 MiB, or
+/// MARKQL_REL_CACHE_MB; 0 disables it). MUST be safe for concurrent statements: lookups and
+/// inserts lock, and published entries are immutable.
+class RelationDocumentCache {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+  };
+
+  RelationDocumentCache(const HtmlDocument& doc, size_t capacity_bytes);
+  RelationDocumentCache(const RelationDocumentCache&) = delete;
+  RelationDocumentCache& operator=(const RelationDocumentCache&) = delete;
+
+  /// The document with sibling positions and child index, derived by the first caller.
+  std::shared_ptr<const RelationDocument> document();
+
+  /// Returns the cached index or table for `key`, or nullptr, and counts a hit or a miss.
+  std::shared_ptr<const RelationLookupIndex> find_index(const std::string& key);
+  std::shared_ptr<const RelationTable> find_table(const std::string& key);
+  /// Publishes a built entry and returns the one the cache holds for `key`: an entry another
+  /// statement published first wins. Entries larger than the whole budget are not kept.
+  std::shared_ptr<const RelationLookupIndex> insert_index(
+      const std::string& key, std::shared_ptr<const RelationLookupIndex> index);
+  std::shared_ptr<const RelationTable> insert_table(const std::string& key,
+                                                    std::shared_ptr<const RelationTable> table);
+
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const RelationLookupIndex> index;
+    std::shared_ptr<const RelationTable> table;
+    size_t bytes = 0;
+  };
+
+  Entry* find_locked(const std::string& key);
+  Entry& insert_locked(Entry entry);
+
+  const HtmlDocument& doc_;
+  const size_t capacity_bytes_;
+  std::once_flag document_once_;
+  std::shared_ptr<const RelationDocument> document_;
+  mutable std::mutex mutex_;
+  /// Most recently used first; `entries_` keys view the strings stored in the list nodes.
+  std::list<Entry> lru_;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> entries_;
+  Stats stats_;
+};
+
+/// True when `query` reads nothing but the default document, inline HTML and its own CTEs, so
+/// rerunning the same text against the same prepared document yields the same rows.
+bool relation_query_reads_document_only(const Query& query);
+
 struct RelationRuntimeCache {
   struct CteSizeSample {
     std::string name;
     size_t rows = 0;
+    uint64_t wall_ns = 0;
+  };
+
+  /// Longest chain of dependent CTEs in one WITH clause, by summed wall time.
+  struct CtePathSample {
+    std::vector<std::string> ctes;
+    uint64_t wall_ns = 0;
   };
 
   struct JoinSample {
@@ -49,6 +486,7 @@ struct RelationRuntimeCache {
     size_t right_rows = 0;
     size_t output_rows = 0;
     uint64_t pairs_evaluated = 0;
+    std::string detail;
   };
 
   struct Profile {
@@ -59,45 +497,131 @@ struct RelationRuntimeCache {
     uint64_t scalar_eval_active_depth = 0;
     uint64_t relation_index_builds = 0;
     uint64_t relation_index_hits = 0;
+    /// Lookups this statement made in the prepared document's RelationDocumentCache.
+    uint64_t document_cache_hits = 0;
+    uint64_t document_cache_misses = 0;
     std::vector<CteSizeSample> cte_sizes;
+    std::vector<CtePathSample> cte_paths;
     std::vector<JoinSample> joins;
   };
 
-  std::optional<HtmlDocument> default_document;
-  std::optional<std::vector<int64_t>> default_sibling_pos;
+  /// The statement's default document, parsed once by whichever task first reads it.
+  struct DefaultDocument {
+    std::once_flag parsed;
+    std::shared_ptr<const RelationDocument> document;
+  };
+
+  /// Cache for a task evaluated concurrently with its siblings. It shares the statement's
+  /// document and relation ids but keeps its own profile and indexes, so no state is written
+  /// from two threads; merge_worker() folds its profile back in declaration order.
+  std::unique_ptr<RelationRuntimeCache> make_worker() const;
+  void merge_worker(RelationRuntimeCache& worker);
+
+  std::shared_ptr<DefaultDocument> default_document = std::make_shared<DefaultDocument>();
   Profile profile;
-  std::unordered_map<std::string, std::unordered_map<std::string, std::vector<size_t>>>
+  std::unordered_map<std::string, std::shared_ptr<const RelationLookupIndex>>
       relation_index_cache;
-  uint64_t next_relation_cache_id = 1;
+  /// Caches of the prepared document the statement runs against; null for one-shot runs.
+  std::shared_ptr<RelationDocumentCache> document_cache;
+  /// The statement's top-level query and the text it was parsed from. Its WITH clause is the
+  /// only one whose CTE relations get keys that stay valid across statements.
+  const Query* statement = nullptr;
+  std::string_view statement_text;
+  /// Source of unique relation cache keys, shared by worker caches.
+  std::shared_ptr<std::atomic<uint64_t>> next_relation_cache_id =
+      std::make_shared<std::atomic<uint64_t>>(1);
+  /// Node-field demand per WITH-owning query and per derived source, decided once per statement.
+  std::unordered_map<const Query*, std::vector<bool>> cte_node_fields;
+  std::unordered_map<const Source*, bool> derived_node_fields;
 };
 
+/// Equi-join keys of one relation side, extracted once before hashing.
+/// Keys that parse as int64 (node_id, parent_id, numeric text) are hashed as integers; other
+/// text keys keep their string form, matching normalize_join_key's N:/S: split.
+struct RelationJoinKeys {
+  enum class Kind : uint8_t { Null, Int, Text };
+  std::vector<Kind> kinds;
+  std::vector<int64_t> ints;
+  std::vector<const std::string*> texts;
+};
+
+/// Equi-join matches as CSR over left rows: right_rows[offsets[l], offsets[l + 1]) ascending.
+struct RelationJoinMatches {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> right_rows;
+  bool built_on_left = false;
+  size_t partitions = 1;
+};
+
+/// Integer keys on both sides combined above which hash joins radix-partition their inputs.
+constexpr size_t kRelationRadixJoinRows = 65536;
+
+/// Hash-joins two key columns, building an open-addressing table on the side with fewer keys.
+/// Above kRelationRadixJoinRows the integer keys are radix-partitioned by hash and partitions
+/// are built and probed on the threads a RelationWorkerLease grants, the caller's included.
+RelationJoinMatches relation_hash_join(const RelationJoinKeys& left, const RelationJoinKeys& right);
+
+/// Conjuncts of a WHERE or ON clause split by the input they can filter before joining.
+/// pushed[0] filters the FROM source and pushed[i + 1] the right side of join i; `residual`
+/// keeps the rest in their original order.
+struct RelationPushdownPlan {
+  std::vector<std::vector<const Expr*>> pushed;
+  std::vector<const Expr*> residual;
+  bool any_pushed = false;
+};
+
+/// Lowered alias a source binds in the relation runtime, or "" when predicates cannot name it.
+std::string source_alias_name(const Source& source);
+/// AND-joins the conjuncts, in order, into one expression.
+Expr conjoin_exprs(const std::vector<const Expr*>& conjuncts);
+/// Assigns each conjunct that reads exactly one alias to the input binding it when
+/// `pushable[input]` holds. `names` lists the alias each input binds ("" for none); `outer`
+/// holds aliases visible from an enclosing row, which predicates may name but never filter.
+RelationPushdownPlan plan_conjunct_pushdown(const Expr& expr,
+                                            const std::vector<std::string>& names,
+                                            const std::vector<bool>& pushable,
+                                            const std::vector<std::string>& outer);
+/// Keeps the rows of `rel` that satisfy every conjunct. The filtered view no longer matches
+/// indexes cached for its unfiltered rows, so it drops the cache key.
+void filter_relation_rows(Relation& rel, const std::vector<const Expr*>& conjuncts,
+                          RelationRuntimeCache::Profile* profile);
+/// Per CTE of `query`'s WITH clause, whether any consumer can read the node fields (tag, text,
+/// inner_html, attributes, ...) its rows inherit beyond the projected columns.
+/// `query_node_fields` says whether `query`'s own result rows must keep theirs.
+std::vector<bool> cte_node_fields_needed(const Query& query, bool query_node_fields);
+/// Same decision for a derived-table source of `query`.
+bool derived_node_fields_needed(const Query& query, const Source& derived,
+                                bool query_node_fields);
+
+/// For each CTE of `with`, the earlier CTEs of the same clause its body can reference.
+std::vector<std::vector<size_t>> cte_dependencies(const Query::WithClause& with);
+
+/// Runs task(i) once every node in deps[i] has finished, on up to `threads` threads including
+/// the caller. Dependencies must point to lower indices. Returns each node's failure; after a
+/// failure, nodes sequential evaluation would not reach are skipped and report it too.
+std::vector<std::exception_ptr> run_relation_task_graph(
+    const std::vector<std::vector<size_t>>& deps, size_t threads,
+    const std::function<void(size_t)>& task);
+
 std::string lower_alias_name(const std::string& alias);
-void merge_alias_columns(Relation& rel, const std::string& alias, const RelationRecord& record);
-std::optional<int64_t> parse_optional_i64(const std::optional<std::string>& value);
-void fill_result_core_from_record(QueryResultRow& out, const RelationRecord& record);
-const RelationRecord* resolve_record(const RelationRow& row,
-                                     const std::optional<std::string>& qualifier,
-                                     const std::optional<std::string>& active_alias);
-std::optional<std::string> relation_operand_value(const Operand& operand, const RelationRow& row,
-                                                  const std::optional<std::string>& active_alias);
-std::optional<std::string> eval_relation_scalar_expr(
-    const ScalarExpr& expr, const RelationRow& row, const std::optional<std::string>& active_alias,
+void fill_result_core_from_row(QueryResultRow& out, const RelationTable& table, uint32_t row);
+RelationValue relation_operand_value(const Operand& operand, const RelationRowView& row);
+RelationValue eval_relation_scalar_expr(
+    const ScalarExpr& expr, const RelationRowView& row,
     RelationRuntimeCache::Profile* profile = nullptr);
 std::optional<std::string> eval_relation_project_expr(
-    const Query::SelectItem::FlattenExtractExpr& expr, const RelationRow& row,
-    const std::optional<std::string>& active_alias,
-    const std::unordered_map<std::string, std::string>& bindings,
+    const Query::SelectItem::FlattenExtractExpr& expr, const RelationRowView& row,
+    const ComputedFields& bindings,
     RelationRuntimeCache::Profile* profile = nullptr);
-bool eval_relation_expr(const Expr& expr, const RelationRow& row,
-                        const std::optional<std::string>& active_alias,
+bool eval_relation_expr(const Expr& expr, const RelationRowView& row,
                         RelationRuntimeCache::Profile* profile = nullptr);
-int compare_optional_relation_values(const std::optional<std::string>& left,
-                                     const std::optional<std::string>& right);
-std::optional<std::string> relation_field_by_name(const RelationRow& row, const std::string& field,
-                                                  const std::optional<std::string>& active_alias);
+/// Projects `relation` through `query`. Without `node_fields` result rows carry only the
+/// projected columns, not the node fields of their FROM row. With `stream` each row goes to it
+/// as soon as it is projected.
 QueryResult query_result_from_relation(const Query& query, const Relation& relation,
-                                       RelationRuntimeCache::Profile* profile);
-bool merge_row_aliases(RelationRow& target, const RelationRow& add, std::string* duplicate_alias);
+                                       RelationRuntimeCache::Profile* profile,
+                                       bool node_fields = true,
+                                       ResultRowStream* stream = nullptr);
 Relation execute_relation_join_non_lateral(const Query::JoinItem& join, const Relation& left_rel,
                                            const Relation& right_rel,
                                            const std::optional<std::string>& active_alias,
@@ -0,0 +1,738 @@
+#include "relation_runtime_internal.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "engine_execution_internal.h"
+
+namespace markql {
+
+namespace {
+
+struct CoreColumnSpec {
+  const char* name;
+  RelationCoreColumn core;
+  RelationTable::ColumnKind kind;
+};
+
+constexpr CoreColumnSpec kCoreColumns[] = {
+    {"node_id", RelationCoreColumn::NodeId, RelationTable::ColumnKind::Int64},
+    {"tag", RelationCoreColumn::Tag, RelationTable::ColumnKind::String},
+    {"text", RelationCoreColumn::Text, RelationTable::ColumnKind::String},
+    {"inner_html", RelationCoreColumn::InnerHtml, RelationTable::ColumnKind::String},
+    {"parent_id", RelationCoreColumn::ParentId, RelationTable::ColumnKind::Int64},
+    {"sibling_pos", RelationCoreColumn::SiblingPos, RelationTable::ColumnKind::Int64},
+    {"max_depth", RelationCoreColumn::MaxDepth, RelationTable::ColumnKind::Int64},
+    {"doc_order", RelationCoreColumn::DocOrder, RelationTable::ColumnKind::Int64},
+    {"source_uri", RelationCoreColumn::SourceUri, RelationTable::ColumnKind::String},
+};
+
+std::optional<int64_t> exact_int64(const std::string& value) {
+  if (value.empty()) return std::nullopt;
+  int64_t out = 0;
+  const char* begin = value.data();
+  const char* end = begin + value.size();
+  auto [ptr, ec] = std::from_chars(begin, end, out);
+  if (ec != std::errc() || ptr != end) return std::nullopt;
+  // WHY: only canonical spellings are stored as integers so value() reproduces the input bytes.
+  if (std::to_string(out) != value) return std::nullopt;
+  return out;
+}
+
+}  // namespace
+
+std::shared_ptr<const RelationDocument> make_relation_document(
+    std::shared_ptr<const HtmlDocument> doc) {
+  auto out = std::make_shared<RelationDocument>();
+  const size_t node_count = doc->nodes.size();
+  out->sibling_pos.assign(node_count, 1);
+  out->parent_index.assign(node_count, -1);
+  std::vector<int64_t> next_sibling(node_count, 1);
+  std::unordered_set<std::string> seen;
+  for (size_t i = 0; i < node_count; ++i) {
+    const HtmlNode& node = doc->nodes[i];
+    if (node.parent_id.has_value()) {
+      const size_t parent = static_cast<size_t>(*node.parent_id);
+      // WHY: parsed documents number nodes by index; ids outside that range have no parent row.
+      if (parent < node_count && doc->nodes[parent].id == *node.parent_id) {
+        out->parent_index[i] = static_cast<int32_t>(parent);
+      }
+      out->sibling_pos.at(static_cast<size_t>(node.id)) = next_sibling.at(parent)++;
+    }
+    for (const auto& attr : node.attributes) {
+      if (seen.insert(attr.first).second) out->attribute_names.push_back(attr.first);
+    }
+  }
+  out->subtree_end.resize(node_count);
+  for (size_t i = 0; i < node_count; ++i) {
+    out->subtree_end[i] = static_cast<uint32_t>(i + 1);
+    if (out->parent_index[i] >= static_cast<int32_t>(i)) out->preorder = false;
+  }
+  for (size_t i = node_count; i-- > 0;) {
+    const int32_t parent = out->parent_index[i];
+    if (parent < 0) continue;
+    uint32_t& end = out->subtree_end[static_cast<size_t>(parent)];
+    if (out->subtree_end[i] > end) end = out->subtree_end[i];
+  }
+  out->child_offsets.assign(node_count + 1, 0);
+  for (size_t i = 0; i < node_count; ++i) {
+    if (out->parent_index[i] >= 0) ++out->child_offsets[out->parent_index[i] + 1];
+  }
+  for (size_t i = 0; i < node_count; ++i) out->child_offsets[i + 1] += out->child_offsets[i];
+  out->child_nodes.resize(out->child_offsets[node_count]);
+  std::vector<uint32_t> fill(out->child_offsets.begin(), out->child_offsets.end() - 1);
+  for (size_t i = 0; i < node_count; ++i) {
+    if (out->parent_index[i] < 0) continue;
+    out->child_nodes[fill[static_cast<size_t>(out->parent_index[i])]++] =
+        static_cast<uint32_t>(i);
+  }
+  out->doc = std::move(doc);
+  return out;
+}
+
+std::shared_ptr<const RelationTable> RelationTable::from_document(
+    std::shared_ptr<const RelationDocument> document, std::vector<uint32_t> nodes,
+    std::string source_uri) {
+  auto table = std::make_shared<RelationTable>();
+  auto add_column = [&](std::string name, ColumnKind kind, RelationCoreColumn field,
+                        bool parent, std::string attribute) {
+    if (table->column_index_.count(name) != 0) return;
+    Column col;
+    col.name = name;
+    col.kind = kind;
+    col.doc_field = field;
+    col.doc_parent = parent;
+    col.doc_attribute = std::move(attribute);
+    table->column_index_.emplace(std::move(name), static_cast<uint32_t>(table->columns_.size()));
+    table->columns_.push_back(std::move(col));
+  };
+  for (const auto& spec : kCoreColumns) {
+    add_column(spec.name, spec.kind, spec.core, false, spec.name);
+  }
+  for (const auto& spec : kCoreColumns) {
+    if (spec.core == RelationCoreColumn::SourceUri) continue;
+    add_column(std::string("parent.") + spec.name, spec.kind, spec.core, true, spec.name);
+  }
+  for (const auto& name : document->attribute_names) {
+    add_column(name, ColumnKind::Sparse, RelationCoreColumn::Count, false, name);
+  }
+  for (const auto& name : document->attribute_names) {
+    add_column("parent." + name, ColumnKind::Sparse, RelationCoreColumn::Count, true, name);
+  }
+  std::unordered_set<std::string> attribute_names(document->attribute_names.begin(),
+                                                  document->attribute_names.end());
+  for (auto& col : table->columns_) {
+    if (col.doc_field == RelationCoreColumn::Count) continue;
+    col.doc_shadowed = attribute_names.count(col.doc_attribute) != 0;
+  }
+  for (const auto& spec : kCoreColumns) {
+    table->core_columns_[static_cast<size_t>(spec.core)] = table->find_column(spec.name);
+  }
+  table->row_count_ = nodes.size();
+  table->document_ = std::move(document);
+  table->document_nodes_ = std::move(nodes);
+  table->source_uri_ = std::move(source_uri);
+  return table;
+}
+
+const HtmlNode* RelationTable::document_target(const Column& col, size_t row) const {
+  const uint32_t node = document_nodes_[row];
+  if (!col.doc_parent) return &document_->doc->nodes[node];
+  const int32_t parent = document_->parent_index[node];
+  if (parent < 0) return nullptr;
+  return &document_->doc->nodes[static_cast<size_t>(parent)];
+}
+
+const std::string* RelationTable::document_attribute(const Column& col,
+                                                     const HtmlNode& node) const {
+  if (col.doc_field != RelationCoreColumn::Count && !col.doc_shadowed) return nullptr;
+  auto it = node.attributes.find(col.doc_attribute);
+  return it == node.attributes.end() ? nullptr : &it->second;
+}
+
+int32_t RelationTable::find_column(std::string_view name) const {
+  auto it = column_index_.find(std::string(name));
+  if (it == column_index_.end()) return -1;
+  return static_cast<int32_t>(it->second);
+}
+
+const RelationTable::SparseCell* RelationTable::find_sparse(size_t column, size_t row) const {
+  for (uint32_t i = sparse_offsets_[row]; i < sparse_offsets_[row + 1]; ++i) {
+    if (sparse_cells_[i].column == column) return &sparse_cells_[i];
+  }
+  return nullptr;
+}
+
+RelationCellState RelationTable::state(size_t column, size_t row) const {
+  const Column& col = columns_[column];
+  if (document_ != nullptr) {
+    const HtmlNode* node = document_target(col, row);
+    if (node == nullptr) return RelationCellState::Absent;
+    if (document_attribute(col, *node) != nullptr) return RelationCellState::Value;
+    if (col.doc_field == RelationCoreColumn::Count) return RelationCellState::Absent;
+    if (col.doc_field == RelationCoreColumn::ParentId && !node->parent_id.has_value()) {
+      return RelationCellState::Null;
+    }
+    return RelationCellState::Value;
+  }
+  if (col.kind != ColumnKind::Sparse) return col.states[row];
+  const SparseCell* cell = find_sparse(column, row);
+  return cell == nullptr ? RelationCellState::Absent : cell->state;
+}
+
+std::optional<std::string> RelationTable::value(size_t column, size_t row) const {
+  const Column& col = columns_[column];
+  if (document_ != nullptr) {
+    if (const std::string* text = string_value(column, row); text != nullptr) return *text;
+    if (auto number = int_value(column, row); number.has_value()) {
+      return std::to_string(*number);
+    }
+    return std::nullopt;
+  }
+  if (col.kind == ColumnKind::Int64) {
+    if (col.states[row] != RelationCellState::Value) return std::nullopt;
+    return std::to_string(col.ints[row]);
+  }
+  const std::string* text = string_value(column, row);
+  if (text == nullptr) return std::nullopt;
+  return *text;
+}
+
+std::optional<int64_t> RelationTable::int_value(size_t column, size_t row) const {
+  const Column& col = columns_[column];
+  if (document_ != nullptr) {
+    const HtmlNode* node = document_target(col, row);
+    if (node == nullptr || document_attribute(col, *node) != nullptr) return std::nullopt;
+    switch (col.doc_field) {
+      case RelationCoreColumn::NodeId:
+        return node->id;
+      case RelationCoreColumn::ParentId:
+        return node->parent_id;
+      case RelationCoreColumn::SiblingPos:
+        return document_->sibling_pos.at(static_cast<size_t>(node->id));
+      case RelationCoreColumn::MaxDepth:
+        return node->max_depth;
+      case RelationCoreColumn::DocOrder:
+        return node->doc_order;
+      default:
+        return std::nullopt;
+    }
+  }
+  if (col.kind != ColumnKind::Int64 || col.states[row] != RelationCellState::Value) {
+    return std::nullopt;
+  }
+  return col.ints[row];
+}
+
+const std::string* RelationTable::string_value(size_t column, size_t row) const {
+  const Column& col = columns_[column];
+  if (document_ != nullptr) {
+    const HtmlNode* node = document_target(col, row);
+    if (node == nullptr) return nullptr;
+    if (const std::string* attr = document_attribute(col, *node); attr != nullptr) return attr;
+    switch (col.doc_field) {
+      case RelationCoreColumn::Tag:
+        return &node->tag;
+      case RelationCoreColumn::Text:
+        return &node->text;
+      case RelationCoreColumn::InnerHtml:
+        return &node->inner_html;
+      case RelationCoreColumn::SourceUri:
+        return &source_uri_;
+      default:
+        return nullptr;
+    }
+  }
+  if (col.kind == ColumnKind::String) {
+    if (col.states[row] != RelationCellState::Value) return nullptr;
+    return &col.strings[row];
+  }
+  if (col.kind == ColumnKind::Sparse) {
+    const SparseCell* cell = find_sparse(column, row);
+    if (cell == nullptr || cell->state != RelationCellState::Value) return nullptr;
+    return &cell->value;
+  }
+  return nullptr;
+}
+
+RelationTableBuilder::RelationTableBuilder() : table_(std::make_shared<RelationTable>()) {}
+
+size_t RelationTableBuilder::add_dense_column(const std::string& name,
+                                              RelationTable::ColumnKind kind) {
+  auto it = table_->column_index_.find(name);
+  if (it != table_->column_index_.end()) return it->second;
+  RelationTable::Column col;
+  col.name = name;
+  col.kind = kind;
+  col.states.assign(table_->row_count_, RelationCellState::Absent);
+  if (kind == RelationTable::ColumnKind::Int64) col.ints.assign(table_->row_count_, 0);
+  if (kind == RelationTable::ColumnKind::String) col.strings.resize(table_->row_count_);
+  const size_t index = table_->columns_.size();
+  table_->columns_.push_back(std::move(col));
+  table_->column_index_.emplace(name, static_cast<uint32_t>(index));
+  return index;
+}
+
+void RelationTableBuilder::add_core_columns(bool with_parent) {
+  for (const auto& spec : kCoreColumns) {
+    add_dense_column(spec.name, spec.kind);
+  }
+  if (!with_parent) return;
+  for (const auto& spec : kCoreColumns) {
+    if (spec.core == RelationCoreColumn::SourceUri) continue;
+    add_dense_column(std::string("parent.") + spec.name, spec.kind);
+  }
+}
+
+size_t RelationTableBuilder::column(const std::string& name) {
+  auto it = table_->column_index_.find(name);
+  if (it != table_->column_index_.end()) return it->second;
+  return add_dense_column(name, RelationTable::ColumnKind::Sparse);
+}
+
+void RelationTableBuilder::begin_row() {
+  if (table_->row_count_ > 0) {
+    table_->sparse_offsets_.push_back(static_cast<uint32_t>(table_->sparse_cells_.size()));
+    table_->attribute_offsets_.push_back(static_cast<uint32_t>(table_->attribute_cells_.size()));
+  }
+  ++table_->row_count_;
+  for (auto& col : table_->columns_) {
+    if (col.kind == RelationTable::ColumnKind::Sparse) continue;
+    col.states.push_back(RelationCellState::Absent);
+    if (col.kind == RelationTable::ColumnKind::Int64) {
+      col.ints.push_back(0);
+    } else {
+      col.strings.emplace_back();
+    }
+  }
+  row_start_sparse_ = table_->sparse_cells_.size();
+}
+
+RelationTable::SparseCell* RelationTableBuilder::current_sparse(size_t column) {
+  for (size_t i = row_start_sparse_; i < table_->sparse_cells_.size(); ++i) {
+    if (table_->sparse_cells_[i].column == column) return &table_->sparse_cells_[i];
+  }
+  RelationTable::SparseCell cell;
+  cell.column = static_cast<uint32_t>(column);
+  table_->sparse_cells_.push_back(std::move(cell));
+  return &table_->sparse_cells_.back();
+}
+
+void RelationTableBuilder::set_null(size_t column) {
+  RelationTable::Column& col = table_->columns_[column];
+  if (col.kind == RelationTable::ColumnKind::Sparse) {
+    RelationTable::SparseCell* cell = current_sparse(column);
+    cell->state = RelationCellState::Null;
+    cell->value.clear();
+    return;
+  }
+  col.states.back() = RelationCellState::Null;
+  if (col.kind == RelationTable::ColumnKind::String) col.strings.back().clear();
+}
+
+void RelationTableBuilder::set_int(size_t column, int64_t value) {
+  RelationTable::Column& col = table_->columns_[column];
+  if (col.kind == RelationTable::ColumnKind::Int64) {
+    col.states.back() = RelationCellState::Value;
+    col.ints.back() = value;
+    return;
+  }
+  set_string(column, std::to_string(value));
+}
+
+void RelationTableBuilder::set_string(size_t column, std::string value) {
+  RelationTable::Column& col = table_->columns_[column];
+  if (col.kind == RelationTable::ColumnKind::Int64) {
+    if (auto parsed = exact_int64(value); parsed.has_value()) {
+      col.states.back() = RelationCellState::Value;
+      col.ints.back() = *parsed;
+      return;
+    }
+    demote_to_string(column);
+  }
+  if (col.kind == RelationTable::ColumnKind::Sparse) {
+    RelationTable::SparseCell* cell = current_sparse(column);
+    cell->state = RelationCellState::Value;
+    cell->value = std::move(value);
+    return;
+  }
+  col.states.back() = RelationCellState::Value;
+  col.strings.back() = std::move(value);
+}
+
+void RelationTableBuilder::set_value(size_t column, const std::optional<std::string>& value) {
+  if (value.has_value()) {
+    set_string(column, *value);
+  } else {
+    set_null(column);
+  }
+}
+
+void RelationTableBuilder::add_attribute(size_t column, std::string value) {
+  RelationTable::AttributeCell cell;
+  cell.column = static_cast<uint32_t>(column);
+  cell.value = std::move(value);
+  table_->attribute_cells_.push_back(std::move(cell));
+}
+
+void RelationTableBuilder::demote_to_string(size_t column) {
+  RelationTable::Column& col = table_->columns_[column];
+  col.strings.assign(col.states.size(), std::string());
+  for (size_t row = 0; row < col.states.size(); ++row) {
+    if (col.states[row] == RelationCellState::Value) {
+      col.strings[row] = std::to_string(col.ints[row]);
+    }
+  }
+  col.ints.clear();
+  col.ints.shrink_to_fit();
+  col.kind = RelationTable::ColumnKind::String;
+}
+
+void RelationTableBuilder::append_row(const std::shared_ptr<const RelationTable>& source,
+                                      size_t row) {
+  const RelationTable& src = *source;
+  if (append_source_ != source) {
+    append_source_ = source;
+    append_map_.assign(src.column_count(), 0);
+    for (size_t c = 0; c < src.column_count(); ++c) {
+      append_map_[c] =
+          static_cast<uint32_t>(add_dense_column(src.column_name(c), src.column_kind(c)));
+    }
+  }
+  begin_row();
+  if (src.document_ != nullptr) {
+    // WHY: document-backed rows only exist as node references; materialize them here.
+    for (size_t c = 0; c < src.column_count(); ++c) {
+      const RelationCellState state = src.state(c, row);
+      if (state == RelationCellState::Absent) continue;
+      if (state == RelationCellState::Null) {
+        set_null(append_map_[c]);
+      } else if (auto number = src.int_value(c, row); number.has_value()) {
+        set_int(append_map_[c], *number);
+      } else if (const std::string* text = src.string_value(c, row); text != nullptr) {
+        set_string(append_map_[c], *text);
+      }
+    }
+    src.for_each_attribute(row, [&](const std::string& name, const std::string& value) {
+      add_attribute(append_map_[static_cast<size_t>(src.find_column(name))], value);
+    });
+    return;
+  }
+  for (size_t c = 0; c < src.column_count(); ++c) {
+    if (src.column_kind(c) == RelationTable::ColumnKind::Sparse) continue;
+    const RelationCellState state = src.state(c, row);
+    if (state == RelationCellState::Absent) continue;
+    if (state == RelationCellState::Null) {
+      set_null(append_map_[c]);
+    } else if (src.column_kind(c) == RelationTable::ColumnKind::Int64) {
+      set_int(append_map_[c], src.columns_[c].ints[row]);
+    } else {
+      set_string(append_map_[c], src.columns_[c].strings[row]);
+    }
+  }
+  for (uint32_t i = src.sparse_offsets_[row]; i < src.sparse_offsets_[row + 1]; ++i) {
+    const RelationTable::SparseCell& cell = src.sparse_cells_[i];
+    if (cell.state == RelationCellState::Null) {
+      set_null(append_map_[cell.column]);
+    } else {
+      set_string(append_map_[cell.column], cell.value);
+    }
+  }
+  for (uint32_t i = src.attribute_offsets_[row]; i < src.attribute_offsets_[row + 1]; ++i) {
+    add_attribute(append_map_[src.attribute_cells_[i].column], src.attribute_cells_[i].value);
+  }
+}
+
+std::shared_ptr<const RelationTable> RelationTableBuilder::finish() {
+  if (table_->row_count_ > 0) {
+    table_->sparse_offsets_.push_back(static_cast<uint32_t>(table_->sparse_cells_.size()));
+    table_->attribute_offsets_.push_back(static_cast<uint32_t>(table_->attribute_cells_.size()));
+  }
+  for (const auto& spec : kCoreColumns) {
+    table_->core_columns_[static_cast<size_t>(spec.core)] = table_->find_column(spec.name);
+  }
+  append_source_.reset();
+  std::shared_ptr<const RelationTable> out = std::move(table_);
+  table_ = std::make_shared<RelationTable>();
+  return out;
+}
+
+int32_t Relation::find_alias(const std::string& name) const {
+  for (size_t i = 0; i < aliases.size(); ++i) {
+    if (aliases[i].name == name) return static_cast<int32_t>(i);
+  }
+  return -1;
+}
+
+void Relation::select_rows(const std::vector<uint32_t>& selection) {
+  for (auto& alias : aliases) {
+    std::vector<uint32_t> rows;
+    rows.reserve(selection.size());
+    for (uint32_t row : selection) rows.push_back(alias.rows[row]);
+    alias.rows = std::move(rows);
+  }
+  row_count = selection.size();
+}
+
+RelationScope::RelationScope(const Relation& relation,
+                             const std::optional<std::string>& active_alias) {
+  aliases_.reserve(relation.aliases.size());
+  for (const auto& alias : relation.aliases) {
+    aliases_.push_back(Entry{alias.name, alias.table.get()});
+  }
+  init_default_alias(active_alias);
+}
+
+RelationScope::RelationScope(const Relation& left, const Relation& right,
+                             const std::optional<std::string>& active_alias) {
+  aliases_.reserve(left.aliases.size() + right.aliases.size());
+  for (const auto& alias : left.aliases) {
+    aliases_.push_back(Entry{alias.name, alias.table.get()});
+  }
+  for (const auto& alias : right.aliases) {
+    aliases_.push_back(Entry{alias.name, alias.table.get()});
+  }
+  init_default_alias(active_alias);
+}
+
+void RelationScope::init_default_alias(const std::optional<std::string>& active_alias) {
+  if (active_alias.has_value()) active_alias_ = find_alias(*active_alias);
+  if (active_alias_ >= 0) {
+    default_alias_ = active_alias_;
+  } else if (aliases_.size() == 1) {
+    default_alias_ = 0;
+  }
+}
+
+int32_t RelationScope::find_alias(const std::string& lowered) const {
+  for (size_t i = 0; i < aliases_.size(); ++i) {
+    if (aliases_[i].name == lowered) return static_cast<int32_t>(i);
+  }
+  return -1;
+}
+
+const RelationSlot& RelationScope::operand_slot(const Operand& operand) const {
+  auto it = operand_slots_.find(&operand);
+  if (it != operand_slots_.end()) return it->second;
+  RelationSlot slot = resolve_operand(operand);
+  return operand_slots_.emplace(&operand, slot).first->second;
+}
+
+RelationSlot RelationScope::resolve_operand(const Operand& operand) const {
+  RelationSlot slot;
+  if (operand.qualifier.has_value()) {
+    const std::string lowered = lower_alias_name(*operand.qualifier);
+    slot.alias = find_alias(lowered);
+    if (slot.alias < 0) {
+      if (lowered == "doc" && aliases_.size() == 1 && aliases_.front().name != "doc") {
+        throw std::runtime_error("Identifier 'doc' is not bound; did you mean '" +
+                                 aliases_.front().name + "'?");
+      }
+      throw std::runtime_error("Unknown identifier '" + *operand.qualifier +
+                               "' (expected a FROM alias or legacy tag binding)");
+    }
+  } else {
+    slot.alias = default_alias_;
+  }
+  if (slot.alias < 0) return slot;
+  if (operand.axis != Operand::Axis::Self && operand.axis != Operand::Axis::Parent) return slot;
+  const std::string prefix = operand.axis == Operand::Axis::Parent ? "parent." : "";
+  std::string key;
+  switch (operand.field_kind) {
+    case Operand::FieldKind::Attribute:
+      key = prefix + operand.attribute;
+      break;
+    case Operand::FieldKind::Tag:
+      key = prefix + "tag";
+      break;
+    case Operand::FieldKind::Text:
+      key = prefix + "text";
+      break;
+    case Operand::FieldKind::NodeId:
+      key = prefix + "node_id";
+      break;
+    case Operand::FieldKind::ParentId:
+      key = prefix + "parent_id";
+      break;
+    case Operand::FieldKind::SiblingPos:
+      key = prefix + "sibling_pos";
+      break;
+    case Operand::FieldKind::MaxDepth:
+      key = prefix + "max_depth";
+      break;
+    case Operand::FieldKind::DocOrder:
+      key = prefix + "doc_order";
+      break;
+    case Operand::FieldKind::AttributesMap:
+      return slot;
+  }
+  slot.column = aliases_[static_cast<size_t>(slot.alias)].table->find_column(key);
+  return slot;
+}
+
+RelationFieldRef RelationScope::bind_field(const std::string& field) const {
+  RelationFieldRef ref;
+  size_t dot = field.find('.');
+  if (dot != std::string::npos) {
+    ref.qualified = true;
+    ref.slot.alias = find_alias(lower_alias_name(field.substr(0, dot)));
+    if (ref.slot.alias >= 0) {
+      ref.slot.column =
+          aliases_[static_cast<size_t>(ref.slot.alias)].table->find_column(field.substr(dot + 1));
+    }
+    return ref;
+  }
+  if (active_alias_ >= 0) {
+    ref.slot.alias = active_alias_;
+    ref.slot.column = aliases_[static_cast<size_t>(active_alias_)].table->find_column(field);
+  }
+  for (size_t i = 0; i < aliases_.size(); ++i) {
+    int32_t column = aliases_[i].table->find_column(field);
+    if (column < 0) continue;
+    ref.candidates.push_back(RelationSlot{static_cast<int32_t>(i), column});
+  }
+  return ref;
+}
+
+void load_relation_row(const Relation& relation, size_t row, std::vector<uint32_t>& out,
+                       size_t offset) {
+  for (size_t i = 0; i < relation.aliases.size(); ++i) {
+    out[offset + i] = relation.aliases[i].rows[row];
+  }
+}
+
+RelationCellState relation_slot_state(const RelationRowView& row, const RelationSlot& slot) {
+  if (slot.alias < 0 || slot.column < 0) return RelationCellState::Absent;
+  const uint32_t table_row = row.table_rows[slot.alias];
+  if (table_row == kRelationNullRow) return RelationCellState::Null;
+  return row.scope->table(static_cast<size_t>(slot.alias))
+      .state(static_cast<size_t>(slot.column), table_row);
+}
+
+std::optional<std::string> relation_slot_value(const RelationRowView& row,
+                                               const RelationSlot& slot) {
+  if (slot.alias < 0 || slot.column < 0) return std::nullopt;
+  const uint32_t table_row = row.table_rows[slot.alias];
+  if (table_row == kRelationNullRow) return std::nullopt;
+  return row.scope->table(static_cast<size_t>(slot.alias))
+      .value(static_cast<size_t>(slot.column), table_row);
+}
+
+std::optional<std::string> relation_field_value(const RelationRowView& row,
+                                                const RelationFieldRef& field) {
+  if (field.qualified) return relation_slot_value(row, field.slot);
+  if (relation_slot_state(row, field.slot) != RelationCellState::Absent) {
+    return relation_slot_value(row, field.slot);
+  }
+  const RelationSlot* found = nullptr;
+  for (const auto& candidate : field.candidates) {
+    if (relation_slot_state(row, candidate) == RelationCellState::Absent) continue;
+    if (found != nullptr) return std::nullopt;
+    found = &candidate;
+  }
+  if (found == nullptr) return std::nullopt;
+  return relation_slot_value(row, *found);
+}
+
+std::optional<int64_t> RelationValue::as_int64() const {
+  if (kind_ == Kind::Number) return number_;
+  if (kind_ == Kind::String) return parse_int64_value(string_value());
+  return std::nullopt;
+}
+
+std::string_view RelationValue::text(std::array<char, 24>& scratch) const {
+  if (kind_ != Kind::Number) return string_value();
+  const auto result = std::to_chars(scratch.data(), scratch.data() + scratch.size(), number_);
+  return std::string_view(scratch.data(), static_cast<size_t>(result.ptr - scratch.data()));
+}
+
+std::optional<std::string> RelationValue::to_text() const {
+  if (kind_ == Kind::Null) return std::nullopt;
+  if (kind_ == Kind::Number) return std::to_string(number_);
+  return std::string(string_value());
+}
+
+RelationValue relation_slot_scalar(const RelationRowView& row, const RelationSlot& slot) {
+  if (slot.alias < 0 || slot.column < 0) return RelationValue();
+  const uint32_t table_row = row.table_rows[slot.alias];
+  if (table_row == kRelationNullRow) return RelationValue();
+  const RelationTable& table = row.scope->table(static_cast<size_t>(slot.alias));
+  const size_t column = static_cast<size_t>(slot.column);
+  if (const std::string* text = table.string_value(column, table_row); text != nullptr) {
+    return RelationValue::view(*text);
+  }
+  if (auto number = table.int_value(column, table_row); number.has_value()) {
+    return RelationValue::number(*number);
+  }
+  return RelationValue();
+}
+
+RelationValue relation_field_scalar(const RelationRowView& row, const RelationFieldRef& field) {
+  if (field.qualified) return relation_slot_scalar(row, field.slot);
+  if (relation_slot_state(row, field.slot) != RelationCellState::Absent) {
+    return relation_slot_scalar(row, field.slot);
+  }
+  const RelationSlot* found = nullptr;
+  for (const auto& candidate : field.candidates) {
+    if (relation_slot_state(row, candidate) == RelationCellState::Absent) continue;
+    if (found != nullptr) return RelationValue();
+    found = &candidate;
+  }
+  if (found == nullptr) return RelationValue();
+  return relation_slot_scalar(row, *found);
+}
+
+void fill_result_core_from_row(QueryResultRow& out, const RelationTable& table, uint32_t row) {
+  if (row == kRelationNullRow) return;
+  auto int_field = [&](RelationCoreColumn core, int64_t& target) {
+    const int32_t column = table.core_column(core);
+    if (column < 0) return;
+    if (auto value = table.int_value(static_cast<size_t>(column), row); value.has_value()) {
+      target = *value;
+      return;
+    }
+    const std::string* text = table.string_value(static_cast<size_t>(column), row);
+    if (text == nullptr) return;
+    if (auto parsed = parse_int64_value(*text); parsed.has_value()) target = *parsed;
+  };
+  auto string_field = [&](RelationCoreColumn core, std::string& target) {
+    const int32_t column = table.core_column(core);
+    if (column < 0) return;
+    if (auto value = table.value(static_cast<size_t>(column), row); value.has_value()) {
+      target = std::move(*value);
+    }
+  };
+  int_field(RelationCoreColumn::NodeId, out.node_id);
+  string_field(RelationCoreColumn::Tag, out.tag);
+  string_field(RelationCoreColumn::Text, out.text);
+  string_field(RelationCoreColumn::InnerHtml, out.inner_html);
+  const int32_t parent_column = table.core_column(RelationCoreColumn::ParentId);
+  if (parent_column >= 0) {
+    int64_t parent_id = 0;
+    bool has_parent = false;
+    if (auto value = table.int_value(static_cast<size_t>(parent_column), row); value.has_value()) {
+      parent_id = *value;
+      has_parent = true;
+    } else if (const std::string* text =
+                   table.string_value(static_cast<size_t>(parent_column), row);
+               text != nullptr) {
+      if (auto parsed = parse_int64_value(*text); parsed.has_value()) {
+        parent_id = *parsed;
+        has_parent = true;
+      }
+    }
+    if (has_parent) out.parent_id = parent_id;
+  }
+  int_field(RelationCoreColumn::SiblingPos, out.sibling_pos);
+  int_field(RelationCoreColumn::MaxDepth, out.max_depth);
+  int_field(RelationCoreColumn::DocOrder, out.doc_order);
+  string_field(RelationCoreColumn::SourceUri, out.source_uri);
+  table.for_each_attribute(row, [&](const std::string& name, const std::string& value) {
+    out.attributes[name] = value;
+  });
+}
+
+}  // namespace markql
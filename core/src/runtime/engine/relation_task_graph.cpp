@@ -0,0 +1,212 @@
+#include "relation_runtime_internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace markql {
+
+namespace {
+
+/// Threads, beyond each caller's own, that relation workers may occupy across the process.
+std::atomic<size_t>& spare_relation_threads() {
+  static std::atomic<size_t> spare = []() -> size_t {
+    size_t threads = std::thread::hardware_concurrency();
+    if (const char* env = std::getenv("MARKQL_REL_THREADS"); env != nullptr && *env != '\0') {
+      threads = static_cast<size_t>(std::strtoull(env, nullptr, 10));
+    }
+    return threads > 1 ? threads - 1 : 0;
+  }();
+  return spare;
+}
+
+void collect_cte_refs(const Query& query, std::unordered_set<std::string>& out);
+
+void collect_source_cte_refs(const Source& source, std::unordered_set<std::string>& out) {
+  if (source.kind == Source::Kind::CteRef) out.insert(lower_alias_name(source.value));
+  if (source.parse_query != nullptr) collect_cte_refs(*source.parse_query, out);
+  if (source.derived_query != nullptr) collect_cte_refs(*source.derived_query, out);
+}
+
+void collect_cte_refs(const Query& query, std::unordered_set<std::string>& out) {
+  if (query.with.has_value()) {
+    for (const auto& cte : query.with->ctes) {
+      if (cte.query != nullptr) collect_cte_refs(*cte.query, out);
+    }
+  }
+  collect_source_cte_refs(query.source, out);
+  for (const auto& join : query.joins) collect_source_cte_refs(join.right_source, out);
+}
+
+}  // namespace
+
+std::unique_ptr<RelationRuntimeCache> RelationRuntimeCache::make_worker() const {
+  auto worker = std::make_unique<RelationRuntimeCache>();
+  worker->default_document = default_document;
+  worker->next_relation_cache_id = next_relation_cache_id;
+  worker->document_cache = document_cache;
+  worker->statement = statement;
+  worker->statement_text = statement_text;
+  worker->profile.enabled = profile.enabled;
+  worker->cte_node_fields = cte_node_fields;
+  worker->derived_node_fields = derived_node_fields;
+  return worker;
+}
+
+void RelationRuntimeCache::merge_worker(RelationRuntimeCache& worker) {
+  profile.join_time_ns += worker.profile.join_time_ns;
+  profile.projection_time_ns += worker.profile.projection_time_ns;
+  profile.scalar_eval_time_ns += worker.profile.scalar_eval_time_ns;
+  profile.relation_index_builds += worker.profile.relation_index_builds;
+  profile.relation_index_hits += worker.profile.relation_index_hits;
+  profile.document_cache_hits += worker.profile.document_cache_hits;
+  profile.document_cache_misses += worker.profile.document_cache_misses;
+  auto append = [](auto& into, auto& from) {
+    into.insert(into.end(), std::make_move_iterator(from.begin()),
+                std::make_move_iterator(from.end()));
+    from.clear();
+  };
+  append(profile.cte_sizes, worker.profile.cte_sizes);
+  append(profile.cte_paths, worker.profile.cte_paths);
+  append(profile.joins, worker.profile.joins);
+  // Equal relation keys name equal rows, so an index the worker built under a key we already
+  // hold is interchangeable with ours.
+  for (auto& [key, index] : worker.relation_index_cache) {
+    relation_index_cache.try_emplace(key, std::move(index));
+  }
+  worker.relation_index_cache.clear();
+  cte_node_fields.insert(worker.cte_node_fields.begin(), worker.cte_node_fields.end());
+  derived_node_fields.insert(worker.derived_node_fields.begin(), worker.derived_node_fields.end());
+}
+
+RelationWorkerLease::RelationWorkerLease(size_t tasks) {
+  if (tasks < 2) return;
+  std::atomic<size_t>& spare = spare_relation_threads();
+  size_t available = spare.load();
+  size_t take = 0;
+  do {
+    take = std::min(available, tasks - 1);
+  } while (take > 0 && !spare.compare_exchange_weak(available, available - take));
+  extra_ = take;
+}
+
+RelationWorkerLease::~RelationWorkerLease() {
+  if (extra_ > 0) spare_relation_threads().fetch_add(extra_);
+}
+
+std::vector<std::vector<size_t>> cte_dependencies(const Query::WithClause& with) {
+  std::vector<std::vector<size_t>> deps(with.ctes.size());
+  std::unordered_map<std::string, size_t> declared;
+  for (size_t i = 0; i < with.ctes.size(); ++i) {
+    if (with.ctes[i].query != nullptr) {
+      std::unordered_set<std::string> refs;
+      collect_cte_refs(*with.ctes[i].query, refs);
+      for (const auto& name : refs) {
+        // WHY: a name may also be a nested CTE or a parent-scope CTE; depending on the earlier
+        // sibling anyway only costs concurrency.
+        auto it = declared.find(name);
+        if (it != declared.end()) deps[i].push_back(it->second);
+      }
+      std::sort(deps[i].begin(), deps[i].end());
+    }
+    declared[lower_alias_name(with.ctes[i].name)] = i;
+  }
+  return deps;
+}
+
+std::vector<std::exception_ptr> run_relation_task_graph(
+    const std::vector<std::vector<size_t>>& deps, size_t threads,
+    const std::function<void(size_t)>& task) {
+  const size_t count = deps.size();
+  std::vector<std::exception_ptr> errors(count);
+  std::vector<size_t> waiting(count, 0);
+  std::vector<std::vector<size_t>> dependents(count);
+  for (size_t i = 0; i < count; ++i) {
+    waiting[i] = deps[i].size();
+    for (size_t dep : deps[i]) dependents[dep].push_back(i);
+  }
+  if (threads <= 1) {
+    // Declaration order is already a topological order.
+    for (size_t i = 0; i < count; ++i) {
+      try {
+        task(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+        break;
+      }
+    }
+    return errors;
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready_changed;
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < count; ++i) {
+    if (waiting[i] == 0) ready.push_back(i);
+  }
+  size_t finished = 0;
+  size_t first_failure = count;
+  auto worker = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready_changed.wait(lock, [&]() { return !ready.empty() || finished == count; });
+      if (ready.empty()) return;
+      // WHY: start the earliest declared node first so critical paths through early CTEs,
+      // which later ones tend to depend on, begin as soon as possible.
+      auto next = std::min_element(ready.begin(), ready.end());
+      const size_t node = *next;
+      ready.erase(next);
+      if (node > first_failure) {
+        // Sequential evaluation would have stopped before reaching this node.
+        errors[node] = errors[first_failure];
+      } else {
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+          task(node);
+        } catch (...) {
+          error = std::current_exception();
+        }
+        lock.lock();
+        if (error != nullptr) {
+          errors[node] = error;
+          first_failure = std::min(first_failure, node);
+        }
+      }
+      // Dependents of a failed node are skipped; the caller rethrows in declaration order.
+      std::vector<size_t> finish{node};
+      while (!finish.empty()) {
+        const size_t done = finish.back();
+        finish.pop_back();
+        ++finished;
+        for (size_t dependent : dependents[done]) {
+          if (--waiting[dependent] != 0) continue;
+          bool blocked = false;
+          for (size_t dep : deps[dependent]) blocked = blocked || errors[dep] != nullptr;
+          if (blocked) {
+            errors[dependent] = errors[done];
+            finish.push_back(dependent);
+          } else {
+            ready.push_back(dependent);
+          }
+        }
+      }
+      ready_changed.notify_all();
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+  worker();
+  for (auto& thread : pool) thread.join();
+  return errors;
+}
+
+}  // namespace markql
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace markql {
+
+/// Reserves worker threads for `tasks` independent tasks from a process-wide budget of
+/// hardware_concurrency() threads (MARKQL_REL_THREADS overrides it). CTE evaluation, input
+/// prefetch, radix hash joins and compressed exports all lease from it, so nested parallel
+/// sections never oversubscribe the machine. The caller's own thread is always included.
+class RelationWorkerLease {
+ public:
+  explicit RelationWorkerLease(size_t tasks);
+  ~RelationWorkerLease();
+  RelationWorkerLease(const RelationWorkerLease&) = delete;
+  RelationWorkerLease& operator=(const RelationWorkerLease&) = delete;
+
+  size_t threads() const { return extra_ + 1; }
+
+ private:
+  size_t extra_ = 0;
+};
+
+}  // namespace markql
@@ -277,47 +277,85 @@ std::vector<std::vector<int64_t>> build_children(const HtmlDocument& doc) {
 /// Inputs are doc/children/table_id; outputs are row vectors.
 void collect_rows(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
                   int64_t table_id, std::vector<std::vector<std::string>>& out_rows) {
-  std::vector<int64_t> stack;
-  stack.push_back(table_id);
-  std::vector<int64_t> tr_nodes;
-  while (!stack.empty()) {
-    int64_t id = stack.back();
-    stack.pop_back();
-    const HtmlNode& node = doc.nodes.at(static_cast<size_t>(id));
-    if (node.tag == "tr") {
-      tr_nodes.push_back(id);
-      continue;
+  TableRowReader reader(doc, children, table_id);
+  std::vector<std::string> row;
+  while (reader.next(row)) {
+    out_rows.push_back(row);
+  }
+}
+
+TableRowReader::TableRowReader(const HtmlDocument& doc,
+                               const std::vector<std::vector<int64_t>>& children,
+                               int64_t table_id)
+    : doc_(doc), children_(children), table_id_(table_id) {
+  rewind();
+}
+
+void TableRowReader::rewind() {
+  path_.clear();
+  path_.emplace_back(table_id_, 0);
+}
+
+bool TableRowReader::next_tr(int64_t& tr_id) {
+  // WHY: a pre-order walk that stops at each tr, as collect_rows always did; keeping the
+  // ancestor path instead of a stack of pending siblings bounds memory by the table's depth.
+  while (!path_.empty()) {
+    auto& [id, next_child] = path_.back();
+    if (next_child == 0 && doc_.nodes.at(static_cast<size_t>(id)).tag == "tr") {
+      tr_id = id;
+      path_.pop_back();
+      return true;
     }
-    const auto& kids = children.at(static_cast<size_t>(id));
-    for (auto it = kids.rbegin(); it != kids.rend(); ++it) {
-      stack.push_back(*it);
+    const auto& kids = children_.at(static_cast<size_t>(id));
+    if (next_child >= kids.size()) {
+      path_.pop_back();
+      continue;
     }
+    const int64_t child = kids[next_child++];
+    path_.emplace_back(child, 0);
   }
+  return false;
+}
 
-  for (int64_t tr_id : tr_nodes) {
-    std::vector<std::string> row;
-    std::vector<int64_t> cell_stack;
-    const auto& kids = children.at(static_cast<size_t>(tr_id));
-    for (auto it = kids.rbegin(); it != kids.rend(); ++it) {
-      cell_stack.push_back(*it);
-    }
-    while (!cell_stack.empty()) {
-      int64_t id = cell_stack.back();
-      cell_stack.pop_back();
-      const HtmlNode& node = doc.nodes.at(static_cast<size_t>(id));
-      if (node.tag == "td" || node.tag == "th") {
-        row.push_back(util::trim_ws(node.text));
-        continue;
-      }
-      const auto& next = children.at(static_cast<size_t>(id));
-      for (auto it = next.rbegin(); it != next.rend(); ++it) {
-        cell_stack.push_back(*it);
-      }
+template <typename Fn>
+void TableRowReader::for_each_cell(int64_t tr_id, Fn&& fn) {
+  cell_path_.clear();
+  cell_path_.emplace_back(tr_id, 0);
+  while (!cell_path_.empty()) {
+    auto& [id, next_child] = cell_path_.back();
+    const auto& kids = children_.at(static_cast<size_t>(id));
+    if (next_child >= kids.size()) {
+      cell_path_.pop_back();
+      continue;
     }
-    if (!row.empty()) {
-      out_rows.push_back(row);
+    const int64_t child = kids[next_child++];
+    const HtmlNode& node = doc_.nodes.at(static_cast<size_t>(child));
+    if (node.tag == "td" || node.tag == "th") {
+      fn(node);
+      continue;
     }
+    cell_path_.emplace_back(child, 0);
+  }
+}
+
+bool TableRowReader::next(std::vector<std::string>& row) {
+  int64_t tr_id = 0;
+  while (next_tr(tr_id)) {
+    row.clear();
+    for_each_cell(tr_id, [&](const HtmlNode& cell) { row.push_back(util::trim_ws(cell.text)); });
+    if (!row.empty()) return true;
+  }
+  return false;
+}
+
+bool TableRowReader::next_width(size_t& width) {
+  int64_t tr_id = 0;
+  while (next_tr(tr_id)) {
+    width = 0;
+    for_each_cell(tr_id, [&](const HtmlNode&) { ++width; });
+    if (width > 0) return true;
   }
+  return false;
 }
 
 }  // namespace markql::markql_internal
@@ -101,7 +101,7 @@ std::vector<std::string> tokenize_default(const std::string& text) {
 /// Computes TFIDF scores per node so each result row includes a term-score dictionary.
 /// MUST return rows aligned with the input node order and capped to TOP_TERMS.
 std::vector<QueryResultRow> build_tfidf_rows(const Query& query,
-                                             const std::vector<HtmlNode>& nodes) {
+                                             const std::vector<const HtmlNode*>& nodes) {
   std::vector<QueryResultRow> rows;
   if (nodes.empty()) return rows;
   const auto& item = query.select_items[0];
@@ -113,7 +113,8 @@ std::vector<QueryResultRow> build_tfidf_rows(const Query& query,
   std::vector<size_t> token_totals;
   token_totals.reserve(nodes.size());
   std::unordered_map<std::string, size_t> doc_freq;
-  for (const auto& node : nodes) {
+  for (const HtmlNode* node_ptr : nodes) {
+    const HtmlNode& node = *node_ptr;
     std::string cleaned = strip_html_text(node.inner_html);
     auto tokens = tokenize_default(cleaned);
     std::unordered_map<std::string, size_t> counts;
@@ -136,7 +137,7 @@ std::vector<QueryResultRow> build_tfidf_rows(const Query& query,
   size_t max_df = item.tfidf_max_df == 0 ? doc_count : std::min(item.tfidf_max_df, doc_count);
   for (size_t idx = 0; idx < nodes.size(); ++idx) {
     QueryResultRow row;
-    const auto& node = nodes[idx];
+    const HtmlNode& node = *nodes[idx];
     row.node_id = node.id;
     row.parent_id = node.parent_id;
     row.tag = node.tag;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "dom/html_parser.h"
 #include "lang/ast.h"
@@ -12,7 +14,8 @@ struct ExecuteError {
 };
 
 struct ExecuteResult {
-  std::vector<HtmlNode> nodes;
+  /// Matched nodes, pointing into the queried document; valid while that document lives.
+  std::vector<const HtmlNode*> nodes;
   std::optional<ExecuteError> error;
 };
 
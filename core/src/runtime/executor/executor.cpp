@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "executor_internal.h"
+#include "filter_batch_internal.h"
 #include "../../util/string_util.h"
 
 namespace markql {
@@ -58,22 +59,44 @@ ExecuteResult execute_query(const Query& query, const HtmlDocument& doc,
     }
   }
 
-  for (const auto& node : doc.nodes) {
-    // WHY: skip non-selected tags early to reduce downstream filtering cost.
-    if (!select_all && !executor_internal::string_in_list(node.tag, select_tags)) continue;
-    if (query.where.has_value()) {
-      if (!executor_internal::eval_expr(*query.where, doc, children, node)) continue;
+  // WHY: simple self-axis predicates run as column kernels over node batches and
+  // ancestor-axis predicates become precomputed masks; only the residual conjuncts fall
+  // back to the row-at-a-time evaluator on surviving nodes.
+  executor_internal::NodeColumns columns = executor_internal::build_node_columns(doc);
+  executor_internal::BatchPredicate predicate;
+  if (query.where.has_value()) {
+    predicate =
+        executor_internal::compile_batch_predicate(*query.where, doc, children, columns);
+  }
+  if (!select_all) {
+    executor_internal::add_batch_tag_filter(predicate, columns, select_tags);
+  }
+  std::vector<uint32_t> selection;
+  selection.reserve(executor_internal::kFilterBatchSize);
+  for (size_t begin = 0; begin < doc.nodes.size();
+       begin += executor_internal::kFilterBatchSize) {
+    const size_t end = std::min(doc.nodes.size(), begin + executor_internal::kFilterBatchSize);
+    selection.clear();
+    executor_internal::eval_batch_predicate(predicate, doc, columns, begin, end, selection);
+    for (uint32_t id : selection) {
+      const HtmlNode& node = doc.nodes[id];
+      bool keep = true;
+      for (const Expr* residual : predicate.residual) {
+        if (!executor_internal::eval_expr(*residual, doc, children, node)) {
+          keep = false;
+          break;
+        }
+      }
+      if (!keep) continue;
+      result.nodes.push_back(&node);
     }
-    HtmlNode out = node;
-    out.tag = node.tag;
-    result.nodes.push_back(out);
   }
 
   if (!query.order_by.empty()) {
     std::stable_sort(result.nodes.begin(), result.nodes.end(),
-                     [&](const HtmlNode& left, const HtmlNode& right) {
+                     [&](const HtmlNode* left, const HtmlNode* right) {
                        for (const auto& order_by : query.order_by) {
-                         int cmp = executor_internal::compare_nodes(left, right, order_by.field);
+                         int cmp = executor_internal::compare_nodes(*left, *right, order_by.field);
                          if (cmp == 0) continue;
                          if (order_by.descending) {
                            return cmp > 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../executor.h"
@@ -22,6 +23,16 @@ bool eval_expr_flatten_base(const Expr& expr, const HtmlDocument& doc,
 /// Checks membership of a string in a list for filtering decisions.
 /// MUST use exact matching and MUST be case-sensitive.
 /// Inputs are value/list; outputs are boolean with no side effects.
-bool string_in_list(const std::string& value, const std::vector<std::string>& list);
+bool string_in_list(std::string_view value, const std::vector<std::string>& list);
+/// Checks membership in a literal list, using the parser-compiled hash set when present.
+/// MUST match string_in_list semantics exactly.
+bool value_list_contains(const ValueList& list, std::string_view value);
+/// Checks CONTAINS ALL / CONTAINS ANY tokens, using the compiled automaton when present.
+/// MUST match util::contains_all_ci / util::contains_any_ci semantics exactly.
+bool value_list_contains_all_ci(const ValueList& list, std::string_view text);
+bool value_list_contains_any_ci(const ValueList& list, std::string_view text);
+/// Matches `text` against the list's LIKE pattern, using the compiled pattern when present.
+/// MUST match util::like_match_ci(text, list.values.front()) exactly.
+bool value_list_like_ci(const ValueList& list, std::string_view text);
 
 }  // namespace markql::executor_internal
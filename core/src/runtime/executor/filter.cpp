@@ -3,14 +3,35 @@
 #include <algorithm>
 #include <regex>
 
+#include "../../util/string_search.h"
 #include "../engine/markql_internal.h"
 
 namespace markql::executor_internal {
 
-bool string_in_list(const std::string& value, const std::vector<std::string>& list) {
+bool string_in_list(std::string_view value, const std::vector<std::string>& list) {
   return std::find(list.begin(), list.end(), value) != list.end();
 }
 
+bool value_list_contains(const ValueList& list, std::string_view value) {
+  if (list.exact_set != nullptr) return list.exact_set->contains(value);
+  return string_in_list(value, list.values);
+}
+
+bool value_list_contains_all_ci(const ValueList& list, std::string_view text) {
+  if (list.token_matcher != nullptr) return list.token_matcher->contains_all(text);
+  return util::contains_all_ci(text, list.values);
+}
+
+bool value_list_contains_any_ci(const ValueList& list, std::string_view text) {
+  if (list.token_matcher != nullptr) return list.token_matcher->contains_any(text);
+  return util::contains_any_ci(text, list.values);
+}
+
+bool value_list_like_ci(const ValueList& list, std::string_view text) {
+  if (list.like_pattern != nullptr) return list.like_pattern->matches(text);
+  return util::like_match_ci(text, list.values.front());
+}
+
 /// Evaluates a boolean expression over the current node and document.
 /// MUST be deterministic and MUST honor axis/field semantics.
 /// Inputs are expr/doc/children/node; outputs are boolean with no side effects.
@@ -20,7 +41,7 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
   const HtmlNode& node = context.current_row_node;
   if (std::holds_alternative<CompareExpr>(expr)) {
     const auto& cmp = std::get<CompareExpr>(expr);
-    std::vector<std::string> values = cmp.rhs.values;
+    const std::vector<std::string>& values = cmp.rhs.values;
     const bool lhs_is_operand =
         cmp.lhs_expr.has_value() && cmp.lhs_expr->kind == ScalarExpr::Kind::Operand;
     const bool legacy_op =
@@ -63,7 +84,10 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
       }
       if (cmp.op == CompareExpr::Op::Like) {
         if (is_null(lhs_value) || is_null(rhs_value)) return false;
-        return like_match_ci(to_string_value(lhs_value), to_string_value(rhs_value));
+        if (cmp.rhs.like_pattern != nullptr) {
+          return cmp.rhs.like_pattern->matches(to_string_value(lhs_value));
+        }
+        return util::like_match_ci(to_string_value(lhs_value), to_string_value(rhs_value));
       }
       if (cmp.op == CompareExpr::Op::Regex) {
         if (is_null(lhs_value) || is_null(rhs_value)) return false;
@@ -90,19 +114,20 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
           rhs_values.push_back(to_string_value(value));
         }
         if (cmp.op == CompareExpr::Op::Contains) {
-          return contains_ci(to_string_value(lhs_value), rhs_values.front());
+          return util::contains_ci(to_string_value(lhs_value), rhs_values.front());
         }
         if (cmp.op == CompareExpr::Op::ContainsAll) {
-          return contains_all_ci(to_string_value(lhs_value), rhs_values);
+          return util::contains_all_ci(to_string_value(lhs_value), rhs_values);
         }
-        return contains_any_ci(to_string_value(lhs_value), rhs_values);
+        return util::contains_any_ci(to_string_value(lhs_value), rhs_values);
       }
     }
 
     if (cmp.op == CompareExpr::Op::HasDirectText) {
       if (node.tag != cmp.lhs.attribute) return false;
-      std::string direct = markql_internal::extract_direct_text(node.inner_html);
-      return contains_ci(direct, values.front());
+      std::string scratch;
+      const std::string& direct = markql_internal::cached_direct_text(doc, node, scratch);
+      return util::contains_ci(direct, values.front());
     }
     if (cmp.op == CompareExpr::Op::IsNull || cmp.op == CompareExpr::Op::IsNotNull) {
       bool exists = false;
@@ -123,21 +148,21 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
       if (!node.parent_id.has_value()) return false;
       const HtmlNode& parent = doc.nodes.at(static_cast<size_t>(*node.parent_id));
       if (cmp.lhs.field_kind == Operand::FieldKind::NodeId) {
-        return match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, values, cmp.op);
+        return match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op);
       }
       if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
         return match_sibling_pos(doc, children, parent, values, cmp.op);
       }
-      return match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, values, cmp.op);
+      return match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op);
     }
     if (cmp.lhs.axis == Operand::Axis::Child) {
       if (cmp.lhs.field_kind == Operand::FieldKind::NodeId) {
-        return has_child_node_id(doc, children, node, values, cmp.op);
+        return has_child_node_id(doc, children, node, cmp.rhs, cmp.op);
       }
       if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
         return has_child_sibling_pos(doc, children, node, values, cmp.op);
       }
-      return has_child_field(doc, children, node, cmp.lhs.field_kind, cmp.lhs.attribute, values,
+      return has_child_field(doc, children, node, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs,
                              cmp.op);
     }
     if (cmp.lhs.axis == Operand::Axis::Ancestor) {
@@ -145,13 +170,13 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
       while (current->parent_id.has_value()) {
         const HtmlNode& parent = doc.nodes.at(static_cast<size_t>(*current->parent_id));
         if (cmp.lhs.field_kind == Operand::FieldKind::NodeId) {
-          if (match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, values, cmp.op)) {
+          if (match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op)) {
             return true;
           }
         } else if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
           if (match_sibling_pos(doc, children, parent, values, cmp.op)) return true;
         } else {
-          if (match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, values, cmp.op)) {
+          if (match_field(parent, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op)) {
             return true;
           }
         }
@@ -161,18 +186,18 @@ bool eval_expr_with_context(const Expr& expr, const HtmlDocument& doc,
     }
     if (cmp.lhs.axis == Operand::Axis::Descendant) {
       if (cmp.lhs.field_kind == Operand::FieldKind::NodeId) {
-        return has_descendant_node_id(doc, children, node, values, cmp.op);
+        return has_descendant_node_id(doc, children, node, cmp.rhs, cmp.op);
       }
       if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
         return has_descendant_sibling_pos(doc, children, node, values, cmp.op);
       }
       return has_descendant_field(doc, children, node, cmp.lhs.field_kind, cmp.lhs.attribute,
-                                  values, cmp.op);
+                                  cmp.rhs, cmp.op);
     }
     if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
       return match_sibling_pos(doc, children, node, values, cmp.op);
     }
-    return match_field(node, cmp.lhs.field_kind, cmp.lhs.attribute, values, cmp.op);
+    return match_field(node, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op);
   }
 
   if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(expr)) {
@@ -0,0 +1,437 @@
+#include "filter_batch_internal.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+#include "../../util/string_util.h"
+#include "../engine/engine_execution_internal.h"
+#include "filter_internal.h"
+
+namespace markql::executor_internal {
+
+namespace {
+
+using Mask = std::array<uint8_t, kFilterBatchSize>;
+using Node = BatchPredicate::Node;
+
+bool is_ordering_op(CompareExpr::Op op) {
+  return op == CompareExpr::Op::Eq || op == CompareExpr::Op::In ||
+         op == CompareExpr::Op::NotEq || op == CompareExpr::Op::Lt ||
+         op == CompareExpr::Op::Lte || op == CompareExpr::Op::Gt || op == CompareExpr::Op::Gte;
+}
+
+/// Mirrors the legacy operand path in eval_expr_with_context for self-axis comparisons and
+/// ancestor-axis comparisons (the latter become precomputed node masks).
+bool is_batch_leaf(const CompareExpr& cmp) {
+  if (cmp.lhs_expr.has_value() && cmp.lhs_expr->kind != ScalarExpr::Kind::Operand) return false;
+  if (cmp.rhs.values.empty()) return false;
+  if (cmp.lhs.axis == Operand::Axis::Ancestor) {
+    return cmp.op != CompareExpr::Op::HasDirectText && cmp.op != CompareExpr::Op::IsNull &&
+           cmp.op != CompareExpr::Op::IsNotNull;
+  }
+  if (cmp.lhs.axis != Operand::Axis::Self) return false;
+  switch (cmp.lhs.field_kind) {
+    case Operand::FieldKind::Tag:
+      return cmp.op == CompareExpr::Op::Eq || cmp.op == CompareExpr::Op::In ||
+             cmp.op == CompareExpr::Op::NotEq;
+    case Operand::FieldKind::Attribute:
+      return cmp.op == CompareExpr::Op::Eq || cmp.op == CompareExpr::Op::In ||
+             cmp.op == CompareExpr::Op::Contains || cmp.op == CompareExpr::Op::ContainsAll ||
+             cmp.op == CompareExpr::Op::ContainsAny;
+    case Operand::FieldKind::NodeId:
+    case Operand::FieldKind::ParentId:
+    case Operand::FieldKind::MaxDepth:
+    case Operand::FieldKind::DocOrder:
+      return is_ordering_op(cmp.op);
+    default:
+      return false;
+  }
+}
+
+bool is_batch_expr(const Expr& expr) {
+  if (std::holds_alternative<CompareExpr>(expr)) {
+    return is_batch_leaf(std::get<CompareExpr>(expr));
+  }
+  if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(expr)) {
+    const auto& exists = *std::get<std::shared_ptr<ExistsExpr>>(expr);
+    return exists.axis == Operand::Axis::Ancestor && exists.where.has_value();
+  }
+  const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+  return is_batch_expr(bin.left) && is_batch_expr(bin.right);
+}
+
+size_t push_node(BatchPredicate& predicate, Node node) {
+  predicate.nodes.push_back(std::move(node));
+  return predicate.nodes.size() - 1;
+}
+
+size_t push_binary(BatchPredicate& predicate, Node::Kind kind, size_t left, size_t right) {
+  Node node;
+  node.kind = kind;
+  node.left = left;
+  node.right = right;
+  return push_node(predicate, std::move(node));
+}
+
+/// Carries "some proper ancestor matches" down the tree with one pre-order pass.
+/// `matches` only needs to be evaluated for nodes that have children.
+template <typename MatchFn>
+std::vector<uint8_t> ancestor_mask(const HtmlDocument& doc,
+                                   const std::vector<std::vector<int64_t>>& children,
+                                   MatchFn matches) {
+  std::vector<uint8_t> below(doc.nodes.size(), 0);
+  std::vector<int64_t> stack;
+  for (const auto& node : doc.nodes) {
+    if (!node.parent_id.has_value()) stack.push_back(node.id);
+  }
+  while (!stack.empty()) {
+    const int64_t id = stack.back();
+    stack.pop_back();
+    const auto& kids = children[static_cast<size_t>(id)];
+    if (kids.empty()) continue;
+    const HtmlNode& node = doc.nodes[static_cast<size_t>(id)];
+    const uint8_t carry =
+        static_cast<uint8_t>(below[static_cast<size_t>(id)] | (matches(node) ? 1u : 0u));
+    for (int64_t kid : kids) {
+      below[static_cast<size_t>(kid)] = carry;
+      stack.push_back(kid);
+    }
+  }
+  return below;
+}
+
+size_t compile_leaf(const CompareExpr& cmp, const HtmlDocument& doc,
+                    const std::vector<std::vector<int64_t>>& children, const NodeColumns& columns,
+                    BatchPredicate& predicate) {
+  Node leaf;
+  leaf.op = cmp.op;
+  if (cmp.lhs.axis == Operand::Axis::Ancestor) {
+    leaf.column = Node::Column::NodeMask;
+    leaf.node_mask = ancestor_mask(doc, children, [&](const HtmlNode& node) {
+      if (cmp.lhs.field_kind == Operand::FieldKind::SiblingPos) {
+        return match_sibling_pos(doc, children, node, cmp.rhs.values, cmp.op);
+      }
+      return match_field(node, cmp.lhs.field_kind, cmp.lhs.attribute, cmp.rhs, cmp.op);
+    });
+    return push_node(predicate, std::move(leaf));
+  }
+  if (cmp.lhs.field_kind == Operand::FieldKind::Tag) {
+    leaf.column = Node::Column::Tag;
+    const bool negate = cmp.op == CompareExpr::Op::NotEq;
+    leaf.allowed_tags.assign(columns.tag_names.size(), negate ? 1 : 0);
+    const size_t used = cmp.op == CompareExpr::Op::In ? cmp.rhs.values.size() : 1;
+    for (size_t i = 0; i < used; ++i) {
+      auto id = find_tag_id(columns, util::to_lower(cmp.rhs.values[i]));
+      if (id.has_value()) leaf.allowed_tags[*id] = negate ? 0 : 1;
+    }
+    return push_node(predicate, std::move(leaf));
+  }
+  if (cmp.lhs.field_kind == Operand::FieldKind::Attribute) {
+    leaf.column = Node::Column::Attribute;
+    leaf.attribute = cmp.lhs.attribute;
+    leaf.rhs = cmp.rhs;
+    return push_node(predicate, std::move(leaf));
+  }
+  switch (cmp.lhs.field_kind) {
+    case Operand::FieldKind::NodeId:
+      leaf.column = Node::Column::NodeId;
+      break;
+    case Operand::FieldKind::ParentId:
+      leaf.column = Node::Column::ParentId;
+      break;
+    case Operand::FieldKind::MaxDepth:
+      leaf.column = Node::Column::MaxDepth;
+      break;
+    default:
+      leaf.column = Node::Column::DocOrder;
+      break;
+  }
+  // WHY: match_field rejects the whole comparison when the first literal is not an integer.
+  if (!parse_int64_value(cmp.rhs.values.front()).has_value()) {
+    leaf.never = true;
+    return push_node(predicate, std::move(leaf));
+  }
+  if (cmp.op == CompareExpr::Op::In) {
+    for (const auto& value : cmp.rhs.values) {
+      if (auto parsed = parse_int64_value(value); parsed.has_value()) {
+        leaf.ints.push_back(*parsed);
+      }
+    }
+  } else {
+    leaf.ints.push_back(*parse_int64_value(cmp.rhs.values.front()));
+  }
+  return push_node(predicate, std::move(leaf));
+}
+
+size_t compile_expr(const Expr& expr, const HtmlDocument& doc,
+                    const std::vector<std::vector<int64_t>>& children, const NodeColumns& columns,
+                    BatchPredicate& predicate) {
+  if (std::holds_alternative<CompareExpr>(expr)) {
+    return compile_leaf(std::get<CompareExpr>(expr), doc, children, columns, predicate);
+  }
+  if (std::holds_alternative<std::shared_ptr<ExistsExpr>>(expr)) {
+    // EXISTS(ancestor WHERE f) only depends on f evaluated at each ancestor, so f runs once
+    // per inner node instead of once per (row, ancestor) pair.
+    const Expr& filter = *std::get<std::shared_ptr<ExistsExpr>>(expr)->where;
+    Node leaf;
+    leaf.column = Node::Column::NodeMask;
+    leaf.node_mask = ancestor_mask(doc, children, [&](const HtmlNode& node) {
+      return eval_expr(filter, doc, children, node);
+    });
+    return push_node(predicate, std::move(leaf));
+  }
+  const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+  size_t left = compile_expr(bin.left, doc, children, columns, predicate);
+  size_t right = compile_expr(bin.right, doc, children, columns, predicate);
+  return push_binary(predicate, bin.op == BinaryExpr::Op::And ? Node::Kind::And : Node::Kind::Or,
+                     left, right);
+}
+
+void collect_conjuncts(const Expr& expr, std::vector<const Expr*>& out) {
+  if (std::holds_alternative<std::shared_ptr<BinaryExpr>>(expr)) {
+    const auto& bin = *std::get<std::shared_ptr<BinaryExpr>>(expr);
+    if (bin.op == BinaryExpr::Op::And) {
+      collect_conjuncts(bin.left, out);
+      collect_conjuncts(bin.right, out);
+      return;
+    }
+  }
+  out.push_back(&expr);
+}
+
+void and_into_root(BatchPredicate& predicate, size_t index) {
+  if (!predicate.root.has_value()) {
+    predicate.root = index;
+    return;
+  }
+  predicate.root = push_binary(predicate, Node::Kind::And, *predicate.root, index);
+}
+
+const int64_t* int_column(const NodeColumns& columns, Node::Column column) {
+  switch (column) {
+    case Node::Column::NodeId:
+      return nullptr;
+    case Node::Column::ParentId:
+      return columns.parent_ids.data();
+    case Node::Column::MaxDepth:
+      return columns.max_depths.data();
+    default:
+      return columns.doc_orders.data();
+  }
+}
+
+// The compare kernels below are branch-free loops over contiguous int64 columns so the
+// compiler can lower them to packed SIMD compares; the active mask carries AND/OR state.
+template <typename Cmp>
+void compare_kernel(const int64_t* values, size_t count, const uint8_t* active, uint8_t* out,
+                    Cmp cmp) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<uint8_t>(active[i] & static_cast<uint8_t>(cmp(values[i])));
+  }
+}
+
+template <typename Cmp>
+void compare_ids_kernel(size_t begin, size_t count, const uint8_t* active, uint8_t* out,
+                        Cmp cmp) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<uint8_t>(active[i] &
+                                  static_cast<uint8_t>(cmp(static_cast<int64_t>(begin + i))));
+  }
+}
+
+template <typename Cmp>
+void eval_int_op(const Node& leaf, const int64_t* values, size_t begin, size_t count,
+                 const uint8_t* active, uint8_t* out, Cmp guard) {
+  const int64_t target = leaf.ints.empty() ? 0 : leaf.ints.front();
+  auto run = [&](auto cmp) {
+    auto guarded = [&](int64_t v) { return guard(v) && cmp(v); };
+    if (values == nullptr) {
+      compare_ids_kernel(begin, count, active, out, guarded);
+    } else {
+      compare_kernel(values + begin, count, active, out, guarded);
+    }
+  };
+  switch (leaf.op) {
+    case CompareExpr::Op::In: {
+      const std::vector<int64_t>& targets = leaf.ints;
+      run([&](int64_t v) {
+        bool hit = false;
+        for (int64_t t : targets) hit |= (v == t);
+        return hit;
+      });
+      return;
+    }
+    case CompareExpr::Op::NotEq:
+      run([target](int64_t v) { return v != target; });
+      return;
+    case CompareExpr::Op::Lt:
+      run([target](int64_t v) { return v < target; });
+      return;
+    case CompareExpr::Op::Lte:
+      run([target](int64_t v) { return v <= target; });
+      return;
+    case CompareExpr::Op::Gt:
+      run([target](int64_t v) { return v > target; });
+      return;
+    case CompareExpr::Op::Gte:
+      run([target](int64_t v) { return v >= target; });
+      return;
+    default:
+      run([target](int64_t v) { return v == target; });
+      return;
+  }
+}
+
+void eval_leaf(const Node& leaf, const HtmlDocument& doc, const NodeColumns& columns,
+               size_t begin, size_t count, const uint8_t* active, uint8_t* out) {
+  if (leaf.never) {
+    std::fill(out, out + count, 0);
+    return;
+  }
+  if (leaf.column == Node::Column::Tag) {
+    const uint32_t* tags = columns.tag_ids.data() + begin;
+    const uint8_t* allowed = leaf.allowed_tags.data();
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = static_cast<uint8_t>(active[i] & allowed[tags[i]]);
+    }
+    return;
+  }
+  if (leaf.column == Node::Column::NodeMask) {
+    const uint8_t* mask = leaf.node_mask.data() + begin;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = static_cast<uint8_t>(active[i] & mask[i]);
+    }
+    return;
+  }
+  if (leaf.column == Node::Column::Attribute) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = active[i] && match_field(doc.nodes[begin + i], Operand::FieldKind::Attribute,
+                                        leaf.attribute, leaf.rhs, leaf.op);
+    }
+    return;
+  }
+  const int64_t* values = int_column(columns, leaf.column);
+  if (leaf.column == Node::Column::ParentId) {
+    eval_int_op(leaf, values, begin, count, active, out,
+                [](int64_t v) { return v != kNoParentId; });
+    return;
+  }
+  eval_int_op(leaf, values, begin, count, active, out, [](int64_t) { return true; });
+}
+
+void eval_mask(const BatchPredicate& predicate, size_t index, const HtmlDocument& doc,
+               const NodeColumns& columns, size_t begin, size_t count, const uint8_t* active,
+               uint8_t* out) {
+  const Node& node = predicate.nodes[index];
+  if (node.kind == Node::Kind::Leaf) {
+    eval_leaf(node, doc, columns, begin, count, active, out);
+    return;
+  }
+  Mask left;
+  eval_mask(predicate, node.left, doc, columns, begin, count, active, left.data());
+  if (node.kind == Node::Kind::And) {
+    // Intersection: the right side only sees rows that survived the left side.
+    eval_mask(predicate, node.right, doc, columns, begin, count, left.data(), out);
+    return;
+  }
+  // Union: the right side only needs rows the left side did not already select.
+  Mask pending;
+  for (size_t i = 0; i < count; ++i) {
+    pending[i] = static_cast<uint8_t>(active[i] & static_cast<uint8_t>(left[i] ^ 1u));
+  }
+  eval_mask(predicate, node.right, doc, columns, begin, count, pending.data(), out);
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<uint8_t>(out[i] | left[i]);
+  }
+}
+
+}  // namespace
+
+NodeColumns build_node_columns(const HtmlDocument& doc) {
+  NodeColumns columns;
+  const size_t size = doc.nodes.size();
+  columns.tag_ids.resize(size);
+  columns.parent_ids.resize(size);
+  columns.max_depths.resize(size);
+  columns.doc_orders.resize(size);
+  std::unordered_map<std::string, uint32_t> dictionary;
+  for (size_t i = 0; i < size; ++i) {
+    const HtmlNode& node = doc.nodes[i];
+    auto [it, inserted] =
+        dictionary.emplace(node.tag, static_cast<uint32_t>(columns.tag_names.size()));
+    if (inserted) columns.tag_names.push_back(node.tag);
+    columns.tag_ids[i] = it->second;
+    columns.parent_ids[i] = node.parent_id.value_or(kNoParentId);
+    columns.max_depths[i] = node.max_depth;
+    columns.doc_orders[i] = node.doc_order;
+  }
+  return columns;
+}
+
+std::optional<uint32_t> find_tag_id(const NodeColumns& columns, const std::string& tag) {
+  for (size_t i = 0; i < columns.tag_names.size(); ++i) {
+    if (columns.tag_names[i] == tag) return static_cast<uint32_t>(i);
+  }
+  return std::nullopt;
+}
+
+BatchPredicate compile_batch_predicate(const Expr& expr, const HtmlDocument& doc,
+                                       const std::vector<std::vector<int64_t>>& children,
+                                       const NodeColumns& columns) {
+  BatchPredicate predicate;
+  std::vector<const Expr*> conjuncts;
+  collect_conjuncts(expr, conjuncts);
+  for (const Expr* conjunct : conjuncts) {
+    if (!is_batch_expr(*conjunct)) {
+      predicate.residual.push_back(conjunct);
+      continue;
+    }
+    and_into_root(predicate, compile_expr(*conjunct, doc, children, columns, predicate));
+  }
+  return predicate;
+}
+
+void add_batch_tag_filter(BatchPredicate& predicate, const NodeColumns& columns,
+                          const std::vector<std::string>& tags) {
+  Node leaf;
+  leaf.column = Node::Column::Tag;
+  leaf.op = CompareExpr::Op::In;
+  leaf.allowed_tags.assign(columns.tag_names.size(), 0);
+  for (const auto& tag : tags) {
+    if (auto id = find_tag_id(columns, tag); id.has_value()) leaf.allowed_tags[*id] = 1;
+  }
+  size_t index = push_node(predicate, std::move(leaf));
+  // WHY: evaluate the cheap tag gate first so attribute leaves only see candidate tags.
+  if (!predicate.root.has_value()) {
+    predicate.root = index;
+  } else {
+    predicate.root = push_binary(predicate, Node::Kind::And, index, *predicate.root);
+  }
+}
+
+void eval_batch_predicate(const BatchPredicate& predicate, const HtmlDocument& doc,
+                          const NodeColumns& columns, size_t begin, size_t end,
+                          std::vector<uint32_t>& selection) {
+  const size_t count = end - begin;
+  if (!predicate.root.has_value()) {
+    for (size_t i = begin; i < end; ++i) selection.push_back(static_cast<uint32_t>(i));
+    return;
+  }
+  Mask active;
+  Mask out;
+  std::fill(active.begin(), active.begin() + count, 1);
+  eval_mask(predicate, *predicate.root, doc, columns, begin, count, active.data(), out.data());
+  // Compact the batch mask into a selection vector without branching on each row.
+  const size_t base = selection.size();
+  selection.resize(base + count);
+  uint32_t* dst = selection.data() + base;
+  size_t selected = 0;
+  for (size_t i = 0; i < count; ++i) {
+    dst[selected] = static_cast<uint32_t>(begin + i);
+    selected += out[i];
+  }
+  selection.resize(base + selected);
+}
+
+}  // namespace markql::executor_internal
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "executor_internal.h"
+
+namespace markql::executor_internal {
+
+/// Number of nodes evaluated per batch by the selection-vector filter.
+constexpr size_t kFilterBatchSize = 1024;
+/// Sentinel stored in NodeColumns::parent_ids for root nodes.
+constexpr int64_t kNoParentId = -1;
+
+/// Structure-of-arrays view of an HtmlDocument for batch predicate evaluation.
+/// MUST be indexed by node id and MUST stay in sync with the source document.
+struct NodeColumns {
+  std::vector<std::string> tag_names;
+  std::vector<uint32_t> tag_ids;
+  std::vector<int64_t> parent_ids;
+  std::vector<int64_t> max_depths;
+  std::vector<int64_t> doc_orders;
+};
+
+/// Builds the columnar node view with a per-document tag dictionary.
+NodeColumns build_node_columns(const HtmlDocument& doc);
+/// Looks up a dictionary id for a lowercase tag name.
+std::optional<uint32_t> find_tag_id(const NodeColumns& columns, const std::string& tag);
+
+/// Compiled form of the batch-evaluable part of a WHERE clause.
+/// Leaves cover self-axis tag/attribute/id/depth/order comparisons (attribute leaves include
+/// CONTAINS forms and reuse the parser-compiled value-list index) plus ancestor-axis
+/// comparisons and EXISTS(ancestor ...), which are precomputed into per-node masks by a
+/// top-down pass; anything else is kept as residual conjuncts for the row-at-a-time evaluator.
+struct BatchPredicate {
+  struct Node {
+    enum class Kind { Leaf, And, Or } kind = Kind::Leaf;
+    enum class Column {
+      Tag,
+      NodeId,
+      ParentId,
+      MaxDepth,
+      DocOrder,
+      Attribute,
+      NodeMask
+    } column = Column::Tag;
+    CompareExpr::Op op = CompareExpr::Op::Eq;
+    bool never = false;
+    std::vector<uint8_t> allowed_tags;
+    std::vector<uint8_t> node_mask;
+    std::vector<int64_t> ints;
+    std::string attribute;
+    ValueList rhs;
+    size_t left = 0;
+    size_t right = 0;
+  };
+  std::vector<Node> nodes;
+  std::optional<size_t> root;
+  std::vector<const Expr*> residual;
+};
+
+/// Splits top-level AND conjuncts into batch-evaluable leaves and row-path residuals.
+/// MUST preserve semantics of eval_expr for every node.
+BatchPredicate compile_batch_predicate(const Expr& expr, const HtmlDocument& doc,
+                                       const std::vector<std::vector<int64_t>>& children,
+                                       const NodeColumns& columns);
+/// Adds a tag membership leaf (ANDed with the current root) for SELECT tag pruning.
+void add_batch_tag_filter(BatchPredicate& predicate, const NodeColumns& columns,
+                          const std::vector<std::string>& tags);
+/// Evaluates the batch predicate over nodes [begin, end) and appends matching ids.
+/// MUST append ids in ascending order and MUST NOT evaluate residual conjuncts.
+void eval_batch_predicate(const BatchPredicate& predicate, const HtmlDocument& doc,
+                          const NodeColumns& columns, size_t begin, size_t end,
+                          std::vector<uint32_t>& selection);
+
+}  // namespace markql::executor_internal
@@ -4,6 +4,7 @@
 #include <cctype>
 #include <regex>
 
+#include "../../util/string_search.h"
 #include "../../util/string_util.h"
 #include "../engine/markql_internal.h"
 
@@ -93,24 +94,24 @@ bool match_position_value(int64_t pos, const std::vector<std::string>& values, C
   return pos == *target;
 }
 
-bool match_attribute(const HtmlNode& node, const std::string& attr,
-                     const std::vector<std::string>& values, bool is_in) {
+bool match_attribute(const HtmlNode& node, const std::string& attr, const ValueList& rhs,
+                     bool is_in) {
   auto it = node.attributes.find(attr);
   if (it == node.attributes.end()) return false;
 
-  std::string attr_value = it->second;
+  const std::string& attr_value = it->second;
   if (attr == "class") {
     auto tokens = split_ws(attr_value);
     for (const auto& token : tokens) {
-      if (string_in_list(token, values)) return true;
+      if (value_list_contains(rhs, token)) return true;
     }
     return false;
   }
 
   if (is_in) {
-    return string_in_list(attr_value, values);
+    return value_list_contains(rhs, attr_value);
   }
-  return attr_value == values.front();
+  return attr_value == rhs.values.front();
 }
 
 bool has_descendant_attribute_exists(const HtmlDocument& doc,
@@ -234,27 +235,6 @@ ScalarValue value_from_operand(const Operand& operand, const HtmlDocument& doc,
 
 }  // namespace
 
-bool contains_ci(const std::string& haystack, const std::string& needle) {
-  if (needle.empty()) return true;
-  std::string lower_haystack = util::to_lower(haystack);
-  std::string lower_needle = util::to_lower(needle);
-  return lower_haystack.find(lower_needle) != std::string::npos;
-}
-
-bool contains_all_ci(const std::string& haystack, const std::vector<std::string>& tokens) {
-  for (const auto& token : tokens) {
-    if (!contains_ci(haystack, token)) return false;
-  }
-  return true;
-}
-
-bool contains_any_ci(const std::string& haystack, const std::vector<std::string>& tokens) {
-  for (const auto& token : tokens) {
-    if (contains_ci(haystack, token)) return true;
-  }
-  return false;
-}
-
 ScalarValue make_null() {
   return ScalarValue{};
 }
@@ -286,35 +266,6 @@ bool values_less(const ScalarValue& left, const ScalarValue& right) {
   return to_string_value(left) < to_string_value(right);
 }
 
-bool like_match_ci(const std::string& text, const std::string& pattern) {
-  std::string s = util::to_lower(text);
-  std::string p = util::to_lower(pattern);
-  size_t si = 0;
-  size_t pi = 0;
-  size_t star = std::string::npos;
-  size_t match = 0;
-  while (si < s.size()) {
-    if (pi < p.size() && (p[pi] == '_' || p[pi] == s[si])) {
-      ++si;
-      ++pi;
-      continue;
-    }
-    if (pi < p.size() && p[pi] == '%') {
-      star = pi++;
-      match = si;
-      continue;
-    }
-    if (star != std::string::npos) {
-      pi = star + 1;
-      si = ++match;
-      continue;
-    }
-    return false;
-  }
-  while (pi < p.size() && p[pi] == '%') ++pi;
-  return pi == p.size();
-}
-
 bool match_sibling_pos(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
                        const HtmlNode& node, const std::vector<std::string>& values,
                        CompareExpr::Op op) {
@@ -323,7 +274,8 @@ bool match_sibling_pos(const HtmlDocument& doc, const std::vector<std::vector<in
 }
 
 bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std::string& attr,
-                 const std::vector<std::string>& values, CompareExpr::Op op) {
+                 const ValueList& rhs, CompareExpr::Op op) {
+  const std::vector<std::string>& values = rhs.values;
   if ((op == CompareExpr::Op::Contains || op == CompareExpr::Op::ContainsAll ||
        op == CompareExpr::Op::ContainsAny) &&
       field_kind != Operand::FieldKind::Attribute) {
@@ -394,17 +346,17 @@ bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std:
     if (op == CompareExpr::Op::Contains) {
       auto it = node.attributes.find(attr);
       if (it == node.attributes.end()) return false;
-      return contains_ci(it->second, values.front());
+      return util::contains_ci(it->second, values.front());
     }
     if (op == CompareExpr::Op::ContainsAll) {
       auto it = node.attributes.find(attr);
       if (it == node.attributes.end()) return false;
-      return contains_all_ci(it->second, values);
+      return value_list_contains_all_ci(rhs, it->second);
     }
     if (op == CompareExpr::Op::ContainsAny) {
       auto it = node.attributes.find(attr);
       if (it == node.attributes.end()) return false;
-      return contains_any_ci(it->second, values);
+      return value_list_contains_any_ci(rhs, it->second);
     }
     if (op == CompareExpr::Op::Regex) {
       auto it = node.attributes.find(attr);
@@ -431,9 +383,9 @@ bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std:
     if (op == CompareExpr::Op::Like) {
       auto it = node.attributes.find(attr);
       if (it == node.attributes.end()) return false;
-      return like_match_ci(it->second, values.front());
+      return value_list_like_ci(rhs, it->second);
     }
-    return match_attribute(node, attr, values, is_in);
+    return match_attribute(node, attr, rhs, is_in);
   }
   if (field_kind == Operand::FieldKind::Tag) {
     if (op == CompareExpr::Op::Contains || op == CompareExpr::Op::ContainsAll ||
@@ -454,7 +406,7 @@ bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std:
       }
       return false;
     }
-    if (op == CompareExpr::Op::Like) return like_match_ci(node.tag, values.front());
+    if (op == CompareExpr::Op::Like) return value_list_like_ci(rhs, node.tag);
     if (op == CompareExpr::Op::NotEq) return node.tag != util::to_lower(values.front());
     if (op == CompareExpr::Op::Lt) return node.tag < util::to_lower(values.front());
     if (op == CompareExpr::Op::Lte) return node.tag <= util::to_lower(values.front());
@@ -470,8 +422,8 @@ bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std:
       return false;
     }
   }
-  if (is_in) return string_in_list(node.text, values);
-  if (op == CompareExpr::Op::Like) return like_match_ci(node.text, values.front());
+  if (is_in) return value_list_contains(rhs, node.text);
+  if (op == CompareExpr::Op::Like) return value_list_like_ci(rhs, node.text);
   if (op == CompareExpr::Op::NotEq) return node.text != values.front();
   if (op == CompareExpr::Op::Lt) return node.text < values.front();
   if (op == CompareExpr::Op::Lte) return node.text <= values.front();
@@ -481,18 +433,17 @@ bool match_field(const HtmlNode& node, Operand::FieldKind field_kind, const std:
 }
 
 bool has_child_node_id(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
-                       const HtmlNode& node, const std::vector<std::string>& values,
-                       CompareExpr::Op op) {
+                       const HtmlNode& node, const ValueList& rhs, CompareExpr::Op op) {
   for (int64_t id : children.at(static_cast<size_t>(node.id))) {
     const HtmlNode& child = doc.nodes.at(static_cast<size_t>(id));
-    if (match_field(child, Operand::FieldKind::NodeId, "", values, op)) return true;
+    if (match_field(child, Operand::FieldKind::NodeId, "", rhs, op)) return true;
   }
   return false;
 }
 
 bool has_descendant_node_id(const HtmlDocument& doc,
                             const std::vector<std::vector<int64_t>>& children, const HtmlNode& node,
-                            const std::vector<std::string>& values, CompareExpr::Op op) {
+                            const ValueList& rhs, CompareExpr::Op op) {
   std::vector<int64_t> stack;
   stack.insert(stack.end(), children.at(static_cast<size_t>(node.id)).begin(),
                children.at(static_cast<size_t>(node.id)).end());
@@ -500,7 +451,7 @@ bool has_descendant_node_id(const HtmlDocument& doc,
     int64_t id = stack.back();
     stack.pop_back();
     const HtmlNode& child = doc.nodes.at(static_cast<size_t>(id));
-    if (match_field(child, Operand::FieldKind::NodeId, "", values, op)) return true;
+    if (match_field(child, Operand::FieldKind::NodeId, "", rhs, op)) return true;
     const auto& next = children.at(static_cast<size_t>(id));
     stack.insert(stack.end(), next.begin(), next.end());
   }
@@ -579,7 +530,7 @@ bool axis_has_parent_id(const HtmlDocument& doc, const std::vector<std::vector<i
 bool has_descendant_field(const HtmlDocument& doc,
                           const std::vector<std::vector<int64_t>>& children, const HtmlNode& node,
                           Operand::FieldKind field_kind, const std::string& attr,
-                          const std::vector<std::string>& values, CompareExpr::Op op) {
+                          const ValueList& rhs, CompareExpr::Op op) {
   std::vector<int64_t> stack;
   stack.insert(stack.end(), children.at(static_cast<size_t>(node.id)).begin(),
                children.at(static_cast<size_t>(node.id)).end());
@@ -587,7 +538,7 @@ bool has_descendant_field(const HtmlDocument& doc,
     int64_t id = stack.back();
     stack.pop_back();
     const HtmlNode& child = doc.nodes.at(static_cast<size_t>(id));
-    if (match_field(child, field_kind, attr, values, op)) return true;
+    if (match_field(child, field_kind, attr, rhs, op)) return true;
     const auto& next = children.at(static_cast<size_t>(id));
     stack.insert(stack.end(), next.begin(), next.end());
   }
@@ -596,10 +547,10 @@ bool has_descendant_field(const HtmlDocument& doc,
 
 bool has_child_field(const HtmlDocument& doc, const std::vector<std::vector<int64_t>>& children,
                      const HtmlNode& node, Operand::FieldKind field_kind, const std::string& attr,
-                     const std::vector<std::string>& values, CompareExpr::Op op) {
+                     const ValueList& rhs, CompareExpr::Op op) {
   for (int64_t id : children.at(static_cast<size_t>(node.id))) {
     const HtmlNode& child = doc.nodes.at(static_cast<size_t>(id));
-    if (match_field(child, field_kind, attr, values, op)) return true;
+    if (match_field(child, field_kind, attr, rhs, op)) return true;
   }
   return false;
 }
@@ -683,7 +634,8 @@ ScalarValue eval_scalar_expr_impl(const ScalarExpr& expr, const HtmlDocument& do
 
     if (fn == "TEXT") return make_string(target->text);
     if (fn == "DIRECT_TEXT") {
-      return make_string(markql_internal::extract_direct_text_strict(target->inner_html));
+      std::string scratch;
+      return make_string(markql_internal::cached_direct_text_strict(doc, *target, scratch));
     }
     if (fn == "ATTR") {
       ScalarValue attr_value = eval_scalar_expr_impl(expr.args[1], doc, children, context);
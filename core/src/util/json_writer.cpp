@@ -0,0 +1,309 @@
+#include "markql/json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace markql {
+
+namespace {
+
+inline bool needs_escape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+/// Returns the offset of the first byte at or after `i` that needs escaping, or size().
+size_t find_escape(std::string_view value, size_t i) {
+  const char* data = value.data();
+  const size_t size = value.size();
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control_max = _mm_set1_epi8(0x1F);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // max_epu8(v, 0x1F) == 0x1F exactly when v <= 0x1F as an unsigned byte.
+    const __m128i hits =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                     _mm_cmpeq_epi8(_mm_max_epu8(v, control_max), control_max));
+    const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(hits));
+    if (bits != 0) return i + static_cast<size_t>(__builtin_ctz(bits));
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t control_end = vdupq_n_u8(0x20);
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+    const uint8x16_t hits =
+        vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)), vcltq_u8(v, control_end));
+    if (vmaxvq_u8(hits) != 0) break;
+  }
+#endif
+  for (; i < size; ++i) {
+    if (needs_escape(static_cast<unsigned char>(data[i]))) return i;
+  }
+  return size;
+}
+
+void append_escape(std::string& out, unsigned char c) {
+  switch (c) {
+    case '"':
+      out += "\\\"";
+      return;
+    case '\\':
+      out += "\\\\";
+      return;
+    case '\b':
+      out += "\\b";
+      return;
+    case '\f':
+      out += "\\f";
+      return;
+    case '\n':
+      out += "\\n";
+      return;
+    case '\r':
+      out += "\\r";
+      return;
+    case '\t':
+      out += "\\t";
+      return;
+    default: {
+      static constexpr char kHex[] = "0123456789abcdef";
+      const char escaped[] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0x0F]};
+      out.append(escaped, sizeof(escaped));
+      return;
+    }
+  }
+}
+
+/// Sorts map entries by key so object output does not depend on hash order.
+template <typename Map>
+std::vector<const typename Map::value_type*> sorted_entries(const Map& map) {
+  std::vector<const typename Map::value_type*> entries;
+  entries.reserve(map.size());
+  for (const auto& entry : map) entries.push_back(&entry);
+  std::sort(entries.begin(), entries.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  return entries;
+}
+
+}  // namespace
+
+void append_json_escaped(std::string& out, std::string_view value) {
+  size_t start = 0;
+  while (start < value.size()) {
+    const size_t hit = find_escape(value, start);
+    out.append(value.data() + start, hit - start);
+    if (hit == value.size()) return;
+    append_escape(out, static_cast<unsigned char>(value[hit]));
+    start = hit + 1;
+  }
+}
+
+void append_json_string(std::string& out, std::string_view value) {
+  out.reserve(out.size() + value.size() + 2);
+  out += '"';
+  append_json_escaped(out, value);
+  out += '"';
+}
+
+void append_json_number(std::string& out, double value) {
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  if (std::signbit(value)) {
+    out += '-';
+    value = -value;
+  }
+  if (value == 0.0) {
+    out += "0.0";
+    return;
+  }
+  // Shortest round-trip digits, then nlohmann's layout: plain decimals for exponents in
+  // (-4, 15], otherwise d.ddde+XX with at least two exponent digits.
+  char buf[32];
+  const auto [end, ec] =
+      std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::scientific);
+  (void)ec;
+  const std::string_view text(buf, static_cast<size_t>(end - buf));
+  const size_t e_pos = text.find('e');
+  std::string digits;
+  for (char c : text.substr(0, e_pos)) {
+    if (c != '.') digits += c;
+  }
+  const int k = static_cast<int>(digits.size());
+  const int n = std::atoi(buf + e_pos + 1) + 1;
+  constexpr int kMinExp = -4;
+  constexpr int kMaxExp = 15;
+  if (k <= n && n <= kMaxExp) {
+    out += digits;
+    out.append(static_cast<size_t>(n - k), '0');
+    out += ".0";
+  } else if (0 < n && n <= kMaxExp) {
+    out.append(digits, 0, static_cast<size_t>(n));
+    out += '.';
+    out.append(digits, static_cast<size_t>(n));
+  } else if (kMinExp < n && n <= 0) {
+    out += "0.";
+    out.append(static_cast<size_t>(-n), '0');
+    out += digits;
+  } else {
+    out += digits[0];
+    if (k > 1) {
+      out += '.';
+      out.append(digits, 1);
+    }
+    const int exponent = n - 1;
+    out += exponent < 0 ? "e-" : "e+";
+    const int magnitude = exponent < 0 ? -exponent : exponent;
+    if (magnitude < 10) out += '0';
+    out += std::to_string(magnitude);
+  }
+}
+
+JsonWriter::JsonWriter(std::string& out, int indent, int depth)
+    : out_(out), indent_(indent), base_depth_(depth) {}
+
+void JsonWriter::newline(int depth) {
+  out_ += '\n';
+  out_.append(static_cast<size_t>(indent_ * depth), ' ');
+}
+
+void JsonWriter::before_value() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (empty_.empty()) return;
+  if (!empty_.back()) out_ += ',';
+  empty_.back() = false;
+  if (indent_ > 0) newline(base_depth_ + static_cast<int>(empty_.size()));
+}
+
+void JsonWriter::begin_object() {
+  before_value();
+  out_ += '{';
+  empty_.push_back(true);
+}
+
+void JsonWriter::end_object() {
+  const bool empty = empty_.back();
+  empty_.pop_back();
+  if (indent_ > 0 && !empty) newline(base_depth_ + static_cast<int>(empty_.size()));
+  out_ += '}';
+}
+
+void JsonWriter::begin_array() {
+  before_value();
+  out_ += '[';
+  empty_.push_back(true);
+}
+
+void JsonWriter::end_array() {
+  const bool empty = empty_.back();
+  empty_.pop_back();
+  if (indent_ > 0 && !empty) newline(base_depth_ + static_cast<int>(empty_.size()));
+  out_ += ']';
+}
+
+void JsonWriter::key(std::string_view name) {
+  before_value();
+  append_json_string(out_, name);
+  out_ += indent_ > 0 ? ": " : ":";
+  after_key_ = true;
+}
+
+void JsonWriter::string(std::string_view value) {
+  before_value();
+  append_json_string(out_, value);
+}
+
+void JsonWriter::integer(int64_t value) {
+  before_value();
+  char buf[24];
+  const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+  (void)ec;
+  out_.append(buf, end);
+}
+
+void JsonWriter::number(double value) {
+  before_value();
+  append_json_number(out_, value);
+}
+
+void JsonWriter::boolean(bool value) {
+  before_value();
+  out_ += value ? "true" : "false";
+}
+
+void JsonWriter::null() {
+  before_value();
+  out_ += "null";
+}
+
+void JsonWriter::raw(std::string_view json) {
+  before_value();
+  out_ += json;
+}
+
+void write_json_field(JsonWriter& writer, const QueryResultRow& row, const std::string& field) {
+  if (field == "node_id" || field == "count") {
+    writer.integer(row.node_id);
+  } else if (field == "tag") {
+    writer.string(row.tag);
+  } else if (field == "text") {
+    writer.string(row.text);
+  } else if (field == "inner_html") {
+    writer.string(row.inner_html);
+  } else if (field == "parent_id") {
+    if (row.parent_id.has_value()) {
+      writer.integer(*row.parent_id);
+    } else {
+      writer.null();
+    }
+  } else if (field == "sibling_pos") {
+    writer.integer(row.sibling_pos);
+  } else if (field == "max_depth") {
+    writer.integer(row.max_depth);
+  } else if (field == "doc_order") {
+    writer.integer(row.doc_order);
+  } else if (field == "source_uri") {
+    writer.string(row.source_uri);
+  } else if (field == "attributes") {
+    writer.begin_object();
+    for (const auto* entry : sorted_entries(row.attributes)) {
+      writer.key(entry->first);
+      writer.string(entry->second);
+    }
+    writer.end_object();
+  } else if (field == "terms_score") {
+    writer.begin_object();
+    for (const auto* entry : sorted_entries(row.term_scores)) {
+      writer.key(entry->first);
+      writer.number(entry->second);
+    }
+    writer.end_object();
+  } else {
+    auto computed = row.computed_fields.find(field);
+    if (computed != row.computed_fields.end()) {
+      writer.string(computed->second);
+      return;
+    }
+    auto attr = row.attributes.find(field);
+    if (attr != row.attributes.end()) {
+      writer.string(attr->second);
+    } else {
+      writer.null();
+    }
+  }
+}
+
+}  // namespace markql
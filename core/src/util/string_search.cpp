@@ -0,0 +1,451 @@
+#include "string_search.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace markql::util {
+
+namespace {
+
+constexpr uint32_t kInvalidByteBase = 0x110000;
+
+inline unsigned char fold_ascii(unsigned char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + 32) : c;
+}
+
+inline bool is_ascii_letter(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool is_ascii(std::string_view s) {
+  const char* data = s.data();
+  size_t i = 0;
+  uint64_t acc = 0;
+  for (; i + 8 <= s.size(); i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + i, sizeof(word));
+    acc |= word;
+  }
+  for (; i < s.size(); ++i) {
+    acc |= static_cast<unsigned char>(data[i]);
+  }
+  return (acc & 0x8080808080808080ULL) == 0;
+}
+
+/// Simple one-to-one lowercase folding for Latin-1, Latin Extended-A, Greek and Cyrillic.
+uint32_t fold_code_point(uint32_t cp) {
+  if (cp < 0x80) return fold_ascii(static_cast<unsigned char>(cp));
+  if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+  if (cp >= 0x100 && cp <= 0x17F) {
+    if (cp == 0x178) return 0xFF;
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) {
+      return (cp & 1) ? cp + 1 : cp;
+    }
+    if (cp == 0x130 || cp == 0x131 || cp == 0x138 || cp == 0x149) return cp;
+    return (cp & 1) ? cp : cp + 1;
+  }
+  if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return cp + 0x20;
+  if (cp == 0x386) return 0x3AC;
+  if (cp >= 0x388 && cp <= 0x38A) return cp + 0x25;
+  if (cp == 0x38C) return 0x3CC;
+  if (cp == 0x38E || cp == 0x38F) return cp + 0x3F;
+  if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;
+  if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;
+  if ((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF)) {
+    return (cp & 1) ? cp : cp + 1;
+  }
+  return cp;
+}
+
+struct FoldedChar {
+  uint32_t cp = 0;
+  size_t len = 1;
+};
+
+inline bool is_continuation(unsigned char c) {
+  return (c & 0xC0) == 0x80;
+}
+
+/// Decodes one UTF-8 sequence at `i` and folds it; invalid bytes map to unique
+/// code points above U+10FFFF so they only match themselves.
+FoldedChar next_folded(std::string_view s, size_t i) {
+  const unsigned char c0 = static_cast<unsigned char>(s[i]);
+  if (c0 < 0x80) return {fold_ascii(c0), 1};
+  size_t len = 0;
+  uint32_t cp = 0;
+  if (c0 >= 0xC2 && c0 <= 0xDF) {
+    len = 2;
+    cp = c0 & 0x1F;
+  } else if (c0 >= 0xE0 && c0 <= 0xEF) {
+    len = 3;
+    cp = c0 & 0x0F;
+  } else if (c0 >= 0xF0 && c0 <= 0xF4) {
+    len = 4;
+    cp = c0 & 0x07;
+  } else {
+    return {kInvalidByteBase + c0, 1};
+  }
+  if (i + len > s.size()) return {kInvalidByteBase + c0, 1};
+  for (size_t k = 1; k < len; ++k) {
+    const unsigned char ck = static_cast<unsigned char>(s[i + k]);
+    if (!is_continuation(ck)) return {kInvalidByteBase + c0, 1};
+    cp = (cp << 6) | (ck & 0x3F);
+  }
+  return {fold_code_point(cp), len};
+}
+
+inline bool equal_ascii_ci(const char* text, const char* needle, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (fold_ascii(static_cast<unsigned char>(text[i])) !=
+        fold_ascii(static_cast<unsigned char>(needle[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// First/last-byte filtered search for an ASCII needle. Haystack bytes >= 0x80 never
+/// fold, so the byte-wise comparison is exact for UTF-8 haystacks as well.
+size_t find_ascii_ci(std::string_view hay, std::string_view needle) {
+  const size_t m = needle.size();
+  if (m > hay.size()) return std::string_view::npos;
+  const unsigned char first = fold_ascii(static_cast<unsigned char>(needle.front()));
+  const unsigned char last = fold_ascii(static_cast<unsigned char>(needle.back()));
+  const unsigned char first_mask = is_ascii_letter(first) ? 0x20 : 0x00;
+  const unsigned char last_mask = is_ascii_letter(last) ? 0x20 : 0x00;
+  const char* data = hay.data();
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i v_first = _mm_set1_epi8(static_cast<char>(first));
+  const __m128i v_last = _mm_set1_epi8(static_cast<char>(last));
+  const __m128i m_first = _mm_set1_epi8(static_cast<char>(first_mask));
+  const __m128i m_last = _mm_set1_epi8(static_cast<char>(last_mask));
+  for (; i + m - 1 + 16 <= hay.size(); i += 16) {
+    const __m128i head =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i tail =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + m - 1));
+    const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(head, m_first), v_first),
+                                     _mm_cmpeq_epi8(_mm_or_si128(tail, m_last), v_last));
+    unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(eq));
+    while (bits != 0) {
+      const unsigned k = static_cast<unsigned>(__builtin_ctz(bits));
+      if (equal_ascii_ci(data + i + k, needle.data(), m)) return i + k;
+      bits &= bits - 1;
+    }
+  }
+#endif
+  for (; i + m <= hay.size(); ++i) {
+    const unsigned char h = static_cast<unsigned char>(data[i]);
+    const unsigned char t = static_cast<unsigned char>(data[i + m - 1]);
+    if (static_cast<unsigned char>(h | first_mask) != first ||
+        static_cast<unsigned char>(t | last_mask) != last) {
+      continue;
+    }
+    if (equal_ascii_ci(data + i, needle.data(), m)) return i;
+  }
+  return std::string_view::npos;
+}
+
+size_t find_utf8_ci(std::string_view hay, std::string_view needle) {
+  size_t start = 0;
+  while (start < hay.size()) {
+    size_t h = start;
+    size_t n = 0;
+    while (n < needle.size() && h < hay.size()) {
+      const FoldedChar a = next_folded(hay, h);
+      const FoldedChar b = next_folded(needle, n);
+      if (a.cp != b.cp) break;
+      h += a.len;
+      n += b.len;
+    }
+    if (n == needle.size()) return start;
+    start += next_folded(hay, start).len;
+  }
+  return std::string_view::npos;
+}
+
+/// Matches an ASCII LIKE segment ('_' = any byte) at `at`; caller checks bounds.
+inline bool segment_matches_at(std::string_view segment, std::string_view text, size_t at) {
+  for (size_t i = 0; i < segment.size(); ++i) {
+    const char p = segment[i];
+    if (p == '_') continue;
+    if (fold_ascii(static_cast<unsigned char>(p)) !=
+        fold_ascii(static_cast<unsigned char>(text[at + i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Code-point LIKE matcher used for non-ASCII input or very fragmented patterns.
+bool like_match_generic(std::string_view s, std::string_view p) {
+  size_t si = 0;
+  size_t pi = 0;
+  size_t star = std::string_view::npos;
+  size_t match = 0;
+  while (si < s.size()) {
+    if (pi < p.size()) {
+      if (p[pi] == '%') {
+        star = pi++;
+        match = si;
+        continue;
+      }
+      const FoldedChar sc = next_folded(s, si);
+      if (p[pi] == '_') {
+        si += sc.len;
+        ++pi;
+        continue;
+      }
+      const FoldedChar pc = next_folded(p, pi);
+      if (pc.cp == sc.cp) {
+        si += sc.len;
+        pi += pc.len;
+        continue;
+      }
+    }
+    if (star != std::string_view::npos) {
+      pi = star + 1;
+      match += next_folded(s, match).len;
+      si = match;
+      continue;
+    }
+    return false;
+  }
+  while (pi < p.size() && p[pi] == '%') ++pi;
+  return pi == p.size();
+}
+
+}  // namespace
+
+size_t find_ci(std::string_view haystack, std::string_view needle) {
+  if (needle.empty()) return 0;
+  if (is_ascii(needle)) return find_ascii_ci(haystack, needle);
+  return find_utf8_ci(haystack, needle);
+}
+
+bool contains_ci(std::string_view haystack, std::string_view needle) {
+  return find_ci(haystack, needle) != std::string_view::npos;
+}
+
+bool contains_all_ci(std::string_view haystack, const std::vector<std::string>& tokens) {
+  for (const auto& token : tokens) {
+    if (!contains_ci(haystack, token)) return false;
+  }
+  return true;
+}
+
+bool contains_any_ci(std::string_view haystack, const std::vector<std::string>& tokens) {
+  for (const auto& token : tokens) {
+    if (contains_ci(haystack, token)) return true;
+  }
+  return false;
+}
+
+size_t StringSet::Hash::operator()(std::string_view value) const noexcept {
+  return std::hash<std::string_view>{}(value);
+}
+
+StringSet::StringSet(const std::vector<std::string>& values)
+    : values_(values.begin(), values.end()) {}
+
+bool StringSet::contains(std::string_view value) const {
+  return values_.find(value) != values_.end();
+}
+
+MultiPatternMatcher::MultiPatternMatcher(const std::vector<std::string>& tokens) {
+  std::vector<std::string_view> ascii_tokens;
+  for (const auto& token : tokens) {
+    if (token.empty()) {
+      has_empty_token_ = true;
+    } else if (is_ascii(token)) {
+      ascii_tokens.push_back(token);
+    } else {
+      utf8_tokens_.push_back(token);
+    }
+  }
+
+  // Byte classes keep the transition table dense: one column per folded byte that occurs in
+  // a token, plus class 0 for every other byte.
+  for (std::string_view token : ascii_tokens) {
+    for (char c : token) {
+      const unsigned char folded = fold_ascii(static_cast<unsigned char>(c));
+      if (byte_class_[folded] == 0) {
+        byte_class_[folded] = static_cast<uint8_t>(alphabet_size_++);
+      }
+    }
+  }
+  for (unsigned c = 'A'; c <= 'Z'; ++c) {
+    byte_class_[c] = byte_class_[c + 32];
+  }
+
+  transitions_.assign(alphabet_size_, kNoPattern);
+  terminal_.push_back(kNoPattern);
+  for (std::string_view token : ascii_tokens) {
+    uint32_t state = 0;
+    for (char c : token) {
+      const size_t slot = state * alphabet_size_ + byte_class_[static_cast<unsigned char>(c)];
+      if (transitions_[slot] == kNoPattern) {
+        transitions_[slot] = static_cast<uint32_t>(terminal_.size());
+        terminal_.push_back(kNoPattern);
+        transitions_.resize(transitions_.size() + alphabet_size_, kNoPattern);
+      }
+      state = transitions_[slot];
+    }
+    if (terminal_[state] == kNoPattern) {
+      terminal_[state] = static_cast<uint32_t>(ascii_pattern_count_++);
+    }
+  }
+
+  // Breadth-first failure construction turns the trie into a complete DFA; output_link_
+  // points at the nearest proper suffix state that ends a token.
+  const size_t state_count = terminal_.size();
+  std::vector<uint32_t> fail(state_count, 0);
+  output_link_.assign(state_count, kNoPattern);
+  std::vector<uint32_t> queue;
+  queue.reserve(state_count);
+  for (size_t cls = 0; cls < alphabet_size_; ++cls) {
+    uint32_t& next = transitions_[cls];
+    if (next == kNoPattern) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const uint32_t state = queue[head];
+    for (size_t cls = 0; cls < alphabet_size_; ++cls) {
+      const size_t slot = state * alphabet_size_ + cls;
+      const uint32_t fallback = transitions_[fail[state] * alphabet_size_ + cls];
+      const uint32_t next = transitions_[slot];
+      if (next == kNoPattern) {
+        transitions_[slot] = fallback;
+        continue;
+      }
+      fail[next] = fallback;
+      output_link_[next] = terminal_[fallback] != kNoPattern ? fallback : output_link_[fallback];
+      queue.push_back(next);
+    }
+  }
+}
+
+bool MultiPatternMatcher::contains_any(std::string_view text) const {
+  if (has_empty_token_) return true;
+  if (ascii_pattern_count_ > 0) {
+    uint32_t state = 0;
+    for (char c : text) {
+      state = transitions_[state * alphabet_size_ + byte_class_[static_cast<unsigned char>(c)]];
+      if (terminal_[state] != kNoPattern || output_link_[state] != kNoPattern) return true;
+    }
+  }
+  for (const auto& token : utf8_tokens_) {
+    if (find_utf8_ci(text, token) != std::string_view::npos) return true;
+  }
+  return false;
+}
+
+bool MultiPatternMatcher::contains_all(std::string_view text) const {
+  if (ascii_pattern_count_ > 0) {
+    // WHY: this runs once per row; a per-thread buffer that only grows keeps it allocation-free
+    // while the matcher itself stays const and shareable across worker threads.
+    thread_local std::vector<uint8_t> seen;
+    seen.assign(ascii_pattern_count_, 0);
+    size_t remaining = ascii_pattern_count_;
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size() && remaining > 0; ++i) {
+      state = transitions_[state * alphabet_size_ +
+                           byte_class_[static_cast<unsigned char>(text[i])]];
+      uint32_t out = terminal_[state] != kNoPattern ? state : output_link_[state];
+      while (out != kNoPattern) {
+        const uint32_t id = terminal_[out];
+        if (seen[id] == 0) {
+          seen[id] = 1;
+          --remaining;
+        }
+        out = output_link_[out];
+      }
+    }
+    if (remaining > 0) return false;
+  }
+  for (const auto& token : utf8_tokens_) {
+    if (find_utf8_ci(text, token) == std::string_view::npos) return false;
+  }
+  return true;
+}
+
+LikePattern::LikePattern(std::string_view pattern) : pattern_(pattern) {
+  ascii_ = is_ascii(pattern);
+  leading_percent_ = !pattern.empty() && pattern.front() == '%';
+  trailing_percent_ = !pattern.empty() && pattern.back() == '%';
+  segmented_ = true;
+  size_t start = 0;
+  while (start <= pattern.size()) {
+    size_t end = pattern.find('%', start);
+    if (end == std::string_view::npos) end = pattern.size();
+    if (end > start) {
+      if (segment_count_ == kMaxSegments) {
+        segmented_ = false;
+        break;
+      }
+      Segment& segment = segments_[segment_count_++];
+      segment.text = pattern.substr(start, end - start);
+      segment.has_wildcard = segment.text.find('_') != std::string_view::npos;
+    }
+    start = end + 1;
+  }
+}
+
+bool LikePattern::matches(std::string_view text) const {
+  if (!segmented_ || !ascii_ || !is_ascii(text)) {
+    return like_match_generic(text, pattern_);
+  }
+  if (segment_count_ == 0) return leading_percent_ || text.empty();
+
+  size_t pos = 0;
+  size_t end = text.size();
+  size_t first = 0;
+  size_t last = segment_count_;
+  if (!leading_percent_) {
+    const std::string_view head = segments_[0].text;
+    if (head.size() > text.size() || !segment_matches_at(head, text, 0)) return false;
+    if (segment_count_ == 1 && !trailing_percent_) return head.size() == text.size();
+    pos = head.size();
+    first = 1;
+  }
+  if (!trailing_percent_) {
+    const std::string_view tail = segments_[segment_count_ - 1].text;
+    if (pos + tail.size() > text.size()) return false;
+    end = text.size() - tail.size();
+    if (!segment_matches_at(tail, text, end)) return false;
+    last = segment_count_ - 1;
+  }
+  for (size_t i = first; i < last; ++i) {
+    const Segment& segment = segments_[i];
+    const std::string_view window = text.substr(pos, end - pos);
+    if (segment.text.size() > window.size()) return false;
+    size_t found = std::string_view::npos;
+    if (!segment.has_wildcard) {
+      found = find_ascii_ci(window, segment.text);
+    } else {
+      for (size_t at = 0; at + segment.text.size() <= window.size(); ++at) {
+        if (segment_matches_at(segment.text, window, at)) {
+          found = at;
+          break;
+        }
+      }
+    }
+    if (found == std::string_view::npos) return false;
+    pos += found + segment.text.size();
+  }
+  return true;
+}
+
+bool like_match_ci(std::string_view text, std::string_view pattern) {
+  return LikePattern(pattern).matches(text);
+}
+
+}  // namespace markql::util
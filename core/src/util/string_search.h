@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace markql::util {
+
+/// Finds `needle` in `haystack` ignoring case and returns the byte offset or npos.
+/// MUST fold ASCII letters byte-wise and MUST fold common UTF-8 letters when the needle is
+/// non-ASCII; MUST NOT allocate.
+/// Inputs are string views; outputs are byte offsets with no side effects.
+size_t find_ci(std::string_view haystack, std::string_view needle);
+/// Checks whether `needle` occurs in `haystack` ignoring case (empty needles always match).
+bool contains_ci(std::string_view haystack, std::string_view needle);
+/// Checks that every token occurs in `haystack` ignoring case.
+bool contains_all_ci(std::string_view haystack, const std::vector<std::string>& tokens);
+/// Checks that at least one token occurs in `haystack` ignoring case.
+bool contains_any_ci(std::string_view haystack, const std::vector<std::string>& tokens);
+
+/// Literal lists shorter than this are scanned linearly; longer lists get a compiled index.
+constexpr size_t kCompiledValueListMinSize = 4;
+
+/// Exact-match hash set for literal IN lists.
+/// MUST compare bytes exactly (no case folding) and MUST NOT allocate on lookup.
+class StringSet {
+ public:
+  explicit StringSet(const std::vector<std::string>& values);
+  bool contains(std::string_view value) const;
+
+ private:
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const noexcept;
+  };
+  std::unordered_set<std::string, Hash, std::equal_to<>> values_;
+};
+
+/// Case-insensitive Aho–Corasick automaton for CONTAINS ANY / CONTAINS ALL token lists.
+/// ASCII tokens are matched in one pass over the text; non-ASCII tokens fall back to find_ci
+/// so folding stays identical to contains_ci.
+class MultiPatternMatcher {
+ public:
+  explicit MultiPatternMatcher(const std::vector<std::string>& tokens);
+  /// Returns true when at least one token occurs in `text`.
+  bool contains_any(std::string_view text) const;
+  /// Returns true when every token occurs in `text`.
+  /// Does not allocate once the calling thread has checked a list at least this long.
+  bool contains_all(std::string_view text) const;
+
+ private:
+  static constexpr uint32_t kNoPattern = 0xFFFFFFFFu;
+
+  std::array<uint8_t, 256> byte_class_{};
+  size_t alphabet_size_ = 1;
+  std::vector<uint32_t> transitions_;
+  std::vector<uint32_t> terminal_;
+  std::vector<uint32_t> output_link_;
+  size_t ascii_pattern_count_ = 0;
+  bool has_empty_token_ = false;
+  std::vector<std::string> utf8_tokens_;
+};
+
+/// Compiled SQL LIKE pattern: '%' matches any run, '_' matches one character.
+/// Literal segments between '%' are matched with the case-insensitive substring kernel.
+/// MUST keep the pattern storage alive while the matcher is used; MUST NOT allocate.
+class LikePattern {
+ public:
+  explicit LikePattern(std::string_view pattern);
+  bool matches(std::string_view text) const;
+
+ private:
+  static constexpr size_t kMaxSegments = 16;
+  struct Segment {
+    std::string_view text;
+    bool has_wildcard = false;
+  };
+
+  std::string_view pattern_;
+  std::array<Segment, kMaxSegments> segments_{};
+  size_t segment_count_ = 0;
+  bool leading_percent_ = false;
+  bool trailing_percent_ = false;
+  bool ascii_ = true;
+  bool segmented_ = false;
+};
+
+/// LikePattern that owns its pattern text, so the parser can compile a literal once and
+/// share it with every row that evaluates the comparison.
+class CompiledLikePattern {
+ public:
+  explicit CompiledLikePattern(std::string pattern)
+      : pattern_(std::move(pattern)), matcher_(pattern_) {}
+  CompiledLikePattern(const CompiledLikePattern&) = delete;
+  CompiledLikePattern& operator=(const CompiledLikePattern&) = delete;
+
+  bool matches(std::string_view text) const { return matcher_.matches(text); }
+
+ private:
+  std::string pattern_;
+  LikePattern matcher_;
+};
+
+/// Matches `text` against a LIKE pattern ignoring case; compiles `pattern` on every call,
+/// so row loops over a literal pattern SHOULD use CompiledLikePattern instead.
+/// MUST treat '%' as any run and '_' as exactly one character.
+bool like_match_ci(std::string_view text, std::string_view pattern);
+
+}  // namespace markql::util
@@ -11,10 +11,11 @@ syn keyword markqlFunction ATTR FIRST_ATTR LAST_ATTR INNER_HTML RAW_INNER_HTML R
 syn keyword markqlFunction COUNT SUMMARIZE TFIDF COALESCE CASE WHEN THEN ELSE END POSITION LOCATE CONCAT
 syn keyword markqlFunction SUBSTRING SUBSTR LENGTH CHAR_LENGTH REPLACE LOWER UPPER TRIM LTRIM RTRIM
 syn keyword markqlAxis self parent child ancestor descendant
-syn keyword markqlConstant MAX_DEPTH FIRST LAST ALL ANY ASC DESC LIST TABLE CSV PARQUET JSON NDJSON
+syn keyword markqlConstant MAX_DEPTH FIRST LAST ALL ANY ASC DESC LIST TABLE CSV PARQUET JSON NDJSON ARROW
 syn keyword markqlConstant HEADER NOHEADER NO_HEADER EXPORT TRIM_EMPTY_ROWS TRIM_EMPTY_COLS EMPTY_IS
 syn keyword markqlConstant STOP_AFTER_EMPTY_ROWS FORMAT SPARSE_SHAPE HEADER_NORMALIZE TRAILING
 syn keyword markqlConstant BLANK_OR_NULL NULL_ONLY BLANK_ONLY RECT SPARSE LONG WIDE
+syn keyword markqlConstant ROW_GROUP COMPRESSION INFER_TYPES FSYNC SNAPPY ZSTD GZIP UNCOMPRESSED
 syn keyword markqlConstant TOP_TERMS MIN_DF MAX_DF STOPWORDS NONE OFF ON ENGLISH DEFAULT
 
 syn match markqlComment "--.*$"
@@ -101,6 +101,30 @@ def summarize(doc: Document, *, max_nodes_preview: int = 50) -> Dict[str, object
     return summarize_document(doc, max_nodes_preview)
 
 
+def _resolve_document(
+    source: Any,
+    doc: Optional[Document],
+    *,
+    allow_network: bool,
+    base_dir: Optional[str],
+    timeout: int,
+    max_bytes: int,
+) -> Document:
+    active = doc or globals().get("doc")
+    if active is not None:
+        return active
+    if source is None:
+        raise ValueError("No document loaded; provide doc or source")
+    policy = FetchPolicy(
+        allow_network=allow_network,
+        allow_private_network=False,
+        timeout=timeout,
+        max_bytes=max_bytes,
+    )
+    html, origin = load_html_source(source, base_dir=base_dir, policy=policy)
+    return Document(html=html, source=origin)
+
+
 def execute(
     query: str,
     *,
@@ -122,18 +146,10 @@ def execute(
     _require_core()
     if params:
         raise ValueError("params are not supported by MARKQL execution")
-    active = doc or globals().get("doc")
-    if active is None:
-        if source is None:
-            raise ValueError("No document loaded; provide doc or source")
-        policy = FetchPolicy(
-            allow_network=allow_network,
-            allow_private_network=False,
-            timeout=timeout,
-            max_bytes=max_bytes,
-        )
-        html, origin = load_html_source(source, base_dir=base_dir, policy=policy)
-        active = Document(html=html, source=origin)
+    active = _resolve_document(
+        source, doc, allow_network=allow_network, base_dir=base_dir, timeout=timeout,
+        max_bytes=max_bytes,
+    )
     raw = _core.execute_from_document(active.html, query)
     rows = raw.get("rows", [])
     tables = []
@@ -158,6 +174,65 @@ def execute(
     )
 
 
+def execute_arrow(
+    query: str,
+    *,
+    source: Any = None,
+    doc: Optional[Document] = None,
+    allow_network: bool = False,
+    base_dir: Optional[str] = None,
+    timeout: int = 10,
+    max_bytes: int = 5_000_000,
+    max_results: int = 10_000,
+) -> Any:
+    """Executes an MARKQL query and returns its rows as a columnar Arrow batch.
+
+    The result implements the Arrow PyCapsule interface, so pyarrow.record_batch(result),
+    polars.from_arrow(result) and similar consumers adopt its buffers without copying.
+    TO TABLE() queries are rejected; use execute() for those.
+    """
+
+    _require_core()
+    active = _resolve_document(
+        source, doc, allow_network=allow_network, base_dir=base_dir, timeout=timeout,
+        max_bytes=max_bytes,
+    )
+    batch = _core.execute_arrow_from_document(active.html, query)
+    if batch.num_rows > max_results:
+        raise ValueError("Query result exceeds max_results")
+    return batch
+
+
+def execute_json(
+    query: str,
+    *,
+    source: Any = None,
+    doc: Optional[Document] = None,
+    lines: bool = False,
+    allow_network: bool = False,
+    base_dir: Optional[str] = None,
+    timeout: int = 10,
+    max_bytes: int = 5_000_000,
+    max_results: int = 10_000,
+) -> str:
+    """Executes an MARKQL query and returns its rows as JSON text.
+
+    Rows are serialized by the native JSON writer while the query runs, without building
+    Python objects: a JSON array of objects, or newline-delimited objects when lines=True.
+    Values are typed like execute() rows. TO TABLE() queries are rejected; use execute().
+    """
+
+    _require_core()
+    active = _resolve_document(
+        source, doc, allow_network=allow_network, base_dir=base_dir, timeout=timeout,
+        max_bytes=max_bytes,
+    )
+    text, row_count = _core.execute_json_from_document(active.html, query, lines)
+    if row_count > max_results:
+        raise ValueError("Query result exceeds max_results")
+    return text
+
+
 def lint(query: str) -> list[dict]:
     """Parses + validates a query and returns diagnostics without execution."""
     if hasattr(_core, "lint_query"):
@@ -290,6 +365,8 @@ __all__ = [
     "load",
     "summarize",
     "execute",
+    "execute_arrow",
+    "execute_json",
     "lint",
     "lint_detailed",
     "core_version",
@@ -1,9 +1,14 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <memory>
+
 #include "helper/helper_controller.h"
 #include "helper/helper_policy.h"
 #include "helper/helper_result_analysis.h"
+#include "markql/arrow_c_data.h"
+#include "markql/columnar_result.h"
+#include "markql/json_writer.h"
 #include "markql/markql.h"
 
 namespace py = pybind11;
@@ -55,6 +60,96 @@ py::dict row_to_dict(const markql::QueryResultRow& row, const std::vector<std::s
   return out;
 }
 
+/// Serializes rows into JSON text while the engine produces them: one array of objects, or
+/// one object per line. Implicit columns that may still gain source_uri are declined, like the
+/// CLI sink does; execute_json_from_document then writes the finished rows instead.
+class JsonRowsSink : public markql::QueryResultSink {
+ public:
+  explicit JsonRowsSink(bool lines) : lines_(lines) {}
+
+  bool begin(const markql::QueryResult& header) override {
+    if (header.to_table || !header.tables.empty()) return false;
+    if (header.columns_implicit && !header.source_uri_excluded) return false;
+    start(header.columns);
+    return true;
+  }
+  void row(const markql::QueryResultRow& row) override {
+    if (!lines_ && rows_ > 0) text_ += ',';
+    markql::JsonWriter writer(text_);
+    writer.begin_object();
+    for (const auto& column : columns_) {
+      writer.key(column);
+      markql::write_json_field(writer, row, column);
+    }
+    writer.end_object();
+    if (lines_) text_ += '\n';
+    ++rows_;
+  }
+  void end() override {
+    if (!lines_) text_ += ']';
+    streamed_ = true;
+  }
+
+  void start(const std::vector<std::string>& columns) {
+    columns_ = columns;
+    if (!lines_) text_ += '[';
+  }
+  bool streamed() const { return streamed_; }
+  size_t rows() const { return rows_; }
+  const std::string& text() const { return text_; }
+
+ private:
+  bool lines_;
+  bool streamed_ = false;
+  size_t rows_ = 0;
+  std::vector<std::string> columns_;
+  std::string text_;
+};
+
+/// A query result in Arrow layout that Arrow consumers import through the PyCapsule interface
+/// (`__arrow_c_schema__` / `__arrow_c_array__`) without copying the column buffers.
+struct ArrowBatch {
+  std::shared_ptr<const markql::ColumnarResult> result;
+};
+
+void release_schema_capsule(PyObject* capsule) {
+  auto* schema = static_cast<ArrowSchema*>(PyCapsule_GetPointer(capsule, "arrow_schema"));
+  if (schema == nullptr) return;
+  if (schema->release != nullptr) schema->release(schema);
+  delete schema;
+}
+
+void release_array_capsule(PyObject* capsule) {
+  auto* array = static_cast<ArrowArray*>(PyCapsule_GetPointer(capsule, "arrow_array"));
+  if (array == nullptr) return;
+  if (array->release != nullptr) array->release(array);
+  delete array;
+}
+
+/// Wraps freshly exported structs in the capsules the Arrow PyCapsule protocol expects; a
+/// consumer that imports them clears `release`, so the destructors then only free the structs.
+py::tuple export_arrow_capsules(const ArrowBatch& batch) {
+  auto schema = std::make_unique<ArrowSchema>();
+  auto array = std::make_unique<ArrowArray>();
+  markql::export_columnar_result(batch.result, schema.get(), array.get());
+  py::object schema_capsule = py::reinterpret_steal<py::object>(
+      PyCapsule_New(schema.get(), "arrow_schema", &release_schema_capsule));
+  if (!schema_capsule) {
+    schema->release(schema.get());
+    array->release(array.get());
+    throw py::error_already_set();
+  }
+  schema.release();
+  py::object array_capsule = py::reinterpret_steal<py::object>(
+      PyCapsule_New(array.get(), "arrow_array", &release_array_capsule));
+  if (!array_capsule) {
+    array->release(array.get());
+    throw py::error_already_set();
+  }
+  array.release();
+  return py::make_tuple(schema_capsule, array_capsule);
+}
+
 py::dict diagnostic_span_to_dict(const markql::DiagnosticSpan& span) {
   py::dict out;
   out["start_line"] = span.start_line;
@@ -448,6 +543,66 @@ PYBIND11_MODULE(_core, m) {
       },
       py::arg("html"), py::arg("query"));
 
+  py::class_<ArrowBatch>(m, "ArrowBatch")
+      .def_property_readonly("num_rows",
+                             [](const ArrowBatch& batch) { return batch.result->num_rows; })
+      .def_property_readonly("column_names",
+                             [](const ArrowBatch& batch) {
+                               std::vector<std::string> names;
+                               for (const auto& column : batch.result->columns) {
+                                 names.push_back(column.name);
+                               }
+                               return names;
+                             })
+      .def_property_readonly("warnings",
+                             [](const ArrowBatch& batch) { return batch.result->warnings; })
+      .def("__arrow_c_schema__",
+           [](const ArrowBatch& batch) { return py::object(export_arrow_capsules(batch)[0]); })
+      .def(
+          "__arrow_c_array__",
+          [](const ArrowBatch& batch, py::object requested_schema) {
+            if (!requested_schema.is_none()) {
+              throw py::value_error("ArrowBatch does not support casting to a requested schema");
+            }
+            return export_arrow_capsules(batch);
+          },
+          py::arg("requested_schema") = py::none());
+
+  m.def(
+      "execute_arrow_from_document",
+      [](const std::string& html, const std::string& query) {
+        markql::ColumnarResultBuilder builder;
+        markql::QueryResult result = markql::execute_query_from_document(html, query, builder);
+        if (result.to_table || !result.tables.empty()) {
+          throw std::runtime_error("TO TABLE() results have no Arrow representation");
+        }
+        ArrowBatch batch;
+        batch.result = std::make_shared<const markql::ColumnarResult>(builder.finish(result));
+        return batch;
+      },
+      py::arg("html"), py::arg("query"));
+
+  m.def(
+      "execute_json_from_document",
+      [](const std::string& html, const std::string& query, bool lines) {
+        JsonRowsSink sink(lines);
+        markql::QueryResult result = markql::execute_query_from_document(html, query, sink);
+        if (result.to_table || !result.tables.empty()) {
+          throw std::runtime_error("TO TABLE() results are not serialized as JSON rows");
+        }
+        if (!sink.streamed()) {
+          sink.start(result.columns);
+          for (const auto& row : result.rows) sink.row(row);
+          sink.end();
+        }
+        // Cell text is copied from the HTML as is, so undecodable bytes become U+FFFD here.
+        py::object text = py::reinterpret_steal<py::object>(PyUnicode_DecodeUTF8(
+            sink.text().data(), static_cast<Py_ssize_t>(sink.text().size()), "replace"));
+        if (!text) throw py::error_already_set();
+        return py::make_tuple(text, sink.rows());
+      },
+      py::arg("html"), py::arg("query"), py::arg("lines") = false);
+
   m.def(
       "lint_query",
       [](const std::string& query) {
@@ -1,5 +1,8 @@
+import json
 import pathlib
 
+import pytest
+
 import markql
 
 
@@ -43,3 +46,30 @@ def test_regex_replace_in_python_execute() -> None:
     )
     assert len(result.rows) == 1
     assert result.rows[0]["digits"] == "278120"
+
+
+def test_execute_arrow_exports_typed_columns() -> None:
+    pa = pytest.importorskip("pyarrow")
+    doc = markql.load("<html><body><a href='x' id='1'>One</a><a>Two</a></body></html>")
+    batch = markql.execute_arrow(
+        "SELECT a.node_id, a.tag, a.href, a.attributes FROM document", doc=doc
+    )
+    assert batch.num_rows == 2
+    table = pa.record_batch(batch)
+    table.validate(full=True)
+    assert table.schema.field("node_id").type == pa.int64()
+    assert pa.types.is_dictionary(table.schema.field("tag").type)
+    assert table.column("href").to_pylist() == ["x", None]
+    assert table.column("attributes").to_pylist()[0] == [("href", "x"), ("id", "1")]
+
+
+def test_execute_json_serializes_typed_rows() -> None:
+    doc = markql.load("<html><body><a href='x' id='1'>One \"q\"</a><a>Two</a></body></html>")
+    query = "SELECT a.node_id, a.href, a.attributes, TEXT(a) FROM document WHERE tag = 'a'"
+    rows = json.loads(markql.execute_json(query, doc=doc))
+    expected = markql.execute(query, doc=doc).rows
+    assert rows == expected
+    assert rows[0]["attributes"] == {"href": "x", "id": "1"}
+    assert rows[1]["href"] is None
+    lines = markql.execute_json(query, doc=doc, lines=True).splitlines()
+    assert [json.loads(line) for line in lines] == expected
@@ -60,12 +60,16 @@ def core_sources() -> list[str]:
         "core/src/lang/parser/parser_util.cpp",
         "core/src/lang/parser/lexer.cpp",
         "core/src/dom/html_parser.cpp",
+        "core/src/dom/node_text_cache.cpp",
         "core/src/dom/backend/parser_naive.cpp",
         "core/src/dom/backend/parser_libxml2.cpp",
         "core/src/runtime/executor/executor.cpp",
         "core/src/runtime/executor/filter.cpp",
+        "core/src/runtime/executor/filter_batch.cpp",
         "core/src/runtime/executor/filter_scalar.cpp",
         "core/src/runtime/executor/order.cpp",
+        "core/src/util/json_writer.cpp",
+        "core/src/util/string_search.cpp",
         "core/src/util/string_util.cpp",
         "core/src/runtime/engine/execute.cpp",
         "core/src/runtime/engine/execute_common.cpp",
@@ -79,11 +83,19 @@ def core_sources() -> list[str]:
         "core/src/runtime/engine/execute_relation_join.cpp",
         "core/src/runtime/engine/execute_relation_expr.cpp",
         "core/src/runtime/engine/execute_relation_result.cpp",
+        "core/src/runtime/engine/relation_table.cpp",
+        "core/src/runtime/engine/relation_hash_join.cpp",
+        "core/src/runtime/engine/relation_pushdown.cpp",
+        "core/src/runtime/engine/relation_task_graph.cpp",
+        "core/src/runtime/engine/relation_document_cache.cpp",
         "core/src/runtime/engine/execute_relation.cpp",
         "core/src/runtime/engine/execute_source.cpp",
         "core/src/runtime/engine/query_validation_entry.cpp",
         "core/src/runtime/engine/io.cpp",
         "core/src/runtime/engine/column_names.cpp",
+        "core/src/runtime/engine/columnar_result.cpp",
+        "core/src/runtime/engine/computed_fields.cpp",
+        "core/src/runtime/engine/arrow_c_export.cpp",
         "core/src/runtime/engine/query_validation_rules.cpp",
         "core/src/runtime/engine/result_builder.cpp",
         "core/src/runtime/engine/table_extract.cpp",
@@ -99,6 +99,30 @@ void test_node_id_filter() {
   }
 }
 
+void test_ancestor_predicates_propagate_top_down() {
+  std::string html =
+      "<div id='content'><section><p id='deep'>a</p></section><p id='near'>b</p></div>"
+      "<div id='other'><p id='outside'>c</p></div>";
+  auto scoped = run_query(html, "SELECT p FROM document WHERE ancestor.attributes.id = 'content'");
+  expect_eq(scoped.rows.size(), 2, "ancestor mask covers nested descendants");
+  auto self_excluded =
+      run_query(html, "SELECT div FROM document WHERE ancestor.attributes.id = 'content'");
+  expect_eq(self_excluded.rows.size(), 0, "ancestor mask excludes the matching node itself");
+  auto exists =
+      run_query(html, "SELECT p FROM document WHERE EXISTS(ancestor WHERE tag = 'section')");
+  expect_eq(exists.rows.size(), 1, "exists ancestor mask");
+  if (!exists.rows.empty()) {
+    expect_true(exists.rows[0].attributes["id"] == "deep", "exists ancestor mask row");
+  }
+  auto mixed = run_query(html,
+                         "SELECT p FROM document WHERE ancestor.attributes.id = 'other' OR "
+                         "EXISTS(ancestor WHERE tag = 'section')");
+  expect_eq(mixed.rows.size(), 2, "ancestor masks combine under OR");
+  auto in_list = run_query(
+      html, "SELECT p FROM document WHERE ancestor.attributes.id IN ('other', 'content')");
+  expect_eq(in_list.rows.size(), 3, "ancestor mask with IN list");
+}
+
 }  // namespace
 
 void register_axis_tests(std::vector<TestCase>& tests) {
@@ -109,4 +133,6 @@ void register_axis_tests(std::vector<TestCase>& tests) {
   tests.push_back({"parent_tag_filter", test_parent_tag_filter});
   tests.push_back({"parent_id_filter", test_parent_id_filter});
   tests.push_back({"node_id_filter", test_node_id_filter});
+  tests.push_back(
+      {"ancestor_predicates_propagate_top_down", test_ancestor_predicates_propagate_top_down});
 }
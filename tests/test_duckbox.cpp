@@ -1,3 +1,7 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "test_harness.h"
 #include "test_utils.h"
 
@@ -82,6 +86,50 @@ void test_duckbox_null_rendering() {
   expect_true(out == expected, "duckbox null rendering");
 }
 
+void test_duckbox_page_offset() {
+  // The text column makes the table wide enough for the footer to fit untruncated.
+  const std::string text(30, 'x');
+  auto result = make_result({"node_id", "text"},
+                            {{"1", text}, {"2", text}, {"3", text}, {"4", text}, {"5", text}});
+  markql::render::DuckboxOptions options;
+  options.max_width = 80;
+  options.max_rows = 2;
+  options.offset = 2;
+  options.highlight = false;
+  options.is_tty = false;
+  std::string out = markql::render::render_duckbox(result, options);
+  expect_true(out.find("│       3 │") != std::string::npos, "duckbox page starts at offset");
+  expect_true(out.find("│       4 │") != std::string::npos, "duckbox page shows max_rows rows");
+  expect_true(out.find("│       2 │") == std::string::npos, "duckbox page skips earlier rows");
+  expect_true(out.find("│       5 │") == std::string::npos, "duckbox page stops at max_rows");
+  expect_true(out.find("rows 3-4 of 5") != std::string::npos, "duckbox page footer");
+
+  std::ostringstream streamed;
+  markql::render::render_duckbox(streamed, result, options);
+  expect_true(streamed.str() == out, "duckbox stream matches string rendering");
+}
+
+void test_duckbox_width_sample_bounds() {
+  const size_t sample = markql::render::kDuckboxWidthSampleRows;
+  std::vector<std::vector<std::string>> values;
+  for (size_t i = 0; i < sample * 2 + 10; ++i) {
+    values.push_back({std::to_string(i + 1), "short"});
+  }
+  values[sample + 5][1] = "a value far wider than any sampled cell";
+  auto result = make_result({"node_id", "text"}, values);
+  markql::render::DuckboxOptions options;
+  options.max_width = 120;
+  options.max_rows = 0;
+  options.highlight = false;
+  options.is_tty = false;
+  std::string out = markql::render::render_duckbox(result, options);
+  expect_true(out.find("│ short │") != std::string::npos, "duckbox widths come from the sample");
+  expect_true(out.find("│ a") != std::string::npos &&
+                  out.find("a value far wider") == std::string::npos,
+              "duckbox cuts unsampled wide cells to the column");
+  expect_true(out.find("truncated") == std::string::npos, "duckbox max_rows 0 shows every row");
+}
+
 }  // namespace
 
 void register_duckbox_tests(std::vector<TestCase>& tests) {
@@ -90,4 +138,6 @@ void register_duckbox_tests(std::vector<TestCase>& tests) {
   tests.push_back({"duckbox_maxrows_truncate", test_duckbox_maxrows_truncate});
   tests.push_back({"duckbox_numeric_alignment", test_duckbox_numeric_alignment});
   tests.push_back({"duckbox_null_rendering", test_duckbox_null_rendering});
+  tests.push_back({"duckbox_page_offset", test_duckbox_page_offset});
+  tests.push_back({"duckbox_width_sample_bounds", test_duckbox_width_sample_bounds});
 }
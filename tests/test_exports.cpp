@@ -2,13 +2,80 @@
 #include "test_utils.h"
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
+#include "cli_utils.h"
+#include "export/arrow_ipc_writer.h"
+#include "export/async_file_writer.h"
 #include "export/export_sinks.h"
+#include "export/streaming_sink.h"
+#include "markql/arrow_c_data.h"
+#include "markql/columnar_result.h"
+#include "markql/json_writer.h"
+
+#ifdef MARKQL_USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MARKQL_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef MARKQL_USE_ARROW
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/reader.h>
+#include <parquet/arrow/reader.h>
+#endif
 
 namespace {
 
+#ifdef MARKQL_USE_ZLIB
+/// Inflates one gzip member; empty when `data` is not exactly one complete member.
+std::string gunzip(const std::string& data) {
+  z_stream stream{};
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) return "";
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  std::string out;
+  char chunk[1 << 16];
+  int status = Z_OK;
+  while (status == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(chunk);
+    stream.avail_out = sizeof(chunk);
+    status = inflate(&stream, Z_NO_FLUSH);
+    out.append(chunk, sizeof(chunk) - stream.avail_out);
+  }
+  const bool complete = status == Z_STREAM_END && stream.avail_in == 0;
+  inflateEnd(&stream);
+  return complete ? out : "";
+}
+#endif
+
+#ifdef MARKQL_USE_ZSTD
+/// Decodes every zstd frame in `data`; empty on error.
+std::string unzstd(const std::string& data) {
+  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  ZSTD_inBuffer in{data.data(), data.size(), 0};
+  std::string out;
+  char chunk[1 << 16];
+  ZSTD_outBuffer chunk_out{chunk, sizeof(chunk), 0};
+  do {
+    chunk_out.pos = 0;
+    const size_t status = ZSTD_decompressStream(ctx, &chunk_out, &in);
+    if (ZSTD_isError(status)) {
+      out.clear();
+      break;
+    }
+    out.append(chunk, chunk_out.pos);
+  } while (in.pos < in.size || chunk_out.pos == chunk_out.size);
+  ZSTD_freeDCtx(ctx);
+  return out;
+}
+#endif
+
 void test_csv_escaping() {
   markql::QueryResult result;
   result.columns = {"col1", "col2"};
@@ -35,6 +102,35 @@ void test_csv_escaping() {
   expect_true(content == expected, "csv escaping content");
 }
 
+void test_json_writer_escaping_and_layout() {
+  std::string escaped;
+  // Longer than one 16-byte block, with hits on both sides of the block boundary.
+  markql::append_json_string(escaped, "0123456789abcd\"e\\f\x01g\tend");
+  expect_true(escaped == "\"0123456789abcd\\\"e\\\\f\\u0001g\\tend\"", "json writer escaping");
+
+  std::string numbers;
+  for (double value : {0.5, 100.0, 0.0, 1e-05, 1e21, 0.1 + 0.2}) {
+    markql::append_json_number(numbers, value);
+    numbers += ' ';
+  }
+  expect_true(numbers == "0.5 100.0 0.0 1e-05 1e+21 0.30000000000000004 ", "json writer numbers");
+
+  std::string pretty;
+  markql::JsonWriter writer(pretty, 2);
+  writer.begin_object();
+  writer.key("a");
+  writer.begin_array();
+  writer.integer(1);
+  writer.null();
+  writer.end_array();
+  writer.key("b");
+  writer.begin_object();
+  writer.end_object();
+  writer.end_object();
+  expect_true(pretty == "{\n  \"a\": [\n    1,\n    null\n  ],\n  \"b\": {}\n}",
+              "json writer pretty layout");
+}
+
 void test_csv_export_integration() {
   std::string html = "<a href='x'>Hi</a><a>Skip</a>";
   auto path = std::filesystem::temp_directory_path() / "markql_csv_integration_test.csv";
@@ -53,6 +149,212 @@ void test_csv_export_integration() {
   expect_true(content == expected, "csv export integration content");
 }
 
+void test_csv_file_writer_matches_stream() {
+  markql::QueryResult result;
+  result.columns = {"id", "value"};
+  // Enough rows for several 1 MiB blocks; specials land before, inside and after the
+  // first 16-byte block of a cell.
+  const std::vector<std::string> values = {
+      "plain cell without specials", "0123456789abcdef0123,tail", "quote \"in\" the head",
+      "0123456789abcdefXYZ\r\n", "", "short"};
+  for (size_t i = 0; i < 150000; ++i) {
+    markql::QueryResultRow row;
+    row.attributes["id"] = std::to_string(i);
+    row.attributes["value"] = values[i % values.size()];
+    result.rows.push_back(std::move(row));
+  }
+  std::ostringstream expected;
+  std::string error;
+  expect_true(markql::cli::write_csv(expected, result, error), "csv stream write ok");
+
+  auto path = std::filesystem::temp_directory_path() / "markql_csv_file_writer_test.csv";
+  expect_true(markql::cli::write_csv(result, path.string(), error), "csv file write ok");
+  std::string content = read_file_to_string(path);
+  std::filesystem::remove(path);
+  expect_true(content.size() > (size_t{2} << 20), "csv file spans several blocks");
+  expect_true(content == expected.str(), "csv file matches stream output");
+  expect_true(content.find("\n1,\"0123456789abcdef0123,tail\"\n") != std::string::npos,
+              "csv quotes a comma after the first block");
+  expect_true(content.find("\n2,\"quote \"\"in\"\" the head\"\n") != std::string::npos,
+              "csv doubles quotes");
+
+  auto missing = std::filesystem::temp_directory_path() / "markql_missing_dir" / "out.csv";
+  expect_true(!markql::cli::write_csv(result, missing.string(), error),
+              "csv write fails for a missing directory");
+  expect_true(error == "Failed to open file for writing: " + missing.string(),
+              "csv open failure message");
+}
+
+void test_export_fsync_option() {
+  std::string html = "<a href='x'>one</a>";
+  auto defaults = run_query(html, "SELECT a.href FROM doc TO CSV('out.csv')");
+  expect_true(!defaults.export_sink.fsync, "fsync is off by default");
+  auto csv = run_query(html, "SELECT a.href FROM doc TO CSV('out.csv', FSYNC=ON)");
+  expect_true(csv.export_sink.fsync, "csv FSYNC=ON");
+  auto ndjson = run_query(html, "SELECT a.href FROM doc TO NDJSON('out.ndjson', fsync = on)");
+  expect_true(ndjson.export_sink.fsync, "ndjson FSYNC=ON");
+  auto json = run_query(html, "SELECT a.href FROM doc TO JSON('out.json', FSYNC=OFF)");
+  expect_true(!json.export_sink.fsync, "json FSYNC=OFF");
+
+  for (const std::string& bad : std::vector<std::string>{
+           "TO CSV('out.csv', FSYNC=MAYBE)", "TO CSV('out.csv', FSYNC=ON, FSYNC=OFF)",
+           "TO JSON('out.json', ROW_GROUP=10)", "TO ARROW('out.arrow', FSYNC=ON)"}) {
+    bool threw = false;
+    try {
+      run_query(html, "SELECT a.href FROM doc " + bad);
+    } catch (const std::exception&) {
+      threw = true;
+    }
+    expect_true(threw, "export option rejected: " + bad);
+  }
+
+  auto path = std::filesystem::temp_directory_path() / "markql_csv_fsync_test.csv";
+  auto result =
+      run_query(html, "SELECT a.href FROM doc TO CSV(\"" + path.string() + "\", FSYNC=ON)");
+  std::string error;
+  expect_true(markql::cli::export_result(result, error), "fsync export ok");
+  std::string content = read_file_to_string(path);
+  std::filesystem::remove(path);
+  expect_true(content == "href\nx\n", "fsync export content");
+}
+
+void test_failed_export_keeps_existing_file() {
+  const auto dir = std::filesystem::temp_directory_path() / "markql_replace_export_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  const auto path = dir / "out.csv";
+  std::ofstream(path, std::ios::binary) << "old\n";
+  {
+    markql::cli::AsyncFileWriter writer(path.string());
+    std::string buffer = "new\n";
+    writer.submit(buffer);
+  }
+  expect_true(read_file_to_string(path) == "old\n", "abandoned export keeps the old file");
+  auto entry_count = [&]() {
+    return static_cast<size_t>(std::distance(std::filesystem::directory_iterator(dir),
+                                             std::filesystem::directory_iterator()));
+  };
+  expect_eq(entry_count(), 1, "abandoned export removes its temporary file");
+
+  std::string html = "<a href='x'>one</a>";
+  auto result = run_query(html, "SELECT a.href FROM doc TO CSV(\"" + path.string() +
+                                    "\", FSYNC=ON)");
+  std::string error;
+  expect_true(markql::cli::export_result(result, error), "export replaces the old file");
+  expect_true(read_file_to_string(path) == "href\nx\n", "replaced file has the new rows");
+  expect_eq(entry_count(), 1, "completed export leaves no temporary file");
+  std::filesystem::remove_all(dir);
+}
+
+void test_export_through_links_updates_target() {
+  const auto dir = std::filesystem::temp_directory_path() / "markql_linked_export_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  const auto real = dir / "real.csv";
+  const auto link = dir / "link.csv";
+  std::ofstream(real, std::ios::binary) << "old\n";
+  std::filesystem::create_symlink(real.filename(), link);
+  std::string html = "<a href='x'>one</a>";
+  std::string error;
+  auto result =
+      run_query(html, "SELECT a.href FROM doc TO CSV(\"" + link.string() + "\", FSYNC=ON)");
+  expect_true(markql::cli::export_result(result, error), "export through a symlink ok");
+  expect_true(std::filesystem::is_symlink(link), "export keeps the symlink");
+  expect_true(read_file_to_string(real) == "href\nx\n", "export writes the linked file");
+  expect_eq(static_cast<size_t>(std::distance(std::filesystem::directory_iterator(dir),
+                                              std::filesystem::directory_iterator())),
+            2, "export through a symlink leaves no temporary file");
+
+  const auto alias = dir / "alias.csv";
+  std::filesystem::create_hard_link(real, alias);
+  auto again = run_query(html, "SELECT a.tag FROM doc TO CSV(\"" + real.string() + "\")");
+  expect_true(markql::cli::export_result(again, error), "export to a hard-linked file ok");
+  expect_true(read_file_to_string(alias) == "tag\na\n" &&
+                  std::filesystem::hard_link_count(real) == 2,
+              "export keeps hard links together");
+  std::filesystem::remove_all(dir);
+}
+
+void test_compressed_exports() {
+  markql::QueryResult result;
+  result.columns = {"id", "value"};
+  for (size_t i = 0; i < 150000; ++i) {
+    markql::QueryResultRow row;
+    row.attributes["id"] = std::to_string(i);
+    row.attributes["value"] = "value \"" + std::to_string(i % 97) + "\", repeated text";
+    result.rows.push_back(std::move(row));
+  }
+  std::ostringstream expected;
+  std::string error;
+  expect_true(markql::cli::write_csv(expected, result, error), "csv stream write ok");
+  expect_true(expected.str().size() > (size_t{2} << 20), "compressed export spans several blocks");
+
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto gz_path = dir / "markql_compressed_export_test.csv.gz";
+  std::filesystem::remove(gz_path);
+  const bool gz_written = markql::cli::write_csv(result, gz_path.string(), error);
+#ifdef MARKQL_USE_ZLIB
+  expect_true(gz_written, "gzip export ok");
+  const std::string gz = read_file_to_string(gz_path);
+  expect_true(gz.size() > 2 && gz.size() < expected.str().size() / 4, "gzip export compresses");
+  expect_true(gunzip(gz) == expected.str(), "gzip export is one member with the csv bytes");
+#else
+  expect_true(!gz_written && error.find("requires zlib") != std::string::npos,
+              "gzip export without zlib reports the missing library");
+  expect_true(!std::filesystem::exists(gz_path), "gzip export without zlib creates no file");
+#endif
+  std::filesystem::remove(gz_path);
+
+  const auto zst_path = dir / "markql_compressed_export_test.ndjson.zst";
+  std::filesystem::remove(zst_path);
+  const bool zst_written = markql::cli::write_ndjson(result, zst_path.string(), error);
+#ifdef MARKQL_USE_ZSTD
+  expect_true(zst_written, "zstd export ok");
+  const auto ndjson_path = dir / "markql_compressed_export_test.ndjson";
+  markql::cli::write_ndjson(result, ndjson_path.string(), error);
+  expect_true(unzstd(read_file_to_string(zst_path)) == read_file_to_string(ndjson_path),
+              "zstd export decodes to the ndjson bytes");
+  std::filesystem::remove(ndjson_path);
+#else
+  expect_true(!zst_written && error.find("requires libzstd") != std::string::npos,
+              "zstd export without libzstd reports the missing library");
+#endif
+  std::filesystem::remove(zst_path);
+
+  // COMPRESSION overrides the suffix either way.
+  std::string html = "<a href='x'>one</a>";
+  auto plain = run_query(html, "SELECT a.href FROM doc TO CSV(\"" + gz_path.string() +
+                                   "\", COMPRESSION=NONE)");
+  expect_true(markql::cli::export_result(plain, error), "COMPRESSION=NONE export ok");
+  expect_true(read_file_to_string(gz_path) == "href\nx\n", "COMPRESSION=NONE writes plain text");
+  std::filesystem::remove(gz_path);
+  const auto csv_path = dir / "markql_compressed_export_option.csv";
+  auto forced = run_query(html, "SELECT a.href FROM doc TO CSV(\"" + csv_path.string() +
+                                    "\", COMPRESSION='gzip', FSYNC=ON)");
+  expect_true(forced.export_sink.compression ==
+                  markql::QueryResult::ExportSink::Compression::Gzip,
+              "COMPRESSION=GZIP parsed");
+#ifdef MARKQL_USE_ZLIB
+  expect_true(markql::cli::export_result(forced, error), "COMPRESSION=GZIP export ok");
+  expect_true(gunzip(read_file_to_string(csv_path)) == "href\nx\n",
+              "COMPRESSION=GZIP compresses a .csv path");
+#endif
+  std::filesystem::remove(csv_path);
+
+  for (const std::string& bad : std::vector<std::string>{
+           "TO CSV('out.csv', COMPRESSION=LZ4)",
+           "TO CSV('out.csv', COMPRESSION=GZIP, COMPRESSION=NONE)",
+           "TO PARQUET('out.parquet', COMPRESSION=NONE, FSYNC=ON)"}) {
+    bool threw = false;
+    try {
+      run_query(html, "SELECT a.href FROM doc " + bad);
+    } catch (const std::exception&) {
+      threw = true;
+    }
+    expect_true(threw, "export option rejected: " + bad);
+  }
+}
+
 void test_table_csv_export_integration() {
   std::string html =
       "<table>"
@@ -214,6 +516,239 @@ void test_csv_export_rejects_table_results() {
               "csv table rejection has clear error");
 }
 
+void test_streaming_sink_matches_collected_exports() {
+  std::string html =
+      "<a href='x'>He said \"hi\"</a>"
+      "<a href='y'>Two,Too</a>"
+      "<a href='z'>line1\nline2</a>";
+  const std::vector<std::string> sinks = {"CSV", "JSON", "NDJSON"};
+  for (const auto& kind : sinks) {
+    auto path = std::filesystem::temp_directory_path() / ("markql_stream_sink_test." + kind);
+    std::string query = "SELECT a.href, TEXT(a) FROM document WHERE attributes.href IS NOT NULL "
+                        "TO " + kind + "(\"" + path.string() + "\")";
+    std::string error;
+    bool ok = markql::cli::export_result(run_query(html, query), error);
+    expect_true(ok, "collected export ok: " + kind);
+    std::string collected = read_file_to_string(path);
+    std::filesystem::remove(path);
+
+    markql::cli::StreamingResultSink sink({});
+    auto result = markql::execute_query_from_document(html, query, sink);
+    expect_true(sink.streamed(), "export streams: " + kind);
+    expect_true(result.rows.empty(), "streamed export keeps no rows: " + kind);
+    expect_true(read_file_to_string(path) == collected, "streamed export bytes: " + kind);
+    std::filesystem::remove(path);
+  }
+
+  std::string query = "SELECT a.href, TEXT(a) FROM document WHERE attributes.href IS NOT NULL";
+  auto collected = run_query(html, query);
+  for (const std::string mode : {"csv", "plain"}) {
+    markql::cli::StreamingResultSink::Options options;
+    options.output_mode = mode;
+    markql::cli::StreamingResultSink sink(options);
+    std::ostringstream captured;
+    auto* old = std::cout.rdbuf(captured.rdbuf());
+    markql::execute_query_from_document(html, query, sink);
+    std::cout.rdbuf(old);
+    std::string expected;
+    if (mode == "csv") {
+      std::ostringstream csv;
+      std::string error;
+      markql::cli::write_csv(csv, collected, error);
+      expected = csv.str();
+    } else {
+      expected = markql::cli::build_json(collected) + "\n";
+    }
+    expect_true(sink.streamed(), "stdout mode streams: " + mode);
+    expect_true(captured.str() == expected, "streamed stdout matches collected: " + mode);
+  }
+
+  markql::cli::StreamingResultSink duckbox({});
+  auto kept = markql::execute_query_from_document(html, query, duckbox);
+  expect_true(!duckbox.streamed(), "duckbox output declines streaming");
+  expect_eq(kept.rows.size(), 3, "declined stream keeps rows for rendering");
+}
+
+void test_streaming_table_export_matches_collected() {
+  // Header with repeated words, a short row, blank and empty-looking rows, a blank column,
+  // trailing blank cells and a row after two empty ones.
+  std::string html =
+      "<table>"
+      "<tr><th>Name  Name</th><th></th><th>Score</th><th> </th></tr>"
+      "<tr><td>Ann</td><td></td><td>1</td><td></td></tr>"
+      "<tr><td>Bob, Jr</td><td> </td></tr>"
+      "<tr><td></td><td></td><td></td><td></td></tr>"
+      "<tr><td> </td><td></td><td></td><td></td></tr>"
+      "<tr><td>Cy</td><td></td><td>\"3\"</td><td></td></tr>"
+      "</table>";
+  const std::vector<std::string> options = {
+      "",
+      "HEADER=OFF",
+      "TRIM_EMPTY_ROWS=ON",
+      "TRIM_EMPTY_COLS=TRAILING",
+      "TRIM_EMPTY_COLS=ALL",
+      "TRIM_EMPTY_COLS=ALL, HEADER=OFF",
+      "TRIM_EMPTY_ROWS=ON, EMPTY_IS=BLANK_ONLY, TRIM_EMPTY_COLS=ALL",
+      "TRIM_EMPTY_ROWS=ON, EMPTY_IS=NULL_ONLY",
+      "STOP_AFTER_EMPTY_ROWS=2",
+      "HEADER_NORMALIZE=ON, TRIM_EMPTY_COLS=TRAILING",
+      "FORMAT=SPARSE",
+      "FORMAT=SPARSE, HEADER=OFF, TRIM_EMPTY_ROWS=ON",
+  };
+  auto path = std::filesystem::temp_directory_path() / "markql_stream_table_test.csv";
+  for (const auto& option : options) {
+    std::string query = "SELECT table FROM document TO TABLE(" + option +
+                        (option.empty() ? "" : ", ") + "EXPORT=\"" + path.string() + "\")";
+    std::string error;
+    bool ok = markql::cli::export_result(run_query(html, query), error);
+    expect_true(ok, "collected table export ok: " + option);
+    std::string collected = read_file_to_string(path);
+    std::filesystem::remove(path);
+
+    markql::cli::StreamingResultSink sink({});
+    auto result = markql::execute_query_from_document(html, query, sink);
+    expect_true(sink.streamed(), "table export streams: " + option);
+    expect_true(result.tables.size() == 1 && result.tables[0].rows.empty(),
+                "streamed table keeps no rows: " + option);
+    expect_true(read_file_to_string(path) == collected, "streamed table bytes: " + option);
+    std::filesystem::remove(path);
+  }
+
+  markql::cli::StreamingResultSink wide({});
+  auto kept = markql::execute_query_from_document(
+      html,
+      "SELECT table FROM document TO TABLE(FORMAT=SPARSE, SPARSE_SHAPE=WIDE, EXPORT=\"" +
+          path.string() + "\")",
+      wide);
+  expect_true(!wide.streamed(), "wide sparse table declines streaming");
+  expect_true(kept.tables.size() == 1 && !kept.tables[0].sparse_wide_rows.empty(),
+              "declined table keeps its rows");
+}
+
+void test_columnar_result_typed_columns() {
+  std::string html =
+      "<ul><li id='a' class='x'>One</li><li class='x'>Two</li><li id='c' class='x'>Three</li>"
+      "</ul>";
+  std::string query =
+      "SELECT li.node_id, li.tag, li.parent_id, li.id, TEXT(li), li.attributes FROM document "
+      "WHERE attributes.class = 'x'";
+  markql::ColumnarResultBuilder builder;
+  auto streamed = markql::execute_query_from_document(html, query, builder);
+  markql::ColumnarResult columns = builder.finish(streamed);
+  markql::QueryResult collected = run_query(html, query);
+  markql::ColumnarResult converted = markql::to_columnar_result(collected);
+  expect_eq(static_cast<size_t>(columns.num_rows), 3, "columnar row count");
+  expect_eq(columns.columns.size(), collected.columns.size(), "columnar column count");
+  expect_eq(static_cast<size_t>(converted.num_rows), 3, "converted row count");
+
+  using Type = markql::ColumnarColumn::Type;
+  const auto* node_id = columns.find("node_id");
+  const auto* tag = columns.find("tag");
+  const auto* id = columns.find("id");
+  const auto* text = columns.find("text");
+  const auto* attributes = columns.find("attributes");
+  expect_true(node_id != nullptr && tag != nullptr && id != nullptr && text != nullptr &&
+                  attributes != nullptr,
+              "columnar columns present");
+  if (node_id == nullptr || tag == nullptr || id == nullptr || text == nullptr ||
+      attributes == nullptr) {
+    return;
+  }
+  expect_true(node_id->type == Type::Int64 && node_id->int64_values.size() == 3,
+              "node_id is int64");
+  expect_true(node_id->int64_values[0] == collected.rows[0].node_id, "node_id values");
+  expect_true(tag->type == Type::DictionaryUtf8 && tag->strings.size() == 1 &&
+                  tag->dictionary_indices == std::vector<int32_t>({0, 0, 0}),
+              "tag is dictionary encoded");
+  expect_true(id->type == Type::Utf8 && id->null_count == 1 && id->is_valid(0) &&
+                  !id->is_valid(1) && id->is_valid(2) && id->strings.at(2) == "c",
+              "missing attribute is null in a utf8 column");
+  expect_true(text->strings.at(1) == "Two", "text column values");
+  expect_true(attributes->type == Type::StringMap &&
+                  attributes->map_offsets == std::vector<int32_t>({0, 2, 3, 5}) &&
+                  attributes->strings.at(0) == "class" && attributes->strings.at(1) == "id",
+              "attributes are a map with sorted keys");
+  const auto* converted_id = converted.find("id");
+  expect_true(converted_id != nullptr && converted_id->strings.data == id->strings.data &&
+                  converted_id->validity == id->validity,
+              "converted result matches the streamed build");
+
+  auto shared = std::make_shared<const markql::ColumnarResult>(std::move(columns));
+  ArrowSchema schema;
+  ArrowArray array;
+  markql::export_columnar_result(shared, &schema, &array);
+  expect_true(std::string(schema.format) == "+s" && schema.n_children == 6,
+              "arrow schema is a struct of the columns");
+  expect_true(array.length == 3 && array.n_children == 6, "arrow array holds every row");
+  expect_true(std::string(schema.children[1]->format) == "i" &&
+                  std::string(schema.children[1]->dictionary->format) == "U",
+              "tag exports as a dictionary");
+  expect_true(array.children[3]->buffers[2] == shared->find("id")->strings.data.data(),
+              "arrow buffers point into the columnar result");
+  schema.release(&schema);
+  array.release(&array);
+  expect_true(schema.release == nullptr && array.release == nullptr, "arrow structs released");
+}
+
+void test_parquet_export_options() {
+  std::string html = "<div id='x'>Hi</div>";
+  auto defaults = run_query(html, "SELECT div FROM doc TO PARQUET('out.parquet')");
+  const auto& sink = defaults.export_sink;
+  using Compression = markql::QueryResult::ExportSink::ParquetOptions::Compression;
+  expect_true(sink.kind == markql::QueryResult::ExportSink::Kind::Parquet, "parquet sink kind");
+  expect_true(sink.parquet.compression == Compression::Snappy, "parquet defaults to snappy");
+  expect_true(sink.parquet.row_group_size == (int64_t{1} << 20), "parquet default row group");
+  expect_true(sink.parquet.infer_types, "parquet infers types by default");
+
+  auto custom = run_query(
+      html,
+      "SELECT div FROM doc TO PARQUET('out.parquet', ROW_GROUP=5000, compression = zstd, "
+      "INFER_TYPES=OFF)");
+  expect_true(custom.export_sink.path == "out.parquet", "parquet options keep the path");
+  expect_true(custom.export_sink.parquet.compression == Compression::Zstd, "parquet zstd");
+  expect_eq(static_cast<size_t>(custom.export_sink.parquet.row_group_size), 5000,
+            "parquet row group option");
+  expect_true(!custom.export_sink.parquet.infer_types, "parquet INFER_TYPES=OFF");
+
+  for (const std::string& bad :
+       std::vector<std::string>{"ROW_GROUP=0", "COMPRESSION=LZ4", "ROW_GROUP=10, ROW_GROUP=20",
+                                "INFER_TYPES=MAYBE", "PAGE_SIZE=10"}) {
+    bool threw = false;
+    try {
+      run_query(html, "SELECT div FROM doc TO PARQUET('out.parquet', " + bad + ")");
+    } catch (const std::exception&) {
+      threw = true;
+    }
+    expect_true(threw, "parquet option rejected: " + bad);
+  }
+  bool threw = false;
+  try {
+    run_query(html, "SELECT div FROM doc TO CSV('out.csv', ROW_GROUP=10)");
+  } catch (const std::exception&) {
+    threw = true;
+  }
+  expect_true(threw, "parquet options are rejected for TO CSV");
+}
+
+void test_arrow_export_parse() {
+  std::string html = "<div id='x'>Hi</div>";
+  auto file = run_query(html, "SELECT div FROM doc TO ARROW('out.arrow')");
+  expect_true(file.export_sink.kind == markql::QueryResult::ExportSink::Kind::Arrow,
+              "arrow sink kind");
+  expect_true(file.export_sink.path == "out.arrow", "arrow sink path");
+  auto stdout_sink = run_query(html, "SELECT div FROM doc TO ARROW()");
+  expect_true(stdout_sink.export_sink.kind == markql::QueryResult::ExportSink::Kind::Arrow,
+              "arrow stdout sink kind");
+  expect_true(stdout_sink.export_sink.path.empty(), "TO ARROW() writes to stdout");
+  bool threw = false;
+  try {
+    run_query(html, "SELECT div FROM doc TO ARROW('out.arrow', ROW_GROUP=10)");
+  } catch (const std::exception&) {
+    threw = true;
+  }
+  expect_true(threw, "parquet options are rejected for TO ARROW");
+}
+
 #ifdef MARKQL_USE_ARROW
 void test_parquet_export_smoke() {
   std::string html = "<div id='x'>Hi</div>";
@@ -231,13 +766,160 @@ void test_parquet_export_smoke() {
     std::filesystem::remove(path);
   }
 }
+
+std::shared_ptr<arrow::Table> read_parquet(const std::filesystem::path& path,
+                                           std::shared_ptr<parquet::FileMetaData>* metadata) {
+  auto input = arrow::io::ReadableFile::Open(path.string()).ValueOrDie();
+  auto reader = parquet::arrow::OpenFile(input, arrow::default_memory_pool()).ValueOrDie();
+  *metadata = reader->parquet_reader()->metadata();
+  std::shared_ptr<arrow::Table> table;
+  expect_true(reader->ReadTable(&table).ok(), "parquet file reads back");
+  return table;
+}
+
+void test_parquet_export_typed_columns() {
+  std::string html =
+      "<ul><li class='a' data-n='3'>x</li><li class='a' data-n='007'>y</li>"
+      "<li data-n='12'>z</li></ul>";
+  auto path = std::filesystem::temp_directory_path() / "markql_parquet_typed.parquet";
+  const std::string query =
+      "SELECT li.node_id, li.tag, li.parent_id, li.class, li.attributes, "
+      "PROJECT(li) AS (pos: sibling_pos, n: ATTR(li, data-n)) FROM doc WHERE tag = 'li' "
+      "TO PARQUET('" + path.string() + "', ROW_GROUP=2, COMPRESSION=ZSTD)";
+  auto collected = run_query(html, query);
+  std::string error;
+  expect_true(markql::cli::export_result(collected, error), "typed parquet export ok");
+
+  std::shared_ptr<parquet::FileMetaData> metadata;
+  auto table = read_parquet(path, &metadata);
+  expect_eq(static_cast<size_t>(table->num_rows()), 3, "typed parquet row count");
+  expect_eq(static_cast<size_t>(metadata->num_row_groups()), 2, "ROW_GROUP caps row groups");
+  expect_true(metadata->RowGroup(0)->ColumnChunk(0)->compression() == parquet::Compression::ZSTD,
+              "COMPRESSION selects the codec");
+  const auto& schema = *table->schema();
+  expect_true(schema.GetFieldByName("node_id")->type()->id() == arrow::Type::INT64,
+              "node_id is int64");
+  expect_true(schema.GetFieldByName("parent_id")->type()->id() == arrow::Type::INT64,
+              "parent_id is int64");
+  expect_true(schema.GetFieldByName("tag")->type()->id() == arrow::Type::DICTIONARY,
+              "tag is dictionary encoded");
+  expect_true(schema.GetFieldByName("attributes")->type()->id() == arrow::Type::MAP,
+              "attributes is a map");
+  expect_true(schema.GetFieldByName("class")->type()->id() == arrow::Type::LARGE_STRING,
+              "attribute columns stay text");
+  expect_true(schema.GetFieldByName("pos")->type()->id() == arrow::Type::INT64,
+              "integer PROJECT field is inferred as int64");
+  expect_true(schema.GetFieldByName("n")->type()->id() == arrow::Type::LARGE_STRING,
+              "leading zeros keep a PROJECT field as text");
+  expect_eq(static_cast<size_t>(table->GetColumnByName("class")->null_count()), 1,
+            "missing attribute is null");
+
+  // The CLI streams TO PARQUET rows into columns; the file must match the collected export.
+  auto streamed_path = std::filesystem::temp_directory_path() / "markql_parquet_streamed.parquet";
+  std::string streamed_query = query;
+  streamed_query.replace(streamed_query.find(path.string()), path.string().size(),
+                         streamed_path.string());
+  markql::cli::StreamingResultSink sink(markql::cli::StreamingResultSink::Options{});
+  markql::execute_query_from_document(html, streamed_query, sink);
+  expect_true(sink.streamed(), "TO PARQUET streams through the sink");
+  std::shared_ptr<parquet::FileMetaData> streamed_metadata;
+  auto streamed = read_parquet(streamed_path, &streamed_metadata);
+  expect_true(streamed->Equals(*table), "streamed parquet matches collected parquet");
+
+  auto untyped = run_query(html, "SELECT PROJECT(li) AS (pos: sibling_pos) FROM doc WHERE "
+                                 "tag = 'li' TO PARQUET('" + path.string() +
+                                     "', INFER_TYPES=OFF)");
+  expect_true(markql::cli::export_result(untyped, error), "untyped parquet export ok");
+  auto untyped_table = read_parquet(path, &metadata);
+  expect_true(untyped_table->schema()->GetFieldByName("pos")->type()->id() ==
+                  arrow::Type::LARGE_STRING,
+              "INFER_TYPES=OFF keeps PROJECT fields as text");
+  std::filesystem::remove(path);
+  std::filesystem::remove(streamed_path);
+}
+
+std::shared_ptr<arrow::Table> read_arrow_stream(const std::filesystem::path& path,
+                                                size_t* batches) {
+  auto input = arrow::io::ReadableFile::Open(path.string()).ValueOrDie();
+  auto reader = arrow::ipc::RecordBatchStreamReader::Open(input).ValueOrDie();
+  std::vector<std::shared_ptr<arrow::RecordBatch>> all;
+  std::shared_ptr<arrow::RecordBatch> batch;
+  while (reader->ReadNext(&batch).ok() && batch != nullptr) all.push_back(batch);
+  *batches = all.size();
+  return arrow::Table::FromRecordBatches(reader->schema(), all).ValueOrDie();
+}
+
+void test_arrow_export_stream() {
+  std::string html =
+      "<ul><li class='a' data-n='3'>x</li><li class='a' data-n='007'>y</li>"
+      "<li data-n='12'>z</li></ul>";
+  auto path = std::filesystem::temp_directory_path() / "markql_arrow_typed.arrow";
+  auto parquet_path = std::filesystem::temp_directory_path() / "markql_arrow_typed.parquet";
+  const std::string select =
+      "SELECT li.node_id, li.tag, li.class, li.attributes, "
+      "PROJECT(li) AS (pos: sibling_pos, n: ATTR(li, data-n)) FROM doc WHERE tag = 'li' ";
+  std::string error;
+  auto collected = run_query(html, select + "TO ARROW('" + path.string() + "')");
+  expect_true(markql::cli::export_result(collected, error), "arrow export ok");
+  size_t batches = 0;
+  auto table = read_arrow_stream(path, &batches);
+  expect_eq(static_cast<size_t>(table->num_rows()), 3, "arrow row count");
+
+  auto parquet = run_query(html, select + "TO PARQUET('" + parquet_path.string() + "')");
+  expect_true(markql::cli::export_result(parquet, error), "parquet export for arrow schema ok");
+  std::shared_ptr<parquet::FileMetaData> metadata;
+  auto parquet_table = read_parquet(parquet_path, &metadata);
+  // Parquet reads dictionaries back as utf8 and renames map entries, so compare type ids.
+  expect_eq(static_cast<size_t>(table->num_columns()),
+            static_cast<size_t>(parquet_table->num_columns()), "arrow columns match parquet");
+  for (const auto& field : table->schema()->fields()) {
+    expect_true(field->type()->id() ==
+                    parquet_table->schema()->GetFieldByName(field->name())->type()->id(),
+                "arrow column type matches parquet: " + field->name());
+  }
+  expect_true(table->GetColumnByName("pos")->type()->id() == arrow::Type::INT64,
+              "arrow infers PROJECT integers");
+
+  auto streamed_path = std::filesystem::temp_directory_path() / "markql_arrow_streamed.arrow";
+  markql::cli::StreamingResultSink sink(markql::cli::StreamingResultSink::Options{});
+  markql::execute_query_from_document(html, select + "TO ARROW('" + streamed_path.string() + "')",
+                                      sink);
+  expect_true(sink.streamed(), "TO ARROW streams through the sink");
+  auto streamed = read_arrow_stream(streamed_path, &batches);
+  expect_true(streamed->Equals(*table), "streamed arrow matches collected arrow");
+
+  // Enough rows for several record batches; node fields let the sink flush as it goes.
+  std::string many = "<ul>";
+  const size_t rows = static_cast<size_t>(markql::cli::ArrowIpcStreamWriter::kBatchRows) + 10;
+  for (size_t i = 0; i < rows; ++i) many += "<li></li>";
+  many += "</ul>";
+  markql::cli::StreamingResultSink many_sink(markql::cli::StreamingResultSink::Options{});
+  markql::execute_query_from_document(
+      many, "SELECT li.node_id, li.tag FROM doc WHERE tag = 'li' TO ARROW('" +
+                streamed_path.string() + "')",
+      many_sink);
+  auto many_table = read_arrow_stream(streamed_path, &batches);
+  expect_eq(static_cast<size_t>(many_table->num_rows()), rows, "batched arrow row count");
+  expect_eq(batches, 2, "arrow rows are written in kBatchRows batches");
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(parquet_path);
+  std::filesystem::remove(streamed_path);
+}
 #endif
 
 }  // namespace
 
 void register_export_tests(std::vector<TestCase>& tests) {
   tests.push_back({"csv_escaping", test_csv_escaping});
+  tests.push_back({"json_writer_escaping_and_layout", test_json_writer_escaping_and_layout});
   tests.push_back({"csv_export_integration", test_csv_export_integration});
+  tests.push_back({"csv_file_writer_matches_stream", test_csv_file_writer_matches_stream});
+  tests.push_back({"export_fsync_option", test_export_fsync_option});
+  tests.push_back({"failed_export_keeps_existing_file", test_failed_export_keeps_existing_file});
+  tests.push_back(
+      {"export_through_links_updates_target", test_export_through_links_updates_target});
+  tests.push_back({"compressed_exports", test_compressed_exports});
   tests.push_back({"table_csv_export_integration", test_table_csv_export_integration});
   tests.push_back({"table_csv_export_header_off", test_table_csv_export_header_off});
   tests.push_back({"table_export_requires_single_table", test_table_export_requires_single_table});
@@ -246,7 +928,16 @@ void register_export_tests(std::vector<TestCase>& tests) {
   tests.push_back({"json_ndjson_stdout_fallback", test_json_ndjson_stdout_fallback});
   tests.push_back({"csv_stdout_fallback", test_csv_stdout_fallback});
   tests.push_back({"csv_export_rejects_table_results", test_csv_export_rejects_table_results});
+  tests.push_back(
+      {"streaming_sink_matches_collected_exports", test_streaming_sink_matches_collected_exports});
+  tests.push_back(
+      {"streaming_table_export_matches_collected", test_streaming_table_export_matches_collected});
+  tests.push_back({"columnar_result_typed_columns", test_columnar_result_typed_columns});
+  tests.push_back({"parquet_export_options", test_parquet_export_options});
+  tests.push_back({"arrow_export_parse", test_arrow_export_parse});
 #ifdef MARKQL_USE_ARROW
   tests.push_back({"parquet_export_smoke", test_parquet_export_smoke});
+  tests.push_back({"parquet_export_typed_columns", test_parquet_export_typed_columns});
+  tests.push_back({"arrow_export_stream", test_arrow_export_stream});
 #endif
 }
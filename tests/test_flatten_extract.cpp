@@ -182,6 +182,57 @@ void test_flatten_extract_table_drift_stability() {
   }
 }
 
+void test_project_rows_share_computed_schema() {
+  std::string html =
+      "<table>"
+      "<tr><td>a</td><td>1</td></tr>"
+      "<tr><td>b</td></tr>"
+      "</table>";
+  auto result = run_query(html,
+                          "SELECT tr.node_id, PROJECT(tr) AS ("
+                          "name: TEXT(td WHERE sibling_pos = 1),"
+                          "score: TEXT(td WHERE sibling_pos = 2)"
+                          ") FROM document WHERE EXISTS(child WHERE tag = 'td')");
+  expect_eq(result.rows.size(), 2, "project schema row count");
+  expect_true(result.computed_schema != nullptr, "project result carries a computed schema");
+  if (result.rows.size() != 2 || result.computed_schema == nullptr) return;
+  expect_eq(result.computed_schema->size(), 2, "project schema stores each name once");
+  expect_true(result.computed_schema->name(0) == "name" &&
+                  result.computed_schema->name(1) == "score",
+              "project schema slots follow select order");
+  for (const auto& row : result.rows) {
+    expect_true(row.computed_fields.schema() == result.computed_schema,
+                "project rows point at the result schema");
+  }
+
+  const auto& second = result.rows[1].computed_fields;
+  expect_true(second.at("name") == "b", "computed field at()");
+  expect_true(second.find("score") == second.end(), "missing PROJECT value stays unset");
+  expect_eq(second.count("score"), 0, "unset computed field count");
+  size_t visited = 0;
+  for (const auto& entry : result.rows[0].computed_fields) {
+    expect_true(entry.first == (visited == 0 ? "name" : "score"),
+                "computed fields iterate by slot");
+    ++visited;
+  }
+  expect_eq(visited, 2, "computed fields iterate set cells");
+
+  markql::ComputedFieldLookup lookup("score");
+  const std::string* score = lookup.find(result.rows[0].computed_fields);
+  expect_true(score != nullptr && *score == "1", "computed lookup by slot");
+  expect_true(lookup.find(second) == nullptr, "computed lookup unset cell");
+
+  // A row built by hand gets its own schema and compares by name and value.
+  markql::QueryResultRow manual;
+  manual.computed_fields["score"] = "1";
+  manual.computed_fields["name"] = "a";
+  expect_true(manual.computed_fields == result.rows[0].computed_fields,
+              "computed fields compare by name, not slot");
+  const std::string* manual_score = lookup.find(manual.computed_fields);
+  expect_true(manual_score != nullptr && *manual_score == "1",
+              "computed lookup re-resolves for another schema");
+}
+
 }  // namespace
 
 void register_flatten_extract_tests(std::vector<TestCase>& tests) {
@@ -193,4 +244,5 @@ void register_flatten_extract_tests(std::vector<TestCase>& tests) {
       {"flatten_extract_alias_compatibility", test_flatten_extract_alias_compatibility});
   tests.push_back(
       {"flatten_extract_table_drift_stability", test_flatten_extract_table_drift_stability});
+  tests.push_back({"project_rows_share_computed_schema", test_project_rows_share_computed_schema});
 }
@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "dom/html_parser.h"
+#include "dom/node_text_cache.h"
 #include "test_harness.h"
 #include "test_utils.h"
+#include "util/string_search.h"
 #include "util/string_util.h"
 
 namespace {
@@ -277,6 +284,116 @@ void test_tfidf_strips_html_markup() {
   }
 }
 
+void test_string_search_kernels() {
+  using markql::util::contains_ci;
+  using markql::util::like_match_ci;
+  expect_true(contains_ci("Hello World", "WORLD"), "contains_ci folds ascii");
+  expect_true(contains_ci("abc", ""), "contains_ci empty needle");
+  expect_true(!contains_ci("ab", "abc"), "contains_ci needle longer than haystack");
+  std::string long_text(100, 'x');
+  long_text += "Needle@End";
+  expect_true(contains_ci(long_text, "needle@end"), "contains_ci simd block path");
+  expect_true(!contains_ci(long_text, "needle`end"), "contains_ci keeps punctuation exact");
+  expect_true(contains_ci("Caf\xC3\x89 au lait", "caf\xC3\xA9"), "contains_ci folds utf8 latin");
+  expect_true(contains_ci("\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",
+                          "\xD0\xBF\xD1\x80\xD0\xB8"),
+              "contains_ci folds utf8 cyrillic");
+  expect_true(like_match_ci("Product-42", "product%"), "like prefix");
+  expect_true(like_match_ci("Product-42", "%-4_"), "like suffix wildcard");
+  expect_true(like_match_ci("a.b.c", "a%b%c"), "like middle segment");
+  expect_true(!like_match_ci("abc", "a%b%b"), "like anchored suffix");
+  expect_true(!like_match_ci("ab", "a%b%b"), "like overlapping anchors");
+  expect_true(like_match_ci("", "%"), "like percent matches empty");
+  expect_true(!like_match_ci("x", ""), "like empty pattern");
+  expect_true(like_match_ci("100%", "100%"), "like percent wildcard");
+  expect_true(like_match_ci("%ba", "%a"), "like percent in text");
+  expect_true(like_match_ci("\xC3\x89t\xC3\xA9", "_T_"), "like underscore is one utf8 char");
+  std::string pattern = "%-4_";
+  markql::util::CompiledLikePattern compiled(std::move(pattern));
+  pattern = "zzz";
+  expect_true(compiled.matches("Product-42") && !compiled.matches("Product-420"),
+              "compiled like owns its pattern");
+
+  markql::util::MultiPatternMatcher matcher({"she", "HE", "his", "hers", "caf\xC3\xA9"});
+  expect_true(matcher.contains_any("USHERS"), "aho-corasick any");
+  expect_true(!matcher.contains_any("xyz"), "aho-corasick any miss");
+  expect_true(!matcher.contains_all("ushers"), "aho-corasick all requires every token");
+  expect_true(matcher.contains_all("ushers his CAF\xC3\x89"), "aho-corasick all with utf8");
+  markql::util::MultiPatternMatcher pair({"she", "zzz"});
+  expect_true(!pair.contains_all("she"), "aho-corasick all resets its scratch between rows");
+  markql::util::MultiPatternMatcher empty_token({"", "zzz"});
+  expect_true(empty_token.contains_any("abc"), "empty token always matches");
+  markql::util::StringSet set({"a", "b", "c", "d"});
+  expect_true(set.contains("c") && !set.contains("C"), "string set exact match");
+}
+
+void test_node_text_cache_memoizes_direct_text() {
+  markql::NodeTextCache cache;
+  int computed = 0;
+  auto compute = [&]() {
+    ++computed;
+    return std::string("direct");
+  };
+  using Kind = markql::NodeTextCache::Kind;
+  const std::string* first = cache.get_or_compute(Kind::DirectText, 4, 2, compute);
+  const std::string* second = cache.get_or_compute(Kind::DirectText, 4, 2, compute);
+  expect_true(first != nullptr && *first == "direct", "node text cache returns computed value");
+  expect_true(first == second && computed == 1, "node text cache computes once per slot");
+  expect_true(cache.get_or_compute(Kind::DirectText, 5, 2, compute) == nullptr,
+              "node text cache bypasses resized documents");
+  markql::NodeTextCache copy = cache;
+  copy.get_or_compute(Kind::DirectText, 4, 2, compute);
+  expect_eq(computed, 2, "node text cache copies start empty");
+
+  markql::NodeTextCache shared;
+  std::vector<const std::string*> seen(4, nullptr);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < seen.size(); ++i) {
+    workers.emplace_back([&, i]() {
+      seen[i] = shared.get_or_compute(Kind::NormalizedDirectText, 1, 0,
+                                      []() { return std::string("x"); });
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  bool same = true;
+  for (const auto* value : seen) same = same && value == seen[0];
+  expect_true(same && seen[0] != nullptr, "node text cache publishes one value to all readers");
+
+  auto prepared = markql::prepare_document(
+      "<div id='a'>Alpha <b>bold</b> tail</div><div id='b'>Beta</div>");
+  const std::string query =
+      "SELECT div.node_id, DIRECT_TEXT(div) AS dt FROM document "
+      "WHERE div HAS_DIRECT_TEXT 'a' ORDER BY node_id";
+  auto cold = markql::execute_query_from_prepared_document(prepared, query);
+  auto warm = markql::execute_query_from_prepared_document(prepared, query);
+  expect_eq(cold.rows.size(), 2, "node text cache prepared row count");
+  expect_eq(warm.rows.size(), cold.rows.size(), "node text cache warm row count");
+  if (cold.rows.size() == 2 && warm.rows.size() == 2) {
+    expect_true(cold.rows[0].computed_fields["dt"] == "Alpha  tail",
+                "node text cache direct text value");
+    expect_true(warm.rows[0].computed_fields["dt"] == cold.rows[0].computed_fields["dt"] &&
+                    warm.rows[1].computed_fields["dt"] == "Beta",
+                "node text cache warm results match cold results");
+  }
+
+  markql::HtmlDocument doc = markql::parse_html("<section>ab<div>x</div></section>");
+  std::string scratch;
+  auto section = std::find_if(doc.nodes.begin(), doc.nodes.end(),
+                        [](const markql::HtmlNode& n) { return n.tag == "section"; });
+  expect_true(section != doc.nodes.end() &&
+                  markql::markql_internal::cached_direct_text(doc, *section, scratch) == "ab",
+              "node text cache serves the document node");
+  if (section == doc.nodes.end()) return;
+  std::string other_scratch;
+  expect_true(&markql::markql_internal::cached_direct_text(doc, *section, scratch) ==
+                  &markql::markql_internal::cached_direct_text(doc, *section, other_scratch),
+              "node text cache hits by document node identity");
+  markql::HtmlNode rewritten = *section;
+  rewritten.inner_html = "cd<div>y</div>";
+  expect_true(markql::markql_internal::cached_direct_text(doc, rewritten, scratch) == "cd",
+              "node text cache ignores rewritten nodes that keep their id");
+}
+
 }  // namespace
 
 void register_function_tests(std::vector<TestCase>& tests) {
@@ -307,4 +424,7 @@ void register_function_tests(std::vector<TestCase>& tests) {
   tests.push_back({"tfidf_scoring_top_term", test_tfidf_scoring_top_term});
   tests.push_back({"tfidf_stopwords", test_tfidf_stopwords});
   tests.push_back({"tfidf_strips_html_markup", test_tfidf_strips_html_markup});
+  tests.push_back({"string_search_kernels", test_string_search_kernels});
+  tests.push_back(
+      {"node_text_cache_memoizes_direct_text", test_node_text_cache_memoizes_direct_text});
 }
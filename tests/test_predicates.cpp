@@ -186,6 +186,69 @@ void test_exists_child_same_node() {
   }
 }
 
+void test_batch_predicates_match_row_semantics() {
+  std::string html =
+      "<div id='root'><span class='a b'>1</span><span class='c'>2</span>"
+      "<p id='x'>3</p><a href='h'>4</a></div><span>5</span>";
+  auto all = run_query(html, "SELECT * FROM document");
+  size_t roots = 0;
+  for (const auto& row : all.rows) {
+    if (!row.parent_id.has_value()) ++roots;
+  }
+  auto root = run_query(html, "SELECT div FROM document WHERE attributes.id = 'root'");
+  expect_eq(root.rows.size(), 1, "batch attribute equality");
+  if (root.rows.empty()) return;
+  const std::string root_id = std::to_string(root.rows[0].node_id);
+  const std::string root_order = std::to_string(root.rows[0].doc_order);
+  auto by_tag = run_query(html, "SELECT span FROM document WHERE parent_id = " + root_id);
+  expect_eq(by_tag.rows.size(), 2, "batch parent_id with select tag");
+  auto ranges = run_query(html, "SELECT * FROM document WHERE (doc_order > " + root_order +
+                                    " AND doc_order <= " + root_order +
+                                    ") OR attributes.id = 'x'");
+  expect_eq(ranges.rows.size(), 1, "batch doc_order range OR attribute");
+  const std::string window_end = std::to_string(root.rows[0].doc_order + 3);
+  auto window = run_query(html, "SELECT * FROM document WHERE doc_order > " + root_order +
+                                    " AND doc_order < " + window_end);
+  expect_eq(window.rows.size(), 2, "batch doc_order window");
+  auto class_token = run_query(html, "SELECT span FROM document WHERE attributes.class = 'b'");
+  expect_eq(class_token.rows.size(), 1, "batch class token equality");
+  auto not_root = run_query(html, "SELECT * FROM document WHERE parent_id <> 999999");
+  expect_eq(not_root.rows.size(), all.rows.size() - roots, "batch parent_id <> excludes roots");
+  auto tags = run_query(html, "SELECT * FROM document WHERE tag IN ('P', 'a') AND max_depth = 0");
+  expect_eq(tags.rows.size(), 2, "batch tag IN is case-insensitive");
+  auto mixed = run_query(html, "SELECT span FROM document WHERE node_id > " + root_id +
+                                   " AND text LIKE '%5%'");
+  expect_eq(mixed.rows.size(), 1, "batch prefilter with residual row predicate");
+  auto bad_int = run_query(html, "SELECT * FROM document WHERE node_id = 'abc'");
+  expect_eq(bad_int.rows.size(), 0, "batch non-integer literal matches nothing");
+}
+
+void test_long_value_lists_use_compiled_index() {
+  std::string html =
+      "<ul><li data-sku='A1' title='Red Apple'>1</li><li data-sku='B2' title='green pear'>2</li>"
+      "<li data-sku='C3' title='Blue Plum'>3</li><li title='plain'>4</li></ul>";
+  auto in_list = run_query(
+      html, "SELECT li FROM document WHERE attributes.data-sku IN ('Z9', 'A1', 'C3', 'Y8', 'X7')");
+  expect_eq(in_list.rows.size(), 2, "compiled IN set matches exact values");
+  auto in_case = run_query(
+      html, "SELECT li FROM document WHERE attributes.data-sku IN ('a1', 'b2', 'c3', 'd4')");
+  expect_eq(in_case.rows.size(), 0, "compiled IN set stays case-sensitive");
+  auto any = run_query(html,
+                       "SELECT li FROM document WHERE attributes.title CONTAINS ANY "
+                       "('kiwi', 'APPLE', 'plum', 'fig')");
+  expect_eq(any.rows.size(), 2, "compiled CONTAINS ANY");
+  auto all = run_query(html,
+                       "SELECT li FROM document WHERE attributes.title CONTAINS ALL "
+                       "('r', 'e', 'd', 'apple')");
+  expect_eq(all.rows.size(), 1, "compiled CONTAINS ALL");
+  auto relation = run_query(
+      html,
+      "WITH items AS (SELECT n.node_id AS id, ATTR(n, title) AS title FROM doc AS n "
+      "WHERE n.tag = 'li') "
+      "SELECT items.id FROM items WHERE items.title CONTAINS ANY ('kiwi', 'pear', 'fig', 'lime')");
+  expect_eq(relation.rows.size(), 1, "relation runtime uses compiled CONTAINS ANY");
+}
+
 }  // namespace
 
 void register_predicate_tests(std::vector<TestCase>& tests) {
@@ -205,4 +268,8 @@ void register_predicate_tests(std::vector<TestCase>& tests) {
   tests.push_back({"exists_child_any", test_exists_child_any});
   tests.push_back({"exists_child_tag", test_exists_child_tag});
   tests.push_back({"exists_child_same_node", test_exists_child_same_node});
+  tests.push_back(
+      {"batch_predicates_match_row_semantics", test_batch_predicates_match_row_semantics});
+  tests.push_back(
+      {"long_value_lists_use_compiled_index", test_long_value_lists_use_compiled_index});
 }
@@ -2,6 +2,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
@@ -16,6 +17,7 @@
 #include "repl/commands/explore_command.h"
 #include "repl/commands/lint_command.h"
 #include "repl/commands/mode_command.h"
+#include "repl/commands/more_command.h"
 #include "repl/commands/plugin_command.h"
 #include "repl/commands/plugin_registry.h"
 #include "repl/commands/set_command.h"
@@ -280,6 +282,55 @@ static void test_mode_command_accepts_csv() {
               "mode command confirms csv mode");
 }
 
+static void test_more_command_pages_last_result() {
+  StreamCapture capture(std::cout);
+  StreamCapture errors(std::cerr);
+  markql::cli::ReplConfig config;
+  config.output_mode = "duckbox";
+  config.color = false;
+  config.highlight = false;
+  markql::cli::LineEditor editor(5, "markql> ", 8);
+  std::unordered_map<std::string, markql::cli::LoadedSource> sources;
+  std::string active_alias = "doc";
+  std::string last_full_output;
+  bool display_full = true;
+  size_t max_rows = 2;
+  std::vector<markql::ColumnNameMapping> last_schema_map;
+  markql::cli::CommandRegistry registry;
+  markql::cli::PluginManager plugin_manager(registry);
+  markql::cli::DuckboxPager pager;
+  markql::cli::CommandContext ctx{
+      config,       editor,   sources,         active_alias,   last_full_output,
+      display_full, max_rows, last_schema_map, plugin_manager, &pager,
+  };
+
+  auto result = std::make_shared<markql::QueryResult>();
+  result->columns = {"tag", "text"};
+  for (const char* tag : {"a", "b", "c", "d", "e"}) {
+    markql::QueryResultRow row;
+    row.tag = tag;
+    row.text = std::string(30, 'x');
+    result->rows.push_back(std::move(row));
+  }
+  pager.result = result;
+  pager.next_row = 2;
+
+  auto handler = markql::cli::make_more_command();
+  expect_true(handler(".more", ctx), "more command handles .more");
+  expect_true(capture.str().find("│ c    │") != std::string::npos, "more shows the next page");
+  expect_true(capture.str().find("rows 3-4 of 5") != std::string::npos, "more page footer");
+  expect_true(pager.next_row == 4 && pager.result != nullptr, "more advances the pager");
+
+  expect_true(handler(".more;", ctx), "more command accepts a trailing semicolon");
+  expect_true(capture.str().find("│ e    │") != std::string::npos, "more shows the last page");
+  expect_true(pager.result == nullptr, "more releases the result after the last page");
+
+  expect_true(handler(".more", ctx), "more command handles an exhausted pager");
+  expect_true(errors.str().find("No more rows") != std::string::npos,
+              "more reports when nothing is left");
+  expect_true(!handler(".max_rows 5", ctx), "more command ignores other commands");
+}
+
 static void test_lint_command_toggles_on_and_off() {
   StreamCapture capture(std::cout);
   markql::cli::ReplConfig config;
@@ -574,6 +625,7 @@ void register_repl_tests(std::vector<TestCase>& tests) {
       {"sql_keyword_catalog_includes_new_tokens", test_sql_keyword_catalog_includes_new_tokens});
   tests.push_back({"set_colnames_command", test_set_colnames_command});
   tests.push_back({"mode_command_accepts_csv", test_mode_command_accepts_csv});
+  tests.push_back({"more_command_pages_last_result", test_more_command_pages_last_result});
   tests.push_back({"lint_command_toggles_on_and_off", test_lint_command_toggles_on_and_off});
   tests.push_back({"lint_command_rejects_invalid_value", test_lint_command_rejects_invalid_value});
   tests.push_back({"describe_last_command_outputs_map", test_describe_last_command_outputs_map});
@@ -470,6 +470,509 @@ void test_with_non_equi_join_fallback_behavior() {
 
 }  // namespace
 
+void test_with_left_join_order_by_numeric_keys_and_padding() {
+  std::string html =
+      "<div>"
+      "<li rank=\"10\">a</li>"
+      "<li rank=\"9\">b</li>"
+      "<li>c</li>"
+      "<p rank=\"9\">d</p>"
+      "</div>";
+  auto result = run_query(html,
+                          "WITH items AS ("
+                          "  SELECT n.node_id AS id, n.rank AS rank "
+                          "  FROM doc AS n "
+                          "  WHERE n.tag = 'li'"
+                          "), "
+                          "other AS ("
+                          "  SELECT n.node_id AS id, n.rank AS rank "
+                          "  FROM doc AS n "
+                          "  WHERE n.tag = 'p'"
+                          ") "
+                          "SELECT i.rank, o.id AS other_id "
+                          "FROM items AS i "
+                          "LEFT JOIN other AS o ON o.rank = i.rank "
+                          "ORDER BY i.rank DESC");
+  expect_eq(result.rows.size(), 3, "left join keeps every item row");
+  if (result.rows.size() != 3) return;
+  expect_true(result.rows[0].computed_fields["rank"] == "10",
+              "integer sort keys compare numerically");
+  expect_true(result.rows[1].computed_fields["rank"] == "9", "second rank in DESC order");
+  expect_true(result.rows[1].computed_fields.count("other_id") == 1,
+              "matched row carries right alias value");
+  expect_true(result.rows[0].computed_fields.count("other_id") == 0,
+              "padded right alias reads as NULL");
+  expect_true(result.rows[2].computed_fields.count("rank") == 0, "NULL sort key orders last");
+}
+
+void test_with_join_doc_source_reads_attributes_and_parent_lazily() {
+  std::string html =
+      "<div class=\"box\">"
+      "<span tag=\"custom\" id=\"a\">x</span>"
+      "<span id=\"b\">y</span>"
+      "</div>";
+  auto result = run_query(html,
+                          "WITH spans AS ("
+                          "  SELECT s.node_id AS node_id "
+                          "  FROM doc AS s "
+                          "  WHERE s.tag = 'span'"
+                          ") "
+                          "SELECT n.id, n.tag AS node_tag, LOWER(n.parent.tag) AS ptag "
+                          "FROM spans AS p "
+                          "JOIN doc AS n ON n.node_id = p.node_id "
+                          "WHERE n.parent.attributes.class = 'box' "
+                          "ORDER BY n.node_id");
+  expect_eq(result.rows.size(), 2, "doc join keeps both spans");
+  if (result.rows.size() != 2) return;
+  expect_true(result.rows[0].computed_fields["id"] == "a", "attribute column read from DOM");
+  expect_true(result.rows[0].computed_fields["node_tag"] == "custom",
+              "attribute overrides core column of the same name");
+  expect_true(result.rows[1].computed_fields["node_tag"] == "span", "core tag without override");
+  expect_true(result.rows[1].computed_fields["ptag"] == "div", "parent axis read from DOM");
+}
+
+void test_with_lateral_reuses_results_for_repeated_outer_rows() {
+  std::string html =
+      "<table>"
+      "<tr><td>a</td><td>b</td></tr>"
+      "<tr><td>c</td><td>d</td></tr>"
+      "</table>";
+  auto result = run_query(html,
+                          "WITH rows AS ("
+                          "  SELECT n.node_id AS row_id "
+                          "  FROM doc AS n "
+                          "  WHERE n.tag = 'tr'"
+                          "), "
+                          "cells AS ("
+                          "  SELECT n.node_id AS id "
+                          "  FROM doc AS n "
+                          "  WHERE n.tag = 'td'"
+                          ") "
+                          "SELECT r.row_id, c.parent_id AS cell_parent "
+                          "FROM rows AS r "
+                          "CROSS JOIN cells AS d "
+                          "CROSS JOIN LATERAL ("
+                          "  SELECT c "
+                          "  FROM doc AS c "
+                          "  WHERE c.parent_id = r.row_id AND c.tag = 'td'"
+                          ") AS c "
+                          "ORDER BY r.row_id");
+  expect_eq(result.rows.size(), 16, "lateral output keeps outer multiplicity");
+  bool parents_match = true;
+  for (auto& row : result.rows) {
+    if (row.computed_fields["row_id"] != row.computed_fields["cell_parent"]) {
+      parents_match = false;
+    }
+  }
+  expect_true(parents_match, "replayed lateral rows stay correlated with their outer row");
+}
+
+void test_with_cte_references_share_rows_without_leaking_changes() {
+  std::string html =
+      "<ul>"
+      "<li class='a'>a</li><li class='b'>b</li><li class='c'>c</li>"
+      "</ul>";
+  auto result = run_query(html,
+                          "WITH items AS ("
+                          "  SELECT n.node_id AS id, n.class AS label "
+                          "  FROM doc AS n "
+                          "  WHERE n.tag = 'li'"
+                          "), "
+                          "first_item AS ("
+                          "  SELECT i.id AS first_id FROM items AS i LIMIT 1"
+                          ") "
+                          "SELECT a.label, b.id AS other_id, f.first_id "
+                          "FROM items AS a "
+                          "JOIN items AS b ON a.id = b.id "
+                          "CROSS JOIN first_item AS f "
+                          "ORDER BY a.id");
+  expect_eq(result.rows.size(), 3, "LIMIT on one reference leaves the shared CTE intact");
+  if (result.rows.size() != 3) return;
+  expect_true(result.rows[2].computed_fields["label"] == "c", "renamed reference reads CTE rows");
+  expect_true(
+      result.rows[2].computed_fields["first_id"] == result.rows[0].computed_fields["other_id"],
+      "limited reference keeps its own first row");
+}
+
+void test_with_join_pushdown_keeps_join_semantics() {
+  std::string html =
+      "<table>"
+      "<tr id='r1'><td class='x'>1</td><td class='y'>2</td></tr>"
+      "<tr id='r2'><td class='y'>3</td></tr>"
+      "<tr id='r3'></tr>"
+      "</table>";
+  auto inner = run_query(html,
+                         "SELECT r.id, c.class FROM doc AS r "
+                         "JOIN doc AS c ON c.parent_id = r.node_id "
+                         "WHERE r.tag = 'tr' AND c.class = 'y' ORDER BY r.id");
+  expect_eq(inner.rows.size(), 2, "single-alias WHERE conjuncts filter both join inputs");
+  if (inner.rows.size() == 2) {
+    expect_true(inner.rows[0].computed_fields["id"] == "r1", "inner join keeps first row");
+    expect_true(inner.rows[1].computed_fields["id"] == "r2", "inner join keeps second row");
+  }
+
+  auto anti = run_query(html,
+                        "SELECT r.id FROM doc AS r "
+                        "LEFT JOIN doc AS c ON c.parent_id = r.node_id AND c.class = 'x' "
+                        "WHERE r.tag = 'tr' AND c.node_id IS NULL ORDER BY r.id");
+  expect_eq(anti.rows.size(), 2, "ON filters narrow a LEFT JOIN's right side only");
+  if (anti.rows.size() == 2) {
+    expect_true(anti.rows[0].computed_fields["id"] == "r2", "unmatched row is padded");
+    expect_true(anti.rows[1].computed_fields["id"] == "r3", "childless row is padded");
+  }
+
+  auto left = run_query(html,
+                        "SELECT r.id FROM doc AS r "
+                        "LEFT JOIN doc AS c ON c.parent_id = r.node_id "
+                        "WHERE r.tag = 'tr' AND c.class = 'y' ORDER BY r.id");
+  expect_eq(left.rows.size(), 2, "WHERE on a LEFT JOIN's right side still drops padded rows");
+
+  const std::string cells =
+      "WITH cells AS ("
+      "  SELECT c.node_id AS cell_id, c.parent_id AS row_id FROM doc AS c WHERE c.tag = 'td'"
+      ") ";
+  auto pruned = run_query(html, cells +
+                                    "SELECT r.id, x.cell_id FROM doc AS r "
+                                    "JOIN cells AS x ON x.row_id = r.node_id ORDER BY x.cell_id");
+  expect_eq(pruned.rows.size(), 3, "CTE read through projected columns only");
+  auto seeded = run_query(html, cells +
+                                    "SELECT r.id, x.tag AS cell_tag FROM doc AS r "
+                                    "JOIN cells AS x ON x.row_id = r.node_id");
+  expect_eq(seeded.rows.size(), 3, "CTE read through a node field");
+  if (!seeded.rows.empty()) {
+    expect_true(seeded.rows[0].computed_fields["cell_tag"] == "td",
+                "node fields survive when a consumer reads them");
+  }
+}
+
+void test_with_independent_ctes_evaluate_deterministically() {
+  std::string html =
+      "<ul><li id='1' k='a'>x</li><li id='2' k='b'>y</li></ul>"
+      "<ol><p k='a' t='q' v='P1'></p><p k='b' t='q' v='P2'></p></ol>"
+      "<div><s k='b' t='q' v='S2'></s><s k='a' t='q' v='S1'></s></div>";
+  // prices and labels are independent; pairs reads both, and a_pairs reads pairs.
+  auto dag = run_query(html,
+                       "WITH items AS (SELECT n.id AS id, n.k AS k FROM doc AS n "
+                       "WHERE n.tag = 'li'), "
+                       "prices AS (SELECT n.k AS k, n.v AS price FROM doc AS n "
+                       "WHERE n.tag = 'p'), "
+                       "labels AS (SELECT n.k AS k, n.v AS label FROM doc AS n "
+                       "WHERE n.tag = 's'), "
+                       "pairs AS (SELECT p.k, p.price, l.label FROM prices AS p "
+                       "JOIN labels AS l ON l.k = p.k), "
+                       "a_pairs AS (SELECT pr.k, pr.label FROM pairs AS pr WHERE pr.k = 'a') "
+                       "SELECT i.id, pr.price, pr.label, l.label AS only_a FROM items AS i "
+                       "JOIN pairs AS pr ON pr.k = i.k LEFT JOIN a_pairs AS l ON l.k = i.k "
+                       "ORDER BY i.id");
+  expect_eq(dag.rows.size(), 2, "independent CTEs join back on their shared key");
+  if (dag.rows.size() == 2) {
+    expect_true(dag.rows[0].computed_fields["price"] == "P1", "first price");
+    expect_true(dag.rows[0].computed_fields["label"] == "S1", "first label");
+    expect_true(dag.rows[0].computed_fields["only_a"] == "S1",
+                "a CTE two levels deep sees its dependencies");
+    expect_true(dag.rows[1].computed_fields["label"] == "S2", "second label");
+    expect_true(
+        dag.rows[1].computed_fields.find("only_a") == dag.rows[1].computed_fields.end(),
+        "dependent CTE keeps only its own rows");
+  }
+
+  // Two derived tables joined through relation indexes must not share one index.
+  auto derived = run_query(html,
+                           "SELECT i.id, p.v AS price, s.v AS label FROM doc AS i "
+                           "JOIN (SELECT n.k AS k, n.t AS t, n.v AS v FROM doc AS n "
+                           "WHERE n.tag = 'p') AS p ON p.k = i.k AND p.t = 'q' "
+                           "JOIN (SELECT n.k AS k, n.t AS t, n.v AS v FROM doc AS n "
+                           "WHERE n.tag = 's') AS s ON s.k = i.k AND s.t = 'q' "
+                           "WHERE i.tag = 'li' ORDER BY i.id");
+  expect_eq(derived.rows.size(), 2, "derived join inputs keep their own rows");
+  if (derived.rows.size() == 2) {
+    expect_true(derived.rows[0].computed_fields["label"] == "S1", "first derived label");
+    expect_true(derived.rows[1].computed_fields["label"] == "S2", "second derived label");
+  }
+
+  // The earliest failing CTE reports, whichever task fails first.
+  std::string message;
+  try {
+    run_query(html,
+              "WITH a AS (SELECT n.k FROM doc AS n WHERE n.tag = 'p'), "
+              "b AS (SELECT m.k FROM missing_one AS m), "
+              "c AS (SELECT m.k FROM missing_two AS m) "
+              "SELECT a.k FROM a");
+  } catch (const std::exception& ex) {
+    message = ex.what();
+  }
+  expect_true(message.find("missing_one") != std::string::npos,
+              "errors surface in declaration order");
+}
+
+void test_with_typed_values_keep_text_semantics() {
+  std::string html =
+      "<div>"
+      "<i v='10' w=' '></i><i v='9' w='x'></i><i v=' +7' w='y'></i><i v='abc'></i>"
+      "</div>";
+  const std::string items =
+      "WITH items AS (SELECT n.node_id AS id, n.v AS v, n.w AS w FROM doc AS n "
+      "WHERE n.tag = 'i') ";
+  auto numeric = run_query(html, items +
+                                     "SELECT x.v FROM items AS x JOIN items AS y "
+                                     "ON y.id = x.id WHERE x.v > 8 ORDER BY x.v");
+  expect_eq(numeric.rows.size(), 3, "text compares numerically when both sides parse");
+  if (numeric.rows.size() == 3) {
+    expect_true(numeric.rows[0].computed_fields["v"] == "9", "numeric order first");
+    expect_true(numeric.rows[1].computed_fields["v"] == "10", "numeric order second");
+    expect_true(numeric.rows[2].computed_fields["v"] == "abc", "text sorts after numbers");
+  }
+  auto signed_text = run_query(html, items +
+                                         "SELECT x.v FROM items AS x JOIN items AS y "
+                                         "ON y.id = x.id WHERE x.v = 7");
+  expect_eq(signed_text.rows.size(), 1, "leading space and plus sign still parse as int64");
+
+  auto rendered = run_query(html, items +
+                                      "SELECT LOWER(x.id) AS id_text, COALESCE(x.w, 'blank') AS w "
+                                      "FROM items AS x JOIN items AS y ON y.id = x.id "
+                                      "WHERE x.id = y.id ORDER BY x.id");
+  expect_eq(rendered.rows.size(), 4, "typed self-join keeps every row");
+  if (rendered.rows.size() == 4) {
+    expect_true(rendered.rows[0].computed_fields["id_text"] ==
+                    std::to_string(rendered.rows[0].node_id),
+                "numbers render as text at the output boundary");
+    expect_true(rendered.rows[0].computed_fields["w"] == "blank",
+                "COALESCE skips whitespace-only text");
+  }
+}
+
+void test_with_prepared_document_reuses_relation_caches() {
+  const std::string html =
+      "<table><tr><td class='k'>a</td><td class='v'>1</td></tr>"
+      "<tr><td class='k'>b</td><td class='v'>2</td></tr>"
+      "<tr><td class='k'>c</td></tr></table>";
+  const std::string cells =
+      "WITH rows_ AS (SELECT r.node_id AS row_id FROM doc AS r WHERE r.tag = 'tr'), "
+      "cells AS (SELECT c.parent_id AS row_id, c.class AS cls, TEXT(c) AS val FROM doc AS c "
+      "WHERE c.tag = 'td') ";
+  // WHY: the compound ON takes indexed_lookup_nested, whose index over `cells` is kept on the
+  // prepared document and reused by the second statement.
+  const std::string pairs = cells +
+                            "SELECT k.val AS k, v.val AS v FROM rows_ AS r "
+                            "LEFT JOIN cells AS k ON k.row_id = r.row_id AND k.cls = 'k' "
+                            "LEFT JOIN cells AS v ON v.row_id = r.row_id AND v.cls = 'v' "
+                            "ORDER BY r.row_id";
+  const std::string values = cells +
+                             "SELECT v.val AS v FROM rows_ AS r "
+                             "JOIN cells AS v ON v.row_id = r.row_id AND v.cls = 'v' "
+                             "ORDER BY r.row_id";
+  auto prepared = markql::prepare_document(html);
+  auto cold = markql::execute_query_from_prepared_document(prepared, pairs);
+  auto other = markql::execute_query_from_prepared_document(prepared, values);
+  auto warm = markql::execute_query_from_prepared_document(prepared, pairs);
+  auto fresh = run_query(html, pairs);
+  expect_eq(cold.rows.size(), 3, "prepared CTE join row count");
+  expect_eq(other.rows.size(), 2, "statement sharing the WITH clause keeps its own rows");
+  expect_eq(warm.rows.size(), fresh.rows.size(), "warm prepared run matches a fresh run");
+  if (cold.rows.size() == 3 && warm.rows.size() == 3 && fresh.rows.size() == 3) {
+    bool same = true;
+    for (size_t i = 0; i < 3; ++i) {
+      same = same && warm.rows[i].computed_fields == fresh.rows[i].computed_fields &&
+             cold.rows[i].computed_fields == fresh.rows[i].computed_fields;
+    }
+    expect_true(same, "cached relation indexes return the rows a fresh run returns");
+    expect_true(warm.rows[2].computed_fields.find("v") == warm.rows[2].computed_fields.end(),
+                "LEFT JOIN padding survives a cached index");
+  }
+
+  // WHY: FROM doc joins used to bypass the relation runtime on prepared documents.
+  const std::string doc_join =
+      "SELECT d.node_id, s.node_id AS sid FROM doc AS d JOIN doc AS s "
+      "ON s.parent_id = d.node_id WHERE d.tag = 'tr'";
+  auto prepared_join = markql::execute_query_from_prepared_document(prepared, doc_join);
+  auto fresh_join = run_query(html, doc_join);
+  expect_eq(prepared_join.rows.size(), fresh_join.rows.size(), "prepared doc join row count");
+  bool join_same = prepared_join.rows.size() == fresh_join.rows.size();
+  for (size_t i = 0; join_same && i < fresh_join.rows.size(); ++i) {
+    join_same = prepared_join.rows[i].computed_fields == fresh_join.rows[i].computed_fields;
+  }
+  expect_true(join_same, "prepared doc join matches a fresh run");
+}
+
+namespace {
+
+class CollectingSink : public markql::QueryResultSink {
+ public:
+  explicit CollectingSink(bool accept = true) : accept_(accept) {}
+  bool begin(const markql::QueryResult& header) override {
+    ++begins;
+    header_rows = header.rows.size();
+    columns = header.columns;
+    return accept_;
+  }
+  void row(const markql::QueryResultRow& row) override { rows.push_back(row); }
+  void end() override { ++ends; }
+
+  int begins = 0;
+  int ends = 0;
+  size_t header_rows = 0;
+  std::vector<std::string> columns;
+  std::vector<markql::QueryResultRow> rows;
+
+ private:
+  bool accept_ = true;
+};
+
+}  // namespace
+
+void test_with_result_sink_streams_rows() {
+  const std::string html =
+      "<ul><li class='a'>one</li><li class='b'>two</li><li class='a'>three</li></ul>";
+  const std::vector<std::string> queries = {
+      "SELECT li.class, TEXT(li) FROM document WHERE attributes.class IS NOT NULL",
+      "SELECT li.class, TEXT(li) FROM document WHERE attributes.class IS NOT NULL "
+      "ORDER BY text DESC",
+      "WITH items AS (SELECT n.node_id AS id, n.class AS cls FROM doc AS n "
+      "WHERE n.tag = 'li') SELECT i.id, i.cls FROM items AS i WHERE i.cls = 'a'",
+      "SELECT COUNT(*) FROM document",
+  };
+  for (const auto& query : queries) {
+    auto collected = run_query(html, query);
+    CollectingSink sink;
+    auto streamed = markql::execute_query_from_document(html, query, sink);
+    expect_true(streamed.rows.empty(), "streamed result leaves rows to the sink: " + query);
+    expect_eq(sink.begins, 1, "sink begins once: " + query);
+    expect_eq(sink.ends, 1, "sink ends once: " + query);
+    expect_eq(sink.header_rows, 0, "header carries no rows: " + query);
+    expect_true(sink.columns == collected.columns, "header columns match: " + query);
+    expect_eq(sink.rows.size(), collected.rows.size(), "sink row count: " + query);
+    bool same = sink.rows.size() == collected.rows.size();
+    for (size_t i = 0; same && i < sink.rows.size(); ++i) {
+      same = sink.rows[i].node_id == collected.rows[i].node_id &&
+             sink.rows[i].text == collected.rows[i].text &&
+             sink.rows[i].computed_fields == collected.rows[i].computed_fields &&
+             sink.rows[i].attributes == collected.rows[i].attributes;
+    }
+    expect_true(same, "sink rows match the materialized rows: " + query);
+
+    auto prepared = markql::prepare_document(html);
+    CollectingSink prepared_sink;
+    markql::execute_query_from_prepared_document(prepared, query, prepared_sink);
+    expect_eq(prepared_sink.rows.size(), collected.rows.size(), "prepared sink rows: " + query);
+    expect_eq(prepared_sink.ends, 1, "prepared sink ends once: " + query);
+  }
+
+  CollectingSink declining(false);
+  auto kept = markql::execute_query_from_document(html, queries[0], declining);
+  expect_eq(kept.rows.size(), 3, "declined stream keeps rows in the result");
+  expect_true(declining.rows.empty() && declining.ends == 0, "declined sink sees no rows");
+}
+
+void test_with_hash_join_typed_keys_and_partitioned_build() {
+  std::string html =
+      "<root>"
+      "<x code='01'></x><x code='abc'></x><x code='7'></x>"
+      "<y code='1'></y><y code='abc'></y><y code='ABC'></y><y code='1'></y>"
+      "</root>";
+  auto mixed = run_query(html,
+                         "WITH xs AS (SELECT n.node_id AS xid, n.code AS code FROM doc AS n "
+                         "WHERE n.tag = 'x'), "
+                         "ys AS (SELECT n.node_id AS yid, n.code AS code FROM doc AS n "
+                         "WHERE n.tag = 'y') "
+                         "SELECT x.xid, y.yid FROM xs AS x JOIN ys AS y ON x.code = y.code");
+  expect_eq(mixed.rows.size(), 3, "numeric text keys match numerically, text keys exactly");
+  if (mixed.rows.size() == 3) {
+    expect_true(mixed.rows[0].computed_fields["yid"] < mixed.rows[1].computed_fields["yid"],
+                "matches of one left row keep right-row order");
+  }
+
+  // WHY: enough integer keys to cross kRelationRadixJoinRows and take the partitioned path.
+  std::string big = "<root>";
+  for (int i = 0; i < 22000; ++i) big += "<p><b></b><i></i></p>";
+  big += "</root>";
+  auto partitioned = run_query(big,
+                               "WITH kids AS (SELECT n.node_id AS kid, n.parent_id AS pid "
+                               "FROM doc AS n WHERE n.tag = 'b' OR n.tag = 'i'), "
+                               "ps AS (SELECT n.node_id AS id FROM doc AS n WHERE n.tag = 'p') "
+                               "SELECT k.kid, k.pid, p.id FROM ps AS p "
+                               "LEFT JOIN kids AS k ON k.pid = p.id");
+  expect_eq(partitioned.rows.size(), 44000, "partitioned hash join keeps every match");
+  bool keys_match = true;
+  bool ordered = true;
+  std::string previous_id;
+  for (auto& row : partitioned.rows) {
+    auto pid = row.computed_fields.find("pid");
+    if (pid != row.computed_fields.end() && pid->second != row.computed_fields["id"]) {
+      keys_match = false;
+    }
+    ordered = ordered && (previous_id.empty() || std::stoll(previous_id) <=
+                                                     std::stoll(row.computed_fields["id"]));
+    previous_id = row.computed_fields["id"];
+  }
+  expect_true(keys_match, "partitioned hash join pairs equal keys only");
+  expect_true(ordered, "partitioned hash join emits in left-row order");
+
+  // a and c run concurrently and each runs a partitioned join of its own, as does the outer
+  // join; with MARKQL_REL_THREADS they all lease worker threads from one budget.
+  auto nested = run_query(big,
+                          "WITH kids AS (SELECT n.node_id AS kid, n.parent_id AS pid "
+                          "FROM doc AS n WHERE n.tag = 'b' OR n.tag = 'i'), "
+                          "ps AS (SELECT n.node_id AS id FROM doc AS n WHERE n.tag = 'p'), "
+                          "a AS (SELECT k.kid AS kid FROM ps AS p JOIN kids AS k ON k.pid = p.id), "
+                          "c AS (SELECT k.kid AS kid FROM kids AS k JOIN ps AS p ON p.id = k.pid) "
+                          "SELECT x.kid FROM a AS x JOIN c AS y ON y.kid = x.kid");
+  expect_eq(nested.rows.size(), 44000, "partitioned joins inside concurrent CTEs");
+}
+
+void test_with_join_structural_containment_matches_nested_loop() {
+  std::string html =
+      "<table>"
+      "<tr><td>a</td><td>b<span>x</span></td></tr>"
+      "<tr><td>c</td></tr>"
+      "</table>"
+      "<div><p>q</p></div>";
+  const std::string rows_cte =
+      "WITH rows AS ("
+      "  SELECT n.node_id AS row_id "
+      "  FROM doc AS n "
+      "  WHERE n.tag = 'tr' OR n.tag = 'span'"
+      ") ";
+  auto structural = run_query(html, rows_cte +
+                                        "SELECT r.row_id, c.node_id AS cell_id "
+                                        "FROM rows AS r "
+                                        "JOIN doc AS c ON c.ancestor.node_id = r.row_id");
+  auto filtered = run_query(html, rows_cte +
+                                      "SELECT r.row_id, c.node_id AS cell_id "
+                                      "FROM rows AS r "
+                                      "CROSS JOIN doc AS c "
+                                      "WHERE c.ancestor.node_id = r.row_id");
+  expect_eq(structural.rows.size(), 4, "descendants of both rows are paired");
+  expect_eq(filtered.rows.size(), 0, "axis operands outside a structural join stay NULL");
+  bool nested_order = structural.rows.size() == 4;
+  for (size_t i = 1; nested_order && i < structural.rows.size(); ++i) {
+    const int64_t prev_row = std::stoll(structural.rows[i - 1].computed_fields["row_id"]);
+    const int64_t row = std::stoll(structural.rows[i].computed_fields["row_id"]);
+    nested_order = prev_row < row ||
+                   (prev_row == row &&
+                    std::stoll(structural.rows[i - 1].computed_fields["cell_id"]) <
+                        std::stoll(structural.rows[i].computed_fields["cell_id"]));
+  }
+  expect_true(nested_order, "structural join keeps nested-loop output order");
+
+  auto residual = run_query(html, rows_cte +
+                                      "SELECT r.row_id, c.node_id AS cell_id "
+                                      "FROM rows AS r "
+                                      "JOIN doc AS c ON c.ancestor.node_id = r.row_id "
+                                      "AND c.tag = 'span'");
+  expect_eq(residual.rows.size(), 1, "structural join applies the remaining ON conjuncts");
+
+  auto padded = run_query(html, rows_cte +
+                                    "SELECT r.row_id, c.tag AS child_tag "
+                                    "FROM rows AS r "
+                                    "LEFT JOIN doc AS c ON r.row_id = c.parent_id");
+  expect_eq(padded.rows.size(), 4, "parent-child left join pads childless rows");
+  if (padded.rows.size() != 4) return;
+  expect_true(padded.rows[0].computed_fields["child_tag"] == "td", "direct child only");
+  expect_true(
+      padded.rows[2].computed_fields.find("child_tag") == padded.rows[2].computed_fields.end(),
+      "span without element children is padded");
+}
+
 void register_with_join_tests(std::vector<TestCase>& tests) {
   tests.push_back(
       {"parse_with_single_and_multiple_ctes", test_parse_with_single_and_multiple_ctes});
@@ -502,4 +1005,25 @@ void register_with_join_tests(std::vector<TestCase>& tests) {
                    test_with_repeated_cell_nodes_joins_correctness});
   tests.push_back(
       {"with_non_equi_join_fallback_behavior", test_with_non_equi_join_fallback_behavior});
+  tests.push_back({"with_left_join_order_by_numeric_keys_and_padding",
+                   test_with_left_join_order_by_numeric_keys_and_padding});
+  tests.push_back({"with_join_doc_source_reads_attributes_and_parent_lazily",
+                   test_with_join_doc_source_reads_attributes_and_parent_lazily});
+  tests.push_back({"with_lateral_reuses_results_for_repeated_outer_rows",
+                   test_with_lateral_reuses_results_for_repeated_outer_rows});
+  tests.push_back({"with_cte_references_share_rows_without_leaking_changes",
+                   test_with_cte_references_share_rows_without_leaking_changes});
+  tests.push_back({"with_hash_join_typed_keys_and_partitioned_build",
+                   test_with_hash_join_typed_keys_and_partitioned_build});
+  tests.push_back({"with_join_structural_containment_matches_nested_loop",
+                   test_with_join_structural_containment_matches_nested_loop});
+  tests.push_back({"with_join_pushdown_keeps_join_semantics",
+                   test_with_join_pushdown_keeps_join_semantics});
+  tests.push_back({"with_independent_ctes_evaluate_deterministically",
+                   test_with_independent_ctes_evaluate_deterministically});
+  tests.push_back({"with_typed_values_keep_text_semantics",
+                   test_with_typed_values_keep_text_semantics});
+  tests.push_back({"with_prepared_document_reuses_relation_caches",
+                   test_with_prepared_document_reuses_relation_caches});
+  tests.push_back({"with_result_sink_streams_rows", test_with_result_sink_streams_rows});
 }